@@ -0,0 +1,893 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/media/config.h"
+#include "fossil/media/media.h"
+#include "fossil/media/ini.h"
+#include "fossil/media/toml.h"
+#include "fossil/media/yaml.h"
+#include "fossil/media/fson.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+/* ---------------------------------------------------------------------------
+ * Flattened tables
+ *
+ * Each layer is parsed once into a table of dotted keys, and a snapshot is
+ * the same kind of table holding the winner of every key. Keys and text live
+ * in the table's arena; lookups go through open addressing on the key hash
+ * with the load kept at or below one half.
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    fossil_media_config_value_t *values;
+    uint64_t *hashes;
+    size_t count;
+    size_t cap;
+    size_t *slots;          /* value index + 1, 0 when empty */
+    size_t mask;
+    const char **cleared;   /* empty arrays: they add no keys but still hide lower layers' items */
+    size_t cleared_count;
+    fossil_media_arena_t arena;
+} config_table_t;
+
+typedef struct {
+    char *origin;           /* file path, or the name given for text layers */
+    int from_file;
+    fossil_media_config_format_t format;
+    config_table_t table;
+} config_layer_t;
+
+struct fossil_media_config {
+    config_layer_t *layers;
+    size_t count;
+    size_t cap;
+};
+
+struct fossil_media_config_snapshot {
+    config_table_t table;
+};
+
+#define CONFIG_FNV_BASIS 14695981039346656037ULL
+
+static uint64_t config_fnv(uint64_t h, char c) {
+    return (h ^ (unsigned char)c) * 1099511628211ULL;
+}
+
+/* Finish an FNV-1a state; split out so key prefixes can be hashed in one pass */
+static uint64_t config_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t config_hash(const char *s, size_t n) {
+    uint64_t h = CONFIG_FNV_BASIS;
+    for (size_t i = 0; i < n; ++i) h = config_fnv(h, s[i]);
+    return config_mix(h);
+}
+
+/* Power-of-two slot count keeping the load at or below one half */
+static size_t slots_for(size_t count) {
+    size_t cap = 8;
+    while (cap < count * 2) cap *= 2;
+    return cap;
+}
+
+static void table_init(config_table_t *t) {
+    memset(t, 0, sizeof(*t));
+    fossil_media_arena_init(&t->arena, 0);
+}
+
+static void table_free(config_table_t *t) {
+    free(t->values);
+    free(t->hashes);
+    free(t->slots);
+    free(t->cleared);
+    fossil_media_arena_destroy(&t->arena);
+    memset(t, 0, sizeof(*t));
+}
+
+static int table_reserve(config_table_t *t, size_t count) {
+    if (count > t->cap) {
+        size_t cap = t->cap ? t->cap : 16;
+        while (cap < count) cap *= 2;
+        fossil_media_config_value_t *values = (fossil_media_config_value_t*)realloc(t->values, cap * sizeof(*values));
+        if (!values) return -1;
+        t->values = values;
+        uint64_t *hashes = (uint64_t*)realloc(t->hashes, cap * sizeof(*hashes));
+        if (!hashes) return -1;
+        t->hashes = hashes;
+        t->cap = cap;
+    }
+    if (t->slots && count * 2 <= t->mask + 1) return 0;
+
+    size_t n = slots_for(count);
+    size_t *slots = (size_t*)calloc(n, sizeof(*slots));
+    if (!slots) return -1;
+    for (size_t i = 0; i < t->count; ++i) {
+        size_t s = (size_t)t->hashes[i] & (n - 1);
+        while (slots[s]) s = (s + 1) & (n - 1);
+        slots[s] = i + 1;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = n - 1;
+    return 0;
+}
+
+static const fossil_media_config_value_t *table_find(const config_table_t *t, const char *key, size_t len, uint64_t h) {
+    if (!t->slots) return NULL;
+    for (size_t i = (size_t)h & t->mask; t->slots[i]; i = (i + 1) & t->mask) {
+        size_t v = t->slots[i] - 1;
+        if (t->hashes[v] == h && strncmp(t->values[v].key, key, len) == 0 && t->values[v].key[len] == '\0') {
+            return &t->values[v];
+        }
+    }
+    return NULL;
+}
+
+/* Add a value under `key` unless the table has it already (first wins) */
+static int table_put(config_table_t *t, const char *key, size_t len, uint64_t h,
+                     const fossil_media_config_value_t *value, const char *text, size_t text_len) {
+    if (table_find(t, key, len, h)) return 0;
+    if (table_reserve(t, t->count + 1)) return -1;
+    fossil_media_config_value_t *v = &t->values[t->count];
+    *v = *value;
+    if (!(v->key = fossil_media_arena_strndup(&t->arena, key, len))) return -1;
+    if (!(v->text = fossil_media_arena_strndup(&t->arena, text, text_len))) return -1;
+    t->hashes[t->count] = h;
+
+    size_t i = (size_t)h & t->mask;
+    while (t->slots[i]) i = (i + 1) & t->mask;
+    t->slots[i] = ++t->count;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Flattening
+ *
+ * Every format is walked with the dotted key of the current value kept in a
+ * buffer; scalars are added to the layer's table under that key.
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    config_table_t *table;
+    fossil_media_buffer_t path;
+} config_flattener_t;
+
+static int put(fossil_media_buffer_t *b, const char *s, size_t n) {
+    return fossil_media_sink_buffer(b, s, n);
+}
+
+static int is_bare_key(const char *s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-'))
+            return 0;
+    }
+    return n > 0;
+}
+
+/*
+ * One key part, spelled the way TOML names are: bare when it can be, a basic
+ * string otherwise. Every format goes through here so the same key hashes the
+ * same whichever file defines it.
+ */
+static int put_key_part(fossil_media_buffer_t *b, const char *key, size_t n) {
+    if (b->len && put(b, ".", 1)) return -1;
+    if (is_bare_key(key, n)) return put(b, key, n);
+    if (put(b, "\"", 1)) return -1;
+    size_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)key[i];
+        char esc[8];
+        int e = 0;
+        switch (c) {
+            case '"':  e = snprintf(esc, sizeof(esc), "\\\""); break;
+            case '\\': e = snprintf(esc, sizeof(esc), "\\\\"); break;
+            case '\b': e = snprintf(esc, sizeof(esc), "\\b"); break;
+            case '\t': e = snprintf(esc, sizeof(esc), "\\t"); break;
+            case '\n': e = snprintf(esc, sizeof(esc), "\\n"); break;
+            case '\f': e = snprintf(esc, sizeof(esc), "\\f"); break;
+            case '\r': e = snprintf(esc, sizeof(esc), "\\r"); break;
+            default:
+                if (c < 0x20 || c == 0x7F) e = snprintf(esc, sizeof(esc), "\\u%04X", c);
+                break;
+        }
+        if (!e) continue;
+        if (put(b, key + run, i - run) || put(b, esc, (size_t)e)) return -1;
+        run = i + 1;
+    }
+    if (put(b, key + run, n - run)) return -1;
+    return put(b, "\"", 1);
+}
+
+static int put_key(fossil_media_buffer_t *b, const char *key) {
+    return put_key_part(b, key, strlen(key));
+}
+
+/* INI section names are dotted paths, `[server.tls]` like TOML's */
+static int put_section(fossil_media_buffer_t *b, const char *name) {
+    for (;;) {
+        const char *dot = strchr(name, '.');
+        size_t n = dot ? (size_t)(dot - name) : strlen(name);
+        if (put_key_part(b, name, n)) return -1;
+        if (!dot) return 0;
+        name = dot + 1;
+    }
+}
+
+static int put_position(fossil_media_buffer_t *b, size_t index) {
+    char digits[32];
+    int n = snprintf(digits, sizeof(digits), "[%zu]", index);
+    return put(b, digits, (size_t)n);
+}
+
+static int emit(config_flattener_t *fl, const fossil_media_config_value_t *value, const char *text, size_t len) {
+    const char *key = fl->path.data ? fl->path.data : "";
+    return table_put(fl->table, key, fl->path.len, config_hash(key, fl->path.len), value, text, len);
+}
+
+static int emit_string(config_flattener_t *fl, const char *text, size_t len) {
+    fossil_media_config_value_t v;
+    memset(&v, 0, sizeof(v));
+    v.type = FOSSIL_MEDIA_CONFIG_STRING;
+    return emit(fl, &v, text ? text : "", text ? len : 0);
+}
+
+static int emit_integer(config_flattener_t *fl, int64_t value) {
+    fossil_media_config_value_t v;
+    memset(&v, 0, sizeof(v));
+    v.type = FOSSIL_MEDIA_CONFIG_INTEGER;
+    v.as.integer = value;
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%lld", (long long)value);
+    return emit(fl, &v, text, (size_t)n);
+}
+
+/* Unsigned values past INT64_MAX keep their digits as a string */
+static int emit_unsigned(config_flattener_t *fl, uint64_t value) {
+    if (value <= (uint64_t)INT64_MAX) return emit_integer(fl, (int64_t)value);
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    return emit_string(fl, text, (size_t)n);
+}
+
+static int emit_float(config_flattener_t *fl, double value) {
+    fossil_media_config_value_t v;
+    memset(&v, 0, sizeof(v));
+    v.type = FOSSIL_MEDIA_CONFIG_FLOAT;
+    v.as.floating = value;
+    char text[40];
+    int n;
+    if (isnan(value)) {
+        n = snprintf(text, sizeof(text), "nan");
+    } else if (isinf(value)) {
+        n = snprintf(text, sizeof(text), value < 0 ? "-inf" : "inf");
+    } else {
+        n = snprintf(text, sizeof(text), "%.15g", value);
+        if (strtod(text, NULL) != value) n = snprintf(text, sizeof(text), "%.17g", value);
+    }
+    return emit(fl, &v, text, (size_t)n);
+}
+
+static int emit_bool(config_flattener_t *fl, int value) {
+    fossil_media_config_value_t v;
+    memset(&v, 0, sizeof(v));
+    v.type = FOSSIL_MEDIA_CONFIG_BOOLEAN;
+    v.as.boolean = value != 0;
+    return emit(fl, &v, value ? "true" : "false", value ? 4 : 5);
+}
+
+/* An empty array at the current key; it replaces lower layers' items like any other array */
+static int emit_cleared(config_flattener_t *fl) {
+    config_table_t *t = fl->table;
+    const char **cleared = (const char**)realloc(t->cleared, (t->cleared_count + 1) * sizeof(*cleared));
+    if (!cleared) return -1;
+    t->cleared = cleared;
+    const char *key = fossil_media_arena_strndup(&t->arena, fl->path.data ? fl->path.data : "", fl->path.len);
+    if (!key) return -1;
+    t->cleared[t->cleared_count++] = key;
+    return 0;
+}
+
+static int emit_null(config_flattener_t *fl, const char *text) {
+    fossil_media_config_value_t v;
+    memset(&v, 0, sizeof(v));
+    v.type = FOSSIL_MEDIA_CONFIG_NULL;
+    return emit(fl, &v, text, strlen(text));
+}
+
+/* --- INI: `section.key`; entries outside any section are not kept by the loader --- */
+
+static int flatten_ini(config_flattener_t *fl, const fossil_media_ini_t *ini) {
+    for (size_t s = 0; s < ini->section_count; ++s) {
+        const fossil_media_ini_section_t *sec = &ini->sections[s];
+        for (size_t e = 0; e < sec->entry_count; ++e) {
+            const fossil_media_ini_entry_t *entry = &sec->entries[e];
+            fl->path.len = 0;
+            if (put_section(&fl->path, sec->name) || put_key(&fl->path, entry->key)) return -1;
+            if (emit_string(fl, entry->value, entry->value ? strlen(entry->value) : 0)) return -1;
+        }
+    }
+    return 0;
+}
+
+/* --- TOML: names from fossil_media_toml_foreach(); arrays add positions --- */
+
+/* RFC 3339 text for a date-time inside an array, where there is no source text to keep */
+static int emit_datetime(config_flattener_t *fl, const fossil_media_toml_datetime_t *dt) {
+    char text[64];
+    size_t n = 0;
+    if (dt->has_date) {
+        n += (size_t)snprintf(text + n, sizeof(text) - n, "%04d-%02d-%02d", dt->year, dt->month, dt->day);
+        if (dt->has_time) text[n++] = 'T';
+    }
+    if (dt->has_time) {
+        n += (size_t)snprintf(text + n, sizeof(text) - n, "%02d:%02d:%02d", dt->hour, dt->minute, dt->second);
+        if (dt->nanosecond > 0) {
+            char frac[16];
+            int digits = 9;
+            snprintf(frac, sizeof(frac), "%09d", (int)dt->nanosecond);
+            while (digits > 1 && frac[digits - 1] == '0') digits--;
+            n += (size_t)snprintf(text + n, sizeof(text) - n, ".%.*s", digits, frac);
+        }
+        if (dt->has_offset && dt->offset_minutes == 0) {
+            text[n++] = 'Z';
+        } else if (dt->has_offset) {
+            int off = dt->offset_minutes, a = off < 0 ? -off : off;
+            n += (size_t)snprintf(text + n, sizeof(text) - n, "%c%02d:%02d", off < 0 ? '-' : '+', a / 60, a % 60);
+        }
+    }
+    return emit_string(fl, text, n);
+}
+
+static int flatten_toml_value(config_flattener_t *fl, const fossil_media_toml_value_t *v, const char *text) {
+    switch (v->type) {
+        case FOSSIL_MEDIA_TOML_STRING:
+            if (v->as.string.data) return emit_string(fl, v->as.string.data, v->as.string.length);
+            return emit_string(fl, text, text ? strlen(text) : 0);
+        case FOSSIL_MEDIA_TOML_INTEGER:
+            return emit_integer(fl, v->as.integer);
+        case FOSSIL_MEDIA_TOML_FLOAT:
+            return emit_float(fl, v->as.floating);
+        case FOSSIL_MEDIA_TOML_BOOLEAN:
+            return emit_bool(fl, v->as.boolean);
+        case FOSSIL_MEDIA_TOML_DATETIME:
+            /* whole entries keep their source text */
+            return text ? emit_string(fl, text, strlen(text)) : emit_datetime(fl, &v->as.datetime);
+        case FOSSIL_MEDIA_TOML_TABLE:
+            return 0; /* entries are visited on their own */
+        case FOSSIL_MEDIA_TOML_ARRAY: {
+            if (v->as.array.count == 0) return emit_cleared(fl);
+            size_t base = fl->path.len;
+            for (size_t i = 0; i < v->as.array.count; ++i) {
+                fl->path.len = base;
+                if (put_position(&fl->path, i) || flatten_toml_value(fl, &v->as.array.items[i], NULL)) return -1;
+            }
+            fl->path.len = base;
+            return 0;
+        }
+    }
+    return 0;
+}
+
+static int flatten_toml_entry(void *user, const char *name, size_t len, const fossil_media_toml_entry_t *entry) {
+    config_flattener_t *fl = (config_flattener_t*)user;
+    fl->path.len = 0;
+    if (put(&fl->path, name, len)) return -1;
+    return flatten_toml_value(fl, &entry->typed, entry->value);
+}
+
+/* --- YAML: mapping keys join with '.', sequence items add positions --- */
+
+/* Core schema integers: decimal, 0o octal or 0x hex */
+static int yaml_integer(const char *s, int64_t *out) {
+    const char *p = s;
+    int neg = 0;
+    if (*p == '-' || *p == '+') neg = *p++ == '-';
+    int base = 10;
+    if (p[0] == '0' && (p[1] == 'o' || p[1] == 'x')) {
+        base = p[1] == 'o' ? 8 : 16;
+        p += 2;
+    }
+    if (!*p) return -1;
+    char *end;
+    errno = 0;
+    unsigned long long v = strtoull(p, &end, base);
+    if (errno == ERANGE || *end || v > (neg ? (unsigned long long)INT64_MAX + 1 : (unsigned long long)INT64_MAX)) {
+        return -1;
+    }
+    *out = neg ? (int64_t)(0 - v) : (int64_t)v;
+    return 0;
+}
+
+static int yaml_float(const char *s, double *out) {
+    const char *p = s;
+    int neg = 0;
+    if (*p == '-' || *p == '+') neg = *p++ == '-';
+    if (fossil_media_strncasecmp(p, ".inf", 5) == 0) {
+        *out = neg ? -INFINITY : INFINITY;
+        return 0;
+    }
+    if (fossil_media_strncasecmp(p, ".nan", 5) == 0) {
+        *out = NAN;
+        return 0;
+    }
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || *end) return -1;
+    *out = v;
+    return 0;
+}
+
+static int flatten_yaml_scalar(config_flattener_t *fl, const fossil_media_yaml_node_t *node) {
+    const char *text = node->value ? node->value : "";
+    int64_t i;
+    double d;
+    switch (node->type) {
+        case FOSSIL_MEDIA_YAML_TYPE_NULL:
+            return emit_null(fl, text);
+        case FOSSIL_MEDIA_YAML_TYPE_BOOL:
+            return emit_bool(fl, text[0] == 't' || text[0] == 'T');
+        case FOSSIL_MEDIA_YAML_TYPE_INT:
+            if (yaml_integer(text, &i) == 0) return emit_integer(fl, i);
+            break;
+        case FOSSIL_MEDIA_YAML_TYPE_FLOAT:
+            if (yaml_float(text, &d) == 0) return emit_float(fl, d);
+            break;
+        case FOSSIL_MEDIA_YAML_TYPE_MAPPING:
+            return 0; /* empty mapping */
+        case FOSSIL_MEDIA_YAML_TYPE_SEQUENCE:
+            return emit_cleared(fl);
+        default:
+            break;
+    }
+    return emit_string(fl, text, strlen(text));
+}
+
+static int flatten_yaml(config_flattener_t *fl, const fossil_media_yaml_node_t *node) {
+    size_t base = fl->path.len;
+    size_t index = 0;
+    for (; node; node = node->next) {
+        fl->path.len = base;
+        int rc = node->key ? put_key(&fl->path, node->key) : put_position(&fl->path, index++);
+        if (rc == 0) rc = node->child ? flatten_yaml(fl, node->child) : flatten_yaml_scalar(fl, node);
+        if (rc) return -1;
+    }
+    fl->path.len = base;
+    return 0;
+}
+
+/* --- FSON: object keys join with '.', array items add positions --- */
+
+static int flatten_fson(config_flattener_t *fl, const fossil_media_fson_value_t *v) {
+    if (!v) return 0;
+    size_t base = fl->path.len;
+    switch (v->type) {
+        case FSON_TYPE_NULL:     return emit_null(fl, "null");
+        case FSON_TYPE_BOOL:     return emit_bool(fl, v->u.boolean);
+        case FSON_TYPE_I8:       return emit_integer(fl, v->u.i8);
+        case FSON_TYPE_I16:      return emit_integer(fl, v->u.i16);
+        case FSON_TYPE_I32:      return emit_integer(fl, v->u.i32);
+        case FSON_TYPE_I64:      return emit_integer(fl, v->u.i64);
+        case FSON_TYPE_U8:       return emit_integer(fl, v->u.u8);
+        case FSON_TYPE_U16:      return emit_integer(fl, v->u.u16);
+        case FSON_TYPE_U32:      return emit_integer(fl, v->u.u32);
+        case FSON_TYPE_U64:      return emit_unsigned(fl, v->u.u64);
+        case FSON_TYPE_F32:      return emit_float(fl, v->u.f32);
+        case FSON_TYPE_F64:      return emit_float(fl, v->u.f64);
+        case FSON_TYPE_OCT:      return emit_unsigned(fl, v->u.oct);
+        case FSON_TYPE_HEX:      return emit_unsigned(fl, v->u.hex);
+        case FSON_TYPE_BIN:      return emit_unsigned(fl, v->u.bin);
+        case FSON_TYPE_CHAR:     return emit_string(fl, &v->u.character, 1);
+        case FSON_TYPE_CSTR:     return emit_string(fl, v->u.cstr, v->u.cstr ? strlen(v->u.cstr) : 0);
+        case FSON_TYPE_ENUM:
+            return emit_string(fl, v->u.enum_val.symbol, v->u.enum_val.symbol ? strlen(v->u.enum_val.symbol) : 0);
+        case FSON_TYPE_DATETIME: return emit_integer(fl, v->u.datetime.epoch_ns);
+        case FSON_TYPE_DURATION: return emit_integer(fl, v->u.duration.ns);
+        case FSON_TYPE_ARRAY:
+            if (v->u.array.count == 0) return emit_cleared(fl);
+            for (size_t i = 0; i < v->u.array.count; ++i) {
+                fl->path.len = base;
+                if (put_position(&fl->path, i) || flatten_fson(fl, v->u.array.items[i])) return -1;
+            }
+            break;
+        case FSON_TYPE_OBJECT:
+            for (size_t i = 0; i < v->u.object.count; ++i) {
+                fl->path.len = base;
+                if (put_key(&fl->path, v->u.object.keys[i]) || flatten_fson(fl, v->u.object.values[i])) return -1;
+            }
+            break;
+    }
+    fl->path.len = base;
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Layers
+ * ------------------------------------------------------------------------- */
+
+static int has_extension(const char *name, const char *ext) {
+    const char *dot = name ? strrchr(name, '.') : NULL;
+    size_t n = strlen(ext);
+    return dot && strlen(dot + 1) == n && fossil_media_strncasecmp(dot + 1, ext, n) == 0;
+}
+
+static fossil_media_config_format_t detect_format(const char *name) {
+    if (has_extension(name, "ini") || has_extension(name, "cfg") || has_extension(name, "conf")) {
+        return FOSSIL_MEDIA_CONFIG_INI;
+    }
+    if (has_extension(name, "toml")) return FOSSIL_MEDIA_CONFIG_TOML;
+    if (has_extension(name, "yaml") || has_extension(name, "yml")) return FOSSIL_MEDIA_CONFIG_YAML;
+    if (has_extension(name, "fson")) return FOSSIL_MEDIA_CONFIG_FSON;
+    return FOSSIL_MEDIA_CONFIG_AUTO;
+}
+
+static int is_blank(const char *text, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (!isspace((unsigned char)text[i])) return 0;
+    }
+    return 1;
+}
+
+/* Parse NUL-terminated `text` of `len` bytes into a fresh table */
+static int flatten_text(config_flattener_t *fl, fossil_media_config_format_t format, const char *text, size_t len) {
+    if (is_blank(text, len)) return 0;
+    int rc = -1;
+    switch (format) {
+        case FOSSIL_MEDIA_CONFIG_INI: {
+            fossil_media_ini_t ini;
+            if (fossil_media_ini_load_buffer(text, len, &ini) != 0) return -1;
+            rc = flatten_ini(fl, &ini);
+            fossil_media_ini_free(&ini);
+            break;
+        }
+        case FOSSIL_MEDIA_CONFIG_TOML: {
+            fossil_media_toml_t toml;
+            if (fossil_media_toml_parse(text, &toml) != 0) return -1;
+            rc = fossil_media_toml_foreach(&toml, flatten_toml_entry, fl);
+            fossil_media_toml_free(&toml);
+            break;
+        }
+        case FOSSIL_MEDIA_CONFIG_YAML: {
+            fossil_media_yaml_node_t *head = fossil_media_yaml_parse(text);
+            if (!head) return -1;
+            rc = flatten_yaml(fl, head);
+            fossil_media_yaml_free(head);
+            break;
+        }
+        case FOSSIL_MEDIA_CONFIG_FSON: {
+            fossil_media_fson_value_t *root = fossil_media_fson_parse_tree(text, NULL);
+            if (!root) return -1;
+            rc = flatten_fson(fl, root);
+            fossil_media_fson_free(root);
+            break;
+        }
+        default:
+            break;
+    }
+    return rc;
+}
+
+/* Read and flatten a layer's source into `out`; the layer itself is untouched */
+static int layer_parse(const config_layer_t *layer, const char *text, config_table_t *out) {
+    table_init(out);
+    config_flattener_t fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.table = out;
+
+    int rc;
+    if (text) {
+        rc = flatten_text(&fl, layer->format, text, strlen(text));
+    } else {
+        size_t size;
+        char *data = fossil_media_read_file(layer->origin, &size);
+        rc = data ? flatten_text(&fl, layer->format, data, size) : -1;
+        free(data);
+    }
+    fossil_media_buffer_free(&fl.path);
+    if (rc != 0) table_free(out);
+    return rc;
+}
+
+fossil_media_config_t *fossil_media_config_new(void) {
+    return (fossil_media_config_t*)calloc(1, sizeof(fossil_media_config_t));
+}
+
+void fossil_media_config_free(fossil_media_config_t *cfg) {
+    if (!cfg) return;
+    for (size_t i = 0; i < cfg->count; ++i) {
+        free(cfg->layers[i].origin);
+        table_free(&cfg->layers[i].table);
+    }
+    free(cfg->layers);
+    free(cfg);
+}
+
+static int add_layer(fossil_media_config_t *cfg, const char *origin, int from_file, const char *text,
+                     fossil_media_config_format_t format) {
+    if (!cfg || !origin || (!from_file && !text)) return -1;
+    if (format == FOSSIL_MEDIA_CONFIG_AUTO && (format = detect_format(origin)) == FOSSIL_MEDIA_CONFIG_AUTO) return -1;
+    if (cfg->count == cfg->cap) {
+        size_t cap = cfg->cap ? cfg->cap * 2 : 4;
+        config_layer_t *layers = (config_layer_t*)realloc(cfg->layers, cap * sizeof(*layers));
+        if (!layers) return -1;
+        cfg->layers = layers;
+        cfg->cap = cap;
+    }
+    config_layer_t *layer = &cfg->layers[cfg->count];
+    layer->from_file = from_file;
+    layer->format = format;
+    if (!(layer->origin = fossil_media_strdup(origin))) return -1;
+    if (layer_parse(layer, text, &layer->table) != 0) {
+        free(layer->origin);
+        return -1;
+    }
+    return (int)cfg->count++;
+}
+
+int fossil_media_config_add_file(fossil_media_config_t *cfg, const char *path, fossil_media_config_format_t format) {
+    return add_layer(cfg, path, 1, NULL, format);
+}
+
+int fossil_media_config_add_string(fossil_media_config_t *cfg, const char *origin, const char *text,
+                                   fossil_media_config_format_t format) {
+    return add_layer(cfg, origin, 0, text, format);
+}
+
+/* Swap in the new contents of one layer only once they parsed */
+static int replace_layer(fossil_media_config_t *cfg, size_t index, const char *text) {
+    config_layer_t *layer = &cfg->layers[index];
+    config_table_t table;
+    if (layer_parse(layer, text, &table) != 0) return -1;
+    table_free(&layer->table);
+    layer->table = table;
+    return 0;
+}
+
+int fossil_media_config_reload(fossil_media_config_t *cfg, size_t layer) {
+    if (!cfg || layer >= cfg->count || !cfg->layers[layer].from_file) return -1;
+    return replace_layer(cfg, layer, NULL);
+}
+
+int fossil_media_config_update(fossil_media_config_t *cfg, size_t layer, const char *text) {
+    if (!cfg || layer >= cfg->count || !text) return -1;
+    return replace_layer(cfg, layer, text);
+}
+
+size_t fossil_media_config_layer_count(const fossil_media_config_t *cfg) {
+    return cfg ? cfg->count : 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Snapshots
+ * ------------------------------------------------------------------------- */
+
+/*
+ * Tables merge key by key, but a scalar or an array replaces the whole value:
+ * `hosts: [z]` over `hosts = ["a", "b", "c"]` must not leave `hosts[1]`
+ * behind. `claimed` holds every scalar and array key of the layers above the
+ * current one, and a key is hidden when it or a prefix ending at '.' or '['
+ * is claimed. `tables` holds the tables of those layers: they hide a lower
+ * scalar or array of the same name, but not the keys a lower table has.
+ */
+typedef struct {
+    config_table_t claimed;
+    config_table_t tables;
+} config_claims_t;
+
+static int claimed_prefix(const config_claims_t *c, const char *key) {
+    if (!c->claimed.count && !c->tables.count) return 0;
+    uint64_t h = CONFIG_FNV_BASIS;
+    int quoted = 0;
+    for (size_t i = 0;; ++i) {
+        if (quoted) {
+            if (key[i] == '\\' && key[i + 1]) h = config_fnv(h, key[i++]);
+            else if (key[i] == '"') quoted = 0;
+        } else if ((key[i] == '\0' || key[i] == '.' || key[i] == '[') && i > 0) {
+            uint64_t m = config_mix(h);
+            if (table_find(&c->claimed, key, i, m)) return 1;
+            if (key[i] != '.' && table_find(&c->tables, key, i, m)) return 1;
+        } else if (key[i] == '"') {
+            quoted = 1;
+        }
+        if (!key[i]) return 0;
+        h = config_fnv(h, key[i]);
+    }
+}
+
+static int claim(config_table_t *claimed, const char *key, size_t len) {
+    fossil_media_config_value_t none;
+    memset(&none, 0, sizeof(none));
+    return table_put(claimed, key, len, config_hash(key, len), &none, "", 0);
+}
+
+/* Claim a key, its arrays (the prefixes before '[') and its tables (the prefixes before '.') */
+static int claim_key(config_claims_t *c, const char *key) {
+    int quoted = 0;
+    size_t i = 0;
+    for (; key[i]; ++i) {
+        if (quoted) {
+            if (key[i] == '\\' && key[i + 1]) ++i;
+            else if (key[i] == '"') quoted = 0;
+        } else if (key[i] == '"') {
+            quoted = 1;
+        } else if (i > 0 && (key[i] == '[' || key[i] == '.')) {
+            if (claim(key[i] == '[' ? &c->claimed : &c->tables, key, i)) return -1;
+        }
+    }
+    return claim(&c->claimed, key, i);
+}
+
+/* Claim a layer's scalars and its empty arrays */
+static int claim_layer(config_claims_t *c, const config_table_t *t) {
+    for (size_t i = 0; i < t->count; ++i) {
+        if (claim_key(c, t->values[i].key)) return -1;
+    }
+    for (size_t i = 0; i < t->cleared_count; ++i) {
+        if (claim_key(c, t->cleared[i])) return -1;
+    }
+    return 0;
+}
+
+static int snapshot_fill(fossil_media_config_snapshot_t *snap, const fossil_media_config_t *cfg) {
+    config_table_t *t = &snap->table;
+    size_t total = 0;
+    for (size_t i = 0; i < cfg->count; ++i) total += cfg->layers[i].table.count;
+    if (table_reserve(t, total)) return -1;
+
+    config_claims_t claims;
+    table_init(&claims.claimed);
+    table_init(&claims.tables);
+    int rc = 0;
+    /* highest precedence first, so the first copy of a key is the winner */
+    for (size_t l = cfg->count; l-- > 0 && rc == 0;) {
+        const config_layer_t *layer = &cfg->layers[l];
+        const char *origin = fossil_media_arena_strndup(&t->arena, layer->origin, strlen(layer->origin));
+        if (!origin) rc = -1;
+        for (size_t i = 0; i < layer->table.count && rc == 0; ++i) {
+            fossil_media_config_value_t v = layer->table.values[i];
+            if (claimed_prefix(&claims, v.key)) continue;
+            v.layer = l;
+            v.origin = origin;
+            rc = table_put(t, v.key, strlen(v.key), layer->table.hashes[i], &v, v.text, strlen(v.text));
+        }
+        if (rc == 0 && l > 0) rc = claim_layer(&claims, &layer->table);
+    }
+    table_free(&claims.claimed);
+    table_free(&claims.tables);
+    return rc;
+}
+
+fossil_media_config_snapshot_t *fossil_media_config_snapshot(const fossil_media_config_t *cfg) {
+    if (!cfg) return NULL;
+    fossil_media_config_snapshot_t *snap = (fossil_media_config_snapshot_t*)malloc(sizeof(*snap));
+    if (!snap) return NULL;
+    table_init(&snap->table);
+    if (snapshot_fill(snap, cfg) != 0) {
+        fossil_media_config_snapshot_free(snap);
+        return NULL;
+    }
+    return snap;
+}
+
+void fossil_media_config_snapshot_free(fossil_media_config_snapshot_t *snap) {
+    if (!snap) return;
+    table_free(&snap->table);
+    free(snap);
+}
+
+const fossil_media_config_value_t *fossil_media_config_lookup(const fossil_media_config_snapshot_t *snap,
+                                                              const char *key) {
+    if (!snap || !key) return NULL;
+    size_t len = strlen(key);
+    return table_find(&snap->table, key, len, config_hash(key, len));
+}
+
+const char *fossil_media_config_get(const fossil_media_config_snapshot_t *snap, const char *key) {
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, key);
+    return v ? v->text : NULL;
+}
+
+static int word_is(const char *s, const char *word) {
+    size_t n = strlen(word);
+    return strlen(s) == n && fossil_media_strncasecmp(s, word, n) == 0;
+}
+
+int fossil_media_config_get_int(const fossil_media_config_snapshot_t *snap, const char *key, int64_t *out) {
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, key);
+    if (!v || !out) return -1;
+    if (v->type == FOSSIL_MEDIA_CONFIG_INTEGER) {
+        *out = v->as.integer;
+        return 0;
+    }
+    if (v->type != FOSSIL_MEDIA_CONFIG_STRING || !*v->text || isspace((unsigned char)*v->text)) return -1;
+    const char *digits = v->text + (*v->text == '+' || *v->text == '-');
+    int base = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X') ? 16 : 10;
+    char *end;
+    errno = 0;
+    long long i = strtoll(v->text, &end, base);
+    if (errno == ERANGE || *end) return -1;
+    *out = (int64_t)i;
+    return 0;
+}
+
+int fossil_media_config_get_double(const fossil_media_config_snapshot_t *snap, const char *key, double *out) {
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, key);
+    if (!v || !out) return -1;
+    if (v->type == FOSSIL_MEDIA_CONFIG_FLOAT) {
+        *out = v->as.floating;
+        return 0;
+    }
+    if (v->type == FOSSIL_MEDIA_CONFIG_INTEGER) {
+        *out = (double)v->as.integer;
+        return 0;
+    }
+    if (v->type != FOSSIL_MEDIA_CONFIG_STRING || !*v->text || isspace((unsigned char)*v->text)) return -1;
+    char *end;
+    double d = strtod(v->text, &end);
+    if (*end) return -1;
+    *out = d;
+    return 0;
+}
+
+int fossil_media_config_get_bool(const fossil_media_config_snapshot_t *snap, const char *key, int *out) {
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, key);
+    if (!v || !out) return -1;
+    if (v->type == FOSSIL_MEDIA_CONFIG_BOOLEAN) {
+        *out = v->as.boolean;
+        return 0;
+    }
+    if (v->type == FOSSIL_MEDIA_CONFIG_INTEGER && (v->as.integer == 0 || v->as.integer == 1)) {
+        *out = (int)v->as.integer;
+        return 0;
+    }
+    if (v->type != FOSSIL_MEDIA_CONFIG_STRING) return -1;
+    const char *s = v->text;
+    if (word_is(s, "true") || word_is(s, "yes") || word_is(s, "on") || strcmp(s, "1") == 0) *out = 1;
+    else if (word_is(s, "false") || word_is(s, "no") || word_is(s, "off") || strcmp(s, "0") == 0) *out = 0;
+    else return -1;
+    return 0;
+}
+
+const char *fossil_media_config_origin(const fossil_media_config_snapshot_t *snap, const char *key) {
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, key);
+    return v ? v->origin : NULL;
+}
+
+size_t fossil_media_config_count(const fossil_media_config_snapshot_t *snap) {
+    return snap ? snap->table.count : 0;
+}
+
+const fossil_media_config_value_t *fossil_media_config_at(const fossil_media_config_snapshot_t *snap, size_t index) {
+    if (!snap || index >= snap->table.count) return NULL;
+    return &snap->table.values[index];
+}
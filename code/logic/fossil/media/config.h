@@ -0,0 +1,440 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_MEDIA_CONFIG_H
+#define FOSSIL_MEDIA_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Format of a configuration layer.
+ */
+typedef enum {
+    FOSSIL_MEDIA_CONFIG_AUTO = 0,   /**< Chosen from the file extension */
+    FOSSIL_MEDIA_CONFIG_INI,
+    FOSSIL_MEDIA_CONFIG_TOML,
+    FOSSIL_MEDIA_CONFIG_YAML,
+    FOSSIL_MEDIA_CONFIG_FSON
+} fossil_media_config_format_t;
+
+/**
+ * @brief Type of a resolved value.
+ *
+ * INI values are always strings; the typed getters convert them on demand.
+ */
+typedef enum {
+    FOSSIL_MEDIA_CONFIG_STRING = 0,
+    FOSSIL_MEDIA_CONFIG_INTEGER,
+    FOSSIL_MEDIA_CONFIG_FLOAT,
+    FOSSIL_MEDIA_CONFIG_BOOLEAN,
+    FOSSIL_MEDIA_CONFIG_NULL
+} fossil_media_config_type_t;
+
+/**
+ * @brief One resolved value of a snapshot.
+ */
+typedef struct fossil_media_config_value_t {
+    const char *key;                    /**< Flattened dotted key */
+    const char *text;                   /**< Value as text */
+    fossil_media_config_type_t type;
+    union {
+        int64_t integer;
+        double floating;
+        int boolean;
+    } as;
+    size_t layer;                       /**< Index of the layer it came from */
+    const char *origin;                 /**< File path (or name) of that layer */
+} fossil_media_config_value_t;
+
+/**
+ * @brief Stack of configuration layers (opaque).
+ */
+typedef struct fossil_media_config fossil_media_config_t;
+
+/**
+ * @brief Immutable, precedence-resolved view of a configuration (opaque).
+ */
+typedef struct fossil_media_config_snapshot fossil_media_config_snapshot_t;
+
+/**
+ * @brief Create an empty layer stack.
+ *
+ * @return New configuration, or NULL on allocation failure. Free with
+ *         fossil_media_config_free().
+ */
+fossil_media_config_t *fossil_media_config_new(void);
+
+/**
+ * @brief Free a layer stack. Snapshots taken from it stay valid.
+ */
+void fossil_media_config_free(fossil_media_config_t *cfg);
+
+/**
+ * @brief Add a layer read from a file.
+ *
+ * Layers added later take precedence, so add defaults first and overrides
+ * last. Every layer is flattened to dotted keys once, when it is added:
+ * INI entries become `section.key` (a dotted section name is a path, as in
+ * TOML), TOML entries use the names of fossil_media_toml_find(), and YAML
+ * and FSON mappings join keys with `.` while sequence items add `[index]`.
+ * Scalars inside TOML arrays are flattened the same way. In every format a
+ * key part that is not a bare TOML key is written as a basic string, so
+ * `server."my key"` is the same key whichever file defines it, and
+ * `"a.b"` differs from `a.b`. Within one layer the first definition of a key
+ * wins. Tables merge across layers key by key, while a scalar or an array
+ * (even an empty one) replaces everything lower layers have under its key,
+ * so a two-item list over a three-item list leaves two items. A table
+ * likewise replaces a lower scalar or array of the same name.
+ *
+ * @param cfg Layer stack.
+ * @param path File to read; recorded as the origin of its values.
+ * @param format Format of the file; FOSSIL_MEDIA_CONFIG_AUTO picks it from
+ *        the extension (.ini/.cfg/.conf, .toml, .yaml/.yml, .fson).
+ * @return Index of the new layer, or -1 on a read or parse error.
+ */
+int fossil_media_config_add_file(fossil_media_config_t *cfg, const char *path,
+                                 fossil_media_config_format_t format);
+
+/**
+ * @brief Add a layer parsed from memory.
+ *
+ * @param cfg Layer stack.
+ * @param origin Name recorded as the origin of its values.
+ * @param text NUL-terminated source text.
+ * @param format Format of the text (FOSSIL_MEDIA_CONFIG_AUTO picks by the
+ *        extension of @p origin).
+ * @return Index of the new layer, or -1 on a parse error.
+ */
+int fossil_media_config_add_string(fossil_media_config_t *cfg, const char *origin, const char *text,
+                                   fossil_media_config_format_t format);
+
+/**
+ * @brief Read the file of one layer again.
+ *
+ * Only this layer is parsed and flattened; the others are reused as they
+ * are. On failure the layer keeps its previous contents.
+ *
+ * @return 0 on success, -1 on error (including layers added from memory).
+ */
+int fossil_media_config_reload(fossil_media_config_t *cfg, size_t layer);
+
+/**
+ * @brief Replace the contents of one layer with new source text.
+ *
+ * Keeps the layer's position, origin and format. On failure the layer
+ * keeps its previous contents.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int fossil_media_config_update(fossil_media_config_t *cfg, size_t layer, const char *text);
+
+/**
+ * @brief Number of layers in the stack.
+ */
+size_t fossil_media_config_layer_count(const fossil_media_config_t *cfg);
+
+/**
+ * @brief Resolve the layers into a new snapshot.
+ *
+ * Merges the flattened layers from the highest precedence down into one
+ * hash index; no source is parsed again. The snapshot owns copies of every
+ * key, value and origin, so it is unaffected by later changes to the stack
+ * or by freeing it, and any number of threads may read it at once.
+ *
+ * @return New snapshot, or NULL on allocation failure. Free with
+ *         fossil_media_config_snapshot_free().
+ */
+fossil_media_config_snapshot_t *fossil_media_config_snapshot(const fossil_media_config_t *cfg);
+
+/**
+ * @brief Free a snapshot.
+ */
+void fossil_media_config_snapshot_free(fossil_media_config_snapshot_t *snap);
+
+/**
+ * @brief Look up a resolved value.
+ *
+ * @param snap Snapshot.
+ * @param key Flattened dotted key, e.g. `server.port` or `hosts[1].name`.
+ * @return Value, or NULL if no layer defines the key.
+ */
+const fossil_media_config_value_t *fossil_media_config_lookup(const fossil_media_config_snapshot_t *snap,
+                                                              const char *key);
+
+/**
+ * @brief Get the text of a value.
+ *
+ * @return Value text, or NULL if not found.
+ */
+const char *fossil_media_config_get(const fossil_media_config_snapshot_t *snap, const char *key);
+
+/**
+ * @brief Get an integer; strings are accepted in decimal or hex (`0x`).
+ *
+ * @return 0 on success, -1 if missing or not an integer.
+ */
+int fossil_media_config_get_int(const fossil_media_config_snapshot_t *snap, const char *key, int64_t *out);
+
+/**
+ * @brief Get a floating-point number; integers are converted.
+ *
+ * @return 0 on success, -1 if missing or not a number.
+ */
+int fossil_media_config_get_double(const fossil_media_config_snapshot_t *snap, const char *key, double *out);
+
+/**
+ * @brief Get a boolean; strings accept true/false, yes/no, on/off and 1/0.
+ *
+ * @return 0 on success, -1 if missing or not a boolean.
+ */
+int fossil_media_config_get_bool(const fossil_media_config_snapshot_t *snap, const char *key, int *out);
+
+/**
+ * @brief Origin of the layer that supplied a value.
+ *
+ * @return File path (or name given to fossil_media_config_add_string()),
+ *         or NULL if not found.
+ */
+const char *fossil_media_config_origin(const fossil_media_config_snapshot_t *snap, const char *key);
+
+/**
+ * @brief Number of resolved values in a snapshot.
+ */
+size_t fossil_media_config_count(const fossil_media_config_snapshot_t *snap);
+
+/**
+ * @brief Resolved value by position; values of the highest-precedence
+ *        layer come first, each layer in document order.
+ *
+ * @return Value, or NULL if @p index is out of range.
+ */
+const fossil_media_config_value_t *fossil_media_config_at(const fossil_media_config_snapshot_t *snap, size_t index);
+
+#ifdef __cplusplus
+}
+#include <string>
+#include <stdexcept>
+#include <utility>
+
+namespace fossil {
+
+    namespace media {
+
+        /**
+         * @brief Immutable resolved configuration.
+         */
+        class ConfigSnapshot {
+        public:
+            explicit ConfigSnapshot(fossil_media_config_snapshot_t* snap) : snap_(snap) {
+                if (!snap_) {
+                    throw std::runtime_error("Failed to build config snapshot");
+                }
+            }
+
+            ~ConfigSnapshot() {
+                fossil_media_config_snapshot_free(snap_);
+            }
+
+            ConfigSnapshot(const ConfigSnapshot&) = delete;
+            ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+
+            ConfigSnapshot(ConfigSnapshot&& other) noexcept : snap_(other.snap_) {
+                other.snap_ = nullptr;
+            }
+            ConfigSnapshot& operator=(ConfigSnapshot&& other) noexcept {
+                if (this != &other) {
+                    fossil_media_config_snapshot_free(snap_);
+                    snap_ = other.snap_;
+                    other.snap_ = nullptr;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Whether any layer defines the key.
+             */
+            bool contains(const std::string& key) const {
+                return fossil_media_config_lookup(snap_, key.c_str()) != nullptr;
+            }
+
+            /**
+             * @brief Value text, or `fallback` if not found.
+             */
+            std::string get(const std::string& key, const std::string& fallback = std::string()) const {
+                const char* val = fossil_media_config_get(snap_, key.c_str());
+                return val ? std::string(val) : fallback;
+            }
+
+            /**
+             * @brief Get an integer value.
+             * @param fallback Returned when the key is missing or not an integer.
+             */
+            int64_t get_int(const std::string& key, int64_t fallback = 0) const {
+                int64_t out;
+                return fossil_media_config_get_int(snap_, key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Get a floating-point value.
+             */
+            double get_double(const std::string& key, double fallback = 0.0) const {
+                double out;
+                return fossil_media_config_get_double(snap_, key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Get a boolean value.
+             */
+            bool get_bool(const std::string& key, bool fallback = false) const {
+                int out;
+                return fossil_media_config_get_bool(snap_, key.c_str(), &out) == 0 ? out != 0 : fallback;
+            }
+
+            /**
+             * @brief Origin of the layer that supplied a value, or empty if not found.
+             */
+            std::string origin(const std::string& key) const {
+                const char* val = fossil_media_config_origin(snap_, key.c_str());
+                return val ? std::string(val) : std::string();
+            }
+
+            /**
+             * @brief Number of resolved values.
+             */
+            size_t size() const { return fossil_media_config_count(snap_); }
+
+            /**
+             * @brief Access the underlying snapshot.
+             */
+            const fossil_media_config_snapshot_t* get() const { return snap_; }
+
+        private:
+            fossil_media_config_snapshot_t* snap_;
+        };
+
+        /**
+         * @brief Stack of configuration layers, lowest precedence first.
+         */
+        class Config {
+        public:
+            /**
+             * @throw std::runtime_error on allocation failure
+             */
+            Config() : cfg_(::fossil_media_config_new()) {
+                if (!cfg_) {
+                    throw std::runtime_error("Failed to create config");
+                }
+            }
+
+            ~Config() {
+                fossil_media_config_free(cfg_);
+            }
+
+            Config(const Config&) = delete;
+            Config& operator=(const Config&) = delete;
+
+            Config(Config&& other) noexcept : cfg_(other.cfg_) {
+                other.cfg_ = nullptr;
+            }
+            Config& operator=(Config&& other) noexcept {
+                if (this != &other) {
+                    fossil_media_config_free(cfg_);
+                    cfg_ = other.cfg_;
+                    other.cfg_ = nullptr;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Add a layer read from a file.
+             * @return Index of the new layer.
+             * @throw std::runtime_error on a read or parse error
+             */
+            size_t add_file(const std::string& path, fossil_media_config_format_t format = FOSSIL_MEDIA_CONFIG_AUTO) {
+                int layer = fossil_media_config_add_file(cfg_, path.c_str(), format);
+                if (layer < 0) {
+                    throw std::runtime_error("Failed to load config layer: " + path);
+                }
+                return (size_t)layer;
+            }
+
+            /**
+             * @brief Add a layer parsed from memory.
+             * @return Index of the new layer.
+             * @throw std::runtime_error on a parse error
+             */
+            size_t add_string(const std::string& origin, const std::string& text, fossil_media_config_format_t format) {
+                int layer = fossil_media_config_add_string(cfg_, origin.c_str(), text.c_str(), format);
+                if (layer < 0) {
+                    throw std::runtime_error("Failed to parse config layer: " + origin);
+                }
+                return (size_t)layer;
+            }
+
+            /**
+             * @brief Read the file of one layer again.
+             * @return true on success; the layer is unchanged on failure.
+             */
+            bool reload(size_t layer) {
+                return fossil_media_config_reload(cfg_, layer) == 0;
+            }
+
+            /**
+             * @brief Replace the contents of one layer.
+             * @return true on success; the layer is unchanged on failure.
+             */
+            bool update(size_t layer, const std::string& text) {
+                return fossil_media_config_update(cfg_, layer, text.c_str()) == 0;
+            }
+
+            /**
+             * @brief Resolve the layers into a snapshot.
+             * @throw std::runtime_error on allocation failure
+             */
+            ConfigSnapshot snapshot() const {
+                return ConfigSnapshot(fossil_media_config_snapshot(cfg_));
+            }
+
+            /**
+             * @brief Access the underlying layer stack.
+             */
+            fossil_media_config_t* get() const { return cfg_; }
+
+        private:
+            fossil_media_config_t* cfg_;
+        };
+
+    } // namespace media
+
+} // namespace fossil
+
+#endif
+
+#endif /* FOSSIL_MEDIA_CONFIG_H */
@@ -32,9 +32,11 @@
 #include "html.h"
 #include "yaml.h"
 #include "toml.h"
+#include "utf8.h"
 #include "text.h"
 #include "ini.h"
 #include "xml.h"
 #include "csv.h"
+#include "config.h"
 
 #endif /* FOSSIL_MEDIA_FRAMEWORK_H */
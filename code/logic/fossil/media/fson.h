@@ -186,6 +186,22 @@ struct fossil_media_fson_value {
  */
 fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil_media_fson_error_t *err_out);
 
+/**
+ * @brief Parse FSON text keeping every object as an object.
+ *
+ * fossil_media_fson_parse() returns the value of an object with a single
+ * key in place of the object (and `{ null: null }` as null), at every
+ * level. This variant keeps the tree exactly as written, so each value
+ * stays reachable under its key; an empty object is an empty object.
+ *
+ * @param json_text  Input FSON text (must be valid UTF-8 and NUL-terminated).
+ * @param err_out    Optional pointer to a fossil_media_fson_error_t to store error details.
+ * @return Pointer to the parsed FSON value on success, or NULL on failure.
+ *
+ * @note The returned value must be freed with fossil_media_fson_free().
+ */
+fossil_media_fson_value_t *fossil_media_fson_parse_tree(const char *json_text, fossil_media_fson_error_t *err_out);
+
 /**
  * @brief Free a FSON DOM tree.
  *
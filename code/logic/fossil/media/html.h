@@ -28,6 +28,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "media.h"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -86,6 +88,42 @@ int fossil_media_html_load_file(const char *path, fossil_media_html_doc_t **out_
  */
 int fossil_media_html_load_string(const char *data, fossil_media_html_doc_t **out_doc);
 
+/**
+ * @brief Options for fossil_media_html_parse_batch().
+ */
+typedef struct fossil_media_html_batch_options {
+    size_t threads;   /**< Worker threads, 0 for one per online CPU */
+    size_t max_steps; /**< Per-document parse budget in input bytes, 0 for the default */
+} fossil_media_html_batch_options_t;
+
+/**
+ * @brief Outcome of one document in a batch.
+ */
+typedef struct fossil_media_html_batch_result {
+    fossil_media_html_doc_t *doc; /**< Parsed document (caller frees), or NULL on failure */
+    int status;                   /**< FOSSIL_MEDIA_HTML_OK or a negative error code */
+} fossil_media_html_batch_result_t;
+
+/**
+ * @brief Parse many independent documents on a pool of worker threads.
+ *
+ * Documents are handed out one at a time to a fixed set of workers, each of
+ * which keeps its tokenizer scratch across the documents it parses. Every
+ * resulting document owns its memory and is freed with fossil_media_html_free()
+ * as usual.
+ *
+ * @param inputs Null-terminated HTML strings (a NULL entry fails with
+ *               FOSSIL_MEDIA_HTML_ERR_INVALID_ARG).
+ * @param n Number of inputs.
+ * @param options Worker count and parse budget, or NULL for defaults.
+ * @param outputs Array of `n` results, filled in input order.
+ * @return Number of documents that failed to parse, or a negative error code
+ *         if the batch could not run.
+ */
+int fossil_media_html_parse_batch(const char *const *inputs, size_t n,
+                                  const fossil_media_html_batch_options_t *options,
+                                  fossil_media_html_batch_result_t *outputs);
+
 /**
  * @brief Free an HTML document and all associated nodes.
  * 
@@ -207,21 +245,460 @@ int fossil_media_html_set_attr(fossil_media_html_node_t *node, const char *attr_
  * 
  * Converts the HTML document tree into a string representation. The returned
  * string is dynamically allocated and must be freed by the caller using free().
+ * Every node type is written with its attributes; text and attribute values
+ * are escaped (except inside `script`/`style`) and void elements such as
+ * `br` get no end tag. The output is sized exactly by a measuring pass.
  * 
  * @param doc Pointer to the HTML document to serialize.
  * @return Pointer to the serialized HTML string, or NULL on failure.
  */
 char* fossil_media_html_serialize(const fossil_media_html_doc_t *doc);
 
+/**
+ * @brief Stream the serialized document to a sink.
+ *
+ * Output is staged in a small fixed buffer, so memory use does not depend
+ * on document size.
+ *
+ * @param doc Document to serialize.
+ * @param sink Output callback.
+ * @param user Opaque pointer passed to the sink.
+ * @return FOSSIL_MEDIA_HTML_OK on success, FOSSIL_MEDIA_HTML_ERR_IO if the
+ *         sink failed, negative error code on other failures.
+ */
+int fossil_media_html_serialize_to(const fossil_media_html_doc_t *doc, fossil_media_sink_fn sink, void *user);
+
+/**
+ * @brief Serialize into a caller-provided buffer.
+ *
+ * With `buf` NULL only the measuring pass runs and `*out_len` receives the
+ * length the output needs (excluding the terminator).
+ *
+ * @param doc Document to serialize.
+ * @param buf Destination buffer, or NULL to measure.
+ * @param cap Size of `buf`; must exceed the output length.
+ * @param out_len Optional pointer to receive the output length.
+ * @return FOSSIL_MEDIA_HTML_OK on success, FOSSIL_MEDIA_HTML_ERR_NOMEM if
+ *         `buf` is too small (nothing is written), negative error code on
+ *         other failures.
+ */
+int fossil_media_html_serialize_buffer(const fossil_media_html_doc_t *doc, char *buf, size_t cap, size_t *out_len);
+
+/* ---------------------------------------------------------------------------
+ * CSS selectors
+ * ------------------------------------------------------------------------- */
+
+/* Compiled selector (opaque) */
+typedef struct fossil_media_html_selector fossil_media_html_selector_t;
+
+/**
+ * @brief Growable list of nodes returned by fossil_media_html_select().
+ *
+ * Initialize with all fields zeroed and release with
+ * fossil_media_html_node_list_free(). Nodes are borrowed from the document.
+ */
+typedef struct fossil_media_html_node_list {
+    fossil_media_html_node_t **nodes;
+    size_t count;
+    size_t capacity;
+} fossil_media_html_node_list_t;
+
+/**
+ * @brief Streaming iterator over the matches of a selector.
+ *
+ * Filled in by fossil_media_html_select_all() and advanced with
+ * fossil_media_html_select_next(). It holds no heap memory, so it can live
+ * on the stack and needs no cleanup.
+ */
+typedef struct fossil_media_html_select_iter {
+    fossil_media_html_doc_t *doc;
+    const fossil_media_html_selector_t *sel;
+    fossil_media_html_node_t *const *candidates; /**< index bucket being scanned */
+    size_t candidate_count;
+    size_t pos;
+} fossil_media_html_select_iter_t;
+
+/**
+ * @brief Compile a CSS selector for repeated use.
+ *
+ * Supported subset: type (`div`), universal (`*`), `#id`, `.class`,
+ * attribute tests (`[a]`, `[a=v]`, `[a~=v]`, `[a|=v]`, `[a^=v]`, `[a$=v]`,
+ * `[a*=v]`), `:nth-child(an+b|odd|even)`, `:first-child`, the descendant
+ * (whitespace) and child (`>`) combinators, and comma-separated groups.
+ *
+ * @param css Null-terminated selector text.
+ * @param out_sel Pointer to receive the compiled selector.
+ * @return FOSSIL_MEDIA_HTML_OK on success, FOSSIL_MEDIA_HTML_ERR_PARSE on
+ *         invalid syntax, negative error code on other failures.
+ */
+int fossil_media_html_selector_compile(const char *css, fossil_media_html_selector_t **out_sel);
+
+/**
+ * @brief Free a compiled selector.
+ *
+ * @param sel Selector to free (may be NULL).
+ */
+void fossil_media_html_selector_free(fossil_media_html_selector_t *sel);
+
+/**
+ * @brief Append every element matching `sel` to `results` in document order.
+ *
+ * The first call on a document builds id, class and tag indexes which are
+ * reused by later queries. Setting an `id` or `class` attribute with
+ * fossil_media_html_set_attr() invalidates them.
+ *
+ * @param doc Document to query.
+ * @param sel Compiled selector.
+ * @param results List to append matches to.
+ * @return Number of matches (>= 0), or a negative error code.
+ */
+int fossil_media_html_select(fossil_media_html_doc_t *doc,
+                             const fossil_media_html_selector_t *sel,
+                             fossil_media_html_node_list_t *results);
+
+/**
+ * @brief Return the first element matching `sel` in document order.
+ *
+ * @param doc Document to query.
+ * @param sel Compiled selector.
+ * @return Matching node, or NULL if none.
+ */
+fossil_media_html_node_t* fossil_media_html_select_first(fossil_media_html_doc_t *doc,
+                                                         const fossil_media_html_selector_t *sel);
+
+/**
+ * @brief Start a streaming iteration over all matches of `sel`.
+ *
+ * Matches are produced lazily by fossil_media_html_select_next(). The
+ * document must not be modified while iterating.
+ *
+ * @param doc Document to query.
+ * @param sel Compiled selector.
+ * @param it Iterator to initialize.
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_select_all(fossil_media_html_doc_t *doc,
+                                 const fossil_media_html_selector_t *sel,
+                                 fossil_media_html_select_iter_t *it);
+
+/**
+ * @brief Advance a selector iterator.
+ *
+ * @param it Iterator initialized by fossil_media_html_select_all().
+ * @return Next matching node, or NULL when exhausted.
+ */
+fossil_media_html_node_t* fossil_media_html_select_next(fossil_media_html_select_iter_t *it);
+
+/**
+ * @brief Release the storage of a node list (not the nodes themselves).
+ *
+ * @param list List to reset.
+ */
+void fossil_media_html_node_list_free(fossil_media_html_node_list_t *list);
+
+/* ---------------------------------------------------------------------------
+ * Streaming rewriter
+ * ------------------------------------------------------------------------- */
+
+/* Streaming rewriter and the handles it passes to handlers (opaque) */
+typedef struct fossil_media_html_rewriter fossil_media_html_rewriter_t;
+typedef struct fossil_media_html_element fossil_media_html_element_t;
+typedef struct fossil_media_html_text_chunk fossil_media_html_text_chunk_t;
+
+/**
+ * @brief Called for every start tag matching the handler's selector.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK to continue, or a negative code to abort
+ *         rewriting (returned from fossil_media_html_rewriter_write()).
+ */
+typedef int (*fossil_media_html_element_fn)(fossil_media_html_element_t *el, void *user);
+
+/**
+ * @brief Called for text whose innermost enclosing element matches the
+ *        handler's selector. Text runs longer than 32 KiB may be delivered
+ *        in several chunks.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK to continue, or a negative code to abort.
+ */
+typedef int (*fossil_media_html_text_fn)(fossil_media_html_text_chunk_t *chunk, void *user);
+
+/**
+ * @brief Create a streaming rewriter.
+ *
+ * The rewriter tokenizes input as it arrives and writes the (possibly
+ * modified) markup to `sink` in bounded chunks. Unmodified markup is copied
+ * byte for byte. Memory use depends on element nesting depth and the size
+ * of the largest single tag, not on document size.
+ *
+ * @param sink Output callback.
+ * @param user Opaque pointer passed to `sink`.
+ * @param out_rw Pointer to receive the rewriter.
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_rewriter_new(fossil_media_sink_fn sink, void *user, fossil_media_html_rewriter_t **out_rw);
+
+/**
+ * @brief Register an element handler for a selector.
+ *
+ * Handlers run in registration order. Must be called before the first write.
+ *
+ * @param rw Rewriter.
+ * @param selector CSS selector (see fossil_media_html_selector_compile()).
+ * @param fn Handler.
+ * @param user Opaque pointer passed to `fn`.
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_rewriter_on_element(fossil_media_html_rewriter_t *rw, const char *selector,
+                                          fossil_media_html_element_fn fn, void *user);
+
+/**
+ * @brief Register a text handler for a selector (at most 64 per rewriter).
+ *
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_rewriter_on_text(fossil_media_html_rewriter_t *rw, const char *selector,
+                                       fossil_media_html_text_fn fn, void *user);
+
+/**
+ * @brief Feed the next chunk of input. Chunks may split tokens anywhere.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_rewriter_write(fossil_media_html_rewriter_t *rw, const char *data, size_t len);
+
+/**
+ * @brief Signal end of input and flush all pending output.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_rewriter_end(fossil_media_html_rewriter_t *rw);
+
+/**
+ * @brief Free a rewriter and its handlers.
+ */
+void fossil_media_html_rewriter_free(fossil_media_html_rewriter_t *rw);
+
+/** @brief Tag name of the element as written in the source. */
+const char* fossil_media_html_element_tag(const fossil_media_html_element_t *el);
+
+/** @brief Attribute value (case-insensitive name), or NULL if absent. */
+const char* fossil_media_html_element_get_attr(const fossil_media_html_element_t *el, const char *name);
+
+/**
+ * @brief Set or add an attribute. The value is escaped on output.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_element_set_attr(fossil_media_html_element_t *el, const char *name, const char *value);
+
+/**
+ * @brief Remove an attribute.
+ *
+ * @return FOSSIL_MEDIA_HTML_OK, or FOSSIL_MEDIA_HTML_ERR_NOT_FOUND.
+ */
+int fossil_media_html_element_remove_attr(fossil_media_html_element_t *el, const char *name);
+
+/** @brief Drop the element together with everything inside it. */
+void fossil_media_html_element_remove(fossil_media_html_element_t *el);
+
+/** @brief Drop the element's start and end tags but keep its content. */
+void fossil_media_html_element_unwrap(fossil_media_html_element_t *el);
+
+/**
+ * @brief Text of a chunk (not null-terminated).
+ *
+ * @param chunk Chunk passed to the handler.
+ * @param out_len Receives the length in bytes.
+ * @return Pointer to the text.
+ */
+const char* fossil_media_html_text_chunk_data(const fossil_media_html_text_chunk_t *chunk, size_t *out_len);
+
+/**
+ * @brief Replace the chunk with `text`, written verbatim (not escaped).
+ *
+ * `text` must stay valid until the handler returns.
+ */
+void fossil_media_html_text_chunk_replace(fossil_media_html_text_chunk_t *chunk, const char *text);
+
+/** @brief Drop the chunk from the output. */
+void fossil_media_html_text_chunk_remove(fossil_media_html_text_chunk_t *chunk);
+
+/* ---------------------------------------------------------------------------
+ * Text extraction
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief Extract the visible text of an HTML page without building a DOM.
+ *
+ * Tags are skipped, `script`/`style` bodies and comments are dropped,
+ * character references (named and numeric) are decoded to UTF-8, and runs of
+ * whitespace are collapsed into single spaces. Block-level tags act as word
+ * breaks; inline tags such as `b` or `span` do not. Leading and trailing
+ * whitespace is not emitted.
+ *
+ * @param html Input markup (need not be null-terminated).
+ * @param len Length of `html` in bytes.
+ * @param out_text Pointer to receive the null-terminated text. Caller must free().
+ * @param out_len Optional pointer to receive the text length.
+ * @return FOSSIL_MEDIA_HTML_OK on success, negative error code on failure.
+ */
+int fossil_media_html_extract_text(const char *html, size_t len, char **out_text, size_t *out_len);
+
 #ifdef __cplusplus
 }
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include <functional>
+#include <memory>
 
 namespace fossil {
 
     namespace media {
 
+        /**
+         * @brief C++ wrapper for a compiled CSS selector.
+         *
+         * Compile once and pass to Html::select() for every page.
+         */
+        class HtmlSelector {
+        public:
+            /**
+             * @brief Compile a selector (throws on invalid syntax).
+             *
+             * @param css Selector text.
+             */
+            explicit HtmlSelector(const std::string &css) : sel_(nullptr) {
+                if (fossil_media_html_selector_compile(css.c_str(), &sel_) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlSelector: invalid selector");
+            }
+
+            /**
+             * @brief Destructor frees the compiled selector.
+             */
+            ~HtmlSelector() {
+                fossil_media_html_selector_free(sel_);
+            }
+
+            HtmlSelector(HtmlSelector &&other) noexcept : sel_(other.sel_) {
+                other.sel_ = nullptr;
+            }
+
+            HtmlSelector& operator=(HtmlSelector &&other) noexcept {
+                if (this != &other) {
+                    fossil_media_html_selector_free(sel_);
+                    sel_ = other.sel_;
+                    other.sel_ = nullptr;
+                }
+                return *this;
+            }
+
+            HtmlSelector(const HtmlSelector&) = delete;
+            HtmlSelector& operator=(const HtmlSelector&) = delete;
+
+            /**
+             * @brief Access the underlying compiled selector.
+             */
+            const fossil_media_html_selector_t* get() const noexcept {
+                return sel_;
+            }
+
+        private:
+            fossil_media_html_selector_t *sel_;
+        };
+
+        /**
+         * @brief C++ wrapper for the streaming HTML rewriter.
+         *
+         * Handlers are std::function objects; an exception thrown by a handler
+         * aborts rewriting and is reported as std::runtime_error by write()/end().
+         */
+        class HtmlRewriter {
+        public:
+            using Sink = std::function<void(const char *data, size_t len)>;
+            using ElementHandler = std::function<void(fossil_media_html_element_t *el)>;
+            using TextHandler = std::function<void(fossil_media_html_text_chunk_t *chunk)>;
+
+            /**
+             * @brief Create a rewriter writing its output to `sink`.
+             */
+            explicit HtmlRewriter(Sink sink) : rw_(nullptr), sink_(new Sink(std::move(sink))) {
+                if (fossil_media_html_rewriter_new(&HtmlRewriter::sink_thunk, sink_.get(), &rw_) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlRewriter: failed to create rewriter");
+            }
+
+            ~HtmlRewriter() {
+                fossil_media_html_rewriter_free(rw_);
+            }
+
+            HtmlRewriter(const HtmlRewriter&) = delete;
+            HtmlRewriter& operator=(const HtmlRewriter&) = delete;
+
+            /**
+             * @brief Register an element handler for a selector.
+             */
+            void on_element(const std::string &selector, ElementHandler fn) {
+                element_handlers_.emplace_back(new ElementHandler(std::move(fn)));
+                if (fossil_media_html_rewriter_on_element(rw_, selector.c_str(), &HtmlRewriter::element_thunk,
+                                                          element_handlers_.back().get()) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlRewriter: invalid element handler");
+            }
+
+            /**
+             * @brief Register a text handler for a selector.
+             */
+            void on_text(const std::string &selector, TextHandler fn) {
+                text_handlers_.emplace_back(new TextHandler(std::move(fn)));
+                if (fossil_media_html_rewriter_on_text(rw_, selector.c_str(), &HtmlRewriter::text_thunk,
+                                                       text_handlers_.back().get()) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlRewriter: invalid text handler");
+            }
+
+            /**
+             * @brief Feed the next chunk of input.
+             */
+            void write(const char *data, size_t len) {
+                if (fossil_media_html_rewriter_write(rw_, data, len) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlRewriter: rewrite failed");
+            }
+
+            /**
+             * @brief Feed the next chunk of input.
+             */
+            void write(const std::string &chunk) {
+                write(chunk.data(), chunk.size());
+            }
+
+            /**
+             * @brief Finish the input and flush the output.
+             */
+            void end() {
+                if (fossil_media_html_rewriter_end(rw_) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("HtmlRewriter: rewrite failed");
+            }
+
+        private:
+            static int sink_thunk(void *user, const char *data, size_t len) {
+                try { (*static_cast<Sink*>(user))(data, len); } catch (...) { return -1; }
+                return 0;
+            }
+
+            static int element_thunk(fossil_media_html_element_t *el, void *user) {
+                try { (*static_cast<ElementHandler*>(user))(el); } catch (...) { return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG; }
+                return FOSSIL_MEDIA_HTML_OK;
+            }
+
+            static int text_thunk(fossil_media_html_text_chunk_t *chunk, void *user) {
+                try { (*static_cast<TextHandler*>(user))(chunk); } catch (...) { return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG; }
+                return FOSSIL_MEDIA_HTML_OK;
+            }
+
+            fossil_media_html_rewriter_t *rw_;
+            std::unique_ptr<Sink> sink_;
+            std::vector<std::unique_ptr<ElementHandler>> element_handlers_;
+            std::vector<std::unique_ptr<TextHandler>> text_handlers_;
+        };
+
         /**
          * @brief C++ wrapper for Fossil HTML document.
          *
@@ -267,6 +744,29 @@ namespace fossil {
                 return h;
             }
 
+            /**
+             * @brief Parse many documents in parallel.
+             *
+             * Documents that fail to parse come back as invalid Html objects
+             * (see is_valid()).
+             *
+             * @param inputs HTML content strings.
+             * @param threads Worker threads, 0 for one per online CPU.
+             * @return One Html per input, in input order.
+             */
+            static std::vector<Html> parse_batch(const std::vector<std::string> &inputs, size_t threads = 0) {
+                std::vector<const char*> ptrs;
+                ptrs.reserve(inputs.size());
+                for (const std::string &in : inputs) ptrs.push_back(in.c_str());
+                std::vector<fossil_media_html_batch_result_t> results(inputs.size());
+                fossil_media_html_batch_options_t opts = { threads, 0 };
+                if (fossil_media_html_parse_batch(ptrs.data(), ptrs.size(), &opts, results.data()) < 0)
+                    throw std::runtime_error("Html: batch parse failed");
+                std::vector<Html> docs(inputs.size());
+                for (size_t i = 0; i < results.size(); ++i) docs[i].doc_ = results[i].doc;
+                return docs;
+            }
+
             /**
              * @brief Destructor frees underlying document.
              *
@@ -344,6 +844,59 @@ namespace fossil {
                 return out;
             }
 
+            /**
+             * @brief Stream the serialized document to `sink`.
+             *
+             * @param sink Receives the output in pieces.
+             */
+            void serialize(const HtmlRewriter::Sink &sink) const {
+                if (fossil_media_html_serialize_to(doc_, &Html::sink_thunk, const_cast<HtmlRewriter::Sink*>(&sink)) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("Html: failed to serialize");
+            }
+
+            /**
+             * @brief Collect every element matching a compiled selector.
+             *
+             * @param sel Compiled selector.
+             * @return Matching nodes in document order.
+             */
+            std::vector<fossil_media_html_node_t*> select(const HtmlSelector &sel) {
+                fossil_media_html_node_list_t list = {nullptr, 0, 0};
+                if (fossil_media_html_select(doc_, sel.get(), &list) < 0) {
+                    fossil_media_html_node_list_free(&list);
+                    throw std::runtime_error("Html: select failed");
+                }
+                std::vector<fossil_media_html_node_t*> out(list.nodes, list.nodes + list.count);
+                fossil_media_html_node_list_free(&list);
+                return out;
+            }
+
+            /**
+             * @brief Compile `css` and collect every matching element.
+             *
+             * @param css Selector text.
+             * @return Matching nodes in document order.
+             */
+            std::vector<fossil_media_html_node_t*> select(const std::string &css) {
+                return select(HtmlSelector(css));
+            }
+
+            /**
+             * @brief Extract the visible text of `html` without parsing a document.
+             *
+             * @param html HTML content string.
+             * @return Whitespace-collapsed text with entities decoded.
+             */
+            static std::string extract_text(const std::string &html) {
+                char *buf = nullptr;
+                size_t len = 0;
+                if (fossil_media_html_extract_text(html.data(), html.size(), &buf, &len) != FOSSIL_MEDIA_HTML_OK)
+                    throw std::runtime_error("Html: failed to extract text");
+                std::string out(buf, len);
+                free(buf);
+                return out;
+            }
+
             /**
              * @brief Check if document is valid.
              *
@@ -384,6 +937,11 @@ namespace fossil {
             }
 
         private:
+            static int sink_thunk(void *user, const char *data, size_t len) {
+                try { (*static_cast<HtmlRewriter::Sink*>(user))(data, len); } catch (...) { return -1; }
+                return 0;
+            }
+
             /**
              * @brief Pointer to the underlying Fossil HTML document.
              */
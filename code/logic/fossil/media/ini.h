@@ -50,17 +50,27 @@ typedef struct fossil_media_ini_section_t {
     size_t entry_count;
 } fossil_media_ini_section_t;
 
+/**
+ * @brief Storage of a loaded INI file (opaque).
+ */
+typedef struct fossil_media_ini_doc fossil_media_ini_doc_t;
+
 /**
  * @brief Represents a loaded INI file.
  */
 typedef struct fossil_media_ini_t {
     fossil_media_ini_section_t *sections;
     size_t section_count;
+    fossil_media_ini_doc_t *doc;  /**< Owns all strings and arrays (NULL if built by hand) */
 } fossil_media_ini_t;
 
 /**
  * @brief Load an INI file from disk.
  *
+ * The file is memory-mapped and scanned in place; see
+ * fossil_media_ini_load_buffer(). The document holds the mapping until it
+ * is freed, or until the first set or save copies the text out of it.
+ *
  * @param path Path to the .ini file.
  * @param ini Output structure pointer.
  * @return 0 on success, nonzero on failure.
@@ -70,15 +80,47 @@ int fossil_media_ini_load_file(const char *path, fossil_media_ini_t *ini);
 /**
  * @brief Load an INI file from a string buffer.
  *
+ * Same as fossil_media_ini_load_buffer(), so @p data is borrowed as well.
+ *
  * @param data INI data as null-terminated string.
  * @param ini Output structure pointer.
  * @return 0 on success, nonzero on failure.
  */
 int fossil_media_ini_load_string(const char *data, fossil_media_ini_t *ini);
 
+/**
+ * @brief Load INI data of a given length (need not be null-terminated).
+ *
+ * Lines are found with memchr and trimmed in place; each section name, key
+ * and value is copied once into an arena owned by the document, so loading
+ * costs a handful of allocations regardless of size. The text itself is
+ * not copied: the document refers to @p data for saving later, so it must
+ * stay valid and unchanged until the document is freed or until the first
+ * fossil_media_ini_set() or fossil_media_ini_save_file(), which copy it.
+ *
+ * @param data INI data.
+ * @param len Length of data in bytes.
+ * @param ini Output structure pointer.
+ * @return 0 on success, nonzero on failure.
+ */
+int fossil_media_ini_load_buffer(const char *data, size_t len, fossil_media_ini_t *ini);
+
 /**
  * @brief Save an INI structure to disk.
  *
+ * A loaded document is written back as its original text with only the
+ * changes made through fossil_media_ini_set() patched in: changed values
+ * are replaced in place, keeping comments and spacing on the line, new keys
+ * go on their own line after the last line of their section, and new
+ * sections are appended. Other documents are written in the plain
+ * `[section]` / `key=value` layout. Values with surrounding whitespace,
+ * leading quotes or newlines are quoted; `;` and `#` always start a comment
+ * when the file is read, so values containing them do not round-trip.
+ *
+ * The data goes to a temporary file in the same directory (one writev on
+ * POSIX) that then replaces `path` by rename, so the target is never seen
+ * half written.
+ *
  * @param path Path to output file.
  * @param ini INI data structure.
  * @return 0 on success, nonzero on failure.
@@ -93,6 +135,9 @@ void fossil_media_ini_free(fossil_media_ini_t *ini);
 /**
  * @brief Get the value for a given section/key.
  *
+ * Loaded documents answer with two hash probes (section, then key);
+ * hand-built ones are searched linearly.
+ *
  * @param ini INI data structure.
  * @param section Section name.
  * @param key Key name.
@@ -100,10 +145,63 @@ void fossil_media_ini_free(fossil_media_ini_t *ini);
  */
 const char *fossil_media_ini_get(const fossil_media_ini_t *ini, const char *section, const char *key);
 
+/**
+ * @brief Get an integer value (decimal, or hex with `0x`).
+ *
+ * The typed getters convert a value on first use and cache the result, or
+ * the failure, next to the entry, so later reads of the same key as the
+ * same type cost only the lookup. Values changed through
+ * fossil_media_ini_set() are converted again; editing `entry->value` in
+ * place is not noticed. The cache is filled without locking: when several
+ * threads read one document, make the first typed read of each key before
+ * sharing it.
+ *
+ * @return 0 on success, -1 if the key is missing or not an integer.
+ */
+int fossil_media_ini_get_int(const fossil_media_ini_t *ini, const char *section, const char *key, int64_t *out);
+
+/**
+ * @brief Get a floating-point value.
+ *
+ * @return 0 on success, -1 if the key is missing or not a number.
+ */
+int fossil_media_ini_get_double(const fossil_media_ini_t *ini, const char *section, const char *key, double *out);
+
+/**
+ * @brief Get a boolean: true/yes/on/1 or false/no/off/0, in any case.
+ *
+ * @return 0 on success, -1 if the key is missing or not a boolean.
+ */
+int fossil_media_ini_get_bool(const fossil_media_ini_t *ini, const char *section, const char *key, int *out);
+
+/**
+ * @brief Get a duration in milliseconds.
+ *
+ * Accepts one or more `<number><unit>` parts, e.g. `250ms`, `1.5s` or
+ * `1h 30m`, with units ms, s/sec, m/min, h, d and w. A bare number is
+ * seconds.
+ *
+ * @return 0 on success, -1 if the key is missing or not a duration.
+ */
+int fossil_media_ini_get_duration(const fossil_media_ini_t *ini, const char *section, const char *key, uint64_t *out_ms);
+
+/**
+ * @brief Get a size in bytes.
+ *
+ * A number with an optional unit: B, K/KB, M/MB, G/GB, T/TB (powers of
+ * 1000) or Ki/KiB, Mi/MiB, Gi/GiB, Ti/TiB (powers of 1024), in any case.
+ *
+ * @return 0 on success, -1 if the key is missing or not a size.
+ */
+int fossil_media_ini_get_size(const fossil_media_ini_t *ini, const char *section, const char *key, uint64_t *out_bytes);
+
 /**
  * @brief Set the value for a given section/key.
  *        Creates section/key if they do not exist.
  *
+ * Pointers returned by fossil_media_ini_get() for the key may be
+ * overwritten or go stale.
+ *
  * @param ini INI data structure.
  * @param section Section name.
  * @param key Key name.
@@ -130,31 +228,24 @@ namespace fossil {
             /**
              * @brief Construct an empty INI object.
              */
-            Ini() {
-                ini_.sections = nullptr;
-                ini_.section_count = 0;
-            }
+            Ini() : ini_{} {}
 
             /**
              * @brief Construct and load an INI file from disk.
              * @param path Path to the .ini file.
              * @throw std::runtime_error on failure.
              */
-            explicit Ini(const std::string& path) {
-                ini_.sections = nullptr;
-                ini_.section_count = 0;
+            explicit Ini(const std::string& path) : ini_{} {
                 if (fossil_media_ini_load_file(path.c_str(), &ini_) != 0)
                     throw std::runtime_error("Failed to load INI file: " + path);
             }
 
             /**
              * @brief Construct and load an INI file from a string buffer.
-             * @param data INI data as null-terminated string.
+             * @param data INI data as null-terminated string; borrowed until the first set or save.
              * @throw std::runtime_error on failure.
              */
-            Ini(const char* data) {
-                ini_.sections = nullptr;
-                ini_.section_count = 0;
+            Ini(const char* data) : ini_{} {
                 if (fossil_media_ini_load_string(data, &ini_) != 0)
                     throw std::runtime_error("Failed to load INI from string");
             }
@@ -164,8 +255,7 @@ namespace fossil {
              */
             Ini(Ini&& other) noexcept
             : ini_{other.ini_} {
-                other.ini_.sections = nullptr;
-                other.ini_.section_count = 0;
+                other.ini_ = fossil_media_ini_t{};
             }
 
             /**
@@ -175,8 +265,7 @@ namespace fossil {
                 if (this != &other) {
                     fossil_media_ini_free(&ini_);
                     ini_ = other.ini_;
-                    other.ini_.sections = nullptr;
-                    other.ini_.section_count = 0;
+                    other.ini_ = fossil_media_ini_t{};
                 }
                 return *this;
             }
@@ -199,20 +288,16 @@ namespace fossil {
              */
             bool load_file(const std::string& path) {
                 fossil_media_ini_free(&ini_);
-                ini_.sections = nullptr;
-                ini_.section_count = 0;
                 return fossil_media_ini_load_file(path.c_str(), &ini_) == 0;
             }
 
             /**
              * @brief Load an INI file from a string buffer.
-             * @param data INI data as null-terminated string.
+             * @param data INI data as null-terminated string; borrowed until the first set or save.
              * @return true on success, false on failure.
              */
             bool load_string(const char* data) {
                 fossil_media_ini_free(&ini_);
-                ini_.sections = nullptr;
-                ini_.section_count = 0;
                 return fossil_media_ini_load_string(data, &ini_) == 0;
             }
 
@@ -236,6 +321,47 @@ namespace fossil {
                 return val ? std::string(val) : std::string();
             }
 
+            /**
+             * @brief Get an integer value.
+             * @param fallback Returned when the key is missing or not an integer.
+             */
+            int64_t get_int(const std::string& section, const std::string& key, int64_t fallback = 0) const {
+                int64_t out;
+                return fossil_media_ini_get_int(&ini_, section.c_str(), key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Get a floating-point value.
+             */
+            double get_double(const std::string& section, const std::string& key, double fallback = 0.0) const {
+                double out;
+                return fossil_media_ini_get_double(&ini_, section.c_str(), key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Get a boolean value.
+             */
+            bool get_bool(const std::string& section, const std::string& key, bool fallback = false) const {
+                int out;
+                return fossil_media_ini_get_bool(&ini_, section.c_str(), key.c_str(), &out) == 0 ? out != 0 : fallback;
+            }
+
+            /**
+             * @brief Get a duration in milliseconds.
+             */
+            uint64_t get_duration(const std::string& section, const std::string& key, uint64_t fallback = 0) const {
+                uint64_t out;
+                return fossil_media_ini_get_duration(&ini_, section.c_str(), key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Get a size in bytes.
+             */
+            uint64_t get_size(const std::string& section, const std::string& key, uint64_t fallback = 0) const {
+                uint64_t out;
+                return fossil_media_ini_get_size(&ini_, section.c_str(), key.c_str(), &out) == 0 ? out : fallback;
+            }
+
             /**
              * @brief Set the value for a given section/key. Creates section/key if they do not exist.
              * @param section Section name.
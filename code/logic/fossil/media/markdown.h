@@ -27,6 +27,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include "media.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -49,8 +50,16 @@ typedef enum {
     FOSSIL_MEDIA_MD_BLOCKQUOTE   /**< > Blockquote */
 } fossil_media_md_type_t;
 
+/* Owner of a parsed tree's memory (opaque) */
+typedef struct fossil_media_md_doc fossil_media_md_doc_t;
+
 /**
  * @brief Parsed Markdown node
+ *
+ * Headings, list items, quote lines and text lines keep their source text
+ * in `content`; when it contains emphasis, code spans, links or escapes
+ * their `children` hold the inline nodes: TEXT (plain text), BOLD and
+ * ITALIC (children), CODE (content) and LINK (children, URL in `extra`).
  */
 typedef struct fossil_media_md_node_t {
     fossil_media_md_type_t type;   /**< Node type */
@@ -62,20 +71,116 @@ typedef struct fossil_media_md_node_t {
     int level;
 
     struct fossil_media_md_node_t *parent;    /**< Parent node */
+    fossil_media_md_doc_t *doc;               /**< Set on the root of a parsed tree; owns its memory */
 } fossil_media_md_node_t;
 
 /**
  * @brief Parse Markdown text into a tree of nodes
+ *
+ * Lines are scanned in place and every node, array and string of the tree
+ * is allocated from one arena owned by the root. Inline markup is parsed
+ * in a single linear pass per block (see fossil_media_md_node_t).
+ *
+ * @return Root node, or NULL on failure. Free with fossil_media_md_free().
  */
 fossil_media_md_node_t *fossil_media_md_parse(const char *input);
 
+/**
+ * @brief Parse large Markdown text on several threads.
+ *
+ * A quick pre-scan cuts the text after blank lines outside fenced code;
+ * the pieces are parsed concurrently and their blocks joined in order
+ * under one root. The result is identical to fossil_media_md_parse() and
+ * supports fossil_media_md_edit(). Inputs under a few tens of KiB, or
+ * @p threads of 1, are parsed serially.
+ *
+ * @param input   Markdown text.
+ * @param threads Worker threads, 0 for one per online CPU.
+ * @return Root node, or NULL on failure. Free with fossil_media_md_free().
+ */
+fossil_media_md_node_t *fossil_media_md_parse_parallel(const char *input, size_t threads);
+
+/**
+ * @brief Top-level nodes replaced by fossil_media_md_edit()
+ */
+typedef struct {
+    size_t first;     /**< Index of the first replaced child of the root */
+    size_t removed;   /**< Number of old children replaced */
+    size_t inserted;  /**< Number of new children, at [first, first + inserted) */
+} fossil_media_md_change_t;
+
+/**
+ * @brief Apply a text edit to a parsed document and update its tree.
+ *
+ * The root keeps a copy of the source and the range of every top-level
+ * block. Parsing restarts at the block before the edit and stops as soon
+ * as it reaches the start of an old block past the edit, so only the
+ * blocks around the edit are parsed again. All other nodes are kept
+ * as they are (the children after the range only move within the root's
+ * array). Replaced nodes stay allocated until the tree is freed; once
+ * they outnumber the live blocks the whole document is parsed again and
+ * `change` covers every child.
+ *
+ * @param root     Root returned by fossil_media_md_parse().
+ * @param offset   Byte offset of the edit in the current source.
+ * @param deleted  Number of bytes removed at @p offset.
+ * @param text     Inserted text (may be NULL when @p len is 0); no NUL bytes.
+ * @param len      Length of @p text.
+ * @param change   Receives the replaced range of root children (may be NULL).
+ * @return 0 on success, -1 on error (the document is left unchanged).
+ */
+int fossil_media_md_edit(fossil_media_md_node_t *root, size_t offset, size_t deleted,
+                         const char *text, size_t len, fossil_media_md_change_t *change);
+
+/**
+ * @brief Current source text of a parsed document, including edits.
+ *
+ * @param root Root returned by fossil_media_md_parse().
+ * @param len  Receives the length in bytes (may be NULL).
+ * @return NUL-terminated text owned by the tree, or NULL for trees built by hand.
+ */
+const char *fossil_media_md_source(const fossil_media_md_node_t *root, size_t *len);
+
 /**
  * @brief Serialize a Markdown node tree back into Markdown text
+ *
+ * The exact output size is measured first and the text is written into a
+ * single allocation of that size.
+ *
+ * @return Heap-allocated text (free with free()), or NULL on failure.
  */
 char *fossil_media_md_serialize(const fossil_media_md_node_t *root);
 
+/**
+ * @brief Render a Markdown node tree as HTML.
+ *
+ * Headings become `<h1>`..`<h6>`, runs of list items one `<ul>`, runs of
+ * quote lines one `<blockquote>`, code blocks `<pre><code>` (with a
+ * `language-*` class when the fence names one) and any other line a `<p>`.
+ * Bold, italic, inline code and link children render as `<strong>`,
+ * `<em>`, `<code>` and `<a href>`. Text is escaped in clean runs found with
+ * fossil_media_find_any(). Output is staged in a small buffer and handed
+ * to the sink as it fills.
+ *
+ * @param root Tree returned by fossil_media_md_parse().
+ * @param sink Output callback, e.g. fossil_media_sink_file().
+ * @param user Passed to @p sink.
+ * @return 0 on success, -1 on error.
+ */
+int fossil_media_md_render_html(const fossil_media_md_node_t *root, fossil_media_sink_fn sink, void *user);
+
+/**
+ * @brief Render a Markdown node tree as an HTML string.
+ *
+ * @return Heap-allocated HTML (free with free()), or NULL on failure.
+ */
+char *fossil_media_md_render_html_string(const fossil_media_md_node_t *root);
+
 /**
  * @brief Free a Markdown node tree
+ *
+ * For parsed trees pass the root; it releases the whole tree at once.
+ * Trees built by hand are freed node by node.
  */
 void fossil_media_md_free(fossil_media_md_node_t *node);
 
@@ -108,6 +213,20 @@ namespace fossil {
                 return root;
             }
 
+            /**
+             * @brief Parse Markdown text on several threads.
+             * @param input The Markdown text to parse.
+             * @param threads Worker threads, 0 for one per online CPU.
+             * @return Pointer to the root node of the parsed tree.
+             * @throws std::runtime_error on parse failure.
+             */
+            static fossil_media_md_node_t* parse_parallel(const std::string& input, size_t threads = 0) {
+                fossil_media_md_node_t* root = fossil_media_md_parse_parallel(input.c_str(), threads);
+                if (!root)
+                    throw std::runtime_error("Failed to parse Markdown");
+                return root;
+            }
+
             /**
              * @brief Serialize a Markdown node tree back into Markdown text.
              * @param root Pointer to the root node of the tree.
@@ -123,6 +242,38 @@ namespace fossil {
                 return output;
             }
 
+            /**
+             * @brief Render a Markdown node tree as HTML.
+             * @param root Pointer to the root node of the tree.
+             * @return HTML text.
+             * @throws std::runtime_error on failure.
+             */
+            static std::string render_html(const fossil_media_md_node_t* root) {
+                char* result = fossil_media_md_render_html_string(root);
+                if (!result)
+                    throw std::runtime_error("Failed to render Markdown");
+                std::string output(result);
+                std::free(result);
+                return output;
+            }
+
+            /**
+             * @brief Apply a text edit to a parsed tree.
+             * @param root Root returned by parse().
+             * @param offset Byte offset of the edit.
+             * @param deleted Number of bytes removed.
+             * @param text Inserted text.
+             * @return The replaced range of root children.
+             * @throws std::runtime_error on failure.
+             */
+            static fossil_media_md_change_t edit(fossil_media_md_node_t* root, size_t offset, size_t deleted,
+                                                 const std::string& text) {
+                fossil_media_md_change_t change;
+                if (fossil_media_md_edit(root, offset, deleted, text.data(), text.size(), &change) != 0)
+                    throw std::runtime_error("Failed to edit Markdown");
+                return change;
+            }
+
             /**
              * @brief Free a Markdown node tree.
              * @param node Pointer to the root node to free.
@@ -54,6 +54,17 @@ extern "C"
  */
 int fossil_media_strncasecmp(const char *s1, const char *s2, size_t n);
 
+/**
+ * @brief Compare `n` bytes, ignoring ASCII case.
+ *
+ * Only A-Z and a-z fold, so the result does not depend on the locale.
+ * Compares 16 bytes at a time with SSE2 when available.
+ *
+ * @return 0 if equal, otherwise the difference of the first differing
+ *         bytes after folding to lowercase.
+ */
+int fossil_media_memcasecmp(const void *a, const void *b, size_t n);
+
 /**
  * @brief Allocates and returns a null-terminated string containing a
  *        copy of the given input.
@@ -98,6 +109,33 @@ char *fossil_media_read_file(const char *path, size_t *out_size);
  */
 int fossil_media_write_file(const char *path, const char *data);
 
+/**
+ * @brief Read-only view of a whole file.
+ */
+typedef struct fossil_media_map {
+    const char *data;  /**< File contents (not null-terminated) */
+    size_t size;       /**< Size in bytes */
+    void *handle;      /**< Internal: mapping handle or heap copy */
+    int mapped;        /**< Internal: data is a memory mapping */
+} fossil_media_map_t;
+
+/**
+ * @brief Map a file into memory for reading.
+ *
+ * Uses mmap (MapViewOfFile on Windows) so the pages are read on demand
+ * without a copy; files that cannot be mapped are read into memory instead.
+ *
+ * @param path Path to the file.
+ * @param map View to fill in; release with fossil_media_unmap().
+ * @return 0 on success, -1 on error.
+ */
+int fossil_media_map_file(const char *path, fossil_media_map_t *map);
+
+/**
+ * @brief Release a view returned by fossil_media_map_file().
+ */
+void fossil_media_unmap(fossil_media_map_t *map);
+
 /**
  * @brief Trims whitespace from both ends of a mutable string in place.
  *
@@ -106,6 +144,238 @@ int fossil_media_write_file(const char *path, const char *data);
  */
 char *fossil_media_trim(char *str);
 
+/**
+ * @brief Find the part of a span without leading and trailing whitespace.
+ *
+ * Nothing is modified or moved. Whitespace is the C locale's isspace()
+ * set; the ends are scanned 16 bytes at a time with SSE2 when available.
+ *
+ * @param s       Bytes to trim (may be NULL).
+ * @param len     Length of @p s.
+ * @param out_len Receives the trimmed length (may be NULL).
+ * @return Pointer to the first byte kept, or NULL if @p s is NULL.
+ */
+const char *fossil_media_trim_n(const char *s, size_t len, size_t *out_len);
+
+/* ===============================
+ *  Byte Scanning
+ * =============================== */
+
+/**
+ * @brief Find the first byte of `data` that appears in `set`.
+ *
+ * Like strpbrk(), but bounded by `len` and safe on data containing NUL bytes.
+ * Uses 16-byte SSE2 compares when available and a bitmap lookup otherwise.
+ *
+ * @param data Bytes to scan.
+ * @param len  Number of bytes to scan.
+ * @param set  Null-terminated set of bytes to look for (up to 16 for the
+ *             vector path; longer sets fall back to the scalar loop).
+ * @return Pointer to the first matching byte, or NULL if none matched.
+ */
+const char *fossil_media_find_any(const char *data, size_t len, const char *set);
+
+/* ===============================
+ *  Streaming Output
+ * =============================== */
+
+/**
+ * @brief Output callback used by the streaming writers and serializers.
+ *
+ * @param user Opaque pointer given when the writer was set up.
+ * @param data Bytes to write (not null-terminated).
+ * @param len  Number of bytes.
+ * @return 0 on success, nonzero to abort the operation.
+ */
+typedef int (*fossil_media_sink_fn)(void *user, const char *data, size_t len);
+
+/**
+ * @brief Buffered writer in front of a sink.
+ *
+ * Output is collected in a caller-provided fixed buffer and handed to the
+ * sink whenever it fills up, so producers can emit many small pieces without
+ * one callback per piece. A writer with a NULL sink discards the data but
+ * still counts it, which serves as a measuring pass.
+ */
+typedef struct fossil_media_writer {
+    fossil_media_sink_fn sink; /**< Destination, or NULL to only count */
+    void *user;                /**< Passed to the sink */
+    char *buf;                 /**< Staging buffer (may be NULL) */
+    size_t cap;                /**< Staging buffer capacity */
+    size_t len;                /**< Bytes currently staged */
+    size_t total;              /**< Bytes accepted so far */
+    int error;                 /**< First sink error (sticky) */
+} fossil_media_writer_t;
+
+/**
+ * @brief Initialize a writer.
+ *
+ * @param w    Writer to initialize.
+ * @param sink Output callback, or NULL to only count bytes.
+ * @param user Opaque pointer passed to the sink.
+ * @param buf  Staging buffer, or NULL for unbuffered writes.
+ * @param cap  Size of `buf` in bytes.
+ */
+void fossil_media_writer_init(fossil_media_writer_t *w, fossil_media_sink_fn sink, void *user, char *buf, size_t cap);
+
+/**
+ * @brief Append bytes to a writer.
+ *
+ * @return 0 on success, the sink's error code otherwise.
+ */
+int fossil_media_writer_write(fossil_media_writer_t *w, const char *data, size_t len);
+
+/**
+ * @brief Append a null-terminated string to a writer.
+ */
+int fossil_media_writer_puts(fossil_media_writer_t *w, const char *str);
+
+/**
+ * @brief Append one character to a writer.
+ */
+int fossil_media_writer_putc(fossil_media_writer_t *w, char c);
+
+/**
+ * @brief Hand any staged bytes to the sink.
+ *
+ * @return 0 on success, the first sink error otherwise.
+ */
+int fossil_media_writer_flush(fossil_media_writer_t *w);
+
+/**
+ * @brief Growable in-memory output, used with fossil_media_sink_buffer().
+ *
+ * Zero-initialize before use. `data` is kept null-terminated.
+ */
+typedef struct fossil_media_buffer {
+    char *data;
+    size_t len;
+    size_t cap;
+} fossil_media_buffer_t;
+
+/**
+ * @brief Sink appending to a fossil_media_buffer_t passed as `user`.
+ */
+int fossil_media_sink_buffer(void *user, const char *data, size_t len);
+
+/**
+ * @brief Sink writing to a `FILE *` passed as `user`.
+ */
+int fossil_media_sink_file(void *user, const char *data, size_t len);
+
+/**
+ * @brief Sink writing to a file descriptor; `user` points to the `int` fd.
+ *
+ * Short writes are retried until all data is written.
+ */
+int fossil_media_sink_fd(void *user, const char *data, size_t len);
+
+/**
+ * @brief Release the memory held by a buffer and reset it.
+ */
+void fossil_media_buffer_free(fossil_media_buffer_t *buf);
+
+/* ===============================
+ *  Arena Allocation
+ * =============================== */
+
+/* One block of arena memory (internal layout) */
+typedef struct fossil_media_arena_block fossil_media_arena_block_t;
+
+/**
+ * @brief Bump allocator for data that is freed all at once.
+ *
+ * Allocations are carved from large blocks whose size grows geometrically,
+ * so building a tree of many small nodes costs a handful of malloc() calls
+ * and tearing it down costs one free() per block. Zero-initialize or call
+ * fossil_media_arena_init() before use.
+ */
+typedef struct fossil_media_arena {
+    fossil_media_arena_block_t *head; /**< Block currently allocated from */
+    size_t block_size;                /**< Size of the next block */
+} fossil_media_arena_t;
+
+/**
+ * @brief Initialize an empty arena.
+ *
+ * @param arena Arena to initialize.
+ * @param block_size Size of the first block (0 for the default of 4 KiB).
+ */
+void fossil_media_arena_init(fossil_media_arena_t *arena, size_t block_size);
+
+/**
+ * @brief Allocate `size` bytes aligned for any scalar type.
+ *
+ * @return Pointer to uninitialized memory, or NULL on allocation failure.
+ */
+void *fossil_media_arena_alloc(fossil_media_arena_t *arena, size_t size);
+
+/**
+ * @brief Allocate `size` zeroed bytes.
+ */
+void *fossil_media_arena_calloc(fossil_media_arena_t *arena, size_t size);
+
+/**
+ * @brief Copy `n` bytes of `s` into the arena and null-terminate them.
+ */
+char *fossil_media_arena_strndup(fossil_media_arena_t *arena, const char *s, size_t n);
+
+/**
+ * @brief Release every allocation but keep the largest block for reuse.
+ */
+void fossil_media_arena_reset(fossil_media_arena_t *arena);
+
+/**
+ * @brief Move every allocation of `src` into `dst`.
+ *
+ * The memory stays where it is and is freed with `dst`; `src` is left
+ * empty. Used to gather arenas filled on separate threads into one owner.
+ */
+void fossil_media_arena_merge(fossil_media_arena_t *dst, fossil_media_arena_t *src);
+
+/**
+ * @brief Free all memory held by the arena.
+ */
+void fossil_media_arena_destroy(fossil_media_arena_t *arena);
+
+/* ===============================
+ *  Parallel Execution
+ * =============================== */
+
+/**
+ * @brief Task body for fossil_media_parallel_run().
+ *
+ * @param ctx    Opaque pointer given to fossil_media_parallel_run().
+ * @param index  Item to process, in [0, count).
+ * @param worker Worker running the task, in [0, workers); use it to index
+ *               per-worker scratch state.
+ */
+typedef void (*fossil_media_task_fn)(void *ctx, size_t index, size_t worker);
+
+/**
+ * @brief Resolve the number of workers for `count` items.
+ *
+ * @param requested Desired worker count, or 0 for one per online CPU.
+ * @param count Number of items to process.
+ * @return A worker count between 1 and max(count, 1).
+ */
+size_t fossil_media_parallel_workers(size_t requested, size_t count);
+
+/**
+ * @brief Run `fn` once for every index in [0, count) on a pool of workers.
+ *
+ * The calling thread is worker 0. Workers claim indices one at a time from a
+ * shared counter, so uneven item costs balance out. If a thread cannot be
+ * started, the remaining workers pick up its share.
+ *
+ * @param count Number of items.
+ * @param workers Worker count, normally from fossil_media_parallel_workers().
+ * @param fn Task body.
+ * @param ctx Opaque pointer passed to `fn`.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int fossil_media_parallel_run(size_t count, size_t workers, fossil_media_task_fn fn, void *ctx);
+
 /** @} */ // end group MediaLibrary
 
 #ifdef __cplusplus
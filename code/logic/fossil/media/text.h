@@ -44,6 +44,10 @@ char *fossil_media_text_trim(char *str);
 /**
  * @brief Convert a string to lowercase in place.
  *
+ * Only ASCII letters are mapped, independent of the current locale;
+ * other bytes, including UTF-8 sequences, are left as they are. Use
+ * fossil_media_text_casefold() for Unicode-aware caseless text.
+ *
  * @param str String to modify.
  * @return Pointer to the modified string.
  */
@@ -52,14 +56,52 @@ char *fossil_media_text_tolower(char *str);
 /**
  * @brief Convert a string to uppercase in place.
  *
+ * Only ASCII letters are mapped, independent of the current locale.
+ *
  * @param str String to modify.
  * @return Pointer to the modified string.
  */
 char *fossil_media_text_toupper(char *str);
 
+/**
+ * @brief Apply Unicode simple case folding to UTF-8 text.
+ *
+ * Folded text compares equal for strings that differ only in case
+ * ("Straße" and "STRASSE" do not, since that needs full folding). A
+ * folded character may encode to a different number of bytes. Malformed
+ * UTF-8 bytes are copied unchanged.
+ *
+ * @param str      Input text (need not be NUL-terminated).
+ * @param len      Length of the input in bytes.
+ * @param out      Output buffer, may be NULL when out_size is 0.
+ * @param out_size Size of the output buffer in bytes.
+ * @return Length of the full folded text, excluding the terminator. The
+ *         output is NUL-terminated and truncated when this is >= out_size.
+ */
+size_t fossil_media_text_casefold(const char *str, size_t len, char *out, size_t out_size);
+
+/**
+ * @brief Compare two UTF-8 strings ignoring case.
+ *
+ * Compares code points after simple case folding, without allocating.
+ * Runs of ASCII are compared 16 bytes at a time.
+ *
+ * @param a    First string.
+ * @param alen Length of the first string in bytes.
+ * @param b    Second string.
+ * @param blen Length of the second string in bytes.
+ * @return Negative, zero or positive like strcmp().
+ */
+int fossil_media_text_casecmp(const char *a, size_t alen, const char *b, size_t blen);
+
 /**
  * @brief Replace all occurrences of a substring within a string.
  *
+ * Runs in time linear in the string. Either every occurrence is replaced
+ * or, when the result would not fit in @p buf_size bytes, the string is
+ * left untouched and 0 is returned; use fossil_media_text_replace_all()
+ * to learn the size needed.
+ *
  * @param str        The input string (modified in place if space allows).
  * @param old_sub    Substring to replace.
  * @param new_sub    Substring to insert.
@@ -68,6 +110,75 @@ char *fossil_media_text_toupper(char *str);
  */
 size_t fossil_media_text_replace(char *str, const char *old_sub, const char *new_sub, size_t buf_size);
 
+/**
+ * @brief Replace every occurrence of a substring, writing to a separate buffer.
+ *
+ * One left-to-right pass; occurrences do not overlap. Like snprintf(), at
+ * most @p out_size - 1 bytes are written followed by a terminator, and the
+ * return value is the full length of the result, so a call with a NULL
+ * @p out and 0 @p out_size queries the size to allocate.
+ *
+ * @param str       Input string.
+ * @param old_sub   Substring to replace; an empty one copies @p str unchanged.
+ * @param new_sub   Replacement (NULL for none).
+ * @param out       Output buffer (may be NULL when @p out_size is 0).
+ * @param out_size  Size of @p out in bytes.
+ * @param count     Receives the number of replacements (may be NULL).
+ * @return Length of the complete result, excluding the terminator. The
+ *         output is complete when this is less than @p out_size.
+ */
+size_t fossil_media_text_replace_all(const char *str, const char *old_sub, const char *new_sub,
+                                     char *out, size_t out_size, size_t *count);
+
+/**
+ * @brief Compiled set of patterns and their replacements (opaque).
+ */
+typedef struct fossil_media_text_replacer fossil_media_text_replacer_t;
+
+/**
+ * @brief Compile patterns into a reusable multi-pattern replacer.
+ *
+ * Builds an Aho-Corasick automaton so all patterns are looked for at once,
+ * however many there are. Where matches overlap the leftmost wins, and of
+ * those starting at the same place the longest; a pattern listed twice uses
+ * its first replacement. The strings are copied.
+ *
+ * @param patterns      Non-empty patterns to look for.
+ * @param replacements  Replacement for each pattern.
+ * @param count         Number of patterns.
+ * @return New replacer, or NULL on invalid input or allocation failure.
+ */
+fossil_media_text_replacer_t *fossil_media_text_replacer_new(const char *const *patterns,
+                                                             const char *const *replacements, size_t count);
+
+/**
+ * @brief Replace every pattern of a compiled replacer.
+ *
+ * Output follows the same rules as fossil_media_text_replace_all(). The
+ * replacer is not modified, so it can be shared between threads.
+ *
+ * To pick the longest match the automaton reads past a match before
+ * replacing it, and scanning then resumes right after the match, so up to
+ * the longest pattern's length is read again per replacement. Text without
+ * matches is read once; the worst case is O(n * m) for n bytes of text and
+ * a longest pattern of m bytes (patterns "a" and "aaaab" over a long run
+ * of 'a').
+ *
+ * @param r         Replacer from fossil_media_text_replacer_new().
+ * @param str       Input string.
+ * @param out       Output buffer (may be NULL when @p out_size is 0).
+ * @param out_size  Size of @p out in bytes.
+ * @param count     Receives the number of replacements (may be NULL).
+ * @return Length of the complete result, excluding the terminator.
+ */
+size_t fossil_media_text_replacer_apply(const fossil_media_text_replacer_t *r, const char *str,
+                                        char *out, size_t out_size, size_t *count);
+
+/**
+ * @brief Free a replacer.
+ */
+void fossil_media_text_replacer_free(fossil_media_text_replacer_t *r);
+
 /**
  * @brief Find the first occurrence of a substring in a string (case-sensitive).
  *
@@ -77,6 +188,75 @@ size_t fossil_media_text_replace(char *str, const char *old_sub, const char *new
  */
 char *fossil_media_text_find(const char *haystack, const char *needle);
 
+/**
+ * @brief Find the first occurrence of a byte sequence in a bounded buffer.
+ *
+ * Neither argument needs a terminator and both may contain NUL bytes.
+ * Candidate positions are filtered 16 at a time on the needle's first and
+ * last byte (SSE2 where available); needles that defeat the filter fall
+ * back to the Two-Way algorithm, so the search stays linear.
+ *
+ * @param haystack    Bytes to search.
+ * @param len         Length of @p haystack.
+ * @param needle      Bytes to look for.
+ * @param needle_len  Length of @p needle; an empty needle matches at the start.
+ * @return Pointer to the first occurrence, or NULL if not found.
+ */
+const char *fossil_media_text_find_n(const char *haystack, size_t len, const char *needle, size_t needle_len);
+
+/**
+ * @brief Compiled set of needles for fossil_media_text_searcher_find() (opaque).
+ */
+typedef struct fossil_media_text_searcher fossil_media_text_searcher_t;
+
+/**
+ * @brief Callback for each match of a searcher.
+ *
+ * @param user    User pointer passed through.
+ * @param offset  Byte offset of the match in the text.
+ * @param length  Length of the match.
+ * @param needle  Index of the needle that matched.
+ * @return 0 to continue, non-zero to stop the search.
+ */
+typedef int (*fossil_media_text_match_fn)(void *user, size_t offset, size_t length, size_t needle);
+
+/**
+ * @brief Compile needles into a reusable multi-needle searcher.
+ *
+ * Uses the same Aho-Corasick automaton as the replacer, so the text is
+ * scanned once however many needles there are. A needle listed twice is
+ * reported under its first index.
+ *
+ * @param needles  Non-empty needles.
+ * @param lengths  Length of each needle, or NULL if they are NUL-terminated.
+ * @param count    Number of needles.
+ * @return New searcher, or NULL on invalid input or allocation failure.
+ */
+fossil_media_text_searcher_t *fossil_media_text_searcher_new(const char *const *needles, const size_t *lengths,
+                                                             size_t count);
+
+/**
+ * @brief Report every occurrence of every needle in a buffer.
+ *
+ * Matches may overlap. They are reported in order of where they end, and
+ * the longer first when several end at the same byte. The searcher is not
+ * modified, so it can be shared between threads.
+ *
+ * @param searcher Searcher from fossil_media_text_searcher_new().
+ * @param text     Bytes to search (may contain NUL bytes).
+ * @param len      Length of @p text.
+ * @param fn       Callback for each match (may be NULL to only count).
+ * @param user     Passed to @p fn.
+ * @return Number of matches reported.
+ */
+size_t fossil_media_text_searcher_find(const fossil_media_text_searcher_t *searcher, const char *text, size_t len,
+                                       fossil_media_text_match_fn fn, void *user);
+
+/**
+ * @brief Free a searcher.
+ */
+void fossil_media_text_searcher_free(fossil_media_text_searcher_t *searcher);
+
 /**
  * @brief Split a string into tokens by a delimiter.
  *
@@ -88,6 +268,63 @@ char *fossil_media_text_find(const char *haystack, const char *needle);
  */
 size_t fossil_media_text_split(char *str, char delim, char **tokens, size_t max_tokens);
 
+/**
+ * @brief Non-mutating iterator over the tokens of a string.
+ *
+ * Filled in by fossil_media_text_split_init() or
+ * fossil_media_text_split_any_init() and advanced with
+ * fossil_media_text_split_next(). Tokens point into the original text.
+ * The iterator holds no heap memory, so it can live on the stack and
+ * needs no cleanup.
+ */
+typedef struct fossil_media_text_split_iter {
+    const char *str;
+    size_t len;
+    size_t pos;         /**< start of the next token, len + 1 once exhausted */
+    const char *delim;
+    size_t delim_len;
+    int any;            /**< delim is a set of single-byte delimiters */
+} fossil_media_text_split_iter_t;
+
+/**
+ * @brief Start splitting text on a (possibly multi-byte) delimiter.
+ *
+ * Like fossil_media_text_split(), n delimiters yield n + 1 tokens, so
+ * adjacent delimiters produce empty tokens. The text and delimiter must
+ * outlive the iterator.
+ *
+ * @param it        Iterator to initialize.
+ * @param str       Text to split (need not be NUL-terminated).
+ * @param len       Length of the text in bytes.
+ * @param delim     Delimiter bytes.
+ * @param delim_len Length of the delimiter, at least 1.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int fossil_media_text_split_init(fossil_media_text_split_iter_t *it, const char *str, size_t len,
+                                 const char *delim, size_t delim_len);
+
+/**
+ * @brief Start splitting text on any byte of a delimiter set.
+ *
+ * @param it  Iterator to initialize.
+ * @param str Text to split (need not be NUL-terminated).
+ * @param len Length of the text in bytes.
+ * @param set Null-terminated, non-empty set of delimiter bytes.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+int fossil_media_text_split_any_init(fossil_media_text_split_iter_t *it, const char *str, size_t len,
+                                     const char *set);
+
+/**
+ * @brief Produce the next token.
+ *
+ * @param it        Iterator to advance.
+ * @param token     Receives a pointer to the token inside the text.
+ * @param token_len Receives the token length in bytes.
+ * @return 1 when a token was produced, 0 when the text is exhausted.
+ */
+int fossil_media_text_split_next(fossil_media_text_split_iter_t *it, const char **token, size_t *token_len);
+
 #ifdef __cplusplus
 }
 #include <string>
@@ -95,6 +332,8 @@ size_t fossil_media_text_split(char *str, char delim, char **tokens, size_t max_
 #include <stdexcept>
 #include <utility>
 #include <cstring>
+#include <iterator>
+#include <string_view>
 
 namespace fossil {
 
@@ -154,6 +393,32 @@ namespace fossil {
                 return result;
             }
 
+            /**
+             * @brief Apply Unicode simple case folding to UTF-8 text.
+             *
+             * @param str String to fold.
+             * @return Folded string.
+             */
+            static std::string casefold(const std::string& str) {
+                std::string result(str.size(), '\0');
+                size_t n = fossil_media_text_casefold(str.data(), str.size(), &result[0], result.size() + 1);
+                if (n > str.size()) {
+                    result.resize(n);
+                    fossil_media_text_casefold(str.data(), str.size(), &result[0], n + 1);
+                }
+                result.resize(n);
+                return result;
+            }
+
+            /**
+             * @brief Compare two UTF-8 strings ignoring case.
+             *
+             * @return Negative, zero or positive like strcmp().
+             */
+            static int casecmp(const std::string& a, const std::string& b) {
+                return fossil_media_text_casecmp(a.data(), a.size(), b.data(), b.size());
+            }
+
             /**
              * @brief Replace all occurrences of a substring within a string.
              *
@@ -163,12 +428,9 @@ namespace fossil {
              * @return String with replacements.
              */
             static std::string replace(const std::string& str, const std::string& old_sub, const std::string& new_sub) {
-                size_t buf_size = str.size() + (new_sub.size() > old_sub.size() ? (str.size() * (new_sub.size() - old_sub.size())) : 1) + 1;
-                char *buf = new char[buf_size];
-                std::strcpy(buf, str.c_str());
-                fossil_media_text_replace(buf, old_sub.c_str(), new_sub.c_str(), buf_size);
-                std::string result(buf);
-                delete[] buf;
+                size_t len = fossil_media_text_replace_all(str.c_str(), old_sub.c_str(), new_sub.c_str(), nullptr, 0, nullptr);
+                std::string result(len, '\0');
+                fossil_media_text_replace_all(str.c_str(), old_sub.c_str(), new_sub.c_str(), &result[0], len + 1, nullptr);
                 return result;
             }
 
@@ -180,9 +442,9 @@ namespace fossil {
              * @return Position of the first occurrence, or std::string::npos if not found.
              */
             static size_t find(const std::string& haystack, const std::string& needle) {
-                char *res = fossil_media_text_find(haystack.c_str(), needle.c_str());
+                const char *res = fossil_media_text_find_n(haystack.data(), haystack.size(), needle.data(), needle.size());
                 if (!res) return std::string::npos;
-                return static_cast<size_t>(res - haystack.c_str());
+                return static_cast<size_t>(res - haystack.data());
             }
 
             /**
@@ -194,21 +456,188 @@ namespace fossil {
              */
             static std::vector<std::string> split(const std::string& str, char delim) {
                 std::vector<std::string> tokens;
-                std::string s = str;
-                // Estimate max tokens as length + 1
-                size_t max_tokens = s.size() + 1;
-                std::vector<char*> c_tokens(max_tokens, nullptr);
-                char *buf = new char[s.size() + 1];
-                std::strcpy(buf, s.c_str());
-                size_t count = fossil_media_text_split(buf, delim, c_tokens.data(), max_tokens);
-                for (size_t i = 0; i < count; ++i) {
-                    tokens.emplace_back(c_tokens[i]);
+                fossil_media_text_split_iter_t it;
+                const char *token;
+                size_t len;
+                fossil_media_text_split_init(&it, str.data(), str.size(), &delim, 1);
+                while (fossil_media_text_split_next(&it, &token, &len)) {
+                    tokens.emplace_back(token, len);
                 }
-                delete[] buf;
                 return tokens;
             }
         };
 
+        /**
+         * @brief Lazy range of the tokens of a string, as views into it.
+         *
+         * Splitting allocates nothing; the text and the delimiter or set
+         * must outlive the range.
+         *
+         * @code
+         * for (std::string_view field : TextSplit(line, ", ")) { ... }
+         * for (std::string_view word : TextSplit::any(text, " \t\n")) { ... }
+         * @endcode
+         */
+        class TextSplit {
+        public:
+            class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = std::string_view;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const std::string_view*;
+                using reference = const std::string_view&;
+
+                iterator() = default;
+                explicit iterator(const fossil_media_text_split_iter_t& it) : it_(it) { ++*this; }
+
+                reference operator*() const { return token_; }
+                pointer operator->() const { return &token_; }
+
+                iterator& operator++() {
+                    const char *token;
+                    size_t len;
+                    done_ = !fossil_media_text_split_next(&it_, &token, &len);
+                    token_ = done_ ? std::string_view() : std::string_view(token, len);
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.done_; }
+
+            private:
+                fossil_media_text_split_iter_t it_{};
+                std::string_view token_;
+                bool done_ = true;
+            };
+
+            /**
+             * @brief Split on a delimiter sequence.
+             * @throws std::runtime_error if the delimiter is empty.
+             */
+            TextSplit(std::string_view text, std::string_view delim) {
+                if (fossil_media_text_split_init(&it_, text.data(), text.size(), delim.data(), delim.size()) != 0) {
+                    throw std::runtime_error("TextSplit: empty delimiter");
+                }
+            }
+
+            /**
+             * @brief Split on any byte of `set`.
+             * @throws std::runtime_error if the set is empty.
+             */
+            static TextSplit any(std::string_view text, const char *set) {
+                TextSplit split;
+                if (fossil_media_text_split_any_init(&split.it_, text.data(), text.size(), set) != 0) {
+                    throw std::runtime_error("TextSplit: empty delimiter set");
+                }
+                return split;
+            }
+
+            iterator begin() const { return iterator(it_); }
+            std::default_sentinel_t end() const { return std::default_sentinel; }
+
+        private:
+            TextSplit() = default;
+            fossil_media_text_split_iter_t it_{};
+        };
+
+        /**
+         * @brief RAII wrapper for a compiled multi-pattern replacer.
+         */
+        class TextReplacer {
+        public:
+            /**
+             * @brief Compile pattern/replacement pairs.
+             * @param pairs Each pattern with its replacement.
+             * @throws std::runtime_error on invalid patterns or allocation failure.
+             */
+            explicit TextReplacer(const std::vector<std::pair<std::string, std::string>>& pairs) {
+                std::vector<const char*> patterns, replacements;
+                for (const auto& pair : pairs) {
+                    patterns.push_back(pair.first.c_str());
+                    replacements.push_back(pair.second.c_str());
+                }
+                replacer_ = fossil_media_text_replacer_new(patterns.data(), replacements.data(), pairs.size());
+                if (!replacer_)
+                    throw std::runtime_error("Failed to compile text replacer");
+            }
+
+            ~TextReplacer() { fossil_media_text_replacer_free(replacer_); }
+
+            TextReplacer(const TextReplacer&) = delete;
+            TextReplacer& operator=(const TextReplacer&) = delete;
+
+            /**
+             * @brief Replace every pattern in a string.
+             * @param str Input string.
+             * @return String with replacements.
+             */
+            std::string apply(const std::string& str) const {
+                size_t len = fossil_media_text_replacer_apply(replacer_, str.c_str(), nullptr, 0, nullptr);
+                std::string result(len, '\0');
+                fossil_media_text_replacer_apply(replacer_, str.c_str(), &result[0], len + 1, nullptr);
+                return result;
+            }
+
+        private:
+            fossil_media_text_replacer_t* replacer_;
+        };
+
+        /**
+         * @brief RAII wrapper for a compiled multi-needle searcher.
+         */
+        class TextSearcher {
+        public:
+            /** @brief One match: byte offset, length and needle index. */
+            struct Match {
+                size_t offset;
+                size_t length;
+                size_t needle;
+            };
+
+            /**
+             * @brief Compile needles.
+             * @param needles Non-empty needles (may contain NUL bytes).
+             * @throws std::runtime_error on invalid needles or allocation failure.
+             */
+            explicit TextSearcher(const std::vector<std::string>& needles) {
+                std::vector<const char*> ptrs;
+                std::vector<size_t> lengths;
+                for (const auto& needle : needles) {
+                    ptrs.push_back(needle.data());
+                    lengths.push_back(needle.size());
+                }
+                searcher_ = fossil_media_text_searcher_new(ptrs.data(), lengths.data(), needles.size());
+                if (!searcher_)
+                    throw std::runtime_error("Failed to compile text searcher");
+            }
+
+            ~TextSearcher() { fossil_media_text_searcher_free(searcher_); }
+
+            TextSearcher(const TextSearcher&) = delete;
+            TextSearcher& operator=(const TextSearcher&) = delete;
+
+            /**
+             * @brief Every match in a text, in order of where they end.
+             * @param text Text to search.
+             * @return The matches.
+             */
+            std::vector<Match> find_all(const std::string& text) const {
+                std::vector<Match> matches;
+                fossil_media_text_searcher_find(searcher_, text.data(), text.size(), collect, &matches);
+                return matches;
+            }
+
+        private:
+            static int collect(void* user, size_t offset, size_t length, size_t needle) {
+                static_cast<std::vector<Match>*>(user)->push_back(Match{offset, length, needle});
+                return 0;
+            }
+
+            fossil_media_text_searcher_t* searcher_;
+        };
+
     } // namespace media
 
 } // namespace fossil
@@ -28,48 +28,134 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "media.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/**
+ * @brief Type of a parsed TOML value.
+ */
+typedef enum {
+    FOSSIL_MEDIA_TOML_STRING = 0,
+    FOSSIL_MEDIA_TOML_INTEGER,
+    FOSSIL_MEDIA_TOML_FLOAT,
+    FOSSIL_MEDIA_TOML_BOOLEAN,
+    FOSSIL_MEDIA_TOML_DATETIME,
+    FOSSIL_MEDIA_TOML_ARRAY,
+    FOSSIL_MEDIA_TOML_TABLE       /**< Inline table (`{ a = 1 }`) */
+} fossil_media_toml_type_t;
+
+/**
+ * @brief Offset date-time, local date-time, local date or local time.
+ *
+ * The `has_*` flags tell which parts were present in the source.
+ */
+typedef struct fossil_media_toml_datetime_t {
+    int year, month, day;
+    int hour, minute, second;
+    int32_t nanosecond;
+    int16_t offset_minutes;       /**< UTC offset when has_offset is set */
+    uint8_t has_date;
+    uint8_t has_time;
+    uint8_t has_offset;
+} fossil_media_toml_datetime_t;
+
+struct fossil_media_toml_entry_t;
+
+/**
+ * @brief Typed TOML value, converted once at parse time.
+ */
+typedef struct fossil_media_toml_value_t {
+    fossil_media_toml_type_t type;
+    union {
+        struct {
+            char *data;           /**< Decoded, null-terminated */
+            size_t length;        /**< Length (strings may contain NUL via escapes) */
+        } string;
+        int64_t integer;
+        double floating;
+        int boolean;
+        fossil_media_toml_datetime_t datetime;
+        struct {
+            struct fossil_media_toml_value_t *items;
+            size_t count;
+        } array;
+        struct {
+            struct fossil_media_toml_entry_t *entries;
+            size_t count;
+        } table;
+    } as;
+} fossil_media_toml_value_t;
+
 /**
  * @brief Representation of a TOML key-value pair.
  */
 typedef struct fossil_media_toml_entry_t {
-    char *key;      /**< The key name */
-    char *value;    /**< The string value (numbers are stored as strings and can be converted) */
+    char *key;      /**< The key name: parts joined with '.', parts that are not bare keys
+                         double-quoted (`site."google.com"`) */
+    char *value;    /**< The value as text: decoded for strings, source text for anything else */
+    fossil_media_toml_value_t typed; /**< The value with its TOML type */
 } fossil_media_toml_entry_t;
 
 /**
  * @brief Representation of a parsed TOML table (section).
  */
 typedef struct fossil_media_toml_table_t {
-    char *name;                             /**< Table name */
+    char *name;                             /**< Table name (NULL for the root table) */
     fossil_media_toml_entry_t *entries;     /**< Array of key-value pairs */
     size_t entry_count;                     /**< Number of entries */
+    int array_element;                      /**< Defined by an `[[name]]` header */
 } fossil_media_toml_table_t;
 
+/**
+ * @brief Storage and key index of a parsed document (opaque).
+ */
+typedef struct fossil_media_toml_doc fossil_media_toml_doc_t;
+
 /**
  * @brief Main parsed TOML document.
  */
 typedef struct fossil_media_toml_t {
     fossil_media_toml_table_t *tables;  /**< Array of tables */
     size_t table_count;                 /**< Number of tables */
+    fossil_media_toml_doc_t *doc;       /**< Owns parsed memory and the key index (NULL if built by hand) */
 } fossil_media_toml_t;
 
+/**
+ * @brief Compiled dotted key (opaque).
+ */
+typedef struct fossil_media_toml_key fossil_media_toml_key_t;
+
 /**
  * @brief Parse TOML data from a string.
  *
+ * Single pass over the input with no global state, so any number of
+ * threads may parse at once. Values are converted to their TOML types
+ * while parsing; see fossil_media_toml_get_value(). The root table is
+ * always first, followed by one table per `[header]` or `[[header]]` in
+ * source order. A key defined twice, a value redefined as a table (by a
+ * dotted key or a header), a `[header]` repeated, or a `[header]` and
+ * `[[header]]` of the same name is a parse error.
+ *
+ * All memory of the document comes from one arena, and every key is indexed
+ * by its fully-qualified dotted name for fossil_media_toml_find().
+ *
  * @param input The TOML string to parse.
  * @param out_toml Pointer to TOML document struct to populate.
- * @return 0 on success, nonzero on error.
+ * @return 0 on success, nonzero on error (the document is left empty).
  */
 int fossil_media_toml_parse(const char *input, fossil_media_toml_t *out_toml);
 
 /**
  * @brief Retrieve a value from a specific table by key.
  *
+ * Names are spelled as in fossil_media_toml_find(). A key that is not
+ * found that way is tried once more as a single part, so `quoted key`
+ * finds `"quoted key" = 1`.
+ *
  * @param toml Pointer to parsed TOML document.
  * @param table_name Table name to search (NULL for root).
  * @param key Key name to search for.
@@ -77,6 +163,132 @@ int fossil_media_toml_parse(const char *input, fossil_media_toml_t *out_toml);
  */
 const char *fossil_media_toml_get(const fossil_media_toml_t *toml, const char *table_name, const char *key);
 
+/**
+ * @brief Retrieve the typed value of a key.
+ *
+ * @param toml Pointer to parsed TOML document.
+ * @param table_name Table name to search (NULL for root).
+ * @param key Key name to search for.
+ * @return Value, or NULL if not found.
+ */
+const fossil_media_toml_value_t *fossil_media_toml_get_value(const fossil_media_toml_t *toml,
+                                                             const char *table_name, const char *key);
+
+/**
+ * @brief Retrieve an integer value.
+ *
+ * @return 0 on success, -1 if the key is missing or not an integer.
+ */
+int fossil_media_toml_get_int(const fossil_media_toml_t *toml, const char *table_name, const char *key, int64_t *out);
+
+/**
+ * @brief Retrieve a float value (integers are converted).
+ *
+ * @return 0 on success, -1 if the key is missing or not a number.
+ */
+int fossil_media_toml_get_double(const fossil_media_toml_t *toml, const char *table_name, const char *key, double *out);
+
+/**
+ * @brief Retrieve a boolean value.
+ *
+ * @return 0 on success, -1 if the key is missing or not a boolean.
+ */
+int fossil_media_toml_get_bool(const fossil_media_toml_t *toml, const char *table_name, const char *key, int *out);
+
+/**
+ * @brief Look up a key by its fully-qualified dotted name.
+ *
+ * Names join the table name and key with `.`, as in `server.http.port`;
+ * root keys are bare. Keys inside inline tables continue the path. Tables
+ * defined by `[[name]]` are numbered in source order, so the second element
+ * is `name[1]`, and tables nested under an array element use the element it
+ * belongs to (`fruit[0].physical.color`). Inline tables inside arrays are
+ * numbered the same way. Parts that are not bare keys are written as basic
+ * strings, so `site."google.com"` differs from `site.google.com`.
+ *
+ * One hash probe; hand-built documents without an index are searched
+ * linearly by table name and key instead.
+ *
+ * @param toml Pointer to parsed TOML document.
+ * @param path Fully-qualified dotted name.
+ * @return Entry, or NULL if not found.
+ */
+const fossil_media_toml_entry_t *fossil_media_toml_find(const fossil_media_toml_t *toml, const char *path);
+
+/**
+ * @brief Precompute the hash of a dotted name for repeated lookups.
+ *
+ * @param path Fully-qualified dotted name (see fossil_media_toml_find()).
+ * @return Compiled key, or NULL on allocation failure. Free with
+ *         fossil_media_toml_key_free().
+ */
+fossil_media_toml_key_t *fossil_media_toml_key_compile(const char *path);
+
+/**
+ * @brief Free a compiled key.
+ */
+void fossil_media_toml_key_free(fossil_media_toml_key_t *key);
+
+/**
+ * @brief Look up a compiled key; the same as fossil_media_toml_find()
+ *        without hashing the name again.
+ *
+ * @return Entry, or NULL if not found.
+ */
+const fossil_media_toml_entry_t *fossil_media_toml_find_key(const fossil_media_toml_t *toml,
+                                                            const fossil_media_toml_key_t *key);
+
+/**
+ * @brief Callback for fossil_media_toml_foreach().
+ *
+ * @param user User pointer passed through.
+ * @param name Fully-qualified dotted name (not NUL-terminated).
+ * @param len Length of @p name.
+ * @param entry Entry under that name.
+ * @return 0 to continue, non-zero to stop the walk.
+ */
+typedef int (*fossil_media_toml_visit_fn)(void *user, const char *name, size_t len,
+                                          const fossil_media_toml_entry_t *entry);
+
+/**
+ * @brief Visit every entry in document order under the name
+ *        fossil_media_toml_find() knows it by.
+ *
+ * Entries inside inline tables and arrays of tables are visited after the
+ * entry holding them.
+ *
+ * @param toml Pointer to parsed TOML document.
+ * @param fn Callback invoked for each entry.
+ * @param user Passed to @p fn.
+ * @return 0 on success (including when @p fn stopped early), -1 on error.
+ */
+int fossil_media_toml_foreach(const fossil_media_toml_t *toml, fossil_media_toml_visit_fn fn, void *user);
+
+/**
+ * @brief Write a document as TOML text.
+ *
+ * Root keys come first, then every table in document order under its
+ * `[name]` or `[[name]]` header. Values are written from their typed form:
+ * strings as basic strings with escapes, floats so they read back exactly,
+ * arrays and inline tables on one line. Entries of hand-built documents that
+ * only set `value` are written as strings. Output is staged in a small
+ * buffer and handed to the sink as it fills.
+ *
+ * @param toml Document to write.
+ * @param sink Output callback, e.g. fossil_media_sink_file(),
+ *             fossil_media_sink_fd() or fossil_media_sink_buffer().
+ * @param user Opaque pointer passed to the sink.
+ * @return 0 on success, -1 on invalid input, or the sink's error.
+ */
+int fossil_media_toml_write(const fossil_media_toml_t *toml, fossil_media_sink_fn sink, void *user);
+
+/**
+ * @brief Write a document into a new string.
+ *
+ * @return Null-terminated text (free with free()), or NULL on error.
+ */
+char *fossil_media_toml_write_string(const fossil_media_toml_t *toml);
+
 /**
  * @brief Free a parsed TOML document.
  *
@@ -86,6 +298,7 @@ void fossil_media_toml_free(fossil_media_toml_t *toml);
 
 #ifdef __cplusplus
 }
+#include <cstdlib>
 #include <string>
 #include <stdexcept>
 #include <utility>
@@ -94,6 +307,50 @@ namespace fossil {
 
     namespace media {
 
+        /**
+         * @brief Compiled dotted key for repeated lookups.
+         */
+        class TomlKey {
+        public:
+            /**
+             * @brief Compile a fully-qualified dotted name.
+             * @throw std::runtime_error on allocation failure
+             */
+            explicit TomlKey(const std::string& path)
+            : key_(::fossil_media_toml_key_compile(path.c_str())) {
+                if (!key_) {
+                    throw std::runtime_error("Failed to compile TOML key");
+                }
+            }
+
+            ~TomlKey() {
+                ::fossil_media_toml_key_free(key_);
+            }
+
+            TomlKey(const TomlKey&) = delete;
+            TomlKey& operator=(const TomlKey&) = delete;
+
+            TomlKey(TomlKey&& other) noexcept : key_(other.key_) {
+                other.key_ = nullptr;
+            }
+            TomlKey& operator=(TomlKey&& other) noexcept {
+                if (this != &other) {
+                    ::fossil_media_toml_key_free(key_);
+                    key_ = other.key_;
+                    other.key_ = nullptr;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Access the underlying compiled key.
+             */
+            const fossil_media_toml_key_t* get() const { return key_; }
+
+        private:
+            fossil_media_toml_key_t* key_;
+        };
+
         /**
          * @brief C++ wrapper for parsed TOML documents.
          *
@@ -117,8 +374,7 @@ namespace fossil {
              * @brief Move constructor.
              */
             Toml(Toml&& other) noexcept : doc_{other.doc_} {
-                other.doc_.tables = nullptr;
-                other.doc_.table_count = 0;
+                other.doc_ = fossil_media_toml_t{};
             }
 
             /**
@@ -128,8 +384,7 @@ namespace fossil {
                 if (this != &other) {
                     fossil_media_toml_free(&doc_);
                     doc_ = other.doc_;
-                    other.doc_.tables = nullptr;
-                    other.doc_.table_count = 0;
+                    other.doc_ = fossil_media_toml_t{};
                 }
                 return *this;
             }
@@ -167,6 +422,78 @@ namespace fossil {
                 return val ? std::string(val) : std::string();
             }
 
+            /**
+             * @brief Retrieve an integer value.
+             *
+             * @param table_name Table name to search (empty for root).
+             * @param key Key name to search for.
+             * @param fallback Returned when the key is missing or not an integer.
+             */
+            int64_t get_int(const std::string& table_name, const std::string& key, int64_t fallback = 0) const {
+                int64_t out;
+                return fossil_media_toml_get_int(&doc_, table_name.empty() ? nullptr : table_name.c_str(),
+                                                 key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Retrieve a float value (integers are converted).
+             */
+            double get_double(const std::string& table_name, const std::string& key, double fallback = 0.0) const {
+                double out;
+                return fossil_media_toml_get_double(&doc_, table_name.empty() ? nullptr : table_name.c_str(),
+                                                    key.c_str(), &out) == 0 ? out : fallback;
+            }
+
+            /**
+             * @brief Retrieve a boolean value.
+             */
+            bool get_bool(const std::string& table_name, const std::string& key, bool fallback = false) const {
+                int out;
+                return fossil_media_toml_get_bool(&doc_, table_name.empty() ? nullptr : table_name.c_str(),
+                                                  key.c_str(), &out) == 0 ? out != 0 : fallback;
+            }
+
+            /**
+             * @brief Look up a key by its fully-qualified dotted name.
+             *
+             * @param path Name such as "server.http.port".
+             * @return Value string, or empty string if not found.
+             */
+            std::string find(const std::string& path) const {
+                const fossil_media_toml_entry_t* e = fossil_media_toml_find(&doc_, path.c_str());
+                return e ? std::string(e->value) : std::string();
+            }
+
+            /**
+             * @brief Look up a compiled key.
+             *
+             * @return Value string, or empty string if not found.
+             */
+            std::string find(const TomlKey& key) const {
+                const fossil_media_toml_entry_t* e = fossil_media_toml_find_key(&doc_, key.get());
+                return e ? std::string(e->value) : std::string();
+            }
+
+            /**
+             * @brief Write the document as TOML text.
+             *
+             * @throws std::runtime_error if writing fails.
+             */
+            std::string dump() const {
+                char* text = fossil_media_toml_write_string(&doc_);
+                if (!text) {
+                    throw std::runtime_error("Failed to write TOML data");
+                }
+                std::string out(text);
+                free(text);
+                return out;
+            }
+
+            /**
+             * @brief Access the underlying document.
+             */
+            const fossil_media_toml_t* get() const { return &doc_; }
+
         private:
             fossil_media_toml_t doc_{};
         };
@@ -0,0 +1,233 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#ifndef FOSSIL_MEDIA_UTF8_H
+#define FOSSIL_MEDIA_UTF8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @brief Check that a byte string is well-formed UTF-8.
+ *
+ * Rejects overlong forms, surrogates, code points above U+10FFFF and
+ * truncated sequences. Blocks of 16 bytes are checked at once: ASCII
+ * runs with SSE2, and mixed text with the Keiser-Lemire lookup method
+ * when SSSE3 is enabled at build time.
+ *
+ * @param str        Bytes to check (need not be NUL-terminated).
+ * @param len        Number of bytes.
+ * @param error_pos  Receives the offset of the first invalid byte on
+ *                   failure (may be NULL).
+ * @return 0 if the input is valid, -1 otherwise.
+ */
+int fossil_media_utf8_validate(const char *str, size_t len, size_t *error_pos);
+
+/**
+ * @brief Count the code points in valid UTF-8.
+ *
+ * Counts every byte that is not a continuation byte, so the result for
+ * malformed input is only an estimate.
+ *
+ * @param str UTF-8 text.
+ * @param len Length in bytes.
+ * @return Number of code points.
+ */
+size_t fossil_media_utf8_count(const char *str, size_t len);
+
+/**
+ * @brief Decode one code point.
+ *
+ * @param str UTF-8 text.
+ * @param len Bytes available.
+ * @param cp  Receives the code point.
+ * @return Bytes consumed (1 to 4), or 0 if the sequence is malformed.
+ */
+size_t fossil_media_utf8_decode(const char *str, size_t len, uint32_t *cp);
+
+/**
+ * @brief Encode one code point.
+ *
+ * @param cp  Code point; surrogates and values above U+10FFFF are
+ *            encoded as U+FFFD.
+ * @param out Buffer of at least 4 bytes (not NUL-terminated).
+ * @return Bytes written (1 to 4).
+ */
+size_t fossil_media_utf8_encode(uint32_t cp, char *out);
+
+/**
+ * @brief Convert UTF-8 to UTF-16.
+ *
+ * Pass a NULL `dst` to only compute the output length.
+ *
+ * @param src      UTF-8 input.
+ * @param len      Input length in bytes.
+ * @param dst      Output code units, or NULL.
+ * @param dst_cap  Capacity of `dst` in code units.
+ * @param dst_len  Receives the number of code units the full output needs.
+ * @return 0 on success, -1 if the input is not valid UTF-8 or `dst` is
+ *         too small (then `*dst_len` > `dst_cap`).
+ */
+int fossil_media_utf8_to_utf16(const char *src, size_t len, uint16_t *dst, size_t dst_cap, size_t *dst_len);
+
+/**
+ * @brief Convert UTF-16 to UTF-8.
+ *
+ * Unpaired surrogates are rejected.
+ *
+ * @param src      UTF-16 input.
+ * @param len      Input length in code units.
+ * @param dst      Output buffer, or NULL to only compute the length.
+ * @param dst_cap  Capacity of `dst` in bytes (no terminator is written).
+ * @param dst_len  Receives the number of bytes the full output needs.
+ * @return 0 on success, -1 on invalid input or a too small `dst`.
+ */
+int fossil_media_utf16_to_utf8(const uint16_t *src, size_t len, char *dst, size_t dst_cap, size_t *dst_len);
+
+/**
+ * @brief Convert UTF-8 to UTF-32.
+ *
+ * @param src      UTF-8 input.
+ * @param len      Input length in bytes.
+ * @param dst      Output code points, or NULL to only compute the length.
+ * @param dst_cap  Capacity of `dst` in code points.
+ * @param dst_len  Receives the number of code points in the full output.
+ * @return 0 on success, -1 on invalid input or a too small `dst`.
+ */
+int fossil_media_utf8_to_utf32(const char *src, size_t len, uint32_t *dst, size_t dst_cap, size_t *dst_len);
+
+/**
+ * @brief Convert UTF-32 to UTF-8.
+ *
+ * Surrogates and values above U+10FFFF are rejected.
+ *
+ * @param src      UTF-32 input.
+ * @param len      Input length in code points.
+ * @param dst      Output buffer, or NULL to only compute the length.
+ * @param dst_cap  Capacity of `dst` in bytes (no terminator is written).
+ * @param dst_len  Receives the number of bytes the full output needs.
+ * @return 0 on success, -1 on invalid input or a too small `dst`.
+ */
+int fossil_media_utf32_to_utf8(const uint32_t *src, size_t len, char *dst, size_t dst_cap, size_t *dst_len);
+
+#ifdef __cplusplus
+}
+#include <string>
+#include <string_view>
+#include <stdexcept>
+
+namespace fossil {
+
+    namespace media {
+
+        /**
+         * @brief UTF-8 validation and transcoding helpers.
+         */
+        class Utf8 {
+        public:
+            /**
+             * @brief Check that text is well-formed UTF-8.
+             */
+            static bool valid(std::string_view text) {
+                return fossil_media_utf8_validate(text.data(), text.size(), nullptr) == 0;
+            }
+
+            /**
+             * @brief Count the code points in valid UTF-8.
+             */
+            static size_t count(std::string_view text) {
+                return fossil_media_utf8_count(text.data(), text.size());
+            }
+
+            /**
+             * @brief Convert UTF-8 to UTF-16.
+             * @throws std::runtime_error on invalid UTF-8.
+             */
+            static std::u16string to_utf16(std::string_view text) {
+                size_t n = 0;
+                if (fossil_media_utf8_to_utf16(text.data(), text.size(), nullptr, 0, &n) != 0) {
+                    throw std::runtime_error("Utf8: invalid UTF-8");
+                }
+                std::u16string out(n, u'\0');
+                fossil_media_utf8_to_utf16(text.data(), text.size(), reinterpret_cast<uint16_t*>(&out[0]), n, &n);
+                return out;
+            }
+
+            /**
+             * @brief Convert UTF-16 to UTF-8.
+             * @throws std::runtime_error on unpaired surrogates.
+             */
+            static std::string from_utf16(std::u16string_view text) {
+                size_t n = 0;
+                const uint16_t *src = reinterpret_cast<const uint16_t*>(text.data());
+                if (fossil_media_utf16_to_utf8(src, text.size(), nullptr, 0, &n) != 0) {
+                    throw std::runtime_error("Utf8: invalid UTF-16");
+                }
+                std::string out(n, '\0');
+                fossil_media_utf16_to_utf8(src, text.size(), &out[0], n, &n);
+                return out;
+            }
+
+            /**
+             * @brief Convert UTF-8 to UTF-32.
+             * @throws std::runtime_error on invalid UTF-8.
+             */
+            static std::u32string to_utf32(std::string_view text) {
+                size_t n = 0;
+                if (fossil_media_utf8_to_utf32(text.data(), text.size(), nullptr, 0, &n) != 0) {
+                    throw std::runtime_error("Utf8: invalid UTF-8");
+                }
+                std::u32string out(n, U'\0');
+                fossil_media_utf8_to_utf32(text.data(), text.size(), reinterpret_cast<uint32_t*>(&out[0]), n, &n);
+                return out;
+            }
+
+            /**
+             * @brief Convert UTF-32 to UTF-8.
+             * @throws std::runtime_error on surrogates or out-of-range values.
+             */
+            static std::string from_utf32(std::u32string_view text) {
+                size_t n = 0;
+                const uint32_t *src = reinterpret_cast<const uint32_t*>(text.data());
+                if (fossil_media_utf32_to_utf8(src, text.size(), nullptr, 0, &n) != 0) {
+                    throw std::runtime_error("Utf8: invalid UTF-32");
+                }
+                std::string out(n, '\0');
+                fossil_media_utf32_to_utf8(src, text.size(), &out[0], n, &n);
+                return out;
+            }
+        };
+
+    } // namespace media
+
+} // namespace fossil
+
+#endif
+
+#endif /* FOSSIL_MEDIA_UTF8_H */
@@ -28,24 +28,138 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "media.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/**
+ * @brief Resolved type of a YAML node.
+ *
+ * Scalars are resolved with the YAML 1.2 core schema: quoted and block
+ * scalars (and `!!str`) are strings, plain scalars may be null, booleans,
+ * integers or floats.
+ */
+typedef enum {
+    FOSSIL_MEDIA_YAML_TYPE_STRING = 0,
+    FOSSIL_MEDIA_YAML_TYPE_NULL,
+    FOSSIL_MEDIA_YAML_TYPE_BOOL,
+    FOSSIL_MEDIA_YAML_TYPE_INT,
+    FOSSIL_MEDIA_YAML_TYPE_FLOAT,
+    FOSSIL_MEDIA_YAML_TYPE_MAPPING,
+    FOSSIL_MEDIA_YAML_TYPE_SEQUENCE
+} fossil_media_yaml_type_t;
+
+/* Owner of a parsed tree's memory (opaque) */
+typedef struct fossil_media_yaml_doc fossil_media_yaml_doc_t;
+
 /**
  * @brief YAML key-value pair node.
+ *
+ * A node is either a mapping entry (`key` set) or a sequence item (`key`
+ * NULL). Mapping and sequence values keep their entries/items in `child`.
  */
 typedef struct fossil_media_yaml_node_t {
-    char *key;                           /**< YAML key string */
-    char *value;                         /**< YAML value string */
+    char *key;                           /**< YAML key string (NULL for sequence items) */
+    char *value;                         /**< YAML value string ("" for collections) */
     size_t indent;                       /**< Indentation level */
     struct fossil_media_yaml_node_t *next; /**< Next node in linked list */
-    struct fossil_media_yaml_node_t *child; /**< Child node (for nested maps) */
+    struct fossil_media_yaml_node_t *child; /**< Child node (for nested maps and sequences) */
+    fossil_media_yaml_type_t type;       /**< Resolved type of the value */
+    fossil_media_yaml_doc_t *doc;        /**< Set on the head of a parsed tree; owns its memory */
 } fossil_media_yaml_node_t;
 
+/* ---------------------------------------------------------------------------
+ * Events
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief Kinds of parse events, in the order a document produces them.
+ */
+typedef enum {
+    FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_START,
+    FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_END,
+    FOSSIL_MEDIA_YAML_EVENT_MAPPING_START,
+    FOSSIL_MEDIA_YAML_EVENT_MAPPING_END,
+    FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START,
+    FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END,
+    FOSSIL_MEDIA_YAML_EVENT_SCALAR
+} fossil_media_yaml_event_type_t;
+
+/**
+ * @brief How a scalar was written.
+ */
+typedef enum {
+    FOSSIL_MEDIA_YAML_STYLE_PLAIN,
+    FOSSIL_MEDIA_YAML_STYLE_SINGLE_QUOTED,
+    FOSSIL_MEDIA_YAML_STYLE_DOUBLE_QUOTED,
+    FOSSIL_MEDIA_YAML_STYLE_LITERAL,
+    FOSSIL_MEDIA_YAML_STYLE_FOLDED
+} fossil_media_yaml_style_t;
+
+/**
+ * @brief One parse event.
+ *
+ * Inside a mapping, scalar and collection events alternate between keys and
+ * values. `value` is not null-terminated; it points straight into the input
+ * when the scalar needed no decoding and into parser scratch otherwise, and
+ * is only valid during the callback.
+ *
+ * As an extension kept from the original line parser, a scalar written on a
+ * key's line and followed by a more-indented block of keys is reported as a
+ * MAPPING_START whose `value` carries that scalar.
+ */
+typedef struct fossil_media_yaml_event {
+    fossil_media_yaml_event_type_t type;
+    const char *value;               /**< Scalar text (or see above), may be NULL */
+    size_t length;                   /**< Length of `value` */
+    fossil_media_yaml_type_t scalar_type; /**< Core-schema type of a scalar; always STRING for
+                                               quoted, block and `!!str` scalars and plain mapping keys */
+    fossil_media_yaml_style_t style; /**< Scalar style */
+    int flow;                        /**< Collection written in flow style (`[...]`, `{...}`) */
+    size_t line;                     /**< 1-based line where the event starts */
+    size_t column;                   /**< 0-based column where the event starts */
+} fossil_media_yaml_event_t;
+
+/**
+ * @brief Event callback. Return 0 to continue, nonzero to stop parsing.
+ */
+typedef int (*fossil_media_yaml_event_fn)(const fossil_media_yaml_event_t *event, void *user);
+
+/**
+ * @brief Scan YAML text and report its structure as events.
+ *
+ * Handles block and flow mappings and sequences, plain, quoted, literal and
+ * folded scalars, comments, `---`/`...` document markers and directives.
+ * Anchors and tags are skipped (except `!!str`), and aliases are reported as
+ * plain `*name` scalars. Complex keys (`? key`) are a syntax error. Nothing
+ * is copied per line; only scalars that need unescaping or folding go
+ * through a scratch buffer.
+ *
+ * @param input YAML text (need not be null-terminated).
+ * @param len Length of `input` in bytes.
+ * @param fn Event callback.
+ * @param user Opaque pointer passed to `fn`.
+ * @return 0 on success, -1 on a syntax error or allocation failure, or the
+ *         nonzero value returned by `fn`.
+ */
+int fossil_media_yaml_parse_events(const char *input, size_t len, fossil_media_yaml_event_fn fn, void *user);
+
+/* ---------------------------------------------------------------------------
+ * Trees
+ * ------------------------------------------------------------------------- */
+
 /**
  * @brief Parse YAML string into a linked list of nodes.
+ *
+ * The first document of the input is built into a tree whose nodes and
+ * strings live in one arena owned by the returned head. A root mapping
+ * yields its entries, a root sequence its items; a document that is a lone
+ * scalar yields nothing. Lines that cannot be read as a key inside a block
+ * mapping are skipped, but complex keys (`? key`) fail the parse.
+ *
  * @param input YAML text (null-terminated)
  * @return Head of linked list, or NULL on failure.
  */
@@ -71,8 +185,249 @@ const char *fossil_media_yaml_get(const fossil_media_yaml_node_t *head, const ch
  */
 void fossil_media_yaml_print(const fossil_media_yaml_node_t *head);
 
+/* ---------------------------------------------------------------------------
+ * Path lookups
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief Compiled path expression (opaque).
+ */
+typedef struct fossil_media_yaml_path fossil_media_yaml_path_t;
+
+/**
+ * @brief Build the lookup index of a parsed tree.
+ *
+ * Path lookups build the index on first use. Call this up front when several
+ * threads will query the same tree, since the lazy build is not synchronized.
+ * Trees that were not produced by fossil_media_yaml_parse() have no index and
+ * are searched linearly.
+ *
+ * @param head Head returned by fossil_media_yaml_parse().
+ * @return 0 on success, -1 on invalid input or allocation failure.
+ */
+int fossil_media_yaml_index(const fossil_media_yaml_node_t *head);
+
+/**
+ * @brief Compile a path such as `spec.template.containers[0].image`.
+ *
+ * Segments are separated by `.`; `[N]` selects a sequence item and
+ * `["key"]` (or `['key']`) a key containing dots or brackets.
+ *
+ * @param path Path expression (null-terminated).
+ * @return Compiled path, or NULL on a syntax error. Free with
+ *         fossil_media_yaml_path_free().
+ */
+fossil_media_yaml_path_t *fossil_media_yaml_path_compile(const char *path);
+
+/**
+ * @brief Free a compiled path.
+ */
+void fossil_media_yaml_path_free(fossil_media_yaml_path_t *path);
+
+/**
+ * @brief Resolve a compiled path against a tree.
+ *
+ * Each segment costs one hash probe. Where a mapping repeats a key, the
+ * first occurrence wins.
+ *
+ * @return Matching node, or NULL if the path does not exist.
+ */
+const fossil_media_yaml_node_t *fossil_media_yaml_path_find(const fossil_media_yaml_node_t *head,
+                                                            const fossil_media_yaml_path_t *path);
+
+/**
+ * @brief Resolve a path expression against a tree.
+ *
+ * Convenience for one-off lookups; compile the path when it is reused.
+ *
+ * @return Matching node, or NULL if the path is invalid or does not exist.
+ */
+const fossil_media_yaml_node_t *fossil_media_yaml_find(const fossil_media_yaml_node_t *head, const char *path);
+
+/**
+ * @brief Value at a path expression.
+ *
+ * Unlike fossil_media_yaml_get(), which returns the first key of that name
+ * at any depth, this only matches the exact path.
+ *
+ * @return Value string, or NULL if the path does not exist.
+ */
+const char *fossil_media_yaml_get_path(const fossil_media_yaml_node_t *head, const char *path);
+
+/* ---------------------------------------------------------------------------
+ * Multi-document streams
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief Reader yielding the documents of a `---`-separated stream (opaque).
+ */
+typedef struct fossil_media_yaml_stream fossil_media_yaml_stream_t;
+
+/**
+ * @brief Read documents from a memory buffer.
+ *
+ * @param data Stream text; must stay valid while the reader is in use.
+ * @param len Length of `data` in bytes.
+ * @return Reader, or NULL on allocation failure.
+ */
+fossil_media_yaml_stream_t *fossil_media_yaml_stream_open_buffer(const char *data, size_t len);
+
+/**
+ * @brief Read documents from a file descriptor.
+ *
+ * Input is read in blocks as documents are requested, so the whole stream
+ * is never held in memory at once. The descriptor is not closed.
+ *
+ * @param fd Readable file descriptor.
+ * @return Reader, or NULL on invalid input or allocation failure.
+ */
+fossil_media_yaml_stream_t *fossil_media_yaml_stream_open_fd(int fd);
+
+/**
+ * @brief Parse the next document.
+ *
+ * The returned tree belongs to the reader and stays valid until the next
+ * call or until the reader is closed; its memory is reused for the next
+ * document. fossil_media_yaml_free() on it is a no-op. Path lookups work
+ * as on any parsed tree. An empty document or one holding a lone scalar
+ * yields a NULL tree, as with fossil_media_yaml_parse().
+ *
+ * @param stream Reader.
+ * @param out_doc Receives the document's tree.
+ * @return 1 if a document was read, 0 at the end of the stream, -1 on a
+ *         syntax or read error.
+ */
+int fossil_media_yaml_stream_next(fossil_media_yaml_stream_t *stream, fossil_media_yaml_node_t **out_doc);
+
+/**
+ * @brief Close a reader and release its memory.
+ */
+void fossil_media_yaml_stream_close(fossil_media_yaml_stream_t *stream);
+
+/**
+ * @brief Parse every document of an in-memory stream, optionally in parallel.
+ *
+ * A pre-scan splits the input at `---`/`...` marker lines, which always
+ * end a document, then the pieces are parsed on a worker pool. The result
+ * matches reading the stream with fossil_media_yaml_stream_next().
+ *
+ * @param data Stream text.
+ * @param len Length of `data` in bytes.
+ * @param threads Worker count (0 for one per CPU, 1 for serial).
+ * @param out_docs Receives a malloc'd array of trees (entries may be NULL,
+ *                 see fossil_media_yaml_stream_next()). Release it with
+ *                 fossil_media_yaml_free_all().
+ * @param out_count Receives the number of documents.
+ * @return 0 on success, -1 on a syntax error or allocation failure.
+ */
+int fossil_media_yaml_parse_all(const char *data, size_t len, size_t threads,
+                                fossil_media_yaml_node_t ***out_docs, size_t *out_count);
+
+/**
+ * @brief Free the documents returned by fossil_media_yaml_parse_all().
+ */
+void fossil_media_yaml_free_all(fossil_media_yaml_node_t **docs, size_t count);
+
+/* ---------------------------------------------------------------------------
+ * Emitting
+ * ------------------------------------------------------------------------- */
+
+/**
+ * @brief Quoting policy for string values.
+ *
+ * Scalars typed as null, bool, int or float are always written plain, and
+ * mapping keys are only quoted when they could not be read back otherwise.
+ */
+typedef enum {
+    FOSSIL_MEDIA_YAML_QUOTE_AUTO = 0, /**< Plain when it reads back unchanged, else quoted or literal block */
+    FOSSIL_MEDIA_YAML_QUOTE_SINGLE,   /**< Single quotes (double when escapes are needed) */
+    FOSSIL_MEDIA_YAML_QUOTE_DOUBLE    /**< Double quotes */
+} fossil_media_yaml_quote_t;
+
+/**
+ * @brief Emitter settings. Zero-initialize for the defaults.
+ */
+typedef struct {
+    size_t indent;                   /**< Spaces per nesting level (0 means 2) */
+    fossil_media_yaml_quote_t quote; /**< Quoting policy for strings */
+    int explicit_start;              /**< Write `---` before the first document too */
+} fossil_media_yaml_emit_options_t;
+
+/**
+ * @brief Event-driven YAML writer (opaque).
+ */
+typedef struct fossil_media_yaml_emitter fossil_media_yaml_emitter_t;
+
+/**
+ * @brief Create an emitter writing to a sink.
+ *
+ * Output is staged in a fixed internal buffer and handed to the sink as it
+ * fills. Each scalar is scanned once to pick the cheapest style that reads
+ * back as the same value.
+ *
+ * @param options Settings, or NULL for the defaults.
+ * @param sink Output callback.
+ * @param user Opaque pointer passed to the sink.
+ * @return Emitter, or NULL on invalid input or allocation failure.
+ */
+fossil_media_yaml_emitter_t *fossil_media_yaml_emitter_new(const fossil_media_yaml_emit_options_t *options,
+                                                           fossil_media_sink_fn sink, void *user);
+
+/**
+ * @brief Write one event.
+ *
+ * Events follow the shape produced by fossil_media_yaml_parse_events(), so
+ * this function can be passed to it directly as the callback (with the
+ * emitter as `user`) to re-emit a stream. Collections marked `flow` are
+ * written inline; a MAPPING_START carrying a `value` is written as that
+ * value followed by the indented entries. Document events may be omitted
+ * for a single document.
+ *
+ * @param event Event to write.
+ * @param emitter Emitter (void* for use as an event callback).
+ * @return 0 on success, -1 on an out-of-place event, or the sink's error.
+ */
+int fossil_media_yaml_emitter_event(const fossil_media_yaml_event_t *event, void *emitter);
+
+/**
+ * @brief Finish the output and flush it to the sink.
+ *
+ * @return 0 on success, -1 if a collection is still open, or the first
+ *         error seen.
+ */
+int fossil_media_yaml_emitter_finish(fossil_media_yaml_emitter_t *emitter);
+
+/**
+ * @brief Free an emitter (without flushing).
+ */
+void fossil_media_yaml_emitter_free(fossil_media_yaml_emitter_t *emitter);
+
+/**
+ * @brief Write a node tree as a YAML document.
+ *
+ * A head with a key is written as a mapping, otherwise as a sequence. Node
+ * types decide scalar quoting, so parsed trees read back with the same
+ * types; hand-built nodes default to strings.
+ *
+ * @param head Tree to write.
+ * @param options Settings, or NULL for the defaults.
+ * @param sink Output callback.
+ * @param user Opaque pointer passed to the sink.
+ * @return 0 on success, -1 on invalid input, or the sink's error.
+ */
+int fossil_media_yaml_emit(const fossil_media_yaml_node_t *head, const fossil_media_yaml_emit_options_t *options,
+                           fossil_media_sink_fn sink, void *user);
+
+/**
+ * @brief Write a node tree into a newly allocated string.
+ *
+ * @return Null-terminated YAML text, or NULL on failure. Caller must free().
+ */
+char *fossil_media_yaml_emit_string(const fossil_media_yaml_node_t *head, const fossil_media_yaml_emit_options_t *options);
+
 #ifdef __cplusplus
 }
+#include <cstdlib>
 #include <string>
 #include <stdexcept>
 #include <utility>
@@ -81,6 +436,117 @@ namespace fossil {
 
     namespace media {
 
+        /**
+         * @brief Compiled YAML path for repeated lookups.
+         */
+        class YamlPath {
+        public:
+            /**
+             * @brief Compile a path expression.
+             * @param path Path such as "spec.containers[0].image"
+             * @throw std::runtime_error on a malformed path
+             */
+            explicit YamlPath(const std::string& path)
+            : path_(::fossil_media_yaml_path_compile(path.c_str())) {
+                if (!path_) {
+                    throw std::runtime_error("Invalid YAML path");
+                }
+            }
+
+            ~YamlPath() {
+                ::fossil_media_yaml_path_free(path_);
+            }
+
+            YamlPath(const YamlPath&) = delete;
+            YamlPath& operator=(const YamlPath&) = delete;
+
+            YamlPath(YamlPath&& other) noexcept : path_(other.path_) {
+                other.path_ = nullptr;
+            }
+            YamlPath& operator=(YamlPath&& other) noexcept {
+                if (this != &other) {
+                    ::fossil_media_yaml_path_free(path_);
+                    path_ = other.path_;
+                    other.path_ = nullptr;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Access the underlying compiled path.
+             */
+            const fossil_media_yaml_path_t* get() const { return path_; }
+
+        private:
+            fossil_media_yaml_path_t* path_;
+        };
+
+        /**
+         * @brief Reader over a multi-document YAML stream.
+         */
+        class YamlStream {
+        public:
+            /**
+             * @brief Read from memory; `data` must outlive the reader.
+             * @throw std::runtime_error on allocation failure
+             */
+            YamlStream(const char* data, size_t len)
+            : stream_(::fossil_media_yaml_stream_open_buffer(data, len)) {
+                if (!stream_) {
+                    throw std::runtime_error("Failed to open YAML stream");
+                }
+            }
+
+            /**
+             * @brief Read from a file descriptor (not closed by the reader).
+             * @throw std::runtime_error on invalid descriptor
+             */
+            explicit YamlStream(int fd)
+            : stream_(::fossil_media_yaml_stream_open_fd(fd)) {
+                if (!stream_) {
+                    throw std::runtime_error("Failed to open YAML stream");
+                }
+            }
+
+            ~YamlStream() {
+                ::fossil_media_yaml_stream_close(stream_);
+            }
+
+            YamlStream(const YamlStream&) = delete;
+            YamlStream& operator=(const YamlStream&) = delete;
+
+            YamlStream(YamlStream&& other) noexcept : stream_(other.stream_) {
+                other.stream_ = nullptr;
+            }
+            YamlStream& operator=(YamlStream&& other) noexcept {
+                if (this != &other) {
+                    ::fossil_media_yaml_stream_close(stream_);
+                    stream_ = other.stream_;
+                    other.stream_ = nullptr;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Parse the next document.
+             * @param doc Receives the tree, valid until the next call
+             * @return true if a document was read, false at the end
+             * @throw std::runtime_error on a syntax or read error
+             */
+            bool next(const fossil_media_yaml_node_t*& doc) {
+                fossil_media_yaml_node_t* head = nullptr;
+                int rc = ::fossil_media_yaml_stream_next(stream_, &head);
+                if (rc < 0) {
+                    throw std::runtime_error("Failed to parse YAML document");
+                }
+                doc = head;
+                return rc == 1;
+            }
+
+        private:
+            fossil_media_yaml_stream_t* stream_;
+        };
+
         /**
          * @brief C++ wrapper for YAML parsing and manipulation.
          */
@@ -138,6 +604,41 @@ namespace fossil {
                 ::fossil_media_yaml_print(head_);
             }
 
+            /**
+             * @brief Write the document as YAML text.
+             * @param options Emitter settings, or nullptr for the defaults
+             * @return YAML text
+             * @throw std::runtime_error on failure
+             */
+            std::string emit(const fossil_media_yaml_emit_options_t* options = nullptr) const {
+                char* text = ::fossil_media_yaml_emit_string(head_, options);
+                if (!text) {
+                    throw std::runtime_error("Failed to emit YAML");
+                }
+                std::string out(text);
+                free(text);
+                return out;
+            }
+
+            /**
+             * @brief Get the value at an exact path (e.g. "spec.containers[0].image").
+             * @param path Path expression
+             * @return Value string, or nullptr if not found.
+             */
+            const char* get_path(const std::string& path) const {
+                return ::fossil_media_yaml_get_path(head_, path.c_str());
+            }
+
+            /**
+             * @brief Get the value at a compiled path.
+             * @param path Compiled path
+             * @return Value string, or nullptr if not found.
+             */
+            const char* get_path(const YamlPath& path) const {
+                const fossil_media_yaml_node_t* node = ::fossil_media_yaml_path_find(head_, path.get());
+                return node ? node->value : nullptr;
+            }
+
         private:
             fossil_media_yaml_node_t* head_;
         };
@@ -24,6 +24,7 @@
  */
 #include "fossil/media/fson.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -97,7 +98,7 @@
  * @note For more details on the FSON specification, refer to the project documentation.
  */
 
-fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil_media_fson_error_t *err_out) {
+static fossil_media_fson_value_t *fson_parse_value(const char *json_text, fossil_media_fson_error_t *err_out, int unwrap) {
     const char *input_start = json_text;
     if (json_text == NULL) {
         if (err_out) {
@@ -116,7 +117,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
         json_text++;
         while (isspace((unsigned char)*json_text)) json_text++;
         // Special case: { null: null }
-        if (strncmp(json_text, "null", 4) == 0) {
+        if (unwrap && strncmp(json_text, "null", 4) == 0) {
             const char *tmp = json_text + 4;
             while (isspace((unsigned char)*tmp)) tmp++;
             if (*tmp == ':') {
@@ -274,7 +275,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
                 }
                 strncpy(obj_buf, obj_start, obj_len);
                 obj_buf[obj_len] = '\0';
-                val = fossil_media_fson_parse(obj_buf, NULL);
+                val = fson_parse_value(obj_buf, NULL, unwrap);
                 free(obj_buf);
             }
             // Handle nested array
@@ -302,7 +303,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
                 }
                 strncpy(arr_buf, arr_start, arr_len);
                 arr_buf[arr_len] = '\0';
-                val = fossil_media_fson_parse(arr_buf, NULL);
+                val = fson_parse_value(arr_buf, NULL, unwrap);
                 free(arr_buf);
             }
             // Handle enum
@@ -651,7 +652,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
             while (isspace((unsigned char)*json_text)) json_text++;
             if (*json_text == ',') json_text++;
         }
-        if (obj->u.object.count == 1 &&
+        if (unwrap && obj->u.object.count == 1 &&
             obj->u.object.keys[0] &&
             strcmp(obj->u.object.keys[0], "null") == 0 &&
             obj->u.object.values[0] &&
@@ -664,14 +665,14 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
             }
             return fossil_media_fson_new_null();
         }
-        if (found_one) {
+        if (found_one || !unwrap) {
             if (err_out) {
                 err_out->code = FOSSIL_MEDIA_FSON_OK;
                 err_out->position = 0;
                 snprintf(err_out->message, sizeof(err_out->message), "Parsed object");
             }
             // If only one key, return its value directly for compatibility
-            if (obj->u.object.count == 1) {
+            if (unwrap && obj->u.object.count == 1) {
                 fossil_media_fson_value_t *single = fossil_media_fson_clone(obj->u.object.values[0]);
                 fossil_media_fson_free(obj);
                 return single;
@@ -731,7 +732,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
                 }
                 strncpy(obj_buf, obj_start, obj_len);
                 obj_buf[obj_len] = '\0';
-                fossil_media_fson_value_t *item = fossil_media_fson_parse(obj_buf, NULL);
+                fossil_media_fson_value_t *item = fson_parse_value(obj_buf, NULL, unwrap);
                 free(obj_buf);
                 if (item) {
                     fossil_media_fson_array_append(arr, item);
@@ -759,7 +760,7 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
                 }
                 strncpy(arr_buf, arr_start, arr_len);
                 arr_buf[arr_len] = '\0';
-                fossil_media_fson_value_t *item = fossil_media_fson_parse(arr_buf, NULL);
+                fossil_media_fson_value_t *item = fson_parse_value(arr_buf, NULL, unwrap);
                 free(arr_buf);
                 if (item) {
                     fossil_media_fson_array_append(arr, item);
@@ -1064,6 +1065,28 @@ fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil
     return NULL;
 }
 
+/* Reject malformed UTF-8 once up front rather than inside every nested parse */
+static int fson_check_utf8(const char *json_text, fossil_media_fson_error_t *err_out) {
+    size_t bad;
+    if (json_text == NULL || fossil_media_utf8_validate(json_text, strlen(json_text), &bad) == 0) return 0;
+    if (err_out) {
+        err_out->code = FOSSIL_MEDIA_FSON_ERR_PARSE;
+        err_out->position = bad;
+        snprintf(err_out->message, sizeof(err_out->message), "Invalid UTF-8");
+    }
+    return -1;
+}
+
+fossil_media_fson_value_t *fossil_media_fson_parse(const char *json_text, fossil_media_fson_error_t *err_out) {
+    if (fson_check_utf8(json_text, err_out) != 0) return NULL;
+    return fson_parse_value(json_text, err_out, 1);
+}
+
+fossil_media_fson_value_t *fossil_media_fson_parse_tree(const char *json_text, fossil_media_fson_error_t *err_out) {
+    if (fson_check_utf8(json_text, err_out) != 0) return NULL;
+    return fson_parse_value(json_text, err_out, 0);
+}
+
 void fossil_media_fson_free(fossil_media_fson_value_t *v) {
     if (v == NULL) {
         return;
@@ -24,6 +24,7 @@
  */
 #include "fossil/media/html.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,42 +36,222 @@ struct fossil_media_html_node {
     char *text;       /* only for text/comment nodes */
     struct fossil_media_html_node *parent;
     struct fossil_media_html_node *first_child;
+    struct fossil_media_html_node *last_child;
     struct fossil_media_html_node *next_sibling;
     /* attributes (array of key-value pairs) */
     struct {
         char **keys;
         char **values;
         size_t count;
+        size_t capacity;
+        unsigned char *owned; /* values[i] is a heap copy made by set_attr */
     } attrs;
+    /* filled in when the selector index is built */
+    size_t order;      /* pre-order position among elements */
+    size_t elem_index; /* 1-based position among element siblings */
+    struct fossil_media_html_doc *doc; /* only set on the document node */
 };
 
+typedef struct html_index html_index_t;
+
+/*
+ * Nodes, strings and attribute arrays all live in the document's arena.
+ * Values replaced through fossil_media_html_set_attr() are heap copies
+ * instead, so repeated updates free the old value rather than pile up.
+ */
 struct fossil_media_html_doc {
     fossil_media_html_node_t *root;
+    html_index_t *index; /* lazily built by the selector engine */
+    fossil_media_arena_t arena;
+    size_t owned_nodes;  /* nodes with an attrs.owned array */
 };
 
+/* Tokenizer scratch that outlives one parse; batch workers keep one each */
+typedef struct {
+    char *buf;
+    size_t cap;
+} html_scratch_t;
+
+#define HTML_DEFAULT_MAX_STEPS 1000000
+
+static void html_index_free(html_index_t *idx);
+static int is_void_element(const char *tag);
+static int is_script_element(const char *tag);
+static size_t html_decode_into(char *out, const char *s, size_t len);
+
 /* --- Minimal helpers --- */
 
-static fossil_media_html_node_t* alloc_node(fossil_media_html_node_type_t type) {
-    fossil_media_html_node_t *n = (fossil_media_html_node_t*)calloc(1, sizeof(*n));
+static fossil_media_html_node_t* alloc_node(fossil_media_html_doc_t *doc, fossil_media_html_node_type_t type) {
+    fossil_media_html_node_t *n = (fossil_media_html_node_t*)fossil_media_arena_calloc(&doc->arena, sizeof(*n));
     if (n) n->type = type;
     return n;
 }
 
-static int parse_html_string(const char *input, fossil_media_html_doc_t **out_doc) {
+static void append_child(fossil_media_html_node_t *parent, fossil_media_html_node_t *n) {
+    if (parent->last_child) parent->last_child->next_sibling = n;
+    else parent->first_child = n;
+    parent->last_child = n;
+    n->parent = parent;
+}
+
+/* Copy with character references decoded (never longer than the source) */
+static char *arena_decode(fossil_media_html_doc_t *doc, const char *s, size_t len) {
+    char *out = (char*)fossil_media_arena_alloc(&doc->arena, len + 1);
+    if (out) out[html_decode_into(out, s, len)] = '\0';
+    return out;
+}
+
+static char *scratch_copy(html_scratch_t *sc, const char *s, size_t len) {
+    if (len + 1 > sc->cap) {
+        size_t cap = sc->cap ? sc->cap : 256;
+        while (cap < len + 1) cap *= 2;
+        char *grown = (char*)realloc(sc->buf, cap);
+        if (!grown) return NULL;
+        sc->buf = grown;
+        sc->cap = cap;
+    }
+    memcpy(sc->buf, s, len);
+    sc->buf[len] = '\0';
+    return sc->buf;
+}
+
+static int node_set_attr(fossil_media_arena_t *arena, fossil_media_html_node_t *node,
+                         const char *name, size_t name_len, const char *value) {
+    char *v = fossil_media_arena_strndup(arena, value, strlen(value));
+    if (!v) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    for (size_t i = 0; i < node->attrs.count; ++i) {
+        if (strncmp(node->attrs.keys[i], name, name_len) == 0 && node->attrs.keys[i][name_len] == '\0') {
+            node->attrs.values[i] = v;
+            return FOSSIL_MEDIA_HTML_OK;
+        }
+    }
+    if (node->attrs.count == node->attrs.capacity) {
+        size_t cap = node->attrs.capacity ? node->attrs.capacity * 2 : 4;
+        char **keys = (char**)fossil_media_arena_alloc(arena, cap * sizeof(char*));
+        char **values = (char**)fossil_media_arena_alloc(arena, cap * sizeof(char*));
+        if (!keys || !values) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        if (node->attrs.count) {
+            memcpy(keys, node->attrs.keys, node->attrs.count * sizeof(char*));
+            memcpy(values, node->attrs.values, node->attrs.count * sizeof(char*));
+        }
+        node->attrs.keys = keys;
+        node->attrs.values = values;
+        node->attrs.capacity = cap;
+    }
+    char *k = fossil_media_arena_strndup(arena, name, name_len);
+    if (!k) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    node->attrs.keys[node->attrs.count] = k;
+    node->attrs.values[node->attrs.count] = v;
+    node->attrs.count++;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+/*
+ * Set an attribute to a heap copy of `value`, freeing or reusing the
+ * previous heap copy. Without a document (`doc` NULL) the attribute
+ * arrays are heap memory too.
+ */
+static int node_set_attr_owned(fossil_media_html_doc_t *doc, fossil_media_html_node_t *node,
+                               const char *name, const char *value) {
+    size_t vlen = strlen(value);
+    size_t i = 0;
+    while (i < node->attrs.count && strcmp(node->attrs.keys[i], name) != 0) ++i;
+    if (i < node->attrs.count && node->attrs.owned && node->attrs.owned[i] &&
+        strlen(node->attrs.values[i]) >= vlen) {
+        memcpy(node->attrs.values[i], value, vlen + 1);
+        return FOSSIL_MEDIA_HTML_OK;
+    }
+    if (i == node->attrs.count && node->attrs.count == node->attrs.capacity) {
+        size_t cap = node->attrs.capacity ? node->attrs.capacity * 2 : 4;
+        char **keys, **values;
+        if (doc) {
+            keys = (char**)fossil_media_arena_alloc(&doc->arena, cap * sizeof(char*));
+            values = (char**)fossil_media_arena_alloc(&doc->arena, cap * sizeof(char*));
+            if (!keys || !values) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+            if (node->attrs.count) {
+                memcpy(keys, node->attrs.keys, node->attrs.count * sizeof(char*));
+                memcpy(values, node->attrs.values, node->attrs.count * sizeof(char*));
+            }
+        } else {
+            keys = (char**)realloc(node->attrs.keys, cap * sizeof(char*));
+            if (!keys) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+            node->attrs.keys = keys;
+            values = (char**)realloc(node->attrs.values, cap * sizeof(char*));
+            if (!values) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        }
+        if (node->attrs.owned) {
+            unsigned char *owned = (unsigned char*)realloc(node->attrs.owned, cap);
+            if (!owned) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+            memset(owned + node->attrs.capacity, 0, cap - node->attrs.capacity);
+            node->attrs.owned = owned;
+        }
+        node->attrs.keys = keys;
+        node->attrs.values = values;
+        node->attrs.capacity = cap;
+    }
+    if (!node->attrs.owned) {
+        node->attrs.owned = (unsigned char*)calloc(node->attrs.capacity, 1);
+        if (!node->attrs.owned) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        if (doc) doc->owned_nodes++;
+    }
+    char *v = fossil_media_strdup(value);
+    if (!v) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    if (i == node->attrs.count) {
+        char *k = doc ? fossil_media_arena_strndup(&doc->arena, name, strlen(name)) : fossil_media_strdup(name);
+        if (!k) {
+            free(v);
+            return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        }
+        node->attrs.keys[i] = k;
+        node->attrs.count++;
+    } else if (node->attrs.owned[i]) {
+        free(node->attrs.values[i]);
+    }
+    node->attrs.values[i] = v;
+    node->attrs.owned[i] = 1;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+/* Release the heap values set through the API; the arena holds the rest */
+static void free_owned_attrs(fossil_media_html_node_t *node) {
+    while (node) {
+        if (node->attrs.owned) {
+            for (size_t i = 0; i < node->attrs.count; ++i) {
+                if (node->attrs.owned[i]) free(node->attrs.values[i]);
+            }
+            free(node->attrs.owned);
+            node->attrs.owned = NULL;
+        }
+        /* pre-order walk without recursion */
+        if (node->first_child) {
+            node = node->first_child;
+            continue;
+        }
+        while (node && !node->next_sibling) node = node->parent;
+        if (node) node = node->next_sibling;
+    }
+}
+
+static int parse_html_string(const char *input, fossil_media_html_doc_t **out_doc,
+                             html_scratch_t *scratch, size_t max_steps) {
     if (!input || !out_doc) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
 
     fossil_media_html_doc_t *doc = (fossil_media_html_doc_t*)calloc(1, sizeof(*doc));
     if (!doc) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    /* strings copied out of the input need about its size again, plus nodes */
+    size_t input_len = strlen(input);
+    fossil_media_arena_init(&doc->arena, input_len < 256 * 1024 ? input_len + 1024 : 256 * 1024);
 
-    fossil_media_html_node_t *root = alloc_node(FOSSIL_MEDIA_HTML_NODE_DOCUMENT);
-    if (!root) { free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+    fossil_media_html_node_t *root = alloc_node(doc, FOSSIL_MEDIA_HTML_NODE_DOCUMENT);
+    if (!root) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+    root->doc = doc;
     doc->root = root;
 
     fossil_media_html_node_t *current = root;
     const char *p = input;
 
     /* Timeout handling: limit max processed characters (not just loop iterations) */
-    size_t max_steps = 1000000; /* tuneable; test uses big input ~2,000,000 so this will timeout */
+    if (!max_steps) max_steps = HTML_DEFAULT_MAX_STEPS; /* test uses big input ~2,000,000 so this will timeout */
     size_t steps = 0;
 
     while (*p) {
@@ -85,24 +266,13 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
             if (next == '?') {
                 const char *end = strstr(p + 2, "?>");
                 if (!end) break;
-                size_t len = (size_t)(end - (p + 2));
-                char *txt = (char*)malloc(len + 1);
-                if (!txt) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                memcpy(txt, p + 2, len);
-                txt[len] = '\0';
-
-                fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_PROCESSING_INSTRUCTION);
-                if (!n) { free(txt); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                n->text = txt;
-
-                /* append as last child of current (document root usually) */
-                if (!current->first_child) current->first_child = n;
-                else {
-                    fossil_media_html_node_t *s = current->first_child;
-                    while (s->next_sibling) s = s->next_sibling;
-                    s->next_sibling = n;
+                fossil_media_html_node_t *n = alloc_node(doc, FOSSIL_MEDIA_HTML_NODE_PROCESSING_INSTRUCTION);
+                if (!n || !(n->text = fossil_media_arena_strndup(&doc->arena, p + 2, (size_t)(end - (p + 2))))) {
+                    fossil_media_html_free(doc);
+                    return FOSSIL_MEDIA_HTML_ERR_NOMEM;
                 }
-                n->parent = current;
+                /* append as last child of current (document root usually) */
+                append_child(current, n);
 
                 /* advance p and steps */
                 steps += (size_t)((end + 2) - p);
@@ -112,95 +282,46 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
 
             /* Declarations / comments / doctype / cdata start with <! */
             if (next == '!') {
-                /* Comment: <!-- ... --> */
-                if (strncmp(p + 2, "--", 2) == 0) {
-                    const char *end = strstr(p + 4, "-->");
-                    if (!end) break;
-                    size_t len = (size_t)(end - (p + 4));
-                    char *txt = (char*)malloc(len + 1);
-                    if (!txt) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    memcpy(txt, p + 4, len);
-                    txt[len] = '\0';
-
-                    fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_COMMENT);
-                    if (!n) { free(txt); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    n->text = txt;
-
-                    if (!current->first_child) current->first_child = n;
-                    else {
-                        fossil_media_html_node_t *s = current->first_child;
-                        while (s->next_sibling) s = s->next_sibling;
-                        s->next_sibling = n;
-                    }
-                    n->parent = current;
+                const char *body = NULL, *end = NULL;
+                size_t tail = 0;
+                fossil_media_html_node_type_t type = FOSSIL_MEDIA_HTML_NODE_COMMENT;
 
-                    steps += (size_t)((end + 3) - p);
-                    p = end + 3;
-                    continue;
+                if (strncmp(p + 2, "--", 2) == 0) {
+                    /* Comment: <!-- ... --> */
+                    body = p + 4;
+                    end = strstr(body, "-->");
+                    tail = 3;
+                } else if (strncmp(p + 2, "[CDATA[", 7) == 0) {
+                    /* CDATA: <![CDATA[ ... ]]> */
+                    type = FOSSIL_MEDIA_HTML_NODE_CDATA;
+                    body = p + 9;
+                    end = strstr(body, "]]>");
+                    tail = 3;
+                } else if (fossil_media_strncasecmp(p + 2, "DOCTYPE", 7) == 0) {
+                    /* DOCTYPE: case-insensitive <!DOCTYPE ...>  */
+                    type = FOSSIL_MEDIA_HTML_NODE_DOCTYPE;
+                    body = p + 2;
+                    end = strchr(body, '>');
+                    tail = 1;
+                } else {
+                    /* Unknown <! ... > sequence - skip until next '>' */
+                    end = strchr(p + 2, '>');
+                    tail = 1;
                 }
+                if (!end) break;
 
-                /* CDATA: <![CDATA[ ... ]]> */
-                if (strncmp(p + 2, "[CDATA[", 7) == 0) {
-                    const char *end = strstr(p + 9, "]]>");
-                    if (!end) break;
-                    size_t len = (size_t)(end - (p + 9));
-                    char *txt = (char*)malloc(len + 1);
-                    if (!txt) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    memcpy(txt, p + 9, len);
-                    txt[len] = '\0';
-
-                    fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_CDATA);
-                    if (!n) { free(txt); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    n->text = txt;
-
-                    if (!current->first_child) current->first_child = n;
-                    else {
-                        fossil_media_html_node_t *s = current->first_child;
-                        while (s->next_sibling) s = s->next_sibling;
-                        s->next_sibling = n;
+                if (body) {
+                    fossil_media_html_node_t *n = alloc_node(doc, type);
+                    if (!n || !(n->text = fossil_media_arena_strndup(&doc->arena, body, (size_t)(end - body)))) {
+                        fossil_media_html_free(doc);
+                        return FOSSIL_MEDIA_HTML_ERR_NOMEM;
                     }
-                    n->parent = current;
-
-                    steps += (size_t)((end + 3) - p);
-                    p = end + 3;
-                    continue;
+                    append_child(current, n);
                 }
 
-                /* DOCTYPE: case-insensitive <!DOCTYPE ...>  */
-                if (fossil_media_strncasecmp(p + 2, "DOCTYPE", 7) == 0) {
-                    const char *end = strchr(p + 2, '>');
-                    if (!end) break;
-                    size_t len = (size_t)(end - (p + 2));
-                    char *txt = (char*)malloc(len + 1);
-                    if (!txt) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    memcpy(txt, p + 2, len);
-                    txt[len] = '\0';
-
-                    fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_DOCTYPE);
-                    if (!n) { free(txt); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                    n->text = txt;
-
-                    if (!current->first_child) current->first_child = n;
-                    else {
-                        fossil_media_html_node_t *s = current->first_child;
-                        while (s->next_sibling) s = s->next_sibling;
-                        s->next_sibling = n;
-                    }
-                    n->parent = current;
-
-                    steps += (size_t)((end + 1) - p);
-                    p = end + 1;
-                    continue;
-                }
-
-                /* Unknown <! ... > sequence - skip until next '>' */
-                {
-                    const char *end = strchr(p + 2, '>');
-                    if (!end) break;
-                    steps += (size_t)((end + 1) - p);
-                    p = end + 1;
-                    continue;
-                }
+                steps += (size_t)((end + tail) - p);
+                p = end + tail;
+                continue;
             }
 
             /* Closing tag: </...> */
@@ -220,11 +341,9 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
                 const char *end = strchr(p + 1, '>');
                 if (!end) break;
                 size_t len = (size_t)(end - (p + 1));
-                /* copy the inside of the angle brackets for parsing */
-                char *tagbuf = (char*)malloc(len + 1);
+                /* copy the inside of the angle brackets into reusable scratch for parsing */
+                char *tagbuf = scratch_copy(scratch, p + 1, len);
                 if (!tagbuf) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                memcpy(tagbuf, p + 1, len);
-                tagbuf[len] = '\0';
 
                 /* Check for trailing '/' for self-closing '<.../>' (allow spaces before '/') */
                 int self_closing = 0;
@@ -239,14 +358,16 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
 
                 /* Extract tag name (up to first space) */
                 char *space = NULL;
+                size_t name_len = len;
                 for (size_t i = 0; i < len; ++i) {
-                    if (tagbuf[i] == ' ' || tagbuf[i] == '\t') { tagbuf[i] = '\0'; space = &tagbuf[i+1]; break; }
+                    if (tagbuf[i] == ' ' || tagbuf[i] == '\t') { name_len = i; space = &tagbuf[i+1]; break; }
+                }
+                /* tagname lower/upper doesn't matter for node->tag, keep as-is */
+                fossil_media_html_node_t *n = alloc_node(doc, FOSSIL_MEDIA_HTML_NODE_ELEMENT);
+                if (!n || !(n->tag = fossil_media_arena_strndup(&doc->arena, tagbuf, name_len))) {
+                    fossil_media_html_free(doc);
+                    return FOSSIL_MEDIA_HTML_ERR_NOMEM;
                 }
-                char *tagname = tagbuf;
-                /* tagname lower/upper doesn't matter for node->tag, keep as-is or normalize as you prefer */
-                fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_ELEMENT);
-                if (!n) { free(tagbuf); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                n->tag = fossil_media_strdup(tagname);
 
                 /* Parse attributes (basic handling: key="value" or key='value' or unquoted) */
                 if (space) {
@@ -261,63 +382,42 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
                         if (!eq) break;
 
                         /* key: from attrstr to eq-1, trim trailing whitespace */
-                        size_t klen = 0;
-                        /* compute real key start/end */
                         const char *kstart = attrstr;
                         const char *kend = eq - 1;
                         while (kend >= kstart && (*kend == ' ' || *kend == '\t')) kend--;
                         if (kend < kstart) { /* empty key */ break; }
-                        klen = (size_t)(kend - kstart + 1);
-                        char *key = (char*)malloc(klen + 1);
-                        if (!key) { free(tagbuf); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                        memcpy(key, kstart, klen);
-                        key[klen] = '\0';
-
-                        /* value parsing */
-                        char *valstart = (char*)(eq + 1);
+                        size_t klen = (size_t)(kend - kstart + 1);
+
+                        /* value parsing: quoted up to the matching quote, unquoted up to a space */
+                        char *valstart = eq + 1;
                         while (*valstart == ' ' || *valstart == '\t') valstart++;
+                        char *valend;
+                        char *resume;
                         if (*valstart == '"' || *valstart == '\'') {
                             char quote = *valstart++;
-                            char *valend = strchr(valstart, quote);
-                            if (!valend) { free(key); break; } /* malformed attribute: bail */
-                            size_t vlen = (size_t)(valend - valstart);
-                            char *value = (char*)malloc(vlen + 1);
-                            if (!value) { free(key); free(tagbuf); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                            memcpy(value, valstart, vlen);
-                            value[vlen] = '\0';
-                            fossil_media_html_set_attr(n, key, value);
-                            free(value);
-                            free(key);
-                            attrstr = valend + 1;
+                            valend = strchr(valstart, quote);
+                            if (!valend) break; /* malformed attribute: bail */
+                            resume = valend + 1;
                         } else {
-                            /* unquoted value: ends at space or end */
-                            char *valend = valstart;
+                            valend = valstart;
                             while (*valend && *valend != ' ' && *valend != '\t') valend++;
-                            size_t vlen = (size_t)(valend - valstart);
-                            char *value = (char*)malloc(vlen + 1);
-                            if (!value) { free(key); free(tagbuf); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                            memcpy(value, valstart, vlen);
-                            value[vlen] = '\0';
-                            fossil_media_html_set_attr(n, key, value);
-                            free(value);
-                            free(key);
-                            attrstr = valend;
+                            /* the decode below overwrites the separator with NUL */
+                            resume = *valend ? valend + 1 : valend;
+                        }
+                        /* decode in place: the value never grows and scratch is ours */
+                        valstart[html_decode_into(valstart, valstart, (size_t)(valend - valstart))] = '\0';
+                        if (node_set_attr(&doc->arena, n, kstart, klen, valstart) != FOSSIL_MEDIA_HTML_OK) {
+                            fossil_media_html_free(doc);
+                            return FOSSIL_MEDIA_HTML_ERR_NOMEM;
                         }
+                        attrstr = resume;
                     }
                 }
 
-                free(tagbuf);
-
                 /* Attach node */
-                if (!current->first_child) current->first_child = n;
-                else {
-                    fossil_media_html_node_t *s = current->first_child;
-                    while (s->next_sibling) s = s->next_sibling;
-                    s->next_sibling = n;
-                }
-                n->parent = current;
+                append_child(current, n);
 
-                if (!self_closing) current = n;
+                if (!self_closing && !is_void_element(n->tag)) current = n;
 
                 steps += (size_t)((end + 1) - p);
                 p = end + 1;
@@ -328,22 +428,14 @@ static int parse_html_string(const char *input, fossil_media_html_doc_t **out_do
             const char *next = strchr(p, '<');
             size_t len = next ? (size_t)(next - p) : strlen(p);
             if (len > 0) {
-                char *txt = (char*)malloc(len + 1);
-                if (!txt) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                memcpy(txt, p, len);
-                txt[len] = '\0';
-
-                fossil_media_html_node_t *n = alloc_node(FOSSIL_MEDIA_HTML_NODE_TEXT);
-                if (!n) { free(txt); fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
-                n->text = txt;
-
-                if (!current->first_child) current->first_child = n;
-                else {
-                    fossil_media_html_node_t *s = current->first_child;
-                    while (s->next_sibling) s = s->next_sibling;
-                    s->next_sibling = n;
+                /* script/style bodies are raw text; everything else has references decoded */
+                fossil_media_html_node_t *n = alloc_node(doc, FOSSIL_MEDIA_HTML_NODE_TEXT);
+                if (n) {
+                    n->text = (current->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT && is_script_element(current->tag))
+                              ? fossil_media_arena_strndup(&doc->arena, p, len) : arena_decode(doc, p, len);
                 }
-                n->parent = current;
+                if (!n || !n->text) { fossil_media_html_free(doc); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+                append_child(current, n);
 
                 steps += len;
                 p += len;
@@ -399,56 +491,68 @@ int fossil_media_html_load_file(const char *path, fossil_media_html_doc_t **out_
 
     fclose(f);
 
-    int rc = parse_html_string(buf, out_doc);
+    html_scratch_t scratch = { NULL, 0 };
+    int rc = parse_html_string(buf, out_doc, &scratch, 0);
+    free(scratch.buf);
     free(buf);
     return rc;
 }
 
 int fossil_media_html_load_string(const char *data, fossil_media_html_doc_t **out_doc) {
     if (!data || !out_doc) return FOSSIL_MEDIA_HTML_ERR_PARSE;
-    return parse_html_string(data, out_doc);
+    html_scratch_t scratch = { NULL, 0 };
+    int rc = parse_html_string(data, out_doc, &scratch, 0);
+    free(scratch.buf);
+    return rc;
+}
+
+/* --- Batch parsing --- */
+
+typedef struct {
+    const char *const *inputs;
+    fossil_media_html_batch_result_t *outputs;
+    html_scratch_t *scratch; /* one per worker, reused across its documents */
+    size_t max_steps;
+} html_batch_t;
+
+static void html_batch_task(void *ctx, size_t index, size_t worker) {
+    html_batch_t *b = (html_batch_t*)ctx;
+    fossil_media_html_batch_result_t *r = &b->outputs[index];
+    r->doc = NULL;
+    r->status = b->inputs[index]
+        ? parse_html_string(b->inputs[index], &r->doc, &b->scratch[worker], b->max_steps)
+        : FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+}
+
+int fossil_media_html_parse_batch(const char *const *inputs, size_t n,
+                                  const fossil_media_html_batch_options_t *options,
+                                  fossil_media_html_batch_result_t *outputs) {
+    if ((!inputs || !outputs) && n) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    if (n == 0) return 0;
+
+    size_t workers = fossil_media_parallel_workers(options ? options->threads : 0, n);
+    html_batch_t batch = { inputs, outputs, NULL, options ? options->max_steps : 0 };
+    batch.scratch = (html_scratch_t*)calloc(workers, sizeof(html_scratch_t));
+    if (!batch.scratch) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+    fossil_media_parallel_run(n, workers, html_batch_task, &batch);
+
+    for (size_t w = 0; w < workers; ++w) free(batch.scratch[w].buf);
+    free(batch.scratch);
+
+    int failed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (outputs[i].status != FOSSIL_MEDIA_HTML_OK) failed++;
+    }
+    return failed;
 }
 
 void fossil_media_html_free(fossil_media_html_doc_t *doc) {
     if (!doc) return;
-    /* recursively free nodes using a dynamic stack */
-    size_t stack_cap = 256;
-    size_t sp = 0;
-    fossil_media_html_node_t **stack = (fossil_media_html_node_t**)malloc(stack_cap * sizeof(fossil_media_html_node_t*));
-    if (!stack) {
-        free(doc);
-        return;
-    }
-    if (doc->root) stack[sp++] = doc->root;
-    while (sp > 0) {
-        fossil_media_html_node_t *n = stack[--sp];
-        // Save next_sibling before freeing n
-        fossil_media_html_node_t *child = n->first_child;
-        while (child) {
-            if (sp >= stack_cap) {
-                stack_cap *= 2;
-                fossil_media_html_node_t **new_stack = (fossil_media_html_node_t**)realloc(stack, stack_cap * sizeof(fossil_media_html_node_t*));
-                if (!new_stack) {
-                    // If realloc fails, just free what we can and exit
-                    break;
-                }
-                stack = new_stack;
-            }
-            fossil_media_html_node_t *next = child->next_sibling;
-            stack[sp++] = child;
-            child = next;
-        }
-        if (n->tag) { free(n->tag); n->tag = NULL; }
-        if (n->text) { free(n->text); n->text = NULL; }
-        for (size_t i = 0; i < n->attrs.count; ++i) {
-            if (n->attrs.keys) { free(n->attrs.keys[i]); n->attrs.keys[i] = NULL; }
-            if (n->attrs.values) { free(n->attrs.values[i]); n->attrs.values[i] = NULL; }
-        }
-        if (n->attrs.keys) { free(n->attrs.keys); n->attrs.keys = NULL; }
-        if (n->attrs.values) { free(n->attrs.values); n->attrs.values = NULL; }
-        free(n);
-    }
-    free(stack);
+    /* every node, string and attribute array came from the arena */
+    if (doc->owned_nodes) free_owned_attrs(doc->root);
+    html_index_free(doc->index);
+    fossil_media_arena_destroy(&doc->arena);
     free(doc);
 }
 
@@ -486,69 +590,1938 @@ const char* fossil_media_html_get_attr(const fossil_media_html_node_t *node, con
     return NULL;
 }
 
+/* id/class changes make the selector index stale; drop it so it is rebuilt */
+static void invalidate_index(fossil_media_html_node_t *node, const char *attr_name) {
+    if (strcmp(attr_name, "id") != 0 && strcmp(attr_name, "class") != 0) return;
+    while (node->parent) node = node->parent;
+    if (node->doc && node->doc->index) {
+        html_index_free(node->doc->index);
+        node->doc->index = NULL;
+    }
+}
+
 int fossil_media_html_set_attr(fossil_media_html_node_t *node, const char *attr_name, const char *attr_value) {
     if (!node || !attr_name || !attr_value) return FOSSIL_MEDIA_HTML_ERR_PARSE;
-    for (size_t i = 0; i < node->attrs.count; ++i) {
-        if (strcmp(node->attrs.keys[i], attr_name) == 0) {
-            free(node->attrs.values[i]);
-            node->attrs.values[i] = fossil_media_strdup(attr_value);
+    fossil_media_html_node_t *root = node;
+    while (root->parent) root = root->parent;
+    invalidate_index(node, attr_name);
+    return node_set_attr_owned(root->doc, node, attr_name, attr_value);
+}
+
+/* ---------------------------------------------------------------------------
+ * CSS selector engine
+ *
+ * Selectors are compiled into groups of compound selectors joined by
+ * combinators and matched right-to-left. Candidates come from per-document
+ * id/class/tag indexes built on the first query, so a typical `#id` or
+ * `.class` lookup touches only the nodes that can possibly match.
+ * ------------------------------------------------------------------------- */
+
+typedef enum {
+    SEL_ATTR_EXISTS,   /* [a]    */
+    SEL_ATTR_EQUALS,   /* [a=v]  */
+    SEL_ATTR_WORD,     /* [a~=v] */
+    SEL_ATTR_DASH,     /* [a|=v] */
+    SEL_ATTR_PREFIX,   /* [a^=v] */
+    SEL_ATTR_SUFFIX,   /* [a$=v] */
+    SEL_ATTR_SUBSTR    /* [a*=v] */
+} sel_attr_op_t;
+
+typedef struct {
+    char *name;
+    char *value;
+    sel_attr_op_t op;
+} sel_attr_t;
+
+typedef struct {
+    char *tag;              /* lowercased, NULL matches any element */
+    char *id;
+    char **classes;
+    size_t class_count;
+    sel_attr_t *attrs;
+    size_t attr_count;
+    int has_nth;
+    long nth_a, nth_b;      /* :nth-child(an+b) */
+    char combinator;        /* link to the previous compound: ' ', '>' or 0 */
+} sel_compound_t;
+
+typedef struct {
+    sel_compound_t *parts;
+    size_t count;
+} sel_complex_t;
+
+struct fossil_media_html_selector {
+    sel_complex_t *groups;
+    size_t group_count;
+};
+
+static char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+static int is_ident_char(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '_' || c >= 0x80;
+}
+
+static int is_css_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static void skip_css_space(const char **p) {
+    while (is_css_space(**p)) (*p)++;
+}
+
+static char *parse_ident(const char **p, int lower) {
+    const char *start = *p;
+    while (is_ident_char((unsigned char)**p)) (*p)++;
+    if (*p == start) return NULL;
+    char *out = fossil_media_strndup(start, (size_t)(*p - start));
+    if (out && lower) {
+        for (char *c = out; *c; ++c) *c = ascii_lower(*c);
+    }
+    return out;
+}
+
+static void free_compound(sel_compound_t *c) {
+    free(c->tag);
+    free(c->id);
+    for (size_t i = 0; i < c->class_count; ++i) free(c->classes[i]);
+    free(c->classes);
+    for (size_t i = 0; i < c->attr_count; ++i) {
+        free(c->attrs[i].name);
+        free(c->attrs[i].value);
+    }
+    free(c->attrs);
+}
+
+void fossil_media_html_selector_free(fossil_media_html_selector_t *sel) {
+    if (!sel) return;
+    for (size_t g = 0; g < sel->group_count; ++g) {
+        for (size_t i = 0; i < sel->groups[g].count; ++i)
+            free_compound(&sel->groups[g].parts[i]);
+        free(sel->groups[g].parts);
+    }
+    free(sel->groups);
+    free(sel);
+}
+
+/* Parses the argument of :nth-child(): "odd", "even", "b", "an", "an+b" */
+static int parse_nth(const char **p, long *a, long *b) {
+    skip_css_space(p);
+    if (fossil_media_strncasecmp(*p, "odd", 3) == 0) { *a = 2; *b = 1; *p += 3; return 0; }
+    if (fossil_media_strncasecmp(*p, "even", 4) == 0) { *a = 2; *b = 0; *p += 4; return 0; }
+
+    long sign = 1;
+    if (**p == '+' || **p == '-') { sign = (**p == '-') ? -1 : 1; (*p)++; }
+    long num = 0;
+    int have_num = 0;
+    while (**p >= '0' && **p <= '9') { num = num * 10 + (**p - '0'); (*p)++; have_num = 1; }
+
+    if (**p == 'n' || **p == 'N') {
+        (*p)++;
+        *a = sign * (have_num ? num : 1);
+        *b = 0;
+        skip_css_space(p);
+        if (**p == '+' || **p == '-') {
+            long bsign = (**p == '-') ? -1 : 1;
+            (*p)++;
+            skip_css_space(p);
+            if (!(**p >= '0' && **p <= '9')) return -1;
+            long bnum = 0;
+            while (**p >= '0' && **p <= '9') { bnum = bnum * 10 + (**p - '0'); (*p)++; }
+            *b = bsign * bnum;
+        }
+        return 0;
+    }
+    if (!have_num) return -1;
+    *a = 0;
+    *b = sign * num;
+    return 0;
+}
+
+static int parse_attr_test(const char **p, sel_compound_t *c) {
+    /* *p points just past '[' */
+    skip_css_space(p);
+    char *name = parse_ident(p, 1);
+    if (!name) return FOSSIL_MEDIA_HTML_ERR_PARSE;
+    skip_css_space(p);
+
+    sel_attr_t attr = { name, NULL, SEL_ATTR_EXISTS };
+    if (**p != ']') {
+        switch (**p) {
+            case '=': attr.op = SEL_ATTR_EQUALS; break;
+            case '~': attr.op = SEL_ATTR_WORD; break;
+            case '|': attr.op = SEL_ATTR_DASH; break;
+            case '^': attr.op = SEL_ATTR_PREFIX; break;
+            case '$': attr.op = SEL_ATTR_SUFFIX; break;
+            case '*': attr.op = SEL_ATTR_SUBSTR; break;
+            default: free(name); return FOSSIL_MEDIA_HTML_ERR_PARSE;
+        }
+        (*p)++;
+        if (attr.op != SEL_ATTR_EQUALS) {
+            if (**p != '=') { free(name); return FOSSIL_MEDIA_HTML_ERR_PARSE; }
+            (*p)++;
+        }
+        skip_css_space(p);
+        if (**p == '"' || **p == '\'') {
+            char quote = *(*p)++;
+            const char *end = strchr(*p, quote);
+            if (!end) { free(name); return FOSSIL_MEDIA_HTML_ERR_PARSE; }
+            attr.value = fossil_media_strndup(*p, (size_t)(end - *p));
+            *p = end + 1;
+        } else {
+            attr.value = parse_ident(p, 0);
+        }
+        if (!attr.value) { free(name); return FOSSIL_MEDIA_HTML_ERR_PARSE; }
+        skip_css_space(p);
+        if (**p != ']') { free(name); free(attr.value); return FOSSIL_MEDIA_HTML_ERR_PARSE; }
+    }
+    (*p)++;
+
+    sel_attr_t *grown = (sel_attr_t*)realloc(c->attrs, (c->attr_count + 1) * sizeof(*grown));
+    if (!grown) { free(name); free(attr.value); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+    c->attrs = grown;
+    c->attrs[c->attr_count++] = attr;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int parse_compound(const char **p, sel_compound_t *c) {
+    int any = 0;
+    if (**p == '*') {
+        (*p)++;
+        any = 1;
+    } else if (is_ident_char((unsigned char)**p)) {
+        c->tag = parse_ident(p, 1);
+        if (!c->tag) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        any = 1;
+    }
+
+    for (;;) {
+        if (**p == '#') {
+            (*p)++;
+            char *id = parse_ident(p, 0);
+            if (!id) return FOSSIL_MEDIA_HTML_ERR_PARSE;
+            free(c->id);
+            c->id = id;
+        } else if (**p == '.') {
+            (*p)++;
+            char *cls = parse_ident(p, 0);
+            if (!cls) return FOSSIL_MEDIA_HTML_ERR_PARSE;
+            char **grown = (char**)realloc(c->classes, (c->class_count + 1) * sizeof(*grown));
+            if (!grown) { free(cls); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+            c->classes = grown;
+            c->classes[c->class_count++] = cls;
+        } else if (**p == '[') {
+            (*p)++;
+            int rc = parse_attr_test(p, c);
+            if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+        } else if (**p == ':') {
+            (*p)++;
+            if (fossil_media_strncasecmp(*p, "nth-child(", 10) == 0) {
+                *p += 10;
+                if (parse_nth(p, &c->nth_a, &c->nth_b) != 0) return FOSSIL_MEDIA_HTML_ERR_PARSE;
+                skip_css_space(p);
+                if (**p != ')') return FOSSIL_MEDIA_HTML_ERR_PARSE;
+                (*p)++;
+            } else if (fossil_media_strncasecmp(*p, "first-child", 11) == 0) {
+                *p += 11;
+                c->nth_a = 0;
+                c->nth_b = 1;
+            } else {
+                return FOSSIL_MEDIA_HTML_ERR_PARSE;
+            }
+            c->has_nth = 1;
+        } else {
+            break;
+        }
+        any = 1;
+    }
+    return any ? FOSSIL_MEDIA_HTML_OK : FOSSIL_MEDIA_HTML_ERR_PARSE;
+}
+
+static int parse_complex(const char **p, sel_complex_t *cx) {
+    char combinator = 0;
+    for (;;) {
+        skip_css_space(p);
+        sel_compound_t *grown = (sel_compound_t*)realloc(cx->parts, (cx->count + 1) * sizeof(*grown));
+        if (!grown) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        cx->parts = grown;
+        sel_compound_t *c = &cx->parts[cx->count++];
+        memset(c, 0, sizeof(*c));
+        c->combinator = combinator;
+
+        int rc = parse_compound(p, c);
+        if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+
+        const char *before = *p;
+        skip_css_space(p);
+        if (**p == '>') {
+            (*p)++;
+            combinator = '>';
+        } else if (**p == ',' || **p == '\0') {
             return FOSSIL_MEDIA_HTML_OK;
+        } else if (*p != before) {
+            combinator = ' ';
+        } else {
+            return FOSSIL_MEDIA_HTML_ERR_PARSE;
         }
     }
-    char **new_keys = realloc(node->attrs.keys, (node->attrs.count+1)*sizeof(char*));
-    char **new_vals = realloc(node->attrs.values, (node->attrs.count+1)*sizeof(char*));
-    if (!new_keys || !new_vals) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
-    node->attrs.keys = new_keys;
-    node->attrs.values = new_vals;
-    node->attrs.keys[node->attrs.count] = fossil_media_strdup(attr_name);
-    node->attrs.values[node->attrs.count] = fossil_media_strdup(attr_value);
-    node->attrs.count++;
+}
+
+int fossil_media_html_selector_compile(const char *css, fossil_media_html_selector_t **out_sel) {
+    if (!css || !out_sel) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    *out_sel = NULL;
+
+    fossil_media_html_selector_t *sel = (fossil_media_html_selector_t*)calloc(1, sizeof(*sel));
+    if (!sel) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+    const char *p = css;
+    for (;;) {
+        sel_complex_t *grown = (sel_complex_t*)realloc(sel->groups, (sel->group_count + 1) * sizeof(*grown));
+        if (!grown) { fossil_media_html_selector_free(sel); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+        sel->groups = grown;
+        sel_complex_t *cx = &sel->groups[sel->group_count++];
+        cx->parts = NULL;
+        cx->count = 0;
+
+        int rc = parse_complex(&p, cx);
+        if (rc != FOSSIL_MEDIA_HTML_OK) { fossil_media_html_selector_free(sel); return rc; }
+        if (*p == '\0') break;
+        p++; /* ',' */
+    }
+
+    *out_sel = sel;
     return FOSSIL_MEDIA_HTML_OK;
 }
 
-/* Serialization: naive recursive printer */
-static void serialize_node(const fossil_media_html_node_t *node, char **buf, size_t *len, size_t *cap) {
-    if (!node) return;
-    if (node->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT) {
-        size_t needed = strlen(node->tag) + 4;
-        if (*len + needed >= *cap) {
-            while (*len + needed >= *cap) *cap *= 2;
-            *buf = (char*)realloc(*buf, *cap);
+/* --- Matching --- */
+
+static int tag_equals(const char *node_tag, const char *lower_tag) {
+    for (; *node_tag && *lower_tag; ++node_tag, ++lower_tag) {
+        if (ascii_lower(*node_tag) != *lower_tag) return 0;
+    }
+    return *node_tag == *lower_tag;
+}
+
+/* Does the whitespace-separated list `list` contain `word`? */
+static int has_word(const char *list, const char *word) {
+    size_t wlen = strlen(word);
+    if (wlen == 0) return 0;
+    const char *p = list;
+    while (*p) {
+        while (*p && is_css_space(*p)) p++;
+        const char *start = p;
+        while (*p && !is_css_space(*p)) p++;
+        if ((size_t)(p - start) == wlen && memcmp(start, word, wlen) == 0) return 1;
+    }
+    return 0;
+}
+
+static int match_attr(const fossil_media_html_node_t *n, const sel_attr_t *a) {
+    const char *v = NULL;
+    for (size_t i = 0; i < n->attrs.count; ++i) {
+        if (fossil_media_strncasecmp(n->attrs.keys[i], a->name, strlen(a->name) + 1) == 0) {
+            v = n->attrs.values[i];
+            break;
         }
-        *len += snprintf(*buf + *len, *cap - *len, "<%s>", node->tag);
+    }
+    if (!v) return 0;
+
+    size_t vlen = strlen(v), alen = a->value ? strlen(a->value) : 0;
+    switch (a->op) {
+        case SEL_ATTR_EXISTS: return 1;
+        case SEL_ATTR_EQUALS: return strcmp(v, a->value) == 0;
+        case SEL_ATTR_WORD:   return has_word(v, a->value);
+        case SEL_ATTR_DASH:   return strncmp(v, a->value, alen) == 0 && (v[alen] == '\0' || v[alen] == '-');
+        case SEL_ATTR_PREFIX: return alen > 0 && strncmp(v, a->value, alen) == 0;
+        case SEL_ATTR_SUFFIX: return alen > 0 && vlen >= alen && memcmp(v + vlen - alen, a->value, alen) == 0;
+        case SEL_ATTR_SUBSTR: return alen > 0 && strstr(v, a->value) != NULL;
+    }
+    return 0;
+}
+
+static int match_nth(size_t index, long a, long b) {
+    long i = (long)index;
+    if (a == 0) return i == b;
+    long diff = i - b;
+    return (diff % a == 0) && (diff / a >= 0);
+}
+
+static int match_compound(const fossil_media_html_node_t *n, const sel_compound_t *c) {
+    if (n->type != FOSSIL_MEDIA_HTML_NODE_ELEMENT || !n->tag) return 0;
+    if (c->tag && !tag_equals(n->tag, c->tag)) return 0;
+    if (c->id) {
+        const char *id = fossil_media_html_get_attr(n, "id");
+        if (!id || strcmp(id, c->id) != 0) return 0;
+    }
+    if (c->class_count) {
+        const char *cls = fossil_media_html_get_attr(n, "class");
+        if (!cls) return 0;
+        for (size_t i = 0; i < c->class_count; ++i)
+            if (!has_word(cls, c->classes[i])) return 0;
+    }
+    for (size_t i = 0; i < c->attr_count; ++i)
+        if (!match_attr(n, &c->attrs[i])) return 0;
+    if (c->has_nth && !match_nth(n->elem_index, c->nth_a, c->nth_b)) return 0;
+    return 1;
+}
+
+static int match_complex(const fossil_media_html_node_t *n, const sel_complex_t *cx, size_t idx) {
+    if (!match_compound(n, &cx->parts[idx])) return 0;
+    if (idx == 0) return 1;
+
+    const fossil_media_html_node_t *p = n->parent;
+    if (cx->parts[idx].combinator == '>')
+        return p && match_complex(p, cx, idx - 1);
+    for (; p; p = p->parent) {
+        if (match_complex(p, cx, idx - 1)) return 1;
+    }
+    return 0;
+}
+
+static int match_selector(const fossil_media_html_node_t *n, const fossil_media_html_selector_t *sel) {
+    for (size_t g = 0; g < sel->group_count; ++g) {
+        const sel_complex_t *cx = &sel->groups[g];
+        if (cx->count && match_complex(n, cx, cx->count - 1)) return 1;
+    }
+    return 0;
+}
+
+/* --- Per-document indexes --- */
+
+typedef struct {
+    char *key;
+    fossil_media_html_node_t **nodes;
+    size_t count;
+    size_t capacity;
+} html_bucket_t;
+
+typedef struct {
+    html_bucket_t *slots;
+    size_t capacity; /* power of two */
+    size_t used;
+} html_map_t;
+
+struct html_index {
+    html_map_t ids;
+    html_map_t classes;
+    html_map_t tags;
+    fossil_media_html_node_t **elements; /* every element in document order */
+    size_t element_count;
+    size_t element_capacity;
+};
+
+static uint64_t hash_bytes(const char *s, size_t len) {
+    uint64_t h = 1469598103934665603ULL; /* FNV-1a */
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void map_free(html_map_t *m) {
+    for (size_t i = 0; i < m->capacity; ++i) {
+        free(m->slots[i].key);
+        free(m->slots[i].nodes);
+    }
+    free(m->slots);
+    memset(m, 0, sizeof(*m));
+}
+
+static html_bucket_t *map_find(const html_map_t *m, const char *key, size_t len) {
+    if (!m->capacity) return NULL;
+    size_t mask = m->capacity - 1;
+    for (size_t i = (size_t)hash_bytes(key, len) & mask;; i = (i + 1) & mask) {
+        html_bucket_t *b = &m->slots[i];
+        if (!b->key) return NULL;
+        if (strncmp(b->key, key, len) == 0 && b->key[len] == '\0') return b;
+    }
+}
+
+static int map_grow(html_map_t *m) {
+    size_t cap = m->capacity ? m->capacity * 2 : 64;
+    html_bucket_t *slots = (html_bucket_t*)calloc(cap, sizeof(*slots));
+    if (!slots) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    for (size_t i = 0; i < m->capacity; ++i) {
+        html_bucket_t *b = &m->slots[i];
+        if (!b->key) continue;
+        size_t j = (size_t)hash_bytes(b->key, strlen(b->key)) & (cap - 1);
+        while (slots[j].key) j = (j + 1) & (cap - 1);
+        slots[j] = *b;
+    }
+    free(m->slots);
+    m->slots = slots;
+    m->capacity = cap;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int push_node(fossil_media_html_node_t ***arr, size_t *count, size_t *cap, fossil_media_html_node_t *n) {
+    if (*count == *cap) {
+        size_t ncap = *cap ? *cap * 2 : 4;
+        fossil_media_html_node_t **grown = (fossil_media_html_node_t**)realloc(*arr, ncap * sizeof(*grown));
+        if (!grown) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        *arr = grown;
+        *cap = ncap;
+    }
+    (*arr)[(*count)++] = n;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int map_add(html_map_t *m, const char *key, size_t len, int lower, fossil_media_html_node_t *n) {
+    if ((m->used + 1) * 2 > m->capacity && map_grow(m) != FOSSIL_MEDIA_HTML_OK)
+        return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+    char tmp[64];
+    char *heap = NULL;
+    const char *k = key;
+    if (lower) {
+        char *dst = tmp;
+        if (len >= sizeof(tmp) && !(dst = heap = (char*)malloc(len + 1))) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        for (size_t i = 0; i < len; ++i) dst[i] = ascii_lower(key[i]);
+        dst[len] = '\0';
+        k = dst;
+    }
+
+    html_bucket_t *b = map_find(m, k, len);
+    if (!b) {
+        size_t mask = m->capacity - 1;
+        size_t i = (size_t)hash_bytes(k, len) & mask;
+        while (m->slots[i].key) i = (i + 1) & mask;
+        b = &m->slots[i];
+        b->key = fossil_media_strndup(k, len);
+        if (!b->key) { free(heap); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+        m->used++;
+    }
+    free(heap);
+    /* a node listing the same class twice is indexed once */
+    if (b->count && b->nodes[b->count - 1] == n) return FOSSIL_MEDIA_HTML_OK;
+    return push_node(&b->nodes, &b->count, &b->capacity, n);
+}
+
+static void html_index_free(html_index_t *idx) {
+    if (!idx) return;
+    map_free(&idx->ids);
+    map_free(&idx->classes);
+    map_free(&idx->tags);
+    free(idx->elements);
+    free(idx);
+}
 
-        for (fossil_media_html_node_t *c = node->first_child; c; c = c->next_sibling)
-            serialize_node(c, buf, len, cap);
+static int index_element(html_index_t *idx, fossil_media_html_node_t *n) {
+    int rc = push_node(&idx->elements, &idx->element_count, &idx->element_capacity, n);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+    if ((rc = map_add(&idx->tags, n->tag, strlen(n->tag), 1, n)) != FOSSIL_MEDIA_HTML_OK) return rc;
+
+    const char *id = fossil_media_html_get_attr(n, "id");
+    if (id && *id && (rc = map_add(&idx->ids, id, strlen(id), 0, n)) != FOSSIL_MEDIA_HTML_OK) return rc;
+
+    const char *cls = fossil_media_html_get_attr(n, "class");
+    while (cls && *cls) {
+        while (*cls && is_css_space(*cls)) cls++;
+        const char *start = cls;
+        while (*cls && !is_css_space(*cls)) cls++;
+        if (cls > start && (rc = map_add(&idx->classes, start, (size_t)(cls - start), 0, n)) != FOSSIL_MEDIA_HTML_OK)
+            return rc;
+    }
+    return FOSSIL_MEDIA_HTML_OK;
+}
 
-        if (*len + strlen(node->tag) + 4 >= *cap) {
-            *cap += strlen(node->tag) + 4;
-            *buf = (char*)realloc(*buf, *cap);
+/* Single non-recursive pre-order walk that numbers and indexes every element */
+static int ensure_index(fossil_media_html_doc_t *doc) {
+    if (doc->index) return FOSSIL_MEDIA_HTML_OK;
+    html_index_t *idx = (html_index_t*)calloc(1, sizeof(*idx));
+    if (!idx) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+    fossil_media_html_node_t *root = doc->root;
+    fossil_media_html_node_t *n = root;
+    while (n) {
+        if (n->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT && n->tag) {
+            n->order = idx->element_count;
+            if (index_element(idx, n) != FOSSIL_MEDIA_HTML_OK) {
+                html_index_free(idx);
+                return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+            }
+        }
+        size_t k = 0;
+        for (fossil_media_html_node_t *c = n->first_child; c; c = c->next_sibling) {
+            if (c->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT) c->elem_index = ++k;
         }
-        *len += snprintf(*buf + *len, *cap - *len, "</%s>", node->tag);
 
-    } else if (node->type == FOSSIL_MEDIA_HTML_NODE_TEXT) {
-        size_t tlen = strlen(node->text);
-        if (*len + tlen + 1 >= *cap) {
-            while (*len + tlen + 1 >= *cap) *cap *= 2;
-            *buf = (char*)realloc(*buf, *cap);
+        if (n->first_child) {
+            n = n->first_child;
+            continue;
         }
-        memcpy(*buf + *len, node->text, tlen);
-        *len += tlen;
-        (*buf)[*len] = '\0';
+        while (n && n != root && !n->next_sibling) n = n->parent;
+        n = (n && n != root) ? n->next_sibling : NULL;
     }
+
+    doc->index = idx;
+    return FOSSIL_MEDIA_HTML_OK;
 }
 
-char* fossil_media_html_serialize(const fossil_media_html_doc_t *doc) {
-    if (!doc || !doc->root) return NULL;
+/* Pick the smallest index bucket that must contain every match */
+static void select_candidates(const html_index_t *idx, const fossil_media_html_selector_t *sel,
+                              fossil_media_html_node_t *const **out, size_t *out_count) {
+    *out = idx->elements;
+    *out_count = idx->element_count;
+    if (sel->group_count != 1 || sel->groups[0].count == 0) return;
+
+    const sel_compound_t *c = &sel->groups[0].parts[sel->groups[0].count - 1];
+    const html_bucket_t *b = NULL;
+    int keyed = 0;
+    if (c->id) {
+        b = map_find(&idx->ids, c->id, strlen(c->id));
+        keyed = 1;
+    } else if (c->class_count) {
+        for (size_t i = 0; i < c->class_count; ++i) {
+            const html_bucket_t *cb = map_find(&idx->classes, c->classes[i], strlen(c->classes[i]));
+            if (!cb) { b = NULL; break; }
+            if (!b || cb->count < b->count) b = cb;
+        }
+        keyed = 1;
+    } else if (c->tag) {
+        b = map_find(&idx->tags, c->tag, strlen(c->tag));
+        keyed = 1;
+    }
 
-    size_t cap = 1024, len = 0;
-    char *buf = (char*)malloc(cap);
-    if (!buf) return NULL;
-    buf[0] = '\0';
+    if (keyed) {
+        *out = b ? b->nodes : NULL;
+        *out_count = b ? b->count : 0;
+    }
+}
+
+int fossil_media_html_select_all(fossil_media_html_doc_t *doc,
+                                 const fossil_media_html_selector_t *sel,
+                                 fossil_media_html_select_iter_t *it) {
+    if (!doc || !sel || !it) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    memset(it, 0, sizeof(*it));
+    int rc = ensure_index(doc);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+    it->doc = doc;
+    it->sel = sel;
+    select_candidates(doc->index, sel, &it->candidates, &it->candidate_count);
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+fossil_media_html_node_t* fossil_media_html_select_next(fossil_media_html_select_iter_t *it) {
+    if (!it || !it->sel) return NULL;
+    while (it->pos < it->candidate_count) {
+        fossil_media_html_node_t *n = it->candidates[it->pos++];
+        if (match_selector(n, it->sel)) return n;
+    }
+    return NULL;
+}
+
+int fossil_media_html_select(fossil_media_html_doc_t *doc,
+                             const fossil_media_html_selector_t *sel,
+                             fossil_media_html_node_list_t *results) {
+    if (!results) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    fossil_media_html_select_iter_t it;
+    int rc = fossil_media_html_select_all(doc, sel, &it);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+
+    int found = 0;
+    fossil_media_html_node_t *n;
+    while ((n = fossil_media_html_select_next(&it)) != NULL) {
+        rc = push_node(&results->nodes, &results->count, &results->capacity, n);
+        if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+        found++;
+    }
+    return found;
+}
+
+fossil_media_html_node_t* fossil_media_html_select_first(fossil_media_html_doc_t *doc,
+                                                         const fossil_media_html_selector_t *sel) {
+    fossil_media_html_select_iter_t it;
+    if (fossil_media_html_select_all(doc, sel, &it) != FOSSIL_MEDIA_HTML_OK) return NULL;
+    return fossil_media_html_select_next(&it);
+}
+
+void fossil_media_html_node_list_free(fossil_media_html_node_list_t *list) {
+    if (!list) return;
+    free(list->nodes);
+    list->nodes = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Streaming rewriter
+ *
+ * An incremental tokenizer runs directly over each input chunk. Text,
+ * comments and raw-text (script/style) content are forwarded as soon as
+ * they are seen; only an unfinished tag at the end of a chunk is carried
+ * over. Open elements are kept on a stack of reusable slots so the CSS
+ * selector engine can match them (including ancestors for combinators)
+ * without building a tree.
+ * ------------------------------------------------------------------------- */
+
+#define RW_OUT_BUFFER 4096
+#define RW_MAX_TOKEN (64 * 1024)
+#define RW_MAX_DEPTH 1024
+#define RW_MAX_TEXT_HANDLERS 64
+#define RW_NOT_SUPPRESSED ((size_t)-1)
+
+static const char *const html_void_elements[] = {
+    "area", "base", "br", "col", "embed", "hr", "img", "input",
+    "link", "meta", "param", "source", "track", "wbr", NULL
+};
+
+static const char *const html_rawtext_elements[] = {
+    "script", "style", "textarea", "title", "xmp", NULL
+};
+
+static int in_tag_list(const char *tag, const char *const *list) {
+    for (size_t i = 0; list[i]; ++i) {
+        if (tag_equals(tag, list[i])) return 1;
+    }
+    return 0;
+}
+
+static int is_void_element(const char *tag) {
+    return in_tag_list(tag, html_void_elements);
+}
+
+/* Elements whose text is raw: references are neither decoded nor escaped */
+static int is_script_element(const char *tag) {
+    return tag_equals(tag, "script") || tag_equals(tag, "style");
+}
+
+/*
+ * Write `s`, replacing each byte of `set` (a subset of &<>") by its character
+ * reference. Clean runs are found with fossil_media_find_any() and copied in
+ * one piece.
+ */
+static int write_escaped(fossil_media_writer_t *w, const char *s, size_t len, const char *set) {
+    while (len) {
+        const char *hit = fossil_media_find_any(s, len, set);
+        size_t run = hit ? (size_t)(hit - s) : len;
+        if (fossil_media_writer_write(w, s, run) != 0) return FOSSIL_MEDIA_HTML_ERR_IO;
+        if (!hit) break;
+        const char *rep = *hit == '&' ? "&amp;" : *hit == '<' ? "&lt;" : *hit == '>' ? "&gt;" : "&quot;";
+        if (fossil_media_writer_puts(w, rep) != 0) return FOSSIL_MEDIA_HTML_ERR_IO;
+        s = hit + 1;
+        len -= run + 1;
+    }
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+/* Start tags that implicitly close an open element of the same family */
+static int implies_end(const char *open_tag, const char *name) {
+    static const char *const groups[][3] = {
+        { "p", NULL, NULL }, { "li", NULL, NULL }, { "option", NULL, NULL },
+        { "tr", NULL, NULL }, { "td", "th", NULL }, { "dt", "dd", NULL }
+    };
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); ++g) {
+        if (in_tag_list(open_tag, groups[g]) && in_tag_list(name, groups[g])) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    fossil_media_html_selector_t *sel;
+    fossil_media_html_element_fn fn;
+    void *user;
+} rw_element_handler_t;
+
+typedef struct {
+    fossil_media_html_selector_t *sel;
+    fossil_media_html_text_fn fn;
+    void *user;
+} rw_text_handler_t;
+
+struct fossil_media_html_element {
+    fossil_media_html_node_t node;   /* tag and attrs point into strs or owned */
+    char *strs;                      /* null-separated name, keys and values */
+    size_t strs_cap;
+    size_t attr_cap;
+    unsigned char *attr_new;         /* value set by a handler, escape on output */
+    char **owned;                    /* strings allocated for handler edits */
+    size_t owned_count;
+    size_t owned_cap;
+    size_t child_elems;              /* element children seen, for :nth-child */
+    uint64_t text_mask;              /* text handlers matching this element */
+    int self_closing;
+    int dirty;
+    int removed;
+    int unwrap;
+};
+
+struct fossil_media_html_text_chunk {
+    const char *data;
+    size_t len;
+    int removed;
+};
+
+typedef enum {
+    RW_STATE_DATA,
+    RW_STATE_COMMENT,
+    RW_STATE_CDATA,
+    RW_STATE_RAWTEXT
+} rw_state_t;
+
+struct fossil_media_html_rewriter {
+    fossil_media_writer_t out;
+    char out_buf[RW_OUT_BUFFER];
+
+    rw_element_handler_t *element_handlers;
+    size_t element_handler_count;
+    rw_text_handler_t *text_handlers;
+    size_t text_handler_count;
+
+    fossil_media_html_element_t **stack; /* slots are reused, never moved */
+    size_t slot_count;
+    size_t depth;
+    fossil_media_html_node_t root;
+    size_t root_children;
+    size_t suppress_at;                  /* depth of a removed element */
+
+    rw_state_t state;
+    char rawtag[16];
+    size_t rawtag_len;
+
+    char *pending;                       /* unfinished token from the last chunk */
+    size_t pending_len;
+    size_t pending_cap;
+
+    int started;
+    int error;
+};
+
+int fossil_media_html_rewriter_new(fossil_media_sink_fn sink, void *user, fossil_media_html_rewriter_t **out_rw) {
+    if (!sink || !out_rw) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    fossil_media_html_rewriter_t *rw = (fossil_media_html_rewriter_t*)calloc(1, sizeof(*rw));
+    if (!rw) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    fossil_media_writer_init(&rw->out, sink, user, rw->out_buf, sizeof(rw->out_buf));
+    rw->root.type = FOSSIL_MEDIA_HTML_NODE_DOCUMENT;
+    rw->suppress_at = RW_NOT_SUPPRESSED;
+    rw->state = RW_STATE_DATA;
+    *out_rw = rw;
+    return FOSSIL_MEDIA_HTML_OK;
+}
 
-    for (fossil_media_html_node_t *c = doc->root->first_child; c; c = c->next_sibling)
-        serialize_node(c, &buf, &len, &cap);
+static void rw_element_reset(fossil_media_html_element_t *el) {
+    for (size_t i = 0; i < el->owned_count; ++i) free(el->owned[i]);
+    el->owned_count = 0;
+    el->node.attrs.count = 0;
+    el->node.tag = NULL;
+    el->self_closing = el->dirty = el->removed = el->unwrap = 0;
+    el->text_mask = 0;
+    el->child_elems = 0;
+}
+
+void fossil_media_html_rewriter_free(fossil_media_html_rewriter_t *rw) {
+    if (!rw) return;
+    for (size_t i = 0; i < rw->element_handler_count; ++i)
+        fossil_media_html_selector_free(rw->element_handlers[i].sel);
+    for (size_t i = 0; i < rw->text_handler_count; ++i)
+        fossil_media_html_selector_free(rw->text_handlers[i].sel);
+    free(rw->element_handlers);
+    free(rw->text_handlers);
+    for (size_t i = 0; i < rw->slot_count; ++i) {
+        fossil_media_html_element_t *el = rw->stack[i];
+        if (!el) continue;
+        rw_element_reset(el);
+        free(el->strs);
+        free(el->node.attrs.keys);
+        free(el->node.attrs.values);
+        free(el->attr_new);
+        free(el->owned);
+        free(el);
+    }
+    free(rw->stack);
+    free(rw->pending);
+    free(rw);
+}
+
+int fossil_media_html_rewriter_on_element(fossil_media_html_rewriter_t *rw, const char *selector,
+                                          fossil_media_html_element_fn fn, void *user) {
+    if (!rw || !selector || !fn || rw->started) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    fossil_media_html_selector_t *sel = NULL;
+    int rc = fossil_media_html_selector_compile(selector, &sel);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+    rw_element_handler_t *grown = (rw_element_handler_t*)realloc(rw->element_handlers,
+        (rw->element_handler_count + 1) * sizeof(*grown));
+    if (!grown) { fossil_media_html_selector_free(sel); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+    rw->element_handlers = grown;
+    rw->element_handlers[rw->element_handler_count].sel = sel;
+    rw->element_handlers[rw->element_handler_count].fn = fn;
+    rw->element_handlers[rw->element_handler_count].user = user;
+    rw->element_handler_count++;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+int fossil_media_html_rewriter_on_text(fossil_media_html_rewriter_t *rw, const char *selector,
+                                       fossil_media_html_text_fn fn, void *user) {
+    if (!rw || !selector || !fn || rw->started || rw->text_handler_count >= RW_MAX_TEXT_HANDLERS)
+        return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    fossil_media_html_selector_t *sel = NULL;
+    int rc = fossil_media_html_selector_compile(selector, &sel);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+    rw_text_handler_t *grown = (rw_text_handler_t*)realloc(rw->text_handlers,
+        (rw->text_handler_count + 1) * sizeof(*grown));
+    if (!grown) { fossil_media_html_selector_free(sel); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+    rw->text_handlers = grown;
+    rw->text_handlers[rw->text_handler_count].sel = sel;
+    rw->text_handlers[rw->text_handler_count].fn = fn;
+    rw->text_handlers[rw->text_handler_count].user = user;
+    rw->text_handler_count++;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+/* --- Element handle API --- */
+
+static int rw_own(fossil_media_html_element_t *el, char *s) {
+    if (!s) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    if (el->owned_count == el->owned_cap) {
+        size_t cap = el->owned_cap ? el->owned_cap * 2 : 4;
+        char **grown = (char**)realloc(el->owned, cap * sizeof(*grown));
+        if (!grown) { free(s); return FOSSIL_MEDIA_HTML_ERR_NOMEM; }
+        el->owned = grown;
+        el->owned_cap = cap;
+    }
+    el->owned[el->owned_count++] = s;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int rw_reserve_attrs(fossil_media_html_element_t *el, size_t n) {
+    if (n <= el->attr_cap) return FOSSIL_MEDIA_HTML_OK;
+    size_t cap = el->attr_cap ? el->attr_cap : 8;
+    while (cap < n) cap *= 2;
+    char **keys = (char**)realloc(el->node.attrs.keys, cap * sizeof(*keys));
+    if (!keys) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    el->node.attrs.keys = keys;
+    char **values = (char**)realloc(el->node.attrs.values, cap * sizeof(*values));
+    if (!values) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    el->node.attrs.values = values;
+    unsigned char *flags = (unsigned char*)realloc(el->attr_new, cap);
+    if (!flags) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    el->attr_new = flags;
+    el->attr_cap = cap;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static long rw_find_attr(const fossil_media_html_element_t *el, const char *name) {
+    size_t n = strlen(name);
+    for (size_t i = 0; i < el->node.attrs.count; ++i) {
+        if (fossil_media_strncasecmp(el->node.attrs.keys[i], name, n + 1) == 0) return (long)i;
+    }
+    return -1;
+}
+
+const char* fossil_media_html_element_tag(const fossil_media_html_element_t *el) {
+    return el ? el->node.tag : NULL;
+}
+
+const char* fossil_media_html_element_get_attr(const fossil_media_html_element_t *el, const char *name) {
+    if (!el || !name) return NULL;
+    long i = rw_find_attr(el, name);
+    return i < 0 ? NULL : el->node.attrs.values[i];
+}
+
+int fossil_media_html_element_set_attr(fossil_media_html_element_t *el, const char *name, const char *value) {
+    if (!el || !name || !*name || !value) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    char *v = fossil_media_strdup(value);
+    int rc = rw_own(el, v);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+
+    long i = rw_find_attr(el, name);
+    if (i < 0) {
+        char *k = fossil_media_strdup(name);
+        if ((rc = rw_own(el, k)) != FOSSIL_MEDIA_HTML_OK) return rc;
+        if ((rc = rw_reserve_attrs(el, el->node.attrs.count + 1)) != FOSSIL_MEDIA_HTML_OK) return rc;
+        i = (long)el->node.attrs.count++;
+        el->node.attrs.keys[i] = k;
+    }
+    el->node.attrs.values[i] = v;
+    el->attr_new[i] = 1;
+    el->dirty = 1;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+int fossil_media_html_element_remove_attr(fossil_media_html_element_t *el, const char *name) {
+    if (!el || !name) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    long i = rw_find_attr(el, name);
+    if (i < 0) return FOSSIL_MEDIA_HTML_ERR_NOT_FOUND;
+    size_t rest = el->node.attrs.count - (size_t)i - 1;
+    memmove(&el->node.attrs.keys[i], &el->node.attrs.keys[i + 1], rest * sizeof(char*));
+    memmove(&el->node.attrs.values[i], &el->node.attrs.values[i + 1], rest * sizeof(char*));
+    memmove(&el->attr_new[i], &el->attr_new[i + 1], rest);
+    el->node.attrs.count--;
+    el->dirty = 1;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+void fossil_media_html_element_remove(fossil_media_html_element_t *el) {
+    if (el) el->removed = 1;
+}
+
+void fossil_media_html_element_unwrap(fossil_media_html_element_t *el) {
+    if (el) el->unwrap = 1;
+}
+
+const char* fossil_media_html_text_chunk_data(const fossil_media_html_text_chunk_t *chunk, size_t *out_len) {
+    if (!chunk) {
+        if (out_len) *out_len = 0;
+        return NULL;
+    }
+    if (out_len) *out_len = chunk->len;
+    return chunk->data;
+}
+
+void fossil_media_html_text_chunk_replace(fossil_media_html_text_chunk_t *chunk, const char *text) {
+    if (!chunk || !text) return;
+    chunk->data = text;
+    chunk->len = strlen(text);
+}
+
+void fossil_media_html_text_chunk_remove(fossil_media_html_text_chunk_t *chunk) {
+    if (chunk) chunk->removed = 1;
+}
+
+/* --- Output --- */
+
+static int rw_out(fossil_media_html_rewriter_t *rw, const char *data, size_t len) {
+    if (rw->suppress_at != RW_NOT_SUPPRESSED || len == 0) return FOSSIL_MEDIA_HTML_OK;
+    return fossil_media_writer_write(&rw->out, data, len) == 0 ? FOSSIL_MEDIA_HTML_OK : FOSSIL_MEDIA_HTML_ERR_IO;
+}
+
+/* Writes `s` as an attribute value, escaping what a double quote would break */
+static int rw_out_escaped_attr(fossil_media_html_rewriter_t *rw, const char *s) {
+    if (rw->suppress_at != RW_NOT_SUPPRESSED) return FOSSIL_MEDIA_HTML_OK;
+    return write_escaped(&rw->out, s, strlen(s), "&\"<>");
+}
+
+static int rw_out_start_tag(fossil_media_html_rewriter_t *rw, const fossil_media_html_element_t *el) {
+    int rc = rw_out(rw, "<", 1);
+    if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, el->node.tag, strlen(el->node.tag));
+    for (size_t i = 0; i < el->node.attrs.count && rc == FOSSIL_MEDIA_HTML_OK; ++i) {
+        const char *k = el->node.attrs.keys[i];
+        const char *v = el->node.attrs.values[i];
+        rc = rw_out(rw, " ", 1);
+        if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, k, strlen(k));
+        if (rc != FOSSIL_MEDIA_HTML_OK || (!*v && !el->attr_new[i])) continue;
+        if (el->attr_new[i]) {
+            rc = rw_out(rw, "=\"", 2);
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out_escaped_attr(rw, v);
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, "\"", 1);
+        } else if (strchr(v, '"') && strchr(v, '\'')) {
+            /* no quote is safe: escape the double quotes; the rest is already escaped */
+            rc = rw_out(rw, "=\"", 2);
+            if (rc == FOSSIL_MEDIA_HTML_OK && rw->suppress_at == RW_NOT_SUPPRESSED)
+                rc = write_escaped(&rw->out, v, strlen(v), "\"");
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, "\"", 1);
+        } else {
+            /* source values are already escaped; keep them, only pick a safe quote */
+            const char *q = strchr(v, '"') ? "'" : "\"";
+            rc = rw_out(rw, "=", 1);
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, q, 1);
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, v, strlen(v));
+            if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, q, 1);
+        }
+    }
+    if (rc == FOSSIL_MEDIA_HTML_OK && el->self_closing) rc = rw_out(rw, " /", 2);
+    if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_out(rw, ">", 1);
+    return rc;
+}
+
+static int rw_text(fossil_media_html_rewriter_t *rw, const char *data, size_t len) {
+    if (len == 0 || rw->suppress_at != RW_NOT_SUPPRESSED) return FOSSIL_MEDIA_HTML_OK;
+    uint64_t mask = rw->depth ? rw->stack[rw->depth - 1]->text_mask : 0;
+    if (!mask) return rw_out(rw, data, len);
+
+    fossil_media_html_text_chunk_t chunk = { data, len, 0 };
+    for (size_t i = 0; i < rw->text_handler_count && !chunk.removed; ++i) {
+        if (!(mask & ((uint64_t)1 << i))) continue;
+        int rc = rw->text_handlers[i].fn(&chunk, rw->text_handlers[i].user);
+        if (rc < 0) return rc;
+    }
+    return chunk.removed ? FOSSIL_MEDIA_HTML_OK : rw_out(rw, chunk.data, chunk.len);
+}
+
+/* --- Tokenizer actions --- */
+
+static fossil_media_html_element_t *rw_slot(fossil_media_html_rewriter_t *rw, size_t i) {
+    if (i >= rw->slot_count) {
+        size_t count = rw->slot_count ? rw->slot_count * 2 : 16;
+        while (count <= i) count *= 2;
+        fossil_media_html_element_t **grown = (fossil_media_html_element_t**)realloc(rw->stack, count * sizeof(*grown));
+        if (!grown) return NULL;
+        memset(grown + rw->slot_count, 0, (count - rw->slot_count) * sizeof(*grown));
+        rw->stack = grown;
+        rw->slot_count = count;
+    }
+    if (!rw->stack[i]) {
+        rw->stack[i] = (fossil_media_html_element_t*)calloc(1, sizeof(fossil_media_html_element_t));
+        if (rw->stack[i]) rw->stack[i]->node.type = FOSSIL_MEDIA_HTML_NODE_ELEMENT;
+    }
+    return rw->stack[i];
+}
+
+static void rw_pop(fossil_media_html_rewriter_t *rw) {
+    rw->depth--;
+    if (rw->suppress_at == rw->depth) rw->suppress_at = RW_NOT_SUPPRESSED;
+}
+
+/* Splits `<name attr=value ...>` into null-terminated pieces inside el->strs */
+static int rw_parse_start_tag(fossil_media_html_element_t *el, const char *tok, size_t len) {
+    if (el->strs_cap < len * 2 + 2) {
+        size_t cap = el->strs_cap ? el->strs_cap : 256;
+        while (cap < len * 2 + 2) cap *= 2;
+        char *grown = (char*)realloc(el->strs, cap);
+        if (!grown) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        el->strs = grown;
+        el->strs_cap = cap;
+    }
+    char *w = el->strs;
+    const char *p = tok + 1, *end = tok + len - 1; /* end points at '>' */
+
+    el->node.tag = w;
+    while (p < end && !is_css_space(*p) && *p != '/') *w++ = *p++;
+    *w++ = '\0';
+
+    for (;;) {
+        while (p < end && (is_css_space(*p) || *p == '/')) {
+            if (*p == '/') el->self_closing = 1;
+            p++;
+        }
+        if (p >= end) break;
+        el->self_closing = 0;
+
+        const char *k = p;
+        while (p < end && !is_css_space(*p) && *p != '=' && *p != '/') p++;
+        if (p == k) { p++; continue; } /* stray '=' */
+        const char *kend = p;
+        while (p < end && is_css_space(*p)) p++;
+
+        const char *v = "", *vend = v;
+        if (p < end && *p == '=') {
+            p++;
+            while (p < end && is_css_space(*p)) p++;
+            if (p < end && (*p == '"' || *p == '\'')) {
+                char q = *p++;
+                v = p;
+                while (p < end && *p != q) p++;
+                vend = p;
+                if (p < end) p++;
+            } else {
+                v = p;
+                while (p < end && !is_css_space(*p)) p++;
+                vend = p;
+            }
+        }
+        if (rw_reserve_attrs(el, el->node.attrs.count + 1) != FOSSIL_MEDIA_HTML_OK) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+        size_t i = el->node.attrs.count++;
+        el->node.attrs.keys[i] = w;
+        memcpy(w, k, (size_t)(kend - k));
+        w += kend - k;
+        *w++ = '\0';
+        el->node.attrs.values[i] = w;
+        memcpy(w, v, (size_t)(vend - v));
+        w += vend - v;
+        *w++ = '\0';
+        el->attr_new[i] = 0;
+    }
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int rw_start_tag(fossil_media_html_rewriter_t *rw, const char *tok, size_t len) {
+    /* implied end tags such as <li> closing an open <li> */
+    if (rw->depth) {
+        size_t n = 1;
+        while (n < len - 1 && !is_css_space(tok[n]) && tok[n] != '/' && tok[n] != '>') n++;
+        char name[16];
+        if (n - 1 < sizeof(name)) {
+            memcpy(name, tok + 1, n - 1);
+            name[n - 1] = '\0';
+            if (implies_end(rw->stack[rw->depth - 1]->node.tag, name)) rw_pop(rw);
+        }
+    }
+
+    /* beyond the depth limit elements share one slot and are not tracked */
+    size_t slot = rw->depth < RW_MAX_DEPTH ? rw->depth : RW_MAX_DEPTH;
+    fossil_media_html_element_t *el = rw_slot(rw, slot);
+    if (!el) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    rw_element_reset(el);
+    int rc = rw_parse_start_tag(el, tok, len);
+    if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+
+    fossil_media_html_element_t *parent = slot ? rw->stack[slot - 1] : NULL;
+    el->node.parent = parent ? &parent->node : &rw->root;
+    el->node.elem_index = parent ? ++parent->child_elems : ++rw->root_children;
+
+    int suppressed = rw->suppress_at != RW_NOT_SUPPRESSED;
+    if (!suppressed) {
+        for (size_t i = 0; i < rw->element_handler_count && !el->removed; ++i) {
+            rw_element_handler_t *h = &rw->element_handlers[i];
+            if (!match_selector(&el->node, h->sel)) continue;
+            if ((rc = h->fn(el, h->user)) < 0) return rc;
+        }
+    }
+
+    int is_void = el->self_closing || is_void_element(el->node.tag);
+    int tracked = !is_void && slot < RW_MAX_DEPTH;
+    if (!suppressed) {
+        if (el->removed) {
+            if (tracked) rw->suppress_at = slot;
+        } else if (!el->unwrap) {
+            rc = el->dirty ? rw_out_start_tag(rw, el) : rw_out(rw, tok, len);
+            if (rc != FOSSIL_MEDIA_HTML_OK) return rc;
+        }
+        for (size_t i = 0; i < rw->text_handler_count && !el->removed; ++i) {
+            if (match_selector(&el->node, rw->text_handlers[i].sel)) el->text_mask |= (uint64_t)1 << i;
+        }
+    }
+
+    if (!is_void) {
+        if (tracked) rw->depth++;
+        if (in_tag_list(el->node.tag, html_rawtext_elements)) {
+            size_t n = strlen(el->node.tag);
+            for (size_t i = 0; i < n; ++i) rw->rawtag[i] = ascii_lower(el->node.tag[i]);
+            rw->rawtag_len = n;
+            rw->state = RW_STATE_RAWTEXT;
+        }
+    }
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int rw_end_tag(fossil_media_html_rewriter_t *rw, const char *tok, size_t len) {
+    const char *name = tok + 2;
+    size_t n = 0;
+    while (name + n < tok + len - 1 && !is_css_space(name[n]) && name[n] != '/' && name[n] != '>') n++;
+
+    size_t k = rw->depth;
+    while (k > 0) {
+        const char *tag = rw->stack[k - 1]->node.tag;
+        if (strlen(tag) == n && fossil_media_strncasecmp(tag, name, n) == 0) break;
+        k--;
+    }
+    if (k == 0) return rw_out(rw, tok, len); /* stray end tag: pass through */
+
+    /* close implicitly-ended children, then the element itself */
+    while (rw->depth > k) rw_pop(rw);
+    fossil_media_html_element_t *el = rw->stack[k - 1];
+    int emit = rw->suppress_at == RW_NOT_SUPPRESSED && !el->unwrap;
+    rw_pop(rw);
+    return emit ? rw_out(rw, tok, len) : FOSSIL_MEDIA_HTML_OK;
+}
+
+/* 1 = `lit` starts at p, 0 = it does not, -1 = not enough input to tell */
+static int rw_prefix(const char *p, size_t avail, const char *lit) {
+    size_t n = strlen(lit);
+    size_t m = avail < n ? avail : n;
+    if (memcmp(p, lit, m) != 0) return 0;
+    return avail < n ? -1 : 1;
+}
+
+static const char *rw_find(const char *p, size_t len, const char *lit, size_t n) {
+    while (len >= n) {
+        const char *hit = (const char*)memchr(p, lit[0], len - n + 1);
+        if (!hit) return NULL;
+        if (memcmp(hit, lit, n) == 0) return hit;
+        len -= (size_t)(hit - p) + 1;
+        p = hit + 1;
+    }
+    return NULL;
+}
+
+/* Length of the start tag at p (quote-aware), or 0 if '>' is not in view */
+static size_t rw_tag_length(const char *p, size_t avail) {
+    char q = 0;
+    int after_eq = 0;
+    for (size_t i = 1; i < avail; ++i) {
+        char c = p[i];
+        if (q) {
+            if (c == q) q = 0;
+            continue;
+        }
+        if (c == '>') return i + 1;
+        if (after_eq && (c == '"' || c == '\'')) {
+            q = c;
+            after_eq = 0;
+        } else if (c == '=') {
+            after_eq = 1;
+        } else if (!is_css_space(c)) {
+            after_eq = 0;
+        }
+    }
+    return 0;
+}
+
+static int rw_process(fossil_media_html_rewriter_t *rw, const char *d, size_t len, int final, size_t *consumed) {
+    size_t pos = 0;
+    int rc = FOSSIL_MEDIA_HTML_OK;
+
+    while (pos < len && rc == FOSSIL_MEDIA_HTML_OK) {
+        size_t avail = len - pos;
+
+        if (rw->state == RW_STATE_COMMENT || rw->state == RW_STATE_CDATA) {
+            const char *term = rw->state == RW_STATE_COMMENT ? "-->" : "]]>";
+            const char *hit = rw_find(d + pos, avail, term, 3);
+            if (hit) {
+                size_t n = (size_t)(hit - (d + pos)) + 3;
+                rc = rw_out(rw, d + pos, n);
+                pos += n;
+                rw->state = RW_STATE_DATA;
+                continue;
+            }
+            /* keep two bytes back in case the terminator straddles chunks */
+            size_t n = (final || avail <= 2) ? (final ? avail : 0) : avail - 2;
+            rc = rw_out(rw, d + pos, n);
+            pos += n;
+            break;
+        }
+
+        if (rw->state == RW_STATE_RAWTEXT) {
+            size_t scan = pos;
+            int stop = 0;
+            while (!stop) {
+                const char *lt = (const char*)memchr(d + scan, '<', len - scan);
+                if (!lt) {
+                    rc = rw_text(rw, d + pos, len - pos);
+                    pos = len;
+                    break;
+                }
+                size_t at = (size_t)(lt - d);
+                size_t need = 2 + rw->rawtag_len + 1;
+                if (len - at < need && !final) {
+                    rc = rw_text(rw, d + pos, at - pos);
+                    pos = at;
+                    stop = 1;
+                    break;
+                }
+                if (len - at >= need - 1 && lt[1] == '/' &&
+                    fossil_media_strncasecmp(lt + 2, rw->rawtag, rw->rawtag_len) == 0 &&
+                    (len - at == need - 1 || is_css_space(lt[need - 1]) || lt[need - 1] == '>' || lt[need - 1] == '/')) {
+                    rc = rw_text(rw, d + pos, at - pos);
+                    pos = at;
+                    rw->state = RW_STATE_DATA;
+                    break;
+                }
+                scan = at + 1;
+            }
+            if (stop) break;
+            continue;
+        }
+
+        /* data state */
+        const char *lt = (const char*)memchr(d + pos, '<', avail);
+        size_t at = lt ? (size_t)(lt - d) : len;
+        /* hold back a short unfinished text run so text handlers see it whole */
+        if (!lt && !final && avail < RW_MAX_TOKEN / 2 && rw->depth &&
+            rw->stack[rw->depth - 1]->text_mask && rw->suppress_at == RW_NOT_SUPPRESSED)
+            break;
+        if (at > pos) {
+            rc = rw_text(rw, d + pos, at - pos);
+            pos = at;
+            if (rc != FOSSIL_MEDIA_HTML_OK || !lt) continue;
+        }
+        avail = len - pos;
+        if (avail < 2) {
+            if (!final) break;
+            rc = rw_text(rw, d + pos, avail);
+            pos = len;
+            continue;
+        }
+
+        const char *p = d + pos;
+        size_t tok = 0;
+        int need_more = 0;
+        if (p[1] == '!') {
+            int m = rw_prefix(p, avail, "<!--");
+            int c = rw_prefix(p, avail, "<![CDATA[");
+            if (m > 0 || c > 0) {
+                size_t n = m > 0 ? 4 : 9;
+                rc = rw_out(rw, p, n);
+                pos += n;
+                rw->state = m > 0 ? RW_STATE_COMMENT : RW_STATE_CDATA;
+                continue;
+            }
+            if (m < 0 || c < 0) {
+                need_more = 1;
+            } else {
+                const char *gt = (const char*)memchr(p, '>', avail);
+                if (gt) tok = (size_t)(gt - p) + 1;
+                else need_more = 1;
+            }
+            if (tok) { rc = rw_out(rw, p, tok); pos += tok; continue; }
+        } else if (p[1] == '?') {
+            const char *gt = (const char*)memchr(p, '>', avail);
+            if (gt) {
+                tok = (size_t)(gt - p) + 1;
+                rc = rw_out(rw, p, tok);
+                pos += tok;
+                continue;
+            }
+            need_more = 1;
+        } else if (p[1] == '/') {
+            const char *gt = (const char*)memchr(p, '>', avail);
+            if (gt) {
+                tok = (size_t)(gt - p) + 1;
+                rc = rw_end_tag(rw, p, tok);
+                pos += tok;
+                continue;
+            }
+            need_more = 1;
+        } else if ((p[1] >= 'a' && p[1] <= 'z') || (p[1] >= 'A' && p[1] <= 'Z')) {
+            tok = rw_tag_length(p, avail);
+            if (tok) {
+                rc = rw_start_tag(rw, p, tok);
+                pos += tok;
+                continue;
+            }
+            need_more = 1;
+        } else {
+            rc = rw_text(rw, p, 1); /* a '<' that starts no markup */
+            pos++;
+            continue;
+        }
+
+        if (need_more) {
+            if (!final) break;
+            rc = rw_text(rw, p, avail); /* unterminated markup at EOF */
+            pos = len;
+        }
+    }
+
+    *consumed = pos;
+    return rc;
+}
+
+static int rw_keep(fossil_media_html_rewriter_t *rw, const char *data, size_t len) {
+    if (len > RW_MAX_TOKEN) return FOSSIL_MEDIA_HTML_ERR_PARSE;
+    if (len > rw->pending_cap) {
+        size_t cap = rw->pending_cap ? rw->pending_cap : 256;
+        while (cap < len) cap *= 2;
+        char *grown = (char*)realloc(rw->pending, cap);
+        if (!grown) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+        rw->pending = grown;
+        rw->pending_cap = cap;
+    }
+    if (len) memmove(rw->pending, data, len);
+    rw->pending_len = len;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+int fossil_media_html_rewriter_write(fossil_media_html_rewriter_t *rw, const char *data, size_t len) {
+    if (!rw || (!data && len)) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    if (rw->error) return rw->error;
+    rw->started = 1;
+
+    size_t consumed = 0;
+    int rc = FOSSIL_MEDIA_HTML_OK;
+    if (rw->pending_len) {
+        /* complete the unfinished token with at most one token's worth of input */
+        size_t old = rw->pending_len;
+        size_t take = len < RW_MAX_TOKEN ? len : RW_MAX_TOKEN;
+        if (old + take > rw->pending_cap) {
+            size_t cap = rw->pending_cap;
+            while (cap < old + take) cap *= 2;
+            char *grown = (char*)realloc(rw->pending, cap);
+            if (!grown) return rw->error = FOSSIL_MEDIA_HTML_ERR_NOMEM;
+            rw->pending = grown;
+            rw->pending_cap = cap;
+        }
+        memcpy(rw->pending + old, data, take);
+        rc = rw_process(rw, rw->pending, old + take, 0, &consumed);
+        if (rc == FOSSIL_MEDIA_HTML_OK && consumed < old) {
+            rc = take < len ? FOSSIL_MEDIA_HTML_ERR_PARSE
+                            : rw_keep(rw, rw->pending + consumed, old + take - consumed);
+            if (rc != FOSSIL_MEDIA_HTML_OK) rw->error = rc;
+            return rc;
+        }
+        rw->pending_len = 0;
+        data += consumed - old;
+        len -= consumed - old;
+    }
+
+    if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_process(rw, data, len, 0, &consumed);
+    if (rc == FOSSIL_MEDIA_HTML_OK) rc = rw_keep(rw, data + consumed, len - consumed);
+    if (rc != FOSSIL_MEDIA_HTML_OK) rw->error = rc;
+    return rc;
+}
+
+int fossil_media_html_rewriter_end(fossil_media_html_rewriter_t *rw) {
+    if (!rw) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    if (rw->error) return rw->error;
+    size_t consumed = 0;
+    int rc = rw_process(rw, rw->pending, rw->pending_len, 1, &consumed);
+    rw->pending_len = 0;
+    if (rc == FOSSIL_MEDIA_HTML_OK && fossil_media_writer_flush(&rw->out) != 0) rc = FOSSIL_MEDIA_HTML_ERR_IO;
+    if (rc != FOSSIL_MEDIA_HTML_OK) rw->error = rc;
+    return rc;
+}
+
+/* ---------------------------------------------------------------------------
+ * Text extraction
+ *
+ * One forward pass and no tree: text runs are located with
+ * fossil_media_find_any(), tags are skipped, script/style bodies and
+ * comments are dropped, entities are decoded and whitespace is collapsed.
+ * Nothing decodes to more bytes than it was spelled with, so the output is
+ * written into a single allocation the size of the input.
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    const char *name;
+    uint32_t cp;
+} html_entity_t;
+
+/*
+ * The HTML 4 named entities plus &apos;, addressed through a hash-and-displace
+ * perfect hash: the name's seed-0 hash picks a displacement, and the hash under
+ * that displacement picks a unique slot.
+ */
+static const html_entity_t html_entities[253] = {
+    {"AElig", 0xC6}, {"Aacute", 0xC1}, {"Acirc", 0xC2}, {"Agrave", 0xC0}, {"Alpha", 0x391},
+    {"Aring", 0xC5}, {"Atilde", 0xC3}, {"Auml", 0xC4}, {"Beta", 0x392}, {"Ccedil", 0xC7},
+    {"Chi", 0x3A7}, {"Dagger", 0x2021}, {"Delta", 0x394}, {"ETH", 0xD0}, {"Eacute", 0xC9},
+    {"Ecirc", 0xCA}, {"Egrave", 0xC8}, {"Epsilon", 0x395}, {"Eta", 0x397}, {"Euml", 0xCB},
+    {"Gamma", 0x393}, {"Iacute", 0xCD}, {"Icirc", 0xCE}, {"Igrave", 0xCC}, {"Iota", 0x399},
+    {"Iuml", 0xCF}, {"Kappa", 0x39A}, {"Lambda", 0x39B}, {"Mu", 0x39C}, {"Ntilde", 0xD1},
+    {"Nu", 0x39D}, {"OElig", 0x152}, {"Oacute", 0xD3}, {"Ocirc", 0xD4}, {"Ograve", 0xD2},
+    {"Omega", 0x3A9}, {"Omicron", 0x39F}, {"Oslash", 0xD8}, {"Otilde", 0xD5}, {"Ouml", 0xD6},
+    {"Phi", 0x3A6}, {"Pi", 0x3A0}, {"Prime", 0x2033}, {"Psi", 0x3A8}, {"Rho", 0x3A1},
+    {"Scaron", 0x160}, {"Sigma", 0x3A3}, {"THORN", 0xDE}, {"Tau", 0x3A4}, {"Theta", 0x398},
+    {"Uacute", 0xDA}, {"Ucirc", 0xDB}, {"Ugrave", 0xD9}, {"Upsilon", 0x3A5}, {"Uuml", 0xDC},
+    {"Xi", 0x39E}, {"Yacute", 0xDD}, {"Yuml", 0x178}, {"Zeta", 0x396}, {"aacute", 0xE1},
+    {"acirc", 0xE2}, {"acute", 0xB4}, {"aelig", 0xE6}, {"agrave", 0xE0}, {"alefsym", 0x2135},
+    {"alpha", 0x3B1}, {"amp", 0x26}, {"and", 0x2227}, {"ang", 0x2220}, {"apos", 0x27},
+    {"aring", 0xE5}, {"asymp", 0x2248}, {"atilde", 0xE3}, {"auml", 0xE4}, {"bdquo", 0x201E},
+    {"beta", 0x3B2}, {"brvbar", 0xA6}, {"bull", 0x2022}, {"cap", 0x2229}, {"ccedil", 0xE7},
+    {"cedil", 0xB8}, {"cent", 0xA2}, {"chi", 0x3C7}, {"circ", 0x2C6}, {"clubs", 0x2663},
+    {"cong", 0x2245}, {"copy", 0xA9}, {"crarr", 0x21B5}, {"cup", 0x222A}, {"curren", 0xA4},
+    {"dArr", 0x21D3}, {"dagger", 0x2020}, {"darr", 0x2193}, {"deg", 0xB0}, {"delta", 0x3B4},
+    {"diams", 0x2666}, {"divide", 0xF7}, {"eacute", 0xE9}, {"ecirc", 0xEA}, {"egrave", 0xE8},
+    {"empty", 0x2205}, {"emsp", 0x2003}, {"ensp", 0x2002}, {"epsilon", 0x3B5}, {"equiv", 0x2261},
+    {"eta", 0x3B7}, {"eth", 0xF0}, {"euml", 0xEB}, {"euro", 0x20AC}, {"exist", 0x2203},
+    {"fnof", 0x192}, {"forall", 0x2200}, {"frac12", 0xBD}, {"frac14", 0xBC}, {"frac34", 0xBE},
+    {"frasl", 0x2044}, {"gamma", 0x3B3}, {"ge", 0x2265}, {"gt", 0x3E}, {"hArr", 0x21D4},
+    {"harr", 0x2194}, {"hearts", 0x2665}, {"hellip", 0x2026}, {"iacute", 0xED}, {"icirc", 0xEE},
+    {"iexcl", 0xA1}, {"igrave", 0xEC}, {"image", 0x2111}, {"infin", 0x221E}, {"int", 0x222B},
+    {"iota", 0x3B9}, {"iquest", 0xBF}, {"isin", 0x2208}, {"iuml", 0xEF}, {"kappa", 0x3BA},
+    {"lArr", 0x21D0}, {"lambda", 0x3BB}, {"lang", 0x2329}, {"laquo", 0xAB}, {"larr", 0x2190},
+    {"lceil", 0x2308}, {"ldquo", 0x201C}, {"le", 0x2264}, {"lfloor", 0x230A}, {"lowast", 0x2217},
+    {"loz", 0x25CA}, {"lrm", 0x200E}, {"lsaquo", 0x2039}, {"lsquo", 0x2018}, {"lt", 0x3C},
+    {"macr", 0xAF}, {"mdash", 0x2014}, {"micro", 0xB5}, {"middot", 0xB7}, {"minus", 0x2212},
+    {"mu", 0x3BC}, {"nabla", 0x2207}, {"nbsp", 0xA0}, {"ndash", 0x2013}, {"ne", 0x2260},
+    {"ni", 0x220B}, {"not", 0xAC}, {"notin", 0x2209}, {"nsub", 0x2284}, {"ntilde", 0xF1},
+    {"nu", 0x3BD}, {"oacute", 0xF3}, {"ocirc", 0xF4}, {"oelig", 0x153}, {"ograve", 0xF2},
+    {"oline", 0x203E}, {"omega", 0x3C9}, {"omicron", 0x3BF}, {"oplus", 0x2295}, {"or", 0x2228},
+    {"ordf", 0xAA}, {"ordm", 0xBA}, {"oslash", 0xF8}, {"otilde", 0xF5}, {"otimes", 0x2297},
+    {"ouml", 0xF6}, {"para", 0xB6}, {"part", 0x2202}, {"permil", 0x2030}, {"perp", 0x22A5},
+    {"phi", 0x3C6}, {"pi", 0x3C0}, {"piv", 0x3D6}, {"plusmn", 0xB1}, {"pound", 0xA3},
+    {"prime", 0x2032}, {"prod", 0x220F}, {"prop", 0x221D}, {"psi", 0x3C8}, {"quot", 0x22},
+    {"rArr", 0x21D2}, {"radic", 0x221A}, {"rang", 0x232A}, {"raquo", 0xBB}, {"rarr", 0x2192},
+    {"rceil", 0x2309}, {"rdquo", 0x201D}, {"real", 0x211C}, {"reg", 0xAE}, {"rfloor", 0x230B},
+    {"rho", 0x3C1}, {"rlm", 0x200F}, {"rsaquo", 0x203A}, {"rsquo", 0x2019}, {"sbquo", 0x201A},
+    {"scaron", 0x161}, {"sdot", 0x22C5}, {"sect", 0xA7}, {"shy", 0xAD}, {"sigma", 0x3C3},
+    {"sigmaf", 0x3C2}, {"sim", 0x223C}, {"spades", 0x2660}, {"sub", 0x2282}, {"sube", 0x2286},
+    {"sum", 0x2211}, {"sup", 0x2283}, {"sup1", 0xB9}, {"sup2", 0xB2}, {"sup3", 0xB3},
+    {"supe", 0x2287}, {"szlig", 0xDF}, {"tau", 0x3C4}, {"there4", 0x2234}, {"theta", 0x3B8},
+    {"thetasym", 0x3D1}, {"thinsp", 0x2009}, {"thorn", 0xFE}, {"tilde", 0x2DC}, {"times", 0xD7},
+    {"trade", 0x2122}, {"uArr", 0x21D1}, {"uacute", 0xFA}, {"uarr", 0x2191}, {"ucirc", 0xFB},
+    {"ugrave", 0xF9}, {"uml", 0xA8}, {"upsih", 0x3D2}, {"upsilon", 0x3C5}, {"uuml", 0xFC},
+    {"weierp", 0x2118}, {"xi", 0x3BE}, {"yacute", 0xFD}, {"yen", 0xA5}, {"yuml", 0xFF},
+    {"zeta", 0x3B6}, {"zwj", 0x200D}, {"zwnj", 0x200C},
+};
+static const uint8_t html_entity_disp[64] = {
+    1, 3, 4, 2, 1, 9, 1, 3, 1, 6, 2, 1, 4, 2, 1, 1,
+    1, 4, 2, 4, 6, 1, 3, 3, 1, 2, 2, 1, 1, 1, 2, 1,
+    6, 1, 5, 4, 7, 1, 4, 1, 1, 3, 7, 1, 12, 2, 1, 2,
+    10, 6, 3, 4, 2, 11, 13, 2, 3, 0, 3, 5, 1, 3, 3, 3,
+};
+/* 1-based index into html_entities, 0 = empty */
+static const uint16_t html_entity_slots[512] = {
+    108, 77, 145, 0, 0, 0, 152, 0, 0, 41, 0, 0, 0, 181, 0, 113,
+    116, 146, 0, 0, 50, 0, 0, 69, 188, 33, 214, 0, 251, 164, 0, 121,
+    149, 0, 0, 1, 189, 148, 92, 0, 180, 84, 0, 119, 0, 40, 174, 0,
+    223, 176, 11, 60, 91, 0, 0, 0, 0, 216, 222, 159, 8, 208, 202, 0,
+    0, 0, 16, 205, 76, 0, 0, 212, 199, 0, 215, 0, 0, 0, 0, 0,
+    253, 98, 0, 0, 42, 0, 17, 0, 5, 0, 0, 111, 235, 0, 210, 54,
+    0, 0, 102, 0, 0, 0, 0, 239, 51, 0, 114, 21, 106, 34, 165, 0,
+    0, 15, 0, 0, 0, 0, 104, 0, 80, 177, 12, 115, 157, 0, 0, 225,
+    228, 71, 0, 242, 123, 93, 0, 0, 170, 0, 0, 0, 153, 0, 47, 0,
+    0, 0, 0, 37, 0, 22, 0, 107, 166, 0, 0, 191, 44, 155, 0, 150,
+    203, 0, 217, 63, 141, 126, 0, 88, 130, 0, 0, 0, 246, 2, 0, 0,
+    234, 0, 0, 0, 32, 86, 97, 36, 66, 0, 83, 0, 0, 0, 0, 244,
+    13, 0, 0, 0, 0, 78, 0, 0, 79, 206, 182, 58, 0, 184, 0, 27,
+    31, 198, 127, 168, 0, 161, 0, 0, 0, 0, 211, 0, 72, 39, 0, 0,
+    28, 0, 0, 133, 134, 74, 0, 0, 0, 224, 0, 4, 0, 154, 59, 38,
+    0, 187, 0, 0, 169, 158, 129, 14, 99, 207, 0, 0, 0, 53, 183, 112,
+    65, 0, 0, 55, 24, 20, 0, 201, 0, 0, 0, 179, 0, 0, 229, 62,
+    0, 243, 0, 132, 0, 0, 250, 172, 30, 26, 124, 81, 117, 143, 35, 0,
+    100, 160, 120, 0, 0, 57, 0, 0, 94, 70, 0, 236, 29, 0, 0, 135,
+    0, 0, 0, 0, 0, 237, 9, 221, 18, 220, 139, 227, 0, 147, 190, 0,
+    89, 0, 0, 0, 3, 101, 0, 23, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 10, 0, 0, 0, 6, 0, 0, 0, 248, 118,
+    0, 0, 19, 0, 167, 0, 204, 67, 0, 0, 0, 49, 0, 103, 0, 110,
+    131, 0, 0, 0, 0, 0, 0, 0, 0, 175, 82, 0, 90, 0, 0, 218,
+    0, 185, 249, 142, 7, 0, 140, 0, 230, 0, 0, 0, 0, 0, 0, 226,
+    0, 0, 95, 0, 0, 0, 0, 0, 138, 196, 0, 241, 0, 233, 43, 0,
+    0, 0, 122, 0, 61, 195, 0, 125, 0, 137, 68, 128, 56, 0, 0, 151,
+    75, 0, 0, 0, 0, 0, 0, 0, 231, 240, 0, 96, 0, 0, 194, 136,
+    0, 0, 0, 45, 0, 25, 0, 209, 162, 87, 0, 64, 85, 0, 163, 178,
+    0, 0, 0, 0, 0, 73, 0, 109, 252, 0, 0, 0, 46, 0, 0, 0,
+    0, 144, 171, 245, 0, 247, 219, 193, 52, 213, 105, 197, 0, 0, 192, 186,
+    238, 156, 0, 173, 0, 0, 0, 0, 0, 200, 0, 232, 0, 0, 48, 0,
+};
+
+#define HTML_ENTITY_MAX_NAME 8
+
+static uint32_t entity_hash(const char *s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int lookup_entity(const char *name, size_t len, uint32_t *cp) {
+    if (len == 0 || len > HTML_ENTITY_MAX_NAME) return 0;
+    size_t nbuckets = sizeof(html_entity_disp) / sizeof(html_entity_disp[0]);
+    size_t nslots = sizeof(html_entity_slots) / sizeof(html_entity_slots[0]);
+    uint32_t disp = html_entity_disp[entity_hash(name, len, 0) % nbuckets];
+    uint16_t idx = html_entity_slots[entity_hash(name, len, disp) % nslots];
+    if (!idx) return 0;
+    const html_entity_t *e = &html_entities[idx - 1];
+    if (strncmp(e->name, name, len) != 0 || e->name[len] != '\0') return 0;
+    *cp = e->cp;
+    return 1;
+}
+
+/* Decode the reference starting at p[0] == '&'; returns bytes consumed or 0 */
+static size_t decode_entity(const char *p, const char *end, uint32_t *cp) {
+    const char *q = p + 1;
+    if (q < end && *q == '#') {
+        int hex = (q + 1 < end && (q[1] == 'x' || q[1] == 'X'));
+        q += hex ? 2 : 1;
+        const char *digits = q;
+        uint32_t v = 0;
+        for (; q < end; ++q) {
+            unsigned d;
+            if (*q >= '0' && *q <= '9') d = (unsigned)(*q - '0');
+            else if (hex && *q >= 'a' && *q <= 'f') d = (unsigned)(*q - 'a' + 10);
+            else if (hex && *q >= 'A' && *q <= 'F') d = (unsigned)(*q - 'A' + 10);
+            else break;
+            if (v <= 0x10FFFF) v = v * (hex ? 16u : 10u) + d;
+        }
+        if (q == digits || q >= end || *q != ';') return 0;
+        if (v == 0 || v > 0x10FFFF || (v >= 0xD800 && v <= 0xDFFF)) v = 0xFFFD;
+        *cp = v;
+        return (size_t)(q + 1 - p);
+    }
+    const char *name = q;
+    while (q < end && (size_t)(q - name) <= HTML_ENTITY_MAX_NAME &&
+           ((*q >= 'a' && *q <= 'z') || (*q >= 'A' && *q <= 'Z') || (*q >= '0' && *q <= '9'))) {
+        ++q;
+    }
+    if (q >= end || *q != ';' || !lookup_entity(name, (size_t)(q - name), cp)) return 0;
+    return (size_t)(q + 1 - p);
+}
+
+/*
+ * Decode character references in s[0..len) into `out`, returning the decoded
+ * length. Output never outruns input, so `out` may be `s` itself.
+ */
+static size_t html_decode_into(char *out, const char *s, size_t len) {
+    const char *p = s, *end = s + len;
+    size_t n = 0;
+    const char *amp;
+    while ((amp = (const char*)memchr(p, '&', (size_t)(end - p))) != NULL) {
+        memmove(out + n, p, (size_t)(amp - p));
+        n += (size_t)(amp - p);
+        uint32_t cp;
+        size_t used = decode_entity(amp, end, &cp);
+        if (used) {
+            char buf[4];
+            size_t k = fossil_media_utf8_encode(cp, buf);
+            memcpy(out + n, buf, k);
+            n += k;
+            p = amp + used;
+        } else {
+            out[n++] = '&';
+            p = amp + 1;
+        }
+    }
+    memmove(out + n, p, (size_t)(end - p));
+    return n + (size_t)(end - p);
+}
+
+typedef struct {
+    char *out;
+    size_t len;
+    int space; /* whitespace seen since the last emitted character */
+} text_out_t;
+
+static void text_put(text_out_t *t, const char *s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (is_css_space(c)) {
+            t->space = 1;
+            continue;
+        }
+        if (t->space && t->len) t->out[t->len++] = ' ';
+        t->space = 0;
+        t->out[t->len++] = c;
+    }
+}
+
+static void text_put_cp(text_out_t *t, uint32_t cp) {
+    char buf[4];
+    if (cp < 0x80) {
+        buf[0] = (char)cp;
+        text_put(t, buf, 1);
+        return;
+    }
+    if (t->space && t->len) t->out[t->len++] = ' ';
+    t->space = 0;
+    t->len += fossil_media_utf8_encode(cp, t->out + t->len);
+}
+
+/* Elements that do not separate words, so no space is implied around them (sorted) */
+static const char *const html_inline_elements[] = {
+    "a", "abbr", "b", "bdi", "bdo", "cite", "code", "data", "dfn", "em",
+    "font", "i", "kbd", "mark", "q", "s", "samp", "small", "span", "strong",
+    "sub", "sup", "time", "tt", "u", "var", "wbr"
+};
+
+static int is_inline_element(const char *lower_name) {
+    size_t lo = 0, hi = sizeof(html_inline_elements) / sizeof(html_inline_elements[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = strcmp(lower_name, html_inline_elements[mid]);
+        if (c == 0) return 1;
+        if (c < 0) hi = mid; else lo = mid + 1;
+    }
+    return 0;
+}
+
+/* Find the `</name` that closes a script/style body (case-insensitive) */
+static const char *find_raw_end(const char *p, const char *end, const char *name, size_t n) {
+    while ((p = fossil_media_find_any(p, (size_t)(end - p), "<")) != NULL) {
+        if ((size_t)(end - p) >= n + 2 && p[1] == '/' &&
+            fossil_media_strncasecmp(p + 2, name, n) == 0 &&
+            ((size_t)(end - p) == n + 2 || is_css_space(p[n + 2]) || p[n + 2] == '/' || p[n + 2] == '>')) {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+int fossil_media_html_extract_text(const char *html, size_t len, char **out_text, size_t *out_len) {
+    if (!out_text || (!html && len)) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    *out_text = NULL;
+    if (out_len) *out_len = 0;
+
+    text_out_t t = { (char*)malloc(len + 1), 0, 0 };
+    if (!t.out) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+
+    const char *p = html;
+    const char *end = html + len;
+    while (p < end) {
+        const char *mark = fossil_media_find_any(p, (size_t)(end - p), "<&");
+        if (!mark) {
+            text_put(&t, p, (size_t)(end - p));
+            break;
+        }
+        text_put(&t, p, (size_t)(mark - p));
+        p = mark;
+
+        if (*p == '&') {
+            uint32_t cp;
+            size_t n = decode_entity(p, end, &cp);
+            if (n) {
+                text_put_cp(&t, cp);
+                p += n;
+            } else {
+                text_put(&t, p++, 1);
+            }
+            continue;
+        }
+
+        size_t avail = (size_t)(end - p);
+        if (avail >= 4 && memcmp(p, "<!--", 4) == 0) {
+            const char *close = rw_find(p + 4, avail - 4, "-->", 3);
+            p = close ? close + 3 : end;
+            continue;
+        }
+        int is_end = avail > 1 && p[1] == '/';
+        char first = avail > (size_t)(1 + is_end) ? p[1 + is_end] : '\0';
+        int letter = (first >= 'a' && first <= 'z') || (first >= 'A' && first <= 'Z');
+        if (!letter && !(avail > 1 && (p[1] == '!' || p[1] == '?')) && !is_end) {
+            text_put(&t, p++, 1); /* a bare '<' is text */
+            continue;
+        }
+
+        char name[16];
+        size_t n = 0;
+        for (const char *q = p + 1 + is_end; q < end && n < sizeof(name) - 1 &&
+             !is_css_space(*q) && *q != '/' && *q != '>'; ++q) {
+            name[n++] = ascii_lower(*q);
+        }
+        name[n] = '\0';
+
+        size_t tag_len = rw_tag_length(p, avail);
+        if (!tag_len) break; /* unterminated tag runs to the end */
+        p += tag_len;
+        if (!letter) continue; /* doctype, processing instruction, bogus comment */
+
+        if (!is_inline_element(name)) t.space = 1;
+        if (!is_end && is_script_element(name)) {
+            p = find_raw_end(p, end, name, n);
+        }
+    }
+
+    t.out[t.len] = '\0';
+    *out_text = t.out;
+    if (out_len) *out_len = t.len;
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * Serialization
+ *
+ * The tree is walked iteratively (parent pointers, no recursion) and written
+ * through a fossil_media_writer_t, so the same walk streams to a sink or,
+ * with no sink, measures the exact output size for a single allocation.
+ * ------------------------------------------------------------------------- */
+
+static int write_open(fossil_media_writer_t *w, const fossil_media_html_node_t *n) {
+    const char *text = n->text ? n->text : "";
+    switch (n->type) {
+        case FOSSIL_MEDIA_HTML_NODE_ELEMENT:
+            fossil_media_writer_putc(w, '<');
+            fossil_media_writer_puts(w, n->tag);
+            for (size_t i = 0; i < n->attrs.count; ++i) {
+                fossil_media_writer_putc(w, ' ');
+                fossil_media_writer_puts(w, n->attrs.keys[i]);
+                if (!n->attrs.values[i]) continue;
+                fossil_media_writer_write(w, "=\"", 2);
+                if (write_escaped(w, n->attrs.values[i], strlen(n->attrs.values[i]), "&\"") != FOSSIL_MEDIA_HTML_OK)
+                    return FOSSIL_MEDIA_HTML_ERR_IO;
+                fossil_media_writer_putc(w, '"');
+            }
+            fossil_media_writer_putc(w, '>');
+            break;
+        case FOSSIL_MEDIA_HTML_NODE_TEXT:
+            if (n->parent && n->parent->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT && is_script_element(n->parent->tag))
+                fossil_media_writer_puts(w, text);
+            else if (write_escaped(w, text, strlen(text), "&<>") != FOSSIL_MEDIA_HTML_OK)
+                return FOSSIL_MEDIA_HTML_ERR_IO;
+            break;
+        case FOSSIL_MEDIA_HTML_NODE_COMMENT:
+            fossil_media_writer_puts(w, "<!--");
+            fossil_media_writer_puts(w, text);
+            fossil_media_writer_puts(w, "-->");
+            break;
+        case FOSSIL_MEDIA_HTML_NODE_DOCTYPE:
+            fossil_media_writer_puts(w, "<!");
+            fossil_media_writer_puts(w, text);
+            fossil_media_writer_putc(w, '>');
+            break;
+        case FOSSIL_MEDIA_HTML_NODE_CDATA:
+            fossil_media_writer_puts(w, "<![CDATA[");
+            fossil_media_writer_puts(w, text);
+            fossil_media_writer_puts(w, "]]>");
+            break;
+        case FOSSIL_MEDIA_HTML_NODE_PROCESSING_INSTRUCTION:
+            fossil_media_writer_puts(w, "<?");
+            fossil_media_writer_puts(w, text);
+            fossil_media_writer_puts(w, "?>");
+            break;
+        default:
+            break;
+    }
+    return w->error ? FOSSIL_MEDIA_HTML_ERR_IO : FOSSIL_MEDIA_HTML_OK;
+}
+
+/* End tag of an element; void elements have none unless they gained children */
+static int write_close(fossil_media_writer_t *w, const fossil_media_html_node_t *n) {
+    if (n->type != FOSSIL_MEDIA_HTML_NODE_ELEMENT) return FOSSIL_MEDIA_HTML_OK;
+    if (!n->first_child && is_void_element(n->tag)) return FOSSIL_MEDIA_HTML_OK;
+    fossil_media_writer_write(w, "</", 2);
+    fossil_media_writer_puts(w, n->tag);
+    fossil_media_writer_putc(w, '>');
+    return w->error ? FOSSIL_MEDIA_HTML_ERR_IO : FOSSIL_MEDIA_HTML_OK;
+}
+
+static int serialize_tree(const fossil_media_html_node_t *root, fossil_media_writer_t *w) {
+    const fossil_media_html_node_t *n = root->first_child;
+    while (n) {
+        if (write_open(w, n) != FOSSIL_MEDIA_HTML_OK) return FOSSIL_MEDIA_HTML_ERR_IO;
+        if (n->type == FOSSIL_MEDIA_HTML_NODE_ELEMENT && n->first_child) {
+            n = n->first_child;
+            continue;
+        }
+        if (write_close(w, n) != FOSSIL_MEDIA_HTML_OK) return FOSSIL_MEDIA_HTML_ERR_IO;
+        while (!n->next_sibling) {
+            n = n->parent;
+            if (!n || n == root) return fossil_media_writer_flush(w) ? FOSSIL_MEDIA_HTML_ERR_IO : FOSSIL_MEDIA_HTML_OK;
+            if (write_close(w, n) != FOSSIL_MEDIA_HTML_OK) return FOSSIL_MEDIA_HTML_ERR_IO;
+        }
+        n = n->next_sibling;
+    }
+    return fossil_media_writer_flush(w) ? FOSSIL_MEDIA_HTML_ERR_IO : FOSSIL_MEDIA_HTML_OK;
+}
+
+int fossil_media_html_serialize_to(const fossil_media_html_doc_t *doc, fossil_media_sink_fn sink, void *user) {
+    if (!doc || !doc->root || !sink) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    char buf[4096];
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, sink, user, buf, sizeof(buf));
+    return serialize_tree(doc->root, &w);
+}
 
-    char *final_buf = (char*)realloc(buf, len + 1);
-    return final_buf ? final_buf : buf;
+typedef struct {
+    char *dst;
+    size_t len;
+} fixed_out_t;
+
+static int fixed_sink(void *user, const char *data, size_t len) {
+    fixed_out_t *f = (fixed_out_t*)user;
+    memcpy(f->dst + f->len, data, len);
+    f->len += len;
+    return 0;
+}
+
+static int serialize_fixed(const fossil_media_html_node_t *root, char *buf) {
+    fixed_out_t f = { buf, 0 };
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, fixed_sink, &f, NULL, 0);
+    int rc = serialize_tree(root, &w);
+    buf[f.len] = '\0';
+    return rc;
+}
+
+static size_t serialize_measure(const fossil_media_html_node_t *root) {
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, NULL, NULL, NULL, 0);
+    serialize_tree(root, &w);
+    return w.total;
+}
+
+int fossil_media_html_serialize_buffer(const fossil_media_html_doc_t *doc, char *buf, size_t cap, size_t *out_len) {
+    if (!doc || !doc->root || (!buf && cap)) return FOSSIL_MEDIA_HTML_ERR_INVALID_ARG;
+    size_t len = serialize_measure(doc->root);
+    if (out_len) *out_len = len;
+    if (!buf) return FOSSIL_MEDIA_HTML_OK;
+    if (len >= cap) return FOSSIL_MEDIA_HTML_ERR_NOMEM;
+    return serialize_fixed(doc->root, buf);
+}
+
+char* fossil_media_html_serialize(const fossil_media_html_doc_t *doc) {
+    if (!doc || !doc->root) return NULL;
+    char *buf = (char*)malloc(serialize_measure(doc->root) + 1);
+    if (!buf) return NULL;
+    if (serialize_fixed(doc->root, buf) != FOSSIL_MEDIA_HTML_OK) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
 }
@@ -22,31 +22,112 @@
  * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
  * -----------------------------------------------------------------------------
  */
+#define _GNU_SOURCE
 #include "fossil/media/ini.h"
 #include "fossil/media/media.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Documents loaded or built by this module keep every section, entry and
+ * string in the arena of their fossil_media_ini_doc_t. Lines are scanned in
+ * place and each key and value is copied exactly once, trimmed, into the
+ * arena; arrays grow geometrically there. Documents assembled by hand
+ * (doc == NULL with sections already set) keep the old malloc ownership.
+ *
+ * The doc also holds an open-addressing index with one slot per section
+ * name and one per (section, key). Slots refer to sections and entries by
+ * position, since the arrays move as they grow, and carry the cached result
+ * of the last typed getter used on the entry.
+ *
+ * Loaded documents also keep their source text. Entry slots remember where
+ * the value sits in it and whether set() changed it since, and each section
+ * remembers the end of its last line; saving copies the source around those
+ * spots, so comments, blank lines and spacing survive untouched. The source
+ * is borrowed at first: the caller's buffer, or the mapping of a loaded file,
+ * which the doc then holds. It is copied into the arena by the first set()
+ * or save, so documents that are only read never copy it.
+ */
+
+enum {
+    INI_CACHE_NONE = 0,
+    INI_CACHE_INT,
+    INI_CACHE_DOUBLE,
+    INI_CACHE_BOOL,
+    INI_CACHE_DURATION,
+    INI_CACHE_SIZE
+};
+
+typedef struct {
+    uint64_t hash;
+    size_t section;          /* section position + 1; 0 marks an empty slot */
+    size_t entry;            /* entry position, or SIZE_MAX for a section slot */
+    const char *cached_for;  /* value the cache was converted from */
+    size_t value_start;      /* value (with its quotes) in the source */
+    size_t value_end;
+    int from_source;
+    int dirty;               /* changed by set() since loading */
+    int cache_kind;
+    int cache_ok;
+    union {
+        int64_t integer;
+        double floating;
+        uint64_t unsigned_;
+    } cache;
+} ini_slot_t;
+
+struct fossil_media_ini_doc {
+    fossil_media_arena_t arena;
+    ini_slot_t *slots;
+    size_t mask;
+    size_t used;
+    const char *source;      /* text the document was loaded from, or NULL */
+    size_t source_len;
+    int source_owned;        /* source is in the arena rather than borrowed */
+    fossil_media_map_t map;  /* file the source is borrowed from, if any */
+    size_t *section_ends;    /* end of each section's last line; SIZE_MAX if added by set() */
+};
+
+/* Where a loaded entry came from */
+typedef struct {
+    size_t value_start;
+    size_t value_end;
+    size_t line_end;
+} ini_source_span_t;
+
+static uint64_t ini_hash(const char *s, size_t n, uint64_t seed) {
+    uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
 
-static char *strdup_trim(const char *src) {
-    if (!src) return NULL;
-    while (isspace((unsigned char)*src)) src++; // trim left
-    size_t len = strlen(src);
-    while (len > 0 && isspace((unsigned char)src[len-1])) len--; // trim right
-    char *out = (char *)malloc(len + 1);
-    if (!out) return NULL;
-    memcpy(out, src, len);
-    out[len] = '\0';
-    return out;
+static void trim_span(const char **s, const char **e) {
+    while (*s < *e && isspace((unsigned char)**s)) (*s)++;
+    while (*e > *s && isspace((unsigned char)(*e)[-1])) (*e)--;
 }
 
-static void remove_inline_comment(char *line) {
-    char *comment = strpbrk(line, ";#");
-    if (comment) *comment = '\0';
+static int span_equals(const char *str, const char *s, size_t n) {
+    return strncmp(str, s, n) == 0 && str[n] == '\0';
 }
 
-static fossil_media_ini_section_t *find_section(fossil_media_ini_t *ini, const char *name) {
+static fossil_media_ini_section_t *scan_section(const fossil_media_ini_t *ini, const char *name) {
     for (size_t i = 0; i < ini->section_count; i++) {
         if (strcmp(ini->sections[i].name, name) == 0) {
             return &ini->sections[i];
@@ -55,229 +136,559 @@ static fossil_media_ini_section_t *find_section(fossil_media_ini_t *ini, const c
     return NULL;
 }
 
-static fossil_media_ini_entry_t *find_entry(fossil_media_ini_section_t *section, const char *key) {
+static fossil_media_ini_entry_t *find_entry_span(fossil_media_ini_section_t *section, const char *key, size_t len) {
     for (size_t i = 0; i < section->entry_count; i++) {
-        if (strcmp(section->entries[i].key, key) == 0) {
+        if (span_equals(section->entries[i].key, key, len)) {
             return &section->entries[i];
         }
     }
     return NULL;
 }
 
-int fossil_media_ini_load_string(const char *data, fossil_media_ini_t *ini) {
-    memset(ini, 0, sizeof(*ini));
-    if (!data || *data == '\0')
-        return 0;
+static fossil_media_ini_entry_t *find_entry(fossil_media_ini_section_t *section, const char *key) {
+    return find_entry_span(section, key, strlen(key));
+}
 
-    fossil_media_ini_section_t *current_section = NULL;
-    const char *line_start = data;
-    char *multiline_key = NULL;
-    char *multiline_value = NULL;
-    int multiline_quote = 0;
-
-    while (*line_start) {
-        const char *line_end = strchr(line_start, '\n');
-        size_t line_len = line_end ? (size_t)(line_end - line_start) : strlen(line_start);
-
-        char *line = (char *)malloc(line_len + 1);
-        memcpy(line, line_start, line_len);
-        line[line_len] = '\0';
-
-        if (!multiline_quote)
-            remove_inline_comment(line);
-
-        char *trimmed = strdup_trim(line);
-        free(line);
-
-        // --- Handle multiline quoted value ---
-        if (multiline_quote) {
-            size_t tlen = strlen(trimmed);
-            char *end_quote = NULL;
-            for (size_t i = 0; i < tlen; ++i) {
-                if (trimmed[i] == multiline_quote) {
-                    end_quote = &trimmed[i];
-                    break;
-                }
-            }
+/* --- Index --- */
 
-            size_t oldlen = strlen(multiline_value);
-            size_t addlen = strlen(trimmed);
-            multiline_value = realloc(multiline_value, oldlen + addlen + 2);
-            multiline_value[oldlen] = '\n';
-            memcpy(multiline_value + oldlen + 1, trimmed, addlen + 1);
-
-            if (end_quote) {
-                *end_quote = '\0';
-                // End of multiline value: store key/value
-                current_section->entries = realloc(
-                    current_section->entries,
-                    sizeof(*current_section->entries) * (current_section->entry_count + 1)
-                );
-                fossil_media_ini_entry_t *entry =
-                    &current_section->entries[current_section->entry_count++];
-                entry->key = multiline_key;
-                entry->value = multiline_value;
-                multiline_key = NULL;
-                multiline_value = NULL;
-                multiline_quote = 0;
-            }
+/* Section slots hash the name alone; entry slots mix in the section position */
+static uint64_t section_hash(const char *name, size_t len) {
+    return ini_hash(name, len, 0);
+}
 
-            free(trimmed);
-            if (!line_end) break;
-            line_start = line_end + 1;
-            continue; // <-- clean jump to next line
-        }
+static uint64_t entry_hash(size_t section, const char *key, size_t len) {
+    return ini_hash(key, len, (uint64_t)section + 1);
+}
 
-        // --- Skip blanks and comments ---
-        if (!trimmed || *trimmed == '\0') {
-            free(trimmed);
-            if (!line_end) break;
-            line_start = line_end + 1;
-            continue;
-        }
+static ini_slot_t *index_probe_section(const fossil_media_ini_t *ini, const char *name, size_t len) {
+    const fossil_media_ini_doc_t *doc = ini->doc;
+    uint64_t h = section_hash(name, len);
+    for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+        ini_slot_t *slot = &doc->slots[i];
+        if (!slot->section) return slot;
+        if (slot->hash == h && slot->entry == SIZE_MAX &&
+            span_equals(ini->sections[slot->section - 1].name, name, len)) return slot;
+    }
+}
 
-        // --- Section header ---
-        if (*trimmed == '[') {
-            char *end = strchr(trimmed, ']');
-            if (end) {
-                *end = '\0';
-                char *section_name = strdup_trim(trimmed + 1);
-                if (section_name && *section_name) {
-                    ini->sections = realloc(
-                        ini->sections,
-                        sizeof(*ini->sections) * (ini->section_count + 1)
-                    );
-                    current_section = &ini->sections[ini->section_count++];
-                    current_section->name = section_name;
-                    current_section->entries = NULL;
-                    current_section->entry_count = 0;
-                } else {
-                    free(section_name);
-                    current_section = NULL;
-                }
-            }
-            free(trimmed);
-            if (!line_end) break;
-            line_start = line_end + 1;
-            continue;
-        }
+static ini_slot_t *index_probe_entry(const fossil_media_ini_t *ini, size_t section, const char *key, size_t len) {
+    const fossil_media_ini_doc_t *doc = ini->doc;
+    uint64_t h = entry_hash(section, key, len);
+    for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+        ini_slot_t *slot = &doc->slots[i];
+        if (!slot->section) return slot;
+        if (slot->hash == h && slot->section == section + 1 && slot->entry != SIZE_MAX &&
+            span_equals(ini->sections[section].entries[slot->entry].key, key, len)) return slot;
+    }
+}
 
-        // --- Key=value pair (or ignored key) ---
-        if (current_section) {
-            char *eq = strchr(trimmed, '=');
-            if (eq) {
-                *eq = '\0';
-                char *key = strdup_trim(trimmed);
-                char *value = strdup_trim(eq + 1);
-
-                // Handle quoted (possibly multiline) values
-                if (value && (*value == '"' || *value == '\'')) {
-                    char quote = *value;
-                    size_t vlen = strlen(value);
-                    if (vlen > 1 && value[vlen - 1] == quote) {
-                        value[vlen - 1] = '\0';
-                        memmove(value, value + 1, vlen - 1);
-                    } else {
-                        memmove(value, value + 1, vlen); // remove leading quote
-                        multiline_key = key;
-                        multiline_value = fossil_media_strdup(value);
-                        multiline_quote = quote;
-                        free(value);
-                        free(trimmed);
-                        if (!line_end) break;
-                        line_start = line_end + 1;
-                        continue;
-                    }
-                }
-
-                fossil_media_ini_entry_t *entry = find_entry(current_section, key);
-                if (entry) {
-                    free(entry->value);
-                    entry->value = value;
-                    free(key);
-                } else {
-                    current_section->entries = realloc(
-                        current_section->entries,
-                        sizeof(*current_section->entries) * (current_section->entry_count + 1)
-                    );
-                    entry = &current_section->entries[current_section->entry_count++];
-                    entry->key = key;
-                    entry->value = value;
-                }
-            }
-        }
+/* Make room for one more slot, keeping the load at or below one half */
+static int index_reserve(fossil_media_ini_doc_t *doc) {
+    size_t cap = doc->slots ? doc->mask + 1 : 0;
+    if ((doc->used + 1) * 2 <= cap) return 0;
+    size_t grown_cap = cap ? cap * 2 : 16;
+    ini_slot_t *grown = (ini_slot_t *)calloc(grown_cap, sizeof(*grown));
+    if (!grown) return -1;
+    for (size_t i = 0; i < cap; ++i) {
+        if (!doc->slots[i].section) continue;
+        size_t j = (size_t)doc->slots[i].hash & (grown_cap - 1);
+        while (grown[j].section) j = (j + 1) & (grown_cap - 1);
+        grown[j] = doc->slots[i];
+    }
+    free(doc->slots);
+    doc->slots = grown;
+    doc->mask = grown_cap - 1;
+    return 0;
+}
+
+static ini_slot_t *index_section(const fossil_media_ini_t *ini, const char *name, size_t len) {
+    ini_slot_t *slot = index_probe_section(ini, name, len);
+    return slot->section ? slot : NULL;
+}
+
+static fossil_media_ini_section_t *find_section(const fossil_media_ini_t *ini, const char *name) {
+    if (!ini->doc) return scan_section(ini, name);
+    if (!ini->doc->slots) return NULL;
+    ini_slot_t *slot = index_section(ini, name, strlen(name));
+    return slot ? &ini->sections[slot->section - 1] : NULL;
+}
+
+/* --- Arena-backed documents --- */
 
-        free(trimmed);
-        if (!line_end) break;
-        line_start = line_end + 1;
+/*
+ * Make room for one more element of an arena array. The capacity is the
+ * next power of two at or above the count (at least 4), so the array moves
+ * only when the count reaches a power of two.
+ */
+static void *arena_grow(fossil_media_arena_t *arena, void *items, size_t count, size_t size) {
+    if (count && (count < 4 || (count & (count - 1)))) return items;
+    size_t cap = count ? count * 2 : 4;
+    void *grown = fossil_media_arena_alloc(arena, cap * size);
+    if (grown && count) memcpy(grown, items, count * size);
+    return grown;
+}
+
+static fossil_media_ini_doc_t *doc_new(size_t hint) {
+    fossil_media_ini_doc_t *doc = (fossil_media_ini_doc_t *)calloc(1, sizeof(*doc));
+    if (doc) fossil_media_arena_init(&doc->arena, hint);
+    return doc;
+}
+
+static fossil_media_ini_section_t *doc_add_section(fossil_media_ini_t *ini, const char *name, size_t len) {
+    fossil_media_arena_t *arena = &ini->doc->arena;
+    fossil_media_ini_section_t *grown = (fossil_media_ini_section_t *)arena_grow(
+        arena, ini->sections, ini->section_count, sizeof(*grown));
+    if (!grown) return NULL;
+    ini->sections = grown;
+    size_t *ends = (size_t *)arena_grow(arena, ini->doc->section_ends, ini->section_count, sizeof(*ends));
+    if (!ends) return NULL;
+    ini->doc->section_ends = ends;
+    ends[ini->section_count] = SIZE_MAX;
+    fossil_media_ini_section_t *sec = &grown[ini->section_count];
+    memset(sec, 0, sizeof(*sec));
+    if (!(sec->name = fossil_media_arena_strndup(arena, name, len))) return NULL;
+    if (index_reserve(ini->doc)) return NULL;
+    ini->section_count++;
+
+    /* a repeated header starts a new section; lookups keep finding the first */
+    ini_slot_t *slot = index_probe_section(ini, name, len);
+    if (!slot->section) {
+        slot->hash = section_hash(name, len);
+        slot->section = ini->section_count;
+        slot->entry = SIZE_MAX;
+        ini->doc->used++;
     }
+    return sec;
+}
 
-    // Handle EOF during multiline quoted value
-    if (multiline_quote && current_section && multiline_key && multiline_value) {
-        current_section->entries = realloc(
-            current_section->entries,
-            sizeof(*current_section->entries) * (current_section->entry_count + 1)
-        );
-        fossil_media_ini_entry_t *entry =
-            &current_section->entries[current_section->entry_count++];
-        entry->key = multiline_key;
-        entry->value = multiline_value;
+/* Replace a value, reusing its storage when the new one fits */
+static int doc_replace_value(fossil_media_ini_t *ini, ini_slot_t *slot, fossil_media_ini_entry_t *entry,
+                             const char *value, size_t len) {
+    slot->cache_kind = INI_CACHE_NONE;
+    if (entry->value && strlen(entry->value) >= len) {
+        memmove(entry->value, value, len);
+        entry->value[len] = '\0';
+        return 0;
     }
+    char *copy = fossil_media_arena_strndup(&ini->doc->arena, value, len);
+    if (!copy) return -1;
+    entry->value = copy;
+    return 0;
+}
+
+static void note_source(fossil_media_ini_t *ini, size_t section, ini_slot_t *slot, const ini_source_span_t *src) {
+    slot->from_source = 1;
+    slot->dirty = 0;
+    slot->value_start = src->value_start;
+    slot->value_end = src->value_end;
+    size_t *end = &ini->doc->section_ends[section];
+    if (*end == SIZE_MAX || *end < src->line_end) *end = src->line_end;
+}
 
+/*
+ * Set key to value in a section; later duplicates replace earlier values.
+ * `src` locates the value in the source while loading, NULL for set().
+ */
+static int doc_put(fossil_media_ini_t *ini, fossil_media_ini_section_t *sec,
+                   const char *key, size_t klen, const char *value, size_t vlen,
+                   const ini_source_span_t *src) {
+    size_t section = (size_t)(sec - ini->sections);
+    if (index_reserve(ini->doc)) return -1;
+    ini_slot_t *slot = index_probe_entry(ini, section, key, klen);
+    if (slot->section) {
+        fossil_media_ini_entry_t *entry = &sec->entries[slot->entry];
+        if (src) note_source(ini, section, slot, src);
+        else if (!span_equals(entry->value, value, vlen)) slot->dirty = 1;
+        return doc_replace_value(ini, slot, entry, value, vlen);
+    }
+
+    fossil_media_arena_t *arena = &ini->doc->arena;
+    fossil_media_ini_entry_t *grown = (fossil_media_ini_entry_t *)arena_grow(
+        arena, sec->entries, sec->entry_count, sizeof(*grown));
+    if (!grown) return -1;
+    sec->entries = grown;
+    fossil_media_ini_entry_t *entry = &grown[sec->entry_count];
+    entry->key = fossil_media_arena_strndup(arena, key, klen);
+    entry->value = fossil_media_arena_strndup(arena, value, vlen);
+    if (!entry->key || !entry->value) return -1;
+    memset(slot, 0, sizeof(*slot));
+    slot->hash = entry_hash(section, key, klen);
+    slot->section = section + 1;
+    slot->entry = sec->entry_count++;
+    if (src) note_source(ini, section, slot, src);
+    ini->doc->used++;
     return 0;
 }
 
-int fossil_media_ini_load_file(const char *path, fossil_media_ini_t *ini) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return -1;
+/* Copy a borrowed source into the arena and let go of what it was borrowed from */
+static int doc_own_source(fossil_media_ini_doc_t *doc) {
+    if (!doc->source || doc->source_owned) return 0;
+    char *copy = fossil_media_arena_strndup(&doc->arena, doc->source, doc->source_len);
+    if (!copy) return -1;
+    doc->source = copy;
+    doc->source_owned = 1;
+    fossil_media_unmap(&doc->map);
+    return 0;
+}
 
-    if (fseek(f, 0, SEEK_END) != 0) {
-        fclose(f);
-        return -1;
+/* --- Loading --- */
+
+typedef struct {
+    fossil_media_ini_t *ini;
+    const char *source;               /* start of the text, for offsets */
+    fossil_media_ini_section_t *section;
+    fossil_media_buffer_t multiline;  /* value of an open quoted value */
+    const char *multiline_key;        /* key span in the source, or NULL */
+    size_t multiline_key_len;
+    ini_source_span_t multiline_span;
+    char multiline_quote;
+} ini_loader_t;
+
+static int load_multiline_line(ini_loader_t *ld, const char *s, const char *e) {
+    const char *line_end = e;
+    trim_span(&s, &e);
+    const char *quote = (const char *)memchr(s, ld->multiline_quote, (size_t)(e - s));
+    if (fossil_media_sink_buffer(&ld->multiline, "\n", 1) ||
+        fossil_media_sink_buffer(&ld->multiline, s, (size_t)((quote ? quote : e) - s))) return -1;
+    ld->multiline_span.value_end = (size_t)((quote ? quote + 1 : e) - ld->source);
+    ld->multiline_span.line_end = (size_t)(line_end - ld->source);
+    if (!quote) return 0;
+    ld->multiline_quote = 0;
+    return doc_put(ld->ini, ld->section, ld->multiline_key, ld->multiline_key_len,
+                   ld->multiline.data, ld->multiline.len, &ld->multiline_span);
+}
+
+static int load_line(ini_loader_t *ld, const char *s, const char *e) {
+    if (ld->multiline_quote) return load_multiline_line(ld, s, e);
+
+    const char *line_end = e;
+    const char *comment = fossil_media_find_any(s, (size_t)(e - s), ";#");
+    if (comment) e = comment;
+    trim_span(&s, &e);
+    if (s == e) return 0;
+
+    if (*s == '[') {
+        const char *close = (const char *)memchr(s, ']', (size_t)(e - s));
+        if (!close) return 0;
+        const char *ns = s + 1, *ne = close;
+        trim_span(&ns, &ne);
+        ld->section = ns < ne ? doc_add_section(ld->ini, ns, (size_t)(ne - ns)) : NULL;
+        if (ns < ne && !ld->section) return -1;
+        if (ld->section) ld->ini->doc->section_ends[ld->ini->section_count - 1] = (size_t)(line_end - ld->source);
+        return 0;
     }
 
-    long fsize = ftell(f);
-    if (fsize < 0) {
-        fclose(f);
-        return -1;
+    if (!ld->section) return 0;
+    const char *eq = (const char *)memchr(s, '=', (size_t)(e - s));
+    if (!eq) return 0;
+    const char *ks = s, *ke = eq, *vs = eq + 1, *ve = e;
+    trim_span(&ks, &ke);
+    trim_span(&vs, &ve);
+    ini_source_span_t span = { (size_t)(vs - ld->source), (size_t)(ve - ld->source), (size_t)(line_end - ld->source) };
+
+    if (vs < ve && (*vs == '"' || *vs == '\'')) {
+        if (ve - vs > 1 && ve[-1] == *vs) {
+            vs++;
+            ve--;
+        } else {
+            /* quoted value continues on the following lines */
+            ld->multiline_quote = *vs;
+            ld->multiline_key = ks;
+            ld->multiline_key_len = (size_t)(ke - ks);
+            ld->multiline.len = 0;
+            ld->multiline_span = span;
+            return fossil_media_sink_buffer(&ld->multiline, vs + 1, (size_t)(ve - vs - 1));
+        }
     }
-    rewind(f);
+    return doc_put(ld->ini, ld->section, ks, (size_t)(ke - ks), vs, (size_t)(ve - vs), &span);
+}
 
-    size_t size = (size_t)fsize;
-    char *buf = malloc(size + 1);
-    if (!buf) {
-        fclose(f);
+/* Load from `data`, which the doc borrows; it takes over `map` (if given) even on failure */
+static int load_borrowed(const char *data, size_t len, fossil_media_map_t *map, fossil_media_ini_t *ini) {
+    if (!ini) {
+        if (map) fossil_media_unmap(map);
         return -1;
     }
+    memset(ini, 0, sizeof(*ini));
+    if (!data || len == 0) {
+        if (map) fossil_media_unmap(map);
+        return 0;
+    }
 
-    size_t nread = fread(buf, 1, size, f);
-    fclose(f);
-
-    if (nread != size) {
-        free(buf);
+    /* names, keys and values take at most as much as the source */
+    if (!(ini->doc = doc_new(len < 128 * 1024 ? len + 512 : 128 * 1024))) {
+        if (map) fossil_media_unmap(map);
         return -1;
     }
+    if (map) ini->doc->map = *map;
+    ini->doc->source = data;
+    ini->doc->source_len = len;
+
+    ini_loader_t ld;
+    memset(&ld, 0, sizeof(ld));
+    ld.ini = ini;
+    ld.source = data;
+    const char *p = data, *end = data + len;
+    int rc = 0;
+    while (rc == 0 && p < end) {
+        const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = nl ? nl : end;
+        rc = load_line(&ld, p, line_end);
+        p = nl ? nl + 1 : end;
+    }
+    // Keep a quoted value left open at the end of the input
+    if (rc == 0 && ld.multiline_quote) {
+        rc = doc_put(ini, ld.section, ld.multiline_key, ld.multiline_key_len,
+                     ld.multiline.data ? ld.multiline.data : "", ld.multiline.len, &ld.multiline_span);
+    }
+    fossil_media_buffer_free(&ld.multiline);
+    if (rc != 0) {
+        fossil_media_ini_free(ini);
+        return -1;
+    }
+    return 0;
+}
 
-    buf[size] = '\0';
+int fossil_media_ini_load_buffer(const char *data, size_t len, fossil_media_ini_t *ini) {
+    return load_borrowed(data, len, NULL, ini);
+}
 
-    int res = fossil_media_ini_load_string(buf, ini);
-    free(buf);
-    return res;
+int fossil_media_ini_load_string(const char *data, fossil_media_ini_t *ini) {
+    return load_borrowed(data, data ? strlen(data) : 0, NULL, ini);
 }
 
-const char *fossil_media_ini_get(const fossil_media_ini_t *ini, const char *section, const char *key) {
-    if (!ini || !section || !key) return NULL;
-    fossil_media_ini_section_t *sec = find_section((fossil_media_ini_t *)ini, section);
+int fossil_media_ini_load_file(const char *path, fossil_media_ini_t *ini) {
+    fossil_media_map_t map;
+    if (fossil_media_map_file(path, &map) != 0) return -1;
+    return load_borrowed(map.data, map.size, &map, ini);
+}
+
+/* Index slot of an entry, or NULL when missing or the document has no index */
+static ini_slot_t *lookup_slot(const fossil_media_ini_t *ini, const char *section, const char *key) {
+    if (!ini->doc || !ini->doc->slots) return NULL;
+    ini_slot_t *sec = index_section(ini, section, strlen(section));
     if (!sec) return NULL;
-    fossil_media_ini_entry_t *entry = find_entry(sec, key);
+    ini_slot_t *slot = index_probe_entry(ini, sec->section - 1, key, strlen(key));
+    return slot->section ? slot : NULL;
+}
+
+static fossil_media_ini_entry_t *lookup(const fossil_media_ini_t *ini, const char *section, const char *key,
+                                        ini_slot_t **out_slot) {
+    *out_slot = NULL;
+    if (!ini || !section || !key) return NULL;
+    if (!ini->doc) {
+        fossil_media_ini_section_t *sec = scan_section(ini, section);
+        return sec ? find_entry(sec, key) : NULL;
+    }
+    ini_slot_t *slot = lookup_slot(ini, section, key);
+    *out_slot = slot;
+    return slot ? &ini->sections[slot->section - 1].entries[slot->entry] : NULL;
+}
+
+const char *fossil_media_ini_get(const fossil_media_ini_t *ini, const char *section, const char *key) {
+    ini_slot_t *slot;
+    fossil_media_ini_entry_t *entry = lookup(ini, section, key, &slot);
     return entry ? entry->value : NULL;
 }
 
-int fossil_media_ini_set(fossil_media_ini_t *ini, const char *section, const char *key, const char *value) {
-    if (!ini || !section || !key || !value) return -1;
+/* --- Typed getters --- */
+
+static int parse_int(const char *s, int64_t *out) {
+    if (!*s || isspace((unsigned char)*s)) return -1;
+    /* base 0 would read a leading zero as octal; only `0x` switches base */
+    const char *digits = s + (*s == '+' || *s == '-');
+    int base = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X') ? 16 : 10;
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, base);
+    if (errno == ERANGE || *end) return -1;
+    *out = (int64_t)v;
+    return 0;
+}
+
+static int parse_double(const char *s, double *out) {
+    if (!*s || isspace((unsigned char)*s)) return -1;
+    char *end;
+    double v = strtod(s, &end);
+    if (*end) return -1;
+    *out = v;
+    return 0;
+}
+
+static int word_is(const char *s, const char *word) {
+    size_t n = strlen(word);
+    return strlen(s) == n && fossil_media_strncasecmp(s, word, n) == 0;
+}
+
+static int parse_bool(const char *s, int64_t *out) {
+    if (word_is(s, "true") || word_is(s, "yes") || word_is(s, "on") || strcmp(s, "1") == 0) *out = 1;
+    else if (word_is(s, "false") || word_is(s, "no") || word_is(s, "off") || strcmp(s, "0") == 0) *out = 0;
+    else return -1;
+    return 0;
+}
+
+/* Non-negative decimal number with an optional fraction */
+static int parse_amount(const char **p, double *out) {
+    const char *s = *p;
+    if (!((*s >= '0' && *s <= '9') || *s == '.')) return -1;
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0) return -1;
+    *out = v;
+    *p = end;
+    return 0;
+}
+
+typedef struct {
+    const char *suffix;
+    double scale;
+} ini_unit_t;
+
+/* Longest unit at *p, compared case-insensitively and ending the word */
+static const ini_unit_t *match_unit(const char **p, const ini_unit_t *units) {
+    const ini_unit_t *best = NULL;
+    size_t best_len = 0;
+    for (const ini_unit_t *u = units; u->suffix; ++u) {
+        size_t n = strlen(u->suffix);
+        if (n > best_len && fossil_media_strncasecmp(*p, u->suffix, n) == 0 && !isalpha((unsigned char)(*p)[n])) {
+            best = u;
+            best_len = n;
+        }
+    }
+    if (best) *p += best_len;
+    return best;
+}
+
+/* Durations such as "250ms", "1.5 s", "1h30m"; a bare number is seconds */
+static int parse_duration(const char *s, uint64_t *out_ms) {
+    static const ini_unit_t units[] = {
+        { "ms", 1.0 }, { "s", 1e3 }, { "sec", 1e3 }, { "m", 60e3 }, { "min", 60e3 },
+        { "h", 3600e3 }, { "d", 86400e3 }, { "w", 604800e3 }, { NULL, 0 }
+    };
+    double total = 0;
+    double amount;
+    if (parse_amount(&s, &amount)) return -1;
+    while (*s == ' ') s++;
+    if (!*s) {
+        total = amount * 1e3;
+    } else {
+        for (;;) {
+            const ini_unit_t *u = match_unit(&s, units);
+            if (!u) return -1;
+            total += amount * u->scale;
+            while (*s == ' ') s++;
+            if (!*s) break;
+            if (parse_amount(&s, &amount)) return -1;
+            while (*s == ' ') s++;
+        }
+    }
+    if (total >= 18446744073709551615.0) return -1;
+    *out_ms = (uint64_t)(total + 0.5);
+    return 0;
+}
+
+/* Sizes such as "512", "64KiB", "1.5 GB": K/M/G/T are decimal, Ki/Mi/Gi/Ti binary */
+static int parse_size(const char *s, uint64_t *out_bytes) {
+    static const ini_unit_t units[] = {
+        { "b", 1.0 },
+        { "k", 1e3 }, { "kb", 1e3 }, { "ki", 1024.0 }, { "kib", 1024.0 },
+        { "m", 1e6 }, { "mb", 1e6 }, { "mi", 1048576.0 }, { "mib", 1048576.0 },
+        { "g", 1e9 }, { "gb", 1e9 }, { "gi", 1073741824.0 }, { "gib", 1073741824.0 },
+        { "t", 1e12 }, { "tb", 1e12 }, { "ti", 1099511627776.0 }, { "tib", 1099511627776.0 },
+        { NULL, 0 }
+    };
+    double amount;
+    if (parse_amount(&s, &amount)) return -1;
+    while (*s == ' ') s++;
+    double scale = 1.0;
+    if (*s) {
+        const ini_unit_t *u = match_unit(&s, units);
+        if (!u || *s) return -1;
+        scale = u->scale;
+    }
+    double total = amount * scale;
+    if (total >= 18446744073709551615.0) return -1;
+    *out_bytes = (uint64_t)(total + 0.5);
+    return 0;
+}
+
+/*
+ * Convert an entry once and remember the result (or the failure) in its
+ * index slot; the cache is dropped when set() replaces the value.
+ */
+static int typed_get(const fossil_media_ini_t *ini, const char *section, const char *key, int kind,
+                     int64_t *out_i, double *out_d, uint64_t *out_u) {
+    ini_slot_t *slot;
+    fossil_media_ini_entry_t *entry = lookup(ini, section, key, &slot);
+    if (!entry || !entry->value) return -1;
+    if (slot && slot->cache_kind == kind && slot->cached_for == entry->value) {
+        if (!slot->cache_ok) return -1;
+        if (out_i) *out_i = slot->cache.integer;
+        if (out_d) *out_d = slot->cache.floating;
+        if (out_u) *out_u = slot->cache.unsigned_;
+        return 0;
+    }
+
+    int64_t i = 0;
+    double d = 0;
+    uint64_t u = 0;
+    int rc;
+    switch (kind) {
+        case INI_CACHE_INT:      rc = parse_int(entry->value, &i); break;
+        case INI_CACHE_DOUBLE:   rc = parse_double(entry->value, &d); break;
+        case INI_CACHE_BOOL:     rc = parse_bool(entry->value, &i); break;
+        case INI_CACHE_DURATION: rc = parse_duration(entry->value, &u); break;
+        default:                 rc = parse_size(entry->value, &u); break;
+    }
+    if (slot) {
+        slot->cache_kind = kind;
+        slot->cache_ok = rc == 0;
+        slot->cached_for = entry->value;
+        if (kind == INI_CACHE_DOUBLE) slot->cache.floating = d;
+        else if (kind == INI_CACHE_DURATION || kind == INI_CACHE_SIZE) slot->cache.unsigned_ = u;
+        else slot->cache.integer = i;
+    }
+    if (rc != 0) return -1;
+    if (out_i) *out_i = i;
+    if (out_d) *out_d = d;
+    if (out_u) *out_u = u;
+    return 0;
+}
+
+int fossil_media_ini_get_int(const fossil_media_ini_t *ini, const char *section, const char *key, int64_t *out) {
+    if (!out) return -1;
+    return typed_get(ini, section, key, INI_CACHE_INT, out, NULL, NULL);
+}
+
+int fossil_media_ini_get_double(const fossil_media_ini_t *ini, const char *section, const char *key, double *out) {
+    if (!out) return -1;
+    return typed_get(ini, section, key, INI_CACHE_DOUBLE, NULL, out, NULL);
+}
+
+int fossil_media_ini_get_bool(const fossil_media_ini_t *ini, const char *section, const char *key, int *out) {
+    int64_t v;
+    if (!out || typed_get(ini, section, key, INI_CACHE_BOOL, &v, NULL, NULL) != 0) return -1;
+    *out = (int)v;
+    return 0;
+}
+
+int fossil_media_ini_get_duration(const fossil_media_ini_t *ini, const char *section, const char *key, uint64_t *out_ms) {
+    if (!out_ms) return -1;
+    return typed_get(ini, section, key, INI_CACHE_DURATION, NULL, NULL, out_ms);
+}
+
+int fossil_media_ini_get_size(const fossil_media_ini_t *ini, const char *section, const char *key, uint64_t *out_bytes) {
+    if (!out_bytes) return -1;
+    return typed_get(ini, section, key, INI_CACHE_SIZE, NULL, NULL, out_bytes);
+}
+
+/* set() on a hand-built document: every piece is malloc'd */
+static int set_owned(fossil_media_ini_t *ini, const char *section, const char *key, const char *value) {
     fossil_media_ini_section_t *sec = find_section(ini, section);
     if (!sec) {
-        ini->sections = realloc(ini->sections, sizeof(*ini->sections) * (ini->section_count + 1));
+        fossil_media_ini_section_t *grown = realloc(ini->sections, sizeof(*ini->sections) * (ini->section_count + 1));
+        if (!grown) return -1;
+        ini->sections = grown;
         sec = &ini->sections[ini->section_count++];
         sec->name = fossil_media_strdup(section);
         sec->entries = NULL;
@@ -285,7 +696,9 @@ int fossil_media_ini_set(fossil_media_ini_t *ini, const char *section, const cha
     }
     fossil_media_ini_entry_t *entry = find_entry(sec, key);
     if (!entry) {
-        sec->entries = realloc(sec->entries, sizeof(*sec->entries) * (sec->entry_count + 1));
+        fossil_media_ini_entry_t *grown = realloc(sec->entries, sizeof(*sec->entries) * (sec->entry_count + 1));
+        if (!grown) return -1;
+        sec->entries = grown;
         entry = &sec->entries[sec->entry_count++];
         entry->key = fossil_media_strdup(key);
         entry->value = fossil_media_strdup(value);
@@ -296,22 +709,248 @@ int fossil_media_ini_set(fossil_media_ini_t *ini, const char *section, const cha
     return 0;
 }
 
-int fossil_media_ini_save_file(const char *path, const fossil_media_ini_t *ini) {
-    FILE *f = fopen(path, "wb");
-    if (!f) return -1;
+int fossil_media_ini_set(fossil_media_ini_t *ini, const char *section, const char *key, const char *value) {
+    if (!ini || !section || !key || !value) return -1;
+    if (!ini->doc) {
+        if (ini->sections) return set_owned(ini, section, key, value);
+        if (!(ini->doc = doc_new(0))) return -1;
+    }
+    if (doc_own_source(ini->doc)) return -1;
+    fossil_media_ini_section_t *sec = find_section(ini, section);
+    if (!sec && !(sec = doc_add_section(ini, section, strlen(section)))) return -1;
+    return doc_put(ini, sec, key, strlen(key), value, strlen(value), NULL);
+}
+
+/* --- Saving ---
+ *
+ * Output is described as a list of pieces: runs of the loaded source and
+ * patches rendered into one scratch buffer. Pieces are written with writev
+ * to a temporary file next to the target, which then replaces it by rename,
+ * so readers see either the old file or the new one.
+ */
+
+typedef struct {
+    size_t start;     /* source range replaced (start == end inserts) */
+    size_t end;
+    size_t patch;     /* text in the scratch buffer */
+    size_t patch_len;
+    size_t seq;       /* keeps generation order at equal offsets */
+} ini_edit_t;
+
+typedef struct {
+    const char *data;
+    size_t len;
+} ini_piece_t;
+
+/* Quote values that would not read back as written */
+static int put_value(fossil_media_buffer_t *out, const char *value) {
+    size_t n = strlen(value);
+    int quote = n && (isspace((unsigned char)value[0]) || isspace((unsigned char)value[n - 1]) ||
+                      value[0] == '"' || value[0] == '\'' || memchr(value, '\n', n));
+    if (!quote) return fossil_media_sink_buffer(out, value, n);
+    const char *q = strchr(value, '"') ? "'" : "\"";
+    return fossil_media_sink_buffer(out, q, 1) || fossil_media_sink_buffer(out, value, n) ||
+           fossil_media_sink_buffer(out, q, 1);
+}
+
+static int put_entry(fossil_media_buffer_t *out, const fossil_media_ini_entry_t *e) {
+    return fossil_media_sink_buffer(out, e->key, strlen(e->key)) || fossil_media_sink_buffer(out, "=", 1) ||
+           put_value(out, e->value);
+}
+
+static int cmp_edit(const void *a, const void *b) {
+    const ini_edit_t *x = (const ini_edit_t *)a, *y = (const ini_edit_t *)b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return x->seq < y->seq ? -1 : (x->seq > y->seq);
+}
+
+/* Whole document in the plain layout, for documents without a source */
+static int render_plain(const fossil_media_ini_t *ini, fossil_media_buffer_t *out) {
     for (size_t i = 0; i < ini->section_count; i++) {
-        fprintf(f, "[%s]\n", ini->sections[i].name);
-        for (size_t j = 0; j < ini->sections[i].entry_count; j++) {
-            fprintf(f, "%s=%s\n", ini->sections[i].entries[j].key, ini->sections[i].entries[j].value);
+        const fossil_media_ini_section_t *sec = &ini->sections[i];
+        if (fossil_media_sink_buffer(out, "[", 1) || fossil_media_sink_buffer(out, sec->name, strlen(sec->name)) ||
+            fossil_media_sink_buffer(out, "]\n", 2)) return -1;
+        for (size_t j = 0; j < sec->entry_count; j++) {
+            if (put_entry(out, &sec->entries[j]) || fossil_media_sink_buffer(out, "\n", 1)) return -1;
         }
-        fprintf(f, "\n");
+        if (fossil_media_sink_buffer(out, "\n", 1)) return -1;
     }
-    fclose(f);
     return 0;
 }
 
+/* Edits turning the loaded source into the current document; added lines end like the source's first line */
+static int collect_edits(const fossil_media_ini_t *ini, fossil_media_buffer_t *patches,
+                         ini_edit_t *edits, size_t *count) {
+    const fossil_media_ini_doc_t *doc = ini->doc;
+    const char *nl = (const char *)memchr(doc->source, '\n', doc->source_len);
+    int crlf = nl && nl > doc->source && nl[-1] == '\r';
+    const char *eol = crlf ? "\r\n" : "\n";
+    size_t eol_len = crlf ? 2 : 1;
+    size_t n = 0;
+    int tail = 0; /* sections added by set() go at the end */
+    for (size_t i = 0; i < ini->section_count; i++) {
+        const fossil_media_ini_section_t *sec = &ini->sections[i];
+        size_t insert_at = doc->section_ends[i];
+        if (insert_at == SIZE_MAX) {
+            if (!sec->entry_count) continue;
+            size_t at = patches->len;
+            /* the first one may need to end the source's last line */
+            if (!tail && doc->source[doc->source_len - 1] != '\n' && fossil_media_sink_buffer(patches, eol, eol_len)) return -1;
+            if (fossil_media_sink_buffer(patches, eol, eol_len) || fossil_media_sink_buffer(patches, "[", 1) ||
+                fossil_media_sink_buffer(patches, sec->name, strlen(sec->name)) ||
+                fossil_media_sink_buffer(patches, "]", 1) || fossil_media_sink_buffer(patches, eol, eol_len)) return -1;
+            for (size_t j = 0; j < sec->entry_count; j++) {
+                if (put_entry(patches, &sec->entries[j]) || fossil_media_sink_buffer(patches, eol, eol_len)) return -1;
+            }
+            edits[n++] = (ini_edit_t){ doc->source_len, doc->source_len, at, patches->len - at, n };
+            tail = 1;
+            continue;
+        }
+        /* new lines go in before the '\r' that ends the section's last line */
+        if (crlf && insert_at > 0 && doc->source[insert_at - 1] == '\r') insert_at--;
+        for (size_t j = 0; j < sec->entry_count; j++) {
+            const fossil_media_ini_entry_t *e = &sec->entries[j];
+            const ini_slot_t *slot = index_probe_entry(ini, i, e->key, strlen(e->key));
+            size_t at = patches->len;
+            if (slot->from_source) {
+                if (!slot->dirty) continue;
+                if (put_value(patches, e->value)) return -1;
+                edits[n++] = (ini_edit_t){ slot->value_start, slot->value_end, at, patches->len - at, n };
+            } else {
+                /* new key: a line of its own after the section's last line */
+                if (fossil_media_sink_buffer(patches, eol, eol_len) || put_entry(patches, e)) return -1;
+                edits[n++] = (ini_edit_t){ insert_at, insert_at, at, patches->len - at, n };
+            }
+        }
+    }
+    *count = n;
+    return 0;
+}
+
+static int write_pieces(const char *path, const ini_piece_t *pieces, size_t count);
+
+int fossil_media_ini_save_file(const char *path, const fossil_media_ini_t *ini) {
+    if (!path || !ini) return -1;
+    fossil_media_buffer_t patches = { NULL, 0, 0 };
+    ini_edit_t *edits = NULL;
+    ini_piece_t *pieces = NULL;
+    size_t piece_count = 0;
+    int rc = 0;
+
+    if (!ini->doc || !ini->doc->source) {
+        rc = render_plain(ini, &patches);
+        if (rc == 0 && patches.len) {
+            pieces = (ini_piece_t *)malloc(sizeof(*pieces));
+            if (pieces) pieces[piece_count++] = (ini_piece_t){ patches.data, patches.len };
+            else rc = -1;
+        }
+    } else if (doc_own_source(ini->doc) != 0) {
+        rc = -1; /* the target may be the mapped file itself */
+    } else {
+        size_t entries = 0;
+        for (size_t i = 0; i < ini->section_count; i++) entries += ini->sections[i].entry_count;
+        size_t edit_count = 0;
+        edits = (ini_edit_t *)malloc((entries + ini->section_count + 1) * sizeof(*edits)); /* at most one per entry or section */
+        rc = edits ? collect_edits(ini, &patches, edits, &edit_count) : -1;
+        if (rc == 0) {
+            qsort(edits, edit_count, sizeof(*edits), cmp_edit);
+            pieces = (ini_piece_t *)malloc((edit_count * 2 + 1) * sizeof(*pieces));
+            rc = pieces ? 0 : -1;
+        }
+        if (rc == 0) {
+            const char *src = ini->doc->source;
+            size_t cursor = 0;
+            for (size_t i = 0; i < edit_count; i++) {
+                if (edits[i].start > cursor) pieces[piece_count++] = (ini_piece_t){ src + cursor, edits[i].start - cursor };
+                pieces[piece_count++] = (ini_piece_t){ patches.data + edits[i].patch, edits[i].patch_len };
+                if (edits[i].end > cursor) cursor = edits[i].end;
+            }
+            if (ini->doc->source_len > cursor) {
+                pieces[piece_count++] = (ini_piece_t){ src + cursor, ini->doc->source_len - cursor };
+            }
+        }
+    }
+
+    if (rc == 0) rc = write_pieces(path, pieces, piece_count);
+    free(pieces);
+    free(edits);
+    fossil_media_buffer_free(&patches);
+    return rc;
+}
+
+/* Write all pieces to a temporary file beside `path`, then rename it over `path` */
+static int write_pieces(const char *path, const ini_piece_t *pieces, size_t count) {
+    size_t plen = strlen(path);
+    char *tmp = (char *)malloc(plen + 8);
+    if (!tmp) return -1;
+    memcpy(tmp, path, plen);
+#if defined(_WIN32)
+    memcpy(tmp + plen, ".tmp", 5);
+    FILE *f = fopen(tmp, "wb");
+    int rc = f ? 0 : -1;
+    for (size_t i = 0; rc == 0 && i < count; i++) {
+        if (fwrite(pieces[i].data, 1, pieces[i].len, f) != pieces[i].len) rc = -1;
+    }
+    if (f && fclose(f) != 0) rc = -1;
+    if (rc == 0 && !MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) rc = -1;
+    if (rc != 0) remove(tmp);
+#else
+    memcpy(tmp + plen, ".XXXXXX", 8);
+    int fd = mkstemp(tmp);
+    if (fd < 0) {
+        free(tmp);
+        return -1;
+    }
+    struct stat st;
+    if (stat(path, &st) == 0) fchmod(fd, st.st_mode & 07777); /* keep the target's permissions */
+    else fchmod(fd, 0644);
+
+    int rc = 0;
+    struct iovec iov[64];
+    size_t next = 0, skip = 0; /* piece to write next, bytes of it already written */
+    while (rc == 0 && next < count) {
+        int n = 0;
+        for (size_t i = next; i < count && n < 64; i++, n++) {
+            iov[n].iov_base = (void *)(pieces[i].data + (i == next ? skip : 0));
+            iov[n].iov_len = pieces[i].len - (i == next ? skip : 0);
+        }
+        ssize_t written = writev(fd, iov, n);
+        if (written < 0) {
+            if (errno != EINTR) rc = -1;
+            continue;
+        }
+        if (written == 0 && iov[0].iov_len) {
+            rc = -1;
+            break;
+        }
+        size_t left = (size_t)written;
+        while (next < count && left >= pieces[next].len - skip) {
+            left -= pieces[next].len - skip;
+            skip = 0;
+            next++;
+        }
+        skip += left;
+    }
+    if (rc == 0 && fsync(fd) != 0) rc = -1;
+    if (close(fd) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if (rc != 0) unlink(tmp);
+#endif
+    free(tmp);
+    return rc;
+}
+
 void fossil_media_ini_free(fossil_media_ini_t *ini) {
-    if (!ini || !ini->sections) return;
+    if (!ini) return;
+    if (ini->doc) {
+        fossil_media_unmap(&ini->doc->map);
+        free(ini->doc->slots);
+        fossil_media_arena_destroy(&ini->doc->arena);
+        free(ini->doc);
+        memset(ini, 0, sizeof(*ini));
+        return;
+    }
+    if (!ini->sections) return;
     for (size_t i = 0; i < ini->section_count; i++) {
         if (ini->sections[i].name) free(ini->sections[i].name);
         if (ini->sections[i].entries) {
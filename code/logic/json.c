@@ -24,6 +24,7 @@
  */
 #include "fossil/media/json.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
@@ -250,6 +251,23 @@ static fossil_media_json_value_t *parse_number(ctx_t *c, fossil_media_json_error
     return fossil_media_json_new_number(val);
 }
 
+/* Read the four hex digits of a \u escape starting at s[*i] */
+static int parse_hex4(const char *s, size_t *i, uint32_t *code, fossil_media_json_error_t *err) {
+    uint32_t v = 0;
+    for (int k = 0; k < 4; ++k) {
+        char ch = s[(*i)++];
+        if (!ch) { set_error(err, 1, *i, "Truncated \\u escape"); return -1; }
+        int digit = -1;
+        if (ch >= '0' && ch <= '9') digit = ch - '0';
+        else if (ch >= 'A' && ch <= 'F') digit = 10 + (ch - 'A');
+        else if (ch >= 'a' && ch <= 'f') digit = 10 + (ch - 'a');
+        if (digit < 0) { set_error(err, 1, *i, "Invalid \\u hex digit"); return -1; }
+        v = (v << 4) | (uint32_t)digit;
+    }
+    *code = v;
+    return 0;
+}
+
 /* parse string with escapes */
 static fossil_media_json_value_t *parse_string(ctx_t *c, fossil_media_json_error_t *err) {
     const char *s = c->s;
@@ -282,34 +300,23 @@ static fossil_media_json_value_t *parse_string(ctx_t *c, fossil_media_json_error
             else if (esc == 't') out = '\t';
             else if (esc == 'u') {
                 /* Unicode escape: \uXXXX -> encode as UTF-8 */
-                unsigned int code = 0;
-                for (int k = 0; k < 4; ++k) {
-                    char ch2 = s[i++];
-                    if (!ch2) { set_error(err, 1, i, "Truncated \\u escape"); fm_free(buf); return NULL; }
-                    int digit = -1;
-                    if (ch2 >= '0' && ch2 <= '9') digit = ch2 - '0';
-                    else if (ch2 >= 'A' && ch2 <= 'F') digit = 10 + (ch2 - 'A');
-                    else if (ch2 >= 'a' && ch2 <= 'f') digit = 10 + (ch2 - 'a');
-                    if (digit < 0) { set_error(err, 1, i, "Invalid \\u hex digit"); fm_free(buf); return NULL; }
-                    code = (code << 4) | digit;
+                uint32_t code;
+                if (parse_hex4(s, &i, &code, err) != 0) { fm_free(buf); return NULL; }
+                /* a high surrogate escape followed by a low one is a single code point */
+                if (code >= 0xD800 && code <= 0xDBFF && s[i] == '\\' && s[i + 1] == 'u') {
+                    size_t j = i + 2;
+                    uint32_t low;
+                    if (parse_hex4(s, &j, &low, err) != 0) { fm_free(buf); return NULL; }
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i = j;
+                    }
                 }
-                /* encode code in UTF-8 */
+                /* lone surrogates have no UTF-8 form and become U+FFFD */
                 char tmp[4];
-                int tlen = 0;
-                if (code <= 0x7F) {
-                    tmp[0] = (char)code; tlen = 1;
-                } else if (code <= 0x7FF) {
-                    tmp[0] = (char)(0xC0 | ((code >> 6) & 0x1F));
-                    tmp[1] = (char)(0x80 | (code & 0x3F));
-                    tlen = 2;
-                } else {
-                    tmp[0] = (char)(0xE0 | ((code >> 12) & 0x0F));
-                    tmp[1] = (char)(0x80 | ((code >> 6) & 0x3F));
-                    tmp[2] = (char)(0x80 | (code & 0x3F));
-                    tlen = 3;
-                }
+                size_t tlen = fossil_media_utf8_encode(code, tmp);
                 if (len + tlen + 1 > cap) { cap = (len + tlen + 1) * 2; buf = fm_realloc(buf, cap); if (!buf) return NULL; }
-                for (int a = 0; a < tlen; ++a) buf[len++] = tmp[a];
+                for (size_t a = 0; a < tlen; ++a) buf[len++] = tmp[a];
                 continue;
             } else {
                 set_error(err, 1, i, "Invalid escape \\%c", esc); fm_free(buf); return NULL;
@@ -427,6 +434,13 @@ static fossil_media_json_value_t *parse_value(ctx_t *c, fossil_media_json_error_
 fossil_media_json_value_t *fossil_media_json_parse(const char *json_text, fossil_media_json_error_t *err_out) {
     fossil_media_json_error_t errtmp = {0,0,""};
     if (!json_text) { set_error(&errtmp,1,0,"NULL input"); if (err_out) *err_out = errtmp; return NULL; }
+    /* RFC 8259 requires UTF-8; checking it up front keeps the parser bytewise */
+    size_t bad;
+    if (fossil_media_utf8_validate(json_text, strlen(json_text), &bad) != 0) {
+        set_error(&errtmp,1,bad,"Invalid UTF-8");
+        if (err_out) *err_out = errtmp;
+        return NULL;
+    }
     ctx_t c = { json_text, 0 };
     skip_ws(&c);
     fossil_media_json_value_t *root = parse_value(&c, &errtmp);
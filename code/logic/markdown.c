@@ -27,33 +27,471 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
-/* ---------- Internal helpers ---------- */
-static fossil_media_md_node_t *md_new_node(fossil_media_md_type_t type, const char *content, const char *extra) {
-    fossil_media_md_node_t *node = calloc(1, sizeof(fossil_media_md_node_t));
-    if (!node) return NULL;
-    node->type = type;
-    node->content = content ? fossil_media_strdup(content) : NULL;
-    node->extra = extra ? fossil_media_strdup(extra) : NULL;
+/* ---------- Tree storage ----------
+ *
+ * A parsed tree lives in one arena owned by its root: nodes, children
+ * arrays and strings. The root itself, its children array and the source
+ * range of each top-level block are kept beside it in the doc together
+ * with a copy of the source, so edits can re-parse single blocks and
+ * splice them in. fossil_media_md_free() releases it all at once.
+ */
+typedef struct {
+    size_t start;   /* offset of the block's first line */
+    size_t end;     /* offset where the scan continued after it */
+} md_span_t;
+
+struct fossil_media_md_doc {
+    fossil_media_md_node_t root;   /* children and spans are heap arrays of block_cap */
+    fossil_media_arena_t arena;
+    md_span_t *spans;
+    size_t block_cap;
+    size_t stale;                  /* replaced blocks still held by the arena */
+    char *text;                    /* source, NUL-terminated */
+    size_t len;
+    size_t cap;
+};
+
+typedef struct {
+    fossil_media_arena_t *arena;   /* nodes and text of the tree */
+    fossil_media_arena_t scratch;  /* inline parsing state, reset per block */
+    fossil_media_md_node_t *root;  /* parent of the top-level blocks */
+    const char *base;              /* source the spans are relative to */
+    const char *stop;              /* scan ends here, or at the NUL when NULL */
+    fossil_media_md_node_t **blocks;
+    md_span_t *spans;
+    size_t count;
+    size_t cap;
+} md_parser_t;
+
+static void md_parser_init(md_parser_t *mp, fossil_media_md_doc_t *doc, fossil_media_arena_t *arena) {
+    memset(mp, 0, sizeof(*mp));
+    mp->arena = arena;
+    mp->root = &doc->root;
+    mp->base = doc->text;
+    fossil_media_arena_init(&mp->scratch, 0);
+}
+
+static void md_parser_done(md_parser_t *mp) {
+    fossil_media_arena_destroy(&mp->scratch);
+    free(mp->blocks);
+    free(mp->spans);
+}
+
+static fossil_media_md_node_t *md_new_node(md_parser_t *mp, fossil_media_md_type_t type) {
+    fossil_media_md_node_t *node = (fossil_media_md_node_t*)fossil_media_arena_calloc(mp->arena, sizeof(*node));
+    if (node) node->type = type;
     return node;
 }
 
-static void md_add_child(fossil_media_md_node_t *parent, fossil_media_md_node_t *child) {
-    if (!parent || !child) return;
-    fossil_media_md_node_t **new_children = realloc(parent->children, sizeof(*parent->children) * (parent->child_count + 1));
-    if (!new_children) return; // realloc failed, do not modify parent
-    parent->children = new_children;
-    parent->children[parent->child_count++] = child;
-    child->parent = parent;
+/* Make room for `count` top-level blocks in a children/spans array pair */
+static int md_reserve_blocks(fossil_media_md_node_t ***blocks, md_span_t **spans, size_t *cap, size_t count) {
+    if (count <= *cap) return 0;
+    size_t grown = *cap ? *cap : 16;
+    while (grown < count) grown *= 2;
+    fossil_media_md_node_t **b = (fossil_media_md_node_t**)realloc(*blocks, grown * sizeof(*b));
+    if (!b) return -1;
+    *blocks = b;
+    md_span_t *sp = (md_span_t*)realloc(*spans, grown * sizeof(*sp));
+    if (!sp) return -1;
+    *spans = sp;
+    *cap = grown;
+    return 0;
+}
+
+/* Top-level block; its span is filled in by the block loop */
+static int md_add_block(md_parser_t *mp, fossil_media_md_node_t *node) {
+    if (md_reserve_blocks(&mp->blocks, &mp->spans, &mp->cap, mp->count + 1)) return -1;
+    node->parent = mp->root;
+    mp->blocks[mp->count++] = node;
+    return 0;
+}
+
+/* ---------- Inline parsing ----------
+ *
+ * One pass over the text of a block. Runs of plain text are skipped with
+ * fossil_media_find_any(); the special characters build a list of items,
+ * with `*` and `_` runs recorded on a delimiter stack and `[` on a bracket
+ * stack. Emphasis is resolved CommonMark-style: each closer looks back for
+ * the nearest compatible opener, and a failed search records how far down
+ * later closers of the same kind need to look, keeping the whole pass
+ * linear. The finished item list becomes the block's children.
+ */
+
+typedef struct md_item {
+    fossil_media_md_type_t type;      /* TEXT, CODE, BOLD, ITALIC or LINK */
+    const char *text;                 /* TEXT and CODE span (delimiter runs shrink as they match) */
+    size_t len;
+    const char *url;                  /* LINK destination */
+    size_t url_len;
+    struct md_item *prev, *next;
+    struct md_item *first, *last;     /* children of BOLD, ITALIC and LINK */
+} md_item_t;
+
+typedef struct md_delim {
+    md_item_t *item;
+    char ch;
+    size_t orig;                      /* run length as scanned */
+    int can_open, can_close;
+    struct md_delim *prev, *next;
+} md_delim_t;
+
+typedef struct md_bracket {
+    md_item_t *item;                  /* the "[" text */
+    md_delim_t *bottom;               /* delimiter stack top when it was pushed */
+    int active;
+    struct md_bracket *prev;
+} md_bracket_t;
+
+#define MD_CODE_RUNS 32
+#define MD_LINK_PARENS 32             /* nesting allowed in a destination, as in CommonMark */
+
+typedef struct {
+    md_parser_t *mp;
+    md_item_t *first, *last;
+    md_delim_t *delims;               /* top of the delimiter stack */
+    md_bracket_t *brackets;
+    unsigned char no_closer[MD_CODE_RUNS + 1]; /* backtick runs with no closer ahead */
+    const char *dest_fail;            /* where the last failed destination scan stopped */
+    const char *dest_close;           /* just past the last ')' it saw */
+} md_inline_t;
+
+static md_item_t *md_item(md_inline_t *il, fossil_media_md_type_t type, const char *text, size_t len) {
+    md_item_t *it = (md_item_t*)fossil_media_arena_calloc(&il->mp->scratch, sizeof(*it));
+    if (!it) return NULL;
+    it->type = type;
+    it->text = text;
+    it->len = len;
+    it->prev = il->last;
+    if (il->last) il->last->next = it;
+    else il->first = it;
+    il->last = it;
+    return it;
+}
+
+static void md_unlink(md_inline_t *il, md_item_t *it) {
+    if (it->prev) it->prev->next = it->next;
+    else il->first = it->next;
+    if (it->next) it->next->prev = it->prev;
+    else il->last = it->prev;
+}
+
+static void md_remove_delim(md_inline_t *il, md_delim_t *d) {
+    if (d->prev) d->prev->next = d->next;
+    if (d->next) d->next->prev = d->prev;
+    else il->delims = d->prev;
+}
+
+/* Wrap the items strictly between `a` and `b` in `wrap`, placed between them */
+static void md_wrap_between(md_item_t *a, md_item_t *b, md_item_t *wrap) {
+    if (a->next != b) {
+        wrap->first = a->next;
+        wrap->last = b->prev;
+        wrap->first->prev = NULL;
+        wrap->last->next = NULL;
+    }
+    a->next = wrap;
+    wrap->prev = a;
+    wrap->next = b;
+    b->prev = wrap;
+}
+
+static void md_process_emphasis(md_inline_t *il, md_delim_t *bottom) {
+    md_delim_t *openers_bottom[2][2][3];
+    for (int c = 0; c < 2; ++c)
+        for (int o = 0; o < 2; ++o)
+            for (int m = 0; m < 3; ++m) openers_bottom[c][o][m] = bottom;
+
+    md_delim_t *closer = il->delims;
+    if (closer == bottom) return;
+    while (closer->prev != bottom) closer = closer->prev;
+
+    while (closer) {
+        if (!closer->can_close) {
+            closer = closer->next;
+            continue;
+        }
+        md_delim_t **ob = &openers_bottom[closer->ch == '*'][closer->can_open != 0][closer->orig % 3];
+        md_delim_t *opener = closer->prev;
+        int found = 0;
+        for (; opener && opener != bottom && opener != *ob; opener = opener->prev) {
+            if (opener->ch != closer->ch || !opener->can_open) continue;
+            /* "rule of three" for runs that can both open and close */
+            int odd = (closer->can_open || opener->can_close) && (opener->orig + closer->orig) % 3 == 0 &&
+                      !(opener->orig % 3 == 0 && closer->orig % 3 == 0);
+            if (!odd) {
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            *ob = closer->prev;
+            md_delim_t *next = closer->next;
+            if (!closer->can_open) md_remove_delim(il, closer);
+            closer = next;
+            continue;
+        }
+
+        size_t use = closer->item->len >= 2 && opener->item->len >= 2 ? 2 : 1;
+        md_item_t *em = (md_item_t*)fossil_media_arena_calloc(&il->mp->scratch, sizeof(*em));
+        if (!em) return;
+        em->type = use == 2 ? FOSSIL_MEDIA_MD_BOLD : FOSSIL_MEDIA_MD_ITALIC;
+        opener->item->len -= use;
+        closer->item->text += use;
+        closer->item->len -= use;
+        md_wrap_between(opener->item, closer->item, em);
+        while (closer->prev != opener) md_remove_delim(il, closer->prev);
+        if (opener->item->len == 0) {
+            md_unlink(il, opener->item);
+            md_remove_delim(il, opener);
+        }
+        if (closer->item->len == 0) {
+            md_delim_t *next = closer->next;
+            md_unlink(il, closer->item);
+            md_remove_delim(il, closer);
+            closer = next;
+        }
+    }
+    while (il->delims != bottom) md_remove_delim(il, il->delims);
+}
+
+static int md_push_delim(md_inline_t *il, const char *s, const char *p, const char *end, size_t n) {
+    md_item_t *it = md_item(il, FOSSIL_MEDIA_MD_TEXT, p, n);
+    if (!it) return -1;
+    unsigned char prev = p > s ? (unsigned char)p[-1] : ' ';
+    unsigned char next = p + n < end ? (unsigned char)p[n] : ' ';
+    int ws_prev = isspace(prev), ws_next = isspace(next);
+    int punct_prev = ispunct(prev), punct_next = ispunct(next);
+    int left = !ws_next && (!punct_next || ws_prev || punct_prev);
+    int right = !ws_prev && (!punct_prev || ws_next || punct_next);
+    int can_open = *p == '*' ? left : left && (!right || punct_prev);
+    int can_close = *p == '*' ? right : right && (!left || punct_next);
+    if (!can_open && !can_close) return 0;
+
+    md_delim_t *d = (md_delim_t*)fossil_media_arena_calloc(&il->mp->scratch, sizeof(*d));
+    if (!d) return -1;
+    d->item = it;
+    d->ch = *p;
+    d->orig = n;
+    d->can_open = can_open;
+    d->can_close = can_close;
+    d->prev = il->delims;
+    if (il->delims) il->delims->next = d;
+    il->delims = d;
+    return 0;
+}
+
+/* Code span opened by `n` backticks at p; returns the end of what was consumed */
+static const char *md_code_span(md_inline_t *il, const char *p, const char *end, size_t n) {
+    const char *q = p + n;
+    if (!(n <= MD_CODE_RUNS && il->no_closer[n])) {
+        while ((q = (const char*)memchr(q, '`', (size_t)(end - q))) != NULL) {
+            const char *r = q;
+            while (r < end && *r == '`') r++;
+            if ((size_t)(r - q) == n) {
+                const char *cs = p + n, *ce = q;
+                /* one space is stripped from each side unless the span is all spaces */
+                if (ce - cs >= 2 && *cs == ' ' && ce[-1] == ' ') {
+                    const char *t = cs;
+                    while (t < ce && *t == ' ') t++;
+                    if (t < ce) {
+                        cs++;
+                        ce--;
+                    }
+                }
+                return md_item(il, FOSSIL_MEDIA_MD_CODE, cs, (size_t)(ce - cs)) ? r : NULL;
+            }
+            q = r;
+        }
+        if (n <= MD_CODE_RUNS) il->no_closer[n] = 1;
+    }
+    return md_item(il, FOSSIL_MEDIA_MD_TEXT, p, n) ? p + n : NULL;
+}
+
+/*
+ * `](destination)` after an open bracket; returns the end of what was consumed.
+ * A destination scan that fails by running into a space or the end is
+ * remembered: a later one starting inside it with no ')' left before that
+ * point would stop at the same place and fail too, so it is not rescanned.
+ * Together with the nesting limit this keeps `[](` runs linear.
+ */
+static const char *md_close_bracket(md_inline_t *il, const char *p, const char *end) {
+    md_bracket_t *b = il->brackets;
+    const char *q = p + 1;
+    const char *us = NULL, *ue = NULL;
+    if (b && b->active && q < end && *q == '(') {
+        q++;
+        while (q < end && *q == ' ') q++;
+        if (q >= il->dest_fail || q < il->dest_close) {
+            us = q;
+            int depth = 0;
+            const char *close = us;
+            for (; q < end && !isspace((unsigned char)*q); ++q) {
+                if (*q == '\\' && q + 1 < end) {
+                    if (*++q == ')') close = q + 1;
+                } else if (*q == '(') {
+                    if (++depth > MD_LINK_PARENS) break;
+                } else if (*q == ')') {
+                    close = q + 1;
+                    if (depth-- == 0) break;
+                }
+            }
+            ue = q;
+            if (depth > MD_LINK_PARENS) {
+                us = NULL;
+            } else {
+                while (q < end && *q == ' ') q++;
+                if (q >= end || *q != ')') {
+                    us = NULL;
+                    il->dest_fail = ue;
+                    il->dest_close = close;
+                }
+            }
+        }
+    }
+    if (b) il->brackets = b->prev;
+    if (!us) return md_item(il, FOSSIL_MEDIA_MD_TEXT, p, 1) ? p + 1 : NULL;
+
+    md_process_emphasis(il, b->bottom);
+    md_item_t *link = (md_item_t*)fossil_media_arena_calloc(&il->mp->scratch, sizeof(*link));
+    if (!link) return NULL;
+    link->type = FOSSIL_MEDIA_MD_LINK;
+    link->url = us;
+    link->url_len = (size_t)(ue - us);
+    if (b->item->next) {
+        link->first = b->item->next;
+        link->last = il->last;
+        link->first->prev = NULL;
+    }
+    /* the link takes the place of its "[" */
+    link->prev = b->item->prev;
+    if (link->prev) link->prev->next = link;
+    else il->first = link;
+    il->last = link;
+    /* no links inside links */
+    for (md_bracket_t *o = il->brackets; o; o = o->prev) o->active = 0;
+    return q + 1;
 }
 
-/* ---------- Enhanced Markdown Parser ---------- */
+static size_t md_text_length(const md_item_t *it) {
+    size_t n = 0;
+    for (; it && it->type == FOSSIL_MEDIA_MD_TEXT; it = it->next) n += it->len;
+    return n;
+}
 
-static int is_blank_line(const char *line) {
-    while (*line) {
-        if (*line != ' ' && *line != '\t' && *line != '\r' && *line != '\n')
+/* Turn an item list into children of `parent`; adjacent text items merge */
+static int md_build_children(md_inline_t *il, fossil_media_md_node_t *parent, const md_item_t *first) {
+    fossil_media_arena_t *arena = il->mp->arena;
+    size_t count = 0;
+    for (const md_item_t *it = first; it; it = it->next) {
+        if (it->type == FOSSIL_MEDIA_MD_TEXT) {
+            while (it->next && it->next->type == FOSSIL_MEDIA_MD_TEXT) it = it->next;
+        }
+        count++;
+    }
+    if (!count) return 0;
+    parent->children = (fossil_media_md_node_t**)fossil_media_arena_alloc(arena, count * sizeof(*parent->children));
+    if (!parent->children) return -1;
+
+    for (const md_item_t *it = first; it; it = it->next) {
+        fossil_media_md_node_t *node = md_new_node(il->mp, it->type);
+        if (!node) return -1;
+        node->parent = parent;
+        parent->children[parent->child_count++] = node;
+        switch (it->type) {
+            case FOSSIL_MEDIA_MD_TEXT: {
+                size_t n = md_text_length(it);
+                char *text = (char*)fossil_media_arena_alloc(arena, n + 1);
+                if (!text) return -1;
+                size_t at = 0;
+                for (;; it = it->next) {
+                    memcpy(text + at, it->text, it->len);
+                    at += it->len;
+                    if (!it->next || it->next->type != FOSSIL_MEDIA_MD_TEXT) break;
+                }
+                text[n] = '\0';
+                node->content = text;
+                break;
+            }
+            case FOSSIL_MEDIA_MD_CODE:
+                if (!(node->content = fossil_media_arena_strndup(arena, it->text, it->len))) return -1;
+                break;
+            case FOSSIL_MEDIA_MD_LINK:
+                if (!(node->extra = fossil_media_arena_strndup(arena, it->url, it->url_len))) return -1;
+                /* fall through */
+            default:
+                if (md_build_children(il, node, it->first)) return -1;
+                break;
+        }
+    }
+    return 0;
+}
+
+static int md_parse_inline(md_parser_t *mp, fossil_media_md_node_t *block) {
+    const char *s = block->content;
+    size_t len = strlen(s);
+    if (!fossil_media_find_any(s, len, "*_`[]\\")) return 0;
+
+    md_inline_t il;
+    memset(&il, 0, sizeof(il));
+    il.mp = mp;
+    il.dest_fail = il.dest_close = s;
+    const char *p = s, *end = s + len;
+    while (p && p < end) {
+        const char *hit = fossil_media_find_any(p, (size_t)(end - p), "*_`[]\\");
+        if (!hit) {
+            if (!md_item(&il, FOSSIL_MEDIA_MD_TEXT, p, (size_t)(end - p))) return -1;
+            break;
+        }
+        if (hit > p && !md_item(&il, FOSSIL_MEDIA_MD_TEXT, p, (size_t)(hit - p))) return -1;
+        p = hit;
+        size_t n = 1;
+        switch (*p) {
+            case '\\':
+                /* an escaped punctuation character is plain text */
+                if (p + 1 < end && ispunct((unsigned char)p[1])) p++;
+                p = md_item(&il, FOSSIL_MEDIA_MD_TEXT, p, 1) ? p + 1 : NULL;
+                break;
+            case '`':
+                while (p + n < end && p[n] == '`') n++;
+                p = md_code_span(&il, p, end, n);
+                break;
+            case '*':
+            case '_':
+                while (p + n < end && p[n] == *p) n++;
+                p = md_push_delim(&il, s, p, end, n) == 0 ? p + n : NULL;
+                break;
+            case '[': {
+                md_bracket_t *b = (md_bracket_t*)fossil_media_arena_calloc(&mp->scratch, sizeof(*b));
+                if (!b || !(b->item = md_item(&il, FOSSIL_MEDIA_MD_TEXT, p, 1))) return -1;
+                b->bottom = il.delims;
+                b->active = 1;
+                b->prev = il.brackets;
+                il.brackets = b;
+                p++;
+                break;
+            }
+            default:
+                p = md_close_bracket(&il, p, end);
+                break;
+        }
+    }
+    if (!p) return -1;
+    md_process_emphasis(&il, NULL);
+
+    /* a block that turned out to be plain text keeps no children */
+    if (md_text_length(il.first) == len) return 0;
+    if (md_build_children(&il, block, il.first)) return -1;
+    return 0;
+}
+
+/* ---------- Block parsing ---------- */
+
+static int is_blank_line(const char *line, const char *end) {
+    for (; line < end; line++) {
+        if (*line != ' ' && *line != '\t' && *line != '\r')
             return 0;
-        line++;
     }
     return 1;
 }
@@ -77,130 +515,631 @@ static int is_blockquote(const char *line) {
     return (*line == '>' && (line[1] == ' ' || line[1] == '\t'));
 }
 
-static char *extract_line(const char *start, const char **next) {
-    const char *end = strchr(start, '\n');
-    size_t len = end ? (size_t)(end - start) : strlen(start);
-    char *line = fossil_media_strndup(start, len);
-    *next = end ? end + 1 : start + len;
-    return line;
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+/* Block holding the rest of the line from `content`, with its inline children */
+static int md_add_line_block(md_parser_t *mp, fossil_media_md_type_t type, const char *content, const char *end, int level) {
+    fossil_media_md_node_t *node = md_new_node(mp, type);
+    if (!node || !(node->content = fossil_media_arena_strndup(mp->arena, content, (size_t)(end - content)))) return -1;
+    node->level = level;
+    fossil_media_arena_reset(&mp->scratch);
+    if (md_parse_inline(mp, node)) return -1;
+    return md_add_block(mp, node);
+}
+
+/* Fenced code from the line after the fence to the next "```"; NULL when unclosed */
+static const char *md_add_code_block(md_parser_t *mp, const char *lang, const char *lang_end,
+                                     const char *code_start, int *rc) {
+    const char *code_end = strstr(code_start, "```");
+    if (!code_end) return NULL;
+    size_t block_len = (size_t)(code_end - code_start);
+    while (block_len > 0 && (code_start[block_len - 1] == '\n' || code_start[block_len - 1] == '\r')) {
+        block_len--;
+    }
+    lang = skip_blanks(lang, lang_end);
+    fossil_media_md_node_t *node = md_new_node(mp, FOSSIL_MEDIA_MD_CODE_BLOCK);
+    if (!node || !(node->content = fossil_media_arena_strndup(mp->arena, code_start, block_len)) ||
+        (lang < lang_end && !(node->extra = fossil_media_arena_strndup(mp->arena, lang, (size_t)(lang_end - lang)))) ||
+        md_add_block(mp, node)) {
+        *rc = -1;
+        return NULL;
+    }
+    const char *next = code_end + 3;
+    // Skip possible trailing newline after closing fence
+    if (*next == '\n' || *next == '\r') next++;
+    return next;
+}
+
+/* Where the re-parse after an edit may rejoin the old top-level blocks */
+typedef struct {
+    const md_span_t *spans;  /* old spans, in offsets before the edit */
+    size_t next;             /* first old block not yet passed */
+    size_t count;
+    size_t deleted;
+    size_t inserted;
+    int joined;              /* stopped at the start of old block `next` */
+} md_resync_t;
+
+/*
+ * Parsing from a line start depends only on the text after it, so once
+ * the scan reaches the start of an old block lying wholly behind the edit,
+ * that block and all after it would come out the same again.
+ */
+static int md_resync(md_resync_t *sync, size_t pos) {
+    while (sync->next < sync->count &&
+           sync->spans[sync->next].start - sync->deleted + sync->inserted < pos) {
+        sync->next++;
+    }
+    return sync->next < sync->count && sync->spans[sync->next].start - sync->deleted + sync->inserted == pos;
+}
+
+static int md_parse_blocks(md_parser_t *mp, const char *line, md_resync_t *sync) {
+    int rc = 0;
+    while (*line && (!mp->stop || line < mp->stop) && rc == 0) {
+        if (sync && md_resync(sync, (size_t)(line - mp->base))) {
+            sync->joined = 1;
+            break;
+        }
+        const char *nl = strchr(line, '\n');
+        const char *end = nl ? nl : line + strlen(line);
+        const char *next = nl ? nl + 1 : end;
+        size_t count = mp->count;
+
+        size_t level = 0;
+        if (is_blank_line(line, end)) {
+            /* nothing */
+        } else if (is_heading(line, &level)) {
+            rc = md_add_line_block(mp, FOSSIL_MEDIA_MD_HEADING, skip_blanks(line + level, end), end, (int)level);
+        } else if (is_list_item(line)) {
+            rc = md_add_line_block(mp, FOSSIL_MEDIA_MD_LIST_ITEM, skip_blanks(line + 2, end), end, 0);
+        } else if (is_blockquote(line)) {
+            rc = md_add_line_block(mp, FOSSIL_MEDIA_MD_BLOCKQUOTE, skip_blanks(line + 1, end), end, 0);
+        } else if (is_code_fence(line)) {
+            next = md_add_code_block(mp, line + 3, end, next, &rc);
+            if (!next) break;
+        } else {
+            rc = md_add_line_block(mp, FOSSIL_MEDIA_MD_TEXT, line, end, 0);
+        }
+        if (rc == 0 && mp->count > count) {
+            mp->spans[count].start = (size_t)(line - mp->base);
+            mp->spans[count].end = (size_t)(next - mp->base);
+        }
+        line = next;
+    }
+    if (sync && !sync->joined) sync->next = sync->count;
+    return rc;
+}
+
+/* Make the parser's blocks the whole top level of the tree */
+static void md_adopt_blocks(fossil_media_md_doc_t *doc, md_parser_t *mp) {
+    free(doc->root.children);
+    free(doc->spans);
+    doc->root.children = mp->blocks;
+    doc->root.child_count = mp->count;
+    doc->spans = mp->spans;
+    doc->block_cap = mp->cap;
+    mp->blocks = NULL;
+    mp->spans = NULL;
+    mp->count = mp->cap = 0;
+}
+
+static void md_doc_free(fossil_media_md_doc_t *doc) {
+    fossil_media_arena_destroy(&doc->arena);
+    free(doc->root.children);
+    free(doc->spans);
+    free(doc->text);
+    free(doc);
+}
+
+/* Doc holding a copy of `input` and an empty root */
+static fossil_media_md_doc_t *md_doc_new(const char *input) {
+    fossil_media_md_doc_t *doc = (fossil_media_md_doc_t*)calloc(1, sizeof(*doc));
+    if (!doc) return NULL;
+    fossil_media_arena_init(&doc->arena, 0);
+    doc->root.type = FOSSIL_MEDIA_MD_PARAGRAPH;
+    doc->root.doc = doc;
+    doc->len = strlen(input);
+    doc->cap = doc->len + 1;
+    doc->text = (char*)malloc(doc->cap);
+    if (!doc->text) {
+        md_doc_free(doc);
+        return NULL;
+    }
+    memcpy(doc->text, input, doc->cap);
+    return doc;
 }
 
 fossil_media_md_node_t *fossil_media_md_parse(const char *input) {
     if (!input) return NULL;
+    fossil_media_md_doc_t *doc = md_doc_new(input);
+    if (!doc) return NULL;
 
-    fossil_media_md_node_t *root = md_new_node(FOSSIL_MEDIA_MD_PARAGRAPH, NULL, NULL);
+    md_parser_t mp;
+    md_parser_init(&mp, doc, &doc->arena);
+    int rc = md_parse_blocks(&mp, doc->text, NULL);
+    if (rc == 0) md_adopt_blocks(doc, &mp);
+    md_parser_done(&mp);
+    if (rc != 0) {
+        md_doc_free(doc);
+        return NULL;
+    }
+    return &doc->root;
+}
 
-    const char *line_ptr = input;
-    while (*line_ptr) {
-        char *line = extract_line(line_ptr, &line_ptr);
-        if (is_blank_line(line)) {
-            free(line);
-            continue;
+/* ---------- Parallel parsing ----------
+ *
+ * Block parsing from a scan position depends only on the text after it.
+ * A pre-scan walks the lines the way md_parse_blocks() does, stepping
+ * over fenced code, and cuts after blank lines about every `step` bytes.
+ * Each piece is parsed on a worker into its own arena; the blocks are
+ * then concatenated in order and the arenas merged into the doc, which
+ * gives exactly the serial tree.
+ */
+
+/* Pieces smaller than this are not worth a thread */
+#define MD_PIECE_MIN (16 * 1024)
+
+/* Cut points after blank lines outside fences; returns the piece count */
+static size_t md_cut_pieces(const char *text, size_t len, size_t pieces, size_t *cuts) {
+    size_t step = len / pieces, count = 0;
+    const char *line = text;
+    cuts[0] = 0;
+    while (*line && count + 1 < pieces) {
+        const char *nl = strchr(line, '\n');
+        const char *end = nl ? nl : line + strlen(line);
+        const char *next = nl ? nl + 1 : end;
+        if (is_code_fence(line)) {
+            const char *close = strstr(next, "```");
+            if (!close) break;  /* the serial parse stops here too */
+            next = close + 3;
+            if (*next == '\n' || *next == '\r') next++;
+        } else if (nl && (size_t)(next - text) >= cuts[count] + step && is_blank_line(line, end)) {
+            cuts[++count] = (size_t)(next - text);
         }
+        line = next;
+    }
+    cuts[++count] = len;
+    return count;
+}
 
-        size_t level = 0;
-        if (is_heading(line, &level)) {
-            const char *content = line + level;
-            while (*content == ' ' || *content == '\t') content++;
-            fossil_media_md_node_t *heading = md_new_node(FOSSIL_MEDIA_MD_HEADING, content, NULL);
-            heading->level = (int)level;
-            md_add_child(root, heading);
-        }
-        else if (is_list_item(line)) {
-            const char *content = line + 2;
-            while (*content == ' ' || *content == '\t') content++;
-            md_add_child(root, md_new_node(FOSSIL_MEDIA_MD_LIST_ITEM, content, NULL));
-        }
-        else if (is_blockquote(line)) {
-            const char *content = line + 1;
-            while (*content == ' ' || *content == '\t') content++;
-            md_add_child(root, md_new_node(FOSSIL_MEDIA_MD_BLOCKQUOTE, content, NULL));
-        }
-        else if (is_code_fence(line)) {
-            const char *lang = line + 3;
-            while (*lang == ' ' || *lang == '\t') lang++;
-            // If lang is only whitespace or empty, treat as no language
-            const char *code_start = line_ptr;
-            const char *code_end = strstr(code_start, "```");
-            if (!code_end) {
-                free(line);
-                break;
-            }
-            // Remove trailing newline if present before closing fence
-            size_t block_len = (size_t)(code_end - code_start);
-            while (block_len > 0 && (code_start[block_len - 1] == '\n' || code_start[block_len - 1] == '\r')) {
-                block_len--;
+typedef struct {
+    fossil_media_md_doc_t *doc;
+    const size_t *cuts;            /* piece i is [cuts[i], cuts[i + 1]) */
+    md_parser_t *parsers;
+    fossil_media_arena_t *arenas;
+    int *status;
+} md_batch_t;
+
+static void md_parse_piece(void *ctx, size_t index, size_t worker) {
+    md_batch_t *batch = (md_batch_t*)ctx;
+    (void)worker;
+    md_parser_t *mp = &batch->parsers[index];
+    md_parser_init(mp, batch->doc, &batch->arenas[index]);
+    mp->stop = batch->doc->text + batch->cuts[index + 1];
+    batch->status[index] = md_parse_blocks(mp, batch->doc->text + batch->cuts[index], NULL);
+}
+
+/* Parse the doc's text in `pieces` pieces on `workers` threads */
+static int md_parse_pieces(fossil_media_md_doc_t *doc, const size_t *cuts, size_t pieces, size_t workers) {
+    md_batch_t batch;
+    batch.doc = doc;
+    batch.cuts = cuts;
+    batch.parsers = (md_parser_t*)calloc(pieces, sizeof(*batch.parsers));
+    batch.arenas = (fossil_media_arena_t*)calloc(pieces, sizeof(*batch.arenas));
+    batch.status = (int*)calloc(pieces, sizeof(*batch.status));
+    if (!batch.parsers || !batch.arenas || !batch.status) {
+        free(batch.parsers);
+        free(batch.arenas);
+        free(batch.status);
+        return -1;
+    }
+    for (size_t i = 0; i < pieces; ++i) fossil_media_arena_init(&batch.arenas[i], 0);
+
+    int rc = fossil_media_parallel_run(pieces, workers, md_parse_piece, &batch);
+    size_t total = 0;
+    for (size_t i = 0; i < pieces; ++i) {
+        if (batch.status[i] != 0) rc = -1;
+        total += batch.parsers[i].count;
+    }
+    if (rc == 0 && md_reserve_blocks(&doc->root.children, &doc->spans, &doc->block_cap, total) == 0) {
+        for (size_t i = 0; i < pieces; ++i) {
+            md_parser_t *mp = &batch.parsers[i];
+            if (mp->count) {
+                memcpy(doc->root.children + doc->root.child_count, mp->blocks, mp->count * sizeof(*mp->blocks));
+                memcpy(doc->spans + doc->root.child_count, mp->spans, mp->count * sizeof(*mp->spans));
+                doc->root.child_count += mp->count;
             }
-            char *block = fossil_media_strndup(code_start, block_len);
-            fossil_media_md_node_t *code_node = md_new_node(FOSSIL_MEDIA_MD_CODE_BLOCK, block, (*lang && *lang != '\n') ? lang : NULL);
-            md_add_child(root, code_node);
-            free(block);
-            line_ptr = code_end + 3;
-            // Skip possible trailing newline after closing fence
-            if (*line_ptr == '\n' || *line_ptr == '\r') line_ptr++;
-        }
-        else {
-            md_add_child(root, md_new_node(FOSSIL_MEDIA_MD_TEXT, line, NULL));
+            fossil_media_arena_merge(&doc->arena, &batch.arenas[i]);
         }
-        free(line);
+    } else {
+        rc = -1;
     }
+    for (size_t i = 0; i < pieces; ++i) {
+        md_parser_done(&batch.parsers[i]);
+        fossil_media_arena_destroy(&batch.arenas[i]);
+    }
+    free(batch.parsers);
+    free(batch.arenas);
+    free(batch.status);
+    return rc;
+}
 
-    return root;
+fossil_media_md_node_t *fossil_media_md_parse_parallel(const char *input, size_t threads) {
+    if (!input) return NULL;
+    size_t len = strlen(input);
+    size_t workers = fossil_media_parallel_workers(threads, len / MD_PIECE_MIN);
+    if (workers < 2) return fossil_media_md_parse(input);
+
+    fossil_media_md_doc_t *doc = md_doc_new(input);
+    if (!doc) return NULL;
+    /* a few pieces per worker so uneven pieces balance out */
+    size_t pieces = workers * 4 < len / MD_PIECE_MIN ? workers * 4 : len / MD_PIECE_MIN;
+    size_t *cuts = (size_t*)malloc((pieces + 1) * sizeof(*cuts));
+    int rc = -1;
+    if (cuts) {
+        pieces = md_cut_pieces(doc->text, doc->len, pieces, cuts);
+        rc = md_parse_pieces(doc, cuts, pieces, fossil_media_parallel_workers(workers, pieces));
+        free(cuts);
+    }
+    if (rc != 0) {
+        md_doc_free(doc);
+        return NULL;
+    }
+    return &doc->root;
+}
+
+/* ---------- Incremental edits ---------- */
+
+/* Replaced blocks tolerated in the arena before an edit re-parses it all */
+#define MD_STALE_SLACK 64
+
+/* Replace `deleted` bytes at `offset` of the source with `len` bytes of `text` */
+static int md_splice_text(fossil_media_md_doc_t *doc, size_t offset, size_t deleted, const char *text, size_t len) {
+    size_t need = doc->len - deleted + len + 1;
+    if (need > doc->cap) {
+        size_t cap = doc->cap * 2 > need ? doc->cap * 2 : need;
+        char *grown = (char*)realloc(doc->text, cap);
+        if (!grown) return -1;
+        doc->text = grown;
+        doc->cap = cap;
+    }
+    memmove(doc->text + offset + len, doc->text + offset + deleted, doc->len - offset - deleted + 1);
+    if (len) memcpy(doc->text + offset, text, len);
+    doc->len = need - 1;
+    return 0;
+}
+
+/* First top-level block whose end (or start) is at or after `offset` */
+static size_t md_span_search(const md_span_t *spans, size_t count, size_t offset, int by_end) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((by_end ? spans[mid].end : spans[mid].start) < offset) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* Put the parser's blocks in place of old blocks [first, last) and shift the spans after them */
+static int md_splice_blocks(fossil_media_md_doc_t *doc, size_t first, size_t last, md_parser_t *mp,
+                            size_t deleted, size_t inserted) {
+    size_t count = doc->root.child_count;
+    size_t total = count - (last - first) + mp->count;
+    if (md_reserve_blocks(&doc->root.children, &doc->spans, &doc->block_cap, total)) return -1;
+    /* an empty document has no arrays at all, and memmove wants real pointers */
+    if (count > last) {
+        memmove(doc->root.children + first + mp->count, doc->root.children + last,
+                (count - last) * sizeof(*doc->root.children));
+        memmove(doc->spans + first + mp->count, doc->spans + last, (count - last) * sizeof(*doc->spans));
+    }
+    for (size_t i = first + mp->count; i < total; ++i) {
+        doc->spans[i].start = doc->spans[i].start - deleted + inserted;
+        doc->spans[i].end = doc->spans[i].end - deleted + inserted;
+    }
+    if (mp->count) {
+        memcpy(doc->root.children + first, mp->blocks, mp->count * sizeof(*mp->blocks));
+        memcpy(doc->spans + first, mp->spans, mp->count * sizeof(*mp->spans));
+    }
+    doc->root.child_count = total;
+    doc->stale += last - first;
+    return 0;
+}
+
+/* Re-parse from the block before the edit until the scan rejoins the old blocks */
+static int md_reparse(fossil_media_md_doc_t *doc, size_t offset, size_t deleted, size_t inserted,
+                      fossil_media_md_change_t *change) {
+    size_t count = doc->root.child_count;
+    /* a block that ends right at the edit only saw it unless it ended on a newline */
+    size_t first = md_span_search(doc->spans, count, offset + 1, 1);
+    if (first && doc->spans[first - 1].end == offset && doc->text[offset - 1] != '\n') first--;
+    size_t from = first ? doc->spans[first - 1].end : 0;
+    md_resync_t sync;
+    sync.spans = doc->spans;
+    sync.next = md_span_search(doc->spans, count, offset + deleted, 0);
+    sync.count = count;
+    sync.deleted = deleted;
+    sync.inserted = inserted;
+    sync.joined = 0;
+
+    md_parser_t mp;
+    md_parser_init(&mp, doc, &doc->arena);
+    int rc = md_parse_blocks(&mp, doc->text + from, &sync);
+    if (rc == 0) rc = md_splice_blocks(doc, first, sync.next, &mp, deleted, inserted);
+    if (rc == 0) {
+        change->first = first;
+        change->removed = sync.next - first;
+        change->inserted = mp.count;
+    }
+    md_parser_done(&mp);
+    return rc;
+}
+
+/* Parse the whole source into a fresh arena, dropping the replaced blocks */
+static int md_rebuild(fossil_media_md_doc_t *doc, fossil_media_md_change_t *change) {
+    fossil_media_arena_t arena;
+    fossil_media_arena_init(&arena, 0);
+    md_parser_t mp;
+    md_parser_init(&mp, doc, &arena);
+    int rc = md_parse_blocks(&mp, doc->text, NULL);
+    if (rc == 0) {
+        change->first = 0;
+        change->removed = doc->root.child_count;
+        change->inserted = mp.count;
+        md_adopt_blocks(doc, &mp);
+        fossil_media_arena_destroy(&doc->arena);
+        doc->arena = arena;
+        doc->stale = 0;
+    } else {
+        fossil_media_arena_destroy(&arena);
+    }
+    md_parser_done(&mp);
+    return rc;
+}
+
+int fossil_media_md_edit(fossil_media_md_node_t *root, size_t offset, size_t deleted,
+                         const char *text, size_t len, fossil_media_md_change_t *change) {
+    if (!root || !root->doc || (!text && len)) return -1;
+    fossil_media_md_doc_t *doc = root->doc;
+    if (offset > doc->len || deleted > doc->len - offset) return -1;
+    if (len && memchr(text, '\0', len)) return -1;
+
+    /* the removed bytes put the source back if parsing fails */
+    char *removed = (char*)malloc(deleted ? deleted : 1);
+    if (!removed) return -1;
+    memcpy(removed, doc->text + offset, deleted);
+    if (md_splice_text(doc, offset, deleted, text, len)) {
+        free(removed);
+        return -1;
+    }
+
+    fossil_media_md_change_t local;
+    if (!change) change = &local;
+    int rc = doc->stale > doc->root.child_count + MD_STALE_SLACK
+        ? md_rebuild(doc, change)
+        : md_reparse(doc, offset, deleted, len, change);
+    if (rc != 0) md_splice_text(doc, offset, len, removed, deleted);
+    free(removed);
+    return rc;
+}
+
+const char *fossil_media_md_source(const fossil_media_md_node_t *root, size_t *len) {
+    if (!root || !root->doc) return NULL;
+    if (len) *len = root->doc->len;
+    return root->doc->text;
+}
+
+/* ---------- Serialization ----------
+ *
+ * Both outputs are produced through a fossil_media_writer_t. The string
+ * forms run the same code twice: once with a counting writer to learn the
+ * exact size, then into a single allocation of that size.
+ */
+
+typedef struct {
+    char *dst;
+    size_t len;
+} md_fixed_out_t;
+
+static int md_fixed_sink(void *user, const char *data, size_t len) {
+    md_fixed_out_t *f = (md_fixed_out_t*)user;
+    memcpy(f->dst + f->len, data, len);
+    f->len += len;
+    return 0;
+}
+
+typedef void (*md_emit_fn)(fossil_media_writer_t *w, const fossil_media_md_node_t *root);
+
+/* Measure, allocate once, fill */
+static char *md_emit_string(const fossil_media_md_node_t *root, md_emit_fn emit) {
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, NULL, NULL, NULL, 0);
+    emit(&w, root);
+    char *buf = (char*)malloc(w.total + 1);
+    if (!buf) return NULL;
+
+    md_fixed_out_t f = { buf, 0 };
+    fossil_media_writer_init(&w, md_fixed_sink, &f, NULL, 0);
+    emit(&w, root);
+    buf[f.len] = '\0';
+    return buf;
+}
+
+static void md_write_markdown(fossil_media_writer_t *w, const fossil_media_md_node_t *root) {
+    for (size_t i = 0; i < root->child_count; i++) {
+        const fossil_media_md_node_t *n = root->children[i];
+        switch (n->type) {
+            case FOSSIL_MEDIA_MD_HEADING: {
+                int level = n->level > 6 ? 6 : n->level < 0 ? 0 : n->level;
+                fossil_media_writer_write(w, "######", (size_t)level);
+                fossil_media_writer_putc(w, ' ');
+                break;
+            }
+            case FOSSIL_MEDIA_MD_LIST_ITEM:
+                fossil_media_writer_puts(w, "- ");
+                break;
+            case FOSSIL_MEDIA_MD_BLOCKQUOTE:
+                fossil_media_writer_puts(w, "> ");
+                break;
+            case FOSSIL_MEDIA_MD_CODE_BLOCK:
+                fossil_media_writer_puts(w, "```");
+                fossil_media_writer_puts(w, n->extra);
+                fossil_media_writer_putc(w, '\n');
+                fossil_media_writer_puts(w, n->content);
+                fossil_media_writer_puts(w, "\n```\n");
+                continue;
+            default:
+                break;
+        }
+        fossil_media_writer_puts(w, n->content);
+        fossil_media_writer_putc(w, '\n');
+    }
 }
 
 char *fossil_media_md_serialize(const fossil_media_md_node_t *root) {
     if (!root) return NULL;
+    return md_emit_string(root, md_write_markdown);
+}
+
+/*
+ * Write `s`, replacing &, <, > and " by their character references. Clean
+ * runs are found with fossil_media_find_any() and copied in one piece.
+ */
+static void md_write_escaped(fossil_media_writer_t *w, const char *s) {
+    if (!s) return;
+    size_t len = strlen(s);
+    while (len) {
+        const char *hit = fossil_media_find_any(s, len, "&<>\"");
+        size_t run = hit ? (size_t)(hit - s) : len;
+        fossil_media_writer_write(w, s, run);
+        if (!hit) break;
+        fossil_media_writer_puts(w, *hit == '&' ? "&amp;" : *hit == '<' ? "&lt;" : *hit == '>' ? "&gt;" : "&quot;");
+        s = hit + 1;
+        len -= run + 1;
+    }
+}
+
+static void md_html_span(fossil_media_writer_t *w, const fossil_media_md_node_t *n);
+
+/* Text of a block: its inline children if it has any, else its content */
+static void md_html_inline(fossil_media_writer_t *w, const fossil_media_md_node_t *n) {
+    if (n->child_count == 0) {
+        md_write_escaped(w, n->content);
+        return;
+    }
+    for (size_t i = 0; i < n->child_count; i++) md_html_span(w, n->children[i]);
+}
+
+static void md_html_span(fossil_media_writer_t *w, const fossil_media_md_node_t *n) {
+    switch (n->type) {
+        case FOSSIL_MEDIA_MD_BOLD:
+            fossil_media_writer_puts(w, "<strong>");
+            md_html_inline(w, n);
+            fossil_media_writer_puts(w, "</strong>");
+            break;
+        case FOSSIL_MEDIA_MD_ITALIC:
+            fossil_media_writer_puts(w, "<em>");
+            md_html_inline(w, n);
+            fossil_media_writer_puts(w, "</em>");
+            break;
+        case FOSSIL_MEDIA_MD_CODE:
+            fossil_media_writer_puts(w, "<code>");
+            md_write_escaped(w, n->content);
+            fossil_media_writer_puts(w, "</code>");
+            break;
+        case FOSSIL_MEDIA_MD_LINK:
+            fossil_media_writer_puts(w, "<a href=\"");
+            md_write_escaped(w, n->extra);
+            fossil_media_writer_puts(w, "\">");
+            md_html_inline(w, n);
+            fossil_media_writer_puts(w, "</a>");
+            break;
+        default:
+            md_html_inline(w, n);
+            break;
+    }
+}
 
-    size_t buf_size = 1024;
-    char *buf = calloc(1, buf_size);
-    size_t len = 0;
+static int md_same_type(const fossil_media_md_node_t *root, size_t i, fossil_media_md_type_t type) {
+    return i < root->child_count && root->children[i]->type == type;
+}
 
+static void md_write_html(fossil_media_writer_t *w, const fossil_media_md_node_t *root) {
     for (size_t i = 0; i < root->child_count; i++) {
         const fossil_media_md_node_t *n = root->children[i];
-        const char *prefix = "";
-        char heading_prefix[8] = {0};
+        /* consecutive items and quote lines share one list or quote */
+        int first = i == 0 || !md_same_type(root, i - 1, n->type);
+        int last = !md_same_type(root, i + 1, n->type);
         switch (n->type) {
-            case FOSSIL_MEDIA_MD_HEADING:
-                memset(heading_prefix, '#', n->level > 6 ? 6 : n->level);
-                heading_prefix[n->level > 6 ? 6 : n->level] = ' ';
-                prefix = heading_prefix;
+            case FOSSIL_MEDIA_MD_HEADING: {
+                char tag[4] = { 'h', (char)('0' + (n->level < 1 ? 1 : n->level > 6 ? 6 : n->level)), '>', '\0' };
+                fossil_media_writer_putc(w, '<');
+                fossil_media_writer_puts(w, tag);
+                md_html_inline(w, n);
+                fossil_media_writer_puts(w, "</");
+                fossil_media_writer_puts(w, tag);
+                fossil_media_writer_putc(w, '\n');
+                break;
+            }
+            case FOSSIL_MEDIA_MD_LIST_ITEM:
+                if (first) fossil_media_writer_puts(w, "<ul>\n");
+                fossil_media_writer_puts(w, "<li>");
+                md_html_inline(w, n);
+                fossil_media_writer_puts(w, "</li>\n");
+                if (last) fossil_media_writer_puts(w, "</ul>\n");
+                break;
+            case FOSSIL_MEDIA_MD_BLOCKQUOTE:
+                if (first) fossil_media_writer_puts(w, "<blockquote>\n");
+                fossil_media_writer_puts(w, "<p>");
+                md_html_inline(w, n);
+                fossil_media_writer_puts(w, "</p>\n");
+                if (last) fossil_media_writer_puts(w, "</blockquote>\n");
                 break;
-            case FOSSIL_MEDIA_MD_LIST_ITEM: prefix = "- "; break;
             case FOSSIL_MEDIA_MD_CODE_BLOCK:
-                if (n->extra && strlen(n->extra) > 0) {
-                    snprintf(buf + len, buf_size - len, "```%s\n", n->extra);
-                    len = strlen(buf);
-                } else {
-                    strcat(buf, "```\n");
-                    len = strlen(buf);
+                fossil_media_writer_puts(w, "<pre><code");
+                if (n->extra && *n->extra) {
+                    fossil_media_writer_puts(w, " class=\"language-");
+                    md_write_escaped(w, n->extra);
+                    fossil_media_writer_putc(w, '"');
                 }
-                if (n->content) {
-                    strcat(buf, n->content);
-                    len = strlen(buf);
+                fossil_media_writer_putc(w, '>');
+                if (n->content && *n->content) {
+                    md_write_escaped(w, n->content);
+                    fossil_media_writer_putc(w, '\n');
                 }
-                strcat(buf, "\n```");
-                len = strlen(buf);
-                strcat(buf, "\n");
-                continue;
-            case FOSSIL_MEDIA_MD_BLOCKQUOTE: prefix = "> "; break;
-            default: break;
-        }
-        size_t chunk_len = strlen(prefix) + (n->content ? strlen(n->content) : 0) + 5;
-        if (len + chunk_len >= buf_size) {
-            buf_size *= 2;
-            buf = realloc(buf, buf_size);
+                fossil_media_writer_puts(w, "</code></pre>\n");
+                break;
+            default:
+                fossil_media_writer_puts(w, "<p>");
+                md_html_span(w, n);
+                fossil_media_writer_puts(w, "</p>\n");
+                break;
         }
-        strcat(buf, prefix);
-        if (n->content) strcat(buf, n->content);
-        strcat(buf, "\n");
-        len = strlen(buf);
     }
+}
 
-    return buf;
+int fossil_media_md_render_html(const fossil_media_md_node_t *root, fossil_media_sink_fn sink, void *user) {
+    if (!root || !sink) return -1;
+    char buf[4096];
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, sink, user, buf, sizeof(buf));
+    md_write_html(&w, root);
+    return fossil_media_writer_flush(&w) == 0 ? 0 : -1;
+}
+
+char *fossil_media_md_render_html_string(const fossil_media_md_node_t *root) {
+    if (!root) return NULL;
+    return md_emit_string(root, md_write_html);
 }
 
 void fossil_media_md_free(fossil_media_md_node_t *node) {
     if (!node) return;
+    if (node->doc) {
+        md_doc_free(node->doc);
+        return;
+    }
     if (node->content) free(node->content);
     if (node->extra) free(node->extra);
     if (node->children) {
@@ -28,6 +28,28 @@
 #include <string.h>
 #include <ctype.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FOSSIL_MEDIA_HAVE_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define FOSSIL_MEDIA_HAVE_SSE2 0
+#endif
+
 
 /**
  * @brief Case-insensitive string comparison up to n characters.
@@ -40,18 +62,17 @@
  * @return 0 if equal, <0 if s1 < s2, >0 if s1 > s2.
  */
 int fossil_media_strncasecmp(const char *s1, const char *s2, size_t n) {
-    size_t i;
-    for (i = 0; i < n; i++) {
-        unsigned char c1 = (unsigned char)s1[i];
-        unsigned char c2 = (unsigned char)s2[i];
-        if (c1 == '\0' || c2 == '\0') {
-            return c1 - c2;
-        }
-        if (tolower(c1) != tolower(c2)) {
-            return tolower(c1) - tolower(c2);
-        }
+    /* bound both strings first; memchr() stops at the terminator it finds */
+    const char *z1 = (const char *)memchr(s1, '\0', n);
+    const char *z2 = (const char *)memchr(s2, '\0', n);
+    size_t len1 = z1 ? (size_t)(z1 - s1) : n;
+    size_t len2 = z2 ? (size_t)(z2 - s2) : n;
+    size_t common = len1 < len2 ? len1 : len2;
+    int diff = fossil_media_memcasecmp(s1, s2, common);
+    if (diff != 0 || len1 == len2) {
+        return diff;
     }
-    return 0;
+    return (unsigned char)s1[common] - (unsigned char)s2[common];
 }
 
 /* -------------------------------------------------------------
@@ -140,6 +161,106 @@ char *fossil_media_read_file(const char *path, size_t *out_size) {
     return buffer;
 }
 
+/* -------------------------------------------------------------
+ *  fossil_media_map_file
+ * -------------------------------------------------------------
+ *  Maps a file read-only. Empty files get an empty view, and files
+ *  the platform cannot map (pipes, some special files) are read
+ *  into a heap copy instead.
+ */
+static int map_read_fallback(const char *path, fossil_media_map_t *map) {
+    size_t size = 0;
+    char *copy = fossil_media_read_file(path, &size);
+    if (!copy) {
+        return -1;
+    }
+    map->data = copy;
+    map->size = size;
+    map->handle = copy;
+    return 0;
+}
+
+int fossil_media_map_file(const char *path, fossil_media_map_t *map) {
+    if (!map) {
+        return -1;
+    }
+    memset(map, 0, sizeof(*map));
+    if (!path) {
+        return -1;
+    }
+    map->data = "";
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return map_read_fallback(path, map);
+    }
+    if (size.QuadPart == 0) {
+        CloseHandle(file);
+        return 0;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) {
+        return map_read_fallback(path, map);
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return map_read_fallback(path, map);
+    }
+    map->data = (const char *)view;
+    map->size = (size_t)size.QuadPart;
+    map->handle = mapping;
+    map->mapped = 1;
+    return 0;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return map_read_fallback(path, map);
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return map_read_fallback(path, map);
+    }
+    map->data = (const char *)view;
+    map->size = (size_t)st.st_size;
+    map->mapped = 1;
+    return 0;
+#endif
+}
+
+void fossil_media_unmap(fossil_media_map_t *map) {
+    if (!map) {
+        return;
+    }
+    if (map->mapped) {
+#if defined(_WIN32)
+        UnmapViewOfFile(map->data);
+        CloseHandle((HANDLE)map->handle);
+#else
+        munmap((void *)map->data, map->size);
+#endif
+    } else {
+        free(map->handle);
+    }
+    memset(map, 0, sizeof(*map));
+}
+
 /* -------------------------------------------------------------
  *  fossil_media_write_file
  * -------------------------------------------------------------
@@ -170,25 +291,592 @@ char *fossil_media_trim(char *str) {
     if (!str) {
         return NULL;
     }
+    size_t len;
+    const char *start = fossil_media_trim_n(str, strlen(str), &len);
+    if (start != str) {
+        memmove(str, start, len);
+    }
+    str[len] = '\0';
+    return str;
+}
 
-    /* Trim leading whitespace */
-    char *start = str;
-    while (isspace((unsigned char)*start)) {
-        start++;
+/* -------------------------------------------------------------
+ *  fossil_media_find_any
+ * -------------------------------------------------------------
+ *  Scans 16 bytes at a time with SSE2 when the target has it,
+ *  comparing each block against every byte of the set. The tail
+ *  and non-SSE2 builds use a 256-bit membership bitmap.
+ */
+static const char *find_any_scalar(const unsigned char *p, const unsigned char *end, const char *set) {
+    uint32_t map[8] = {0};
+    for (const unsigned char *s = (const unsigned char *)set; *s; s++) {
+        map[*s >> 5] |= 1u << (*s & 31);
+    }
+    for (; p < end; p++) {
+        if (map[*p >> 5] & (1u << (*p & 31))) {
+            return (const char *)p;
+        }
+    }
+    return NULL;
+}
+
+#if FOSSIL_MEDIA_HAVE_SSE2
+static unsigned lowest_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (unsigned)idx;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+const char *fossil_media_find_any(const char *data, size_t len, const char *set) {
+    if (!data || !set || !*set || len == 0) {
+        return NULL;
     }
+    if (!set[1]) {
+        return (const char *)memchr(data, set[0], len);
+    }
+    const unsigned char *p = (const unsigned char *)data;
+    const unsigned char *end = p + len;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    size_t nset = strlen(set);
+    if (nset <= 16 && len >= 16) {
+        __m128i needles[16];
+        for (size_t i = 0; i < nset; i++) {
+            needles[i] = _mm_set1_epi8(set[i]);
+        }
+        for (; end - p >= 16; p += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i *)p);
+            __m128i hit = _mm_cmpeq_epi8(block, needles[0]);
+            for (size_t i = 1; i < nset; i++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, needles[i]));
+            }
+            unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+            if (mask) {
+                return (const char *)p + lowest_bit(mask);
+            }
+        }
+    }
+#endif
+    return find_any_scalar(p, end, set);
+}
+
+/* -------------------------------------------------------------
+ *  ASCII case and whitespace kernels
+ * -------------------------------------------------------------
+ *  Locale-independent: only A-Z fold and only the C locale's
+ *  isspace() bytes count as whitespace. SSE2 handles 16 bytes per
+ *  step; lengths are always known, so nothing is read past them.
+ */
+static int ascii_lower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+static int ascii_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+#if FOSSIL_MEDIA_HAVE_SSE2
+static __m128i sse2_lower(__m128i v) {
+    /* A-Z land on the 26 smallest signed bytes after the shift */
+    __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - 'A')));
+    __m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+/* Bit set for every byte that is not whitespace */
+static unsigned sse2_non_space(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i ctrl = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, _mm_set1_epi8('\t')), _mm_set1_epi8(4)),
+                                  _mm_setzero_si128());
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(space, ctrl)) ^ 0xFFFFu;
+}
+
+static unsigned highest_bit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse(&idx, mask);
+    return (unsigned)idx;
+#else
+    return 31u - (unsigned)__builtin_clz(mask);
+#endif
+}
+#endif
+
+int fossil_media_memcasecmp(const void *a, const void *b, size_t n) {
+    const unsigned char *p = (const unsigned char *)a;
+    const unsigned char *q = (const unsigned char *)b;
+    size_t i = 0;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(q + i));
+        unsigned diff = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(sse2_lower(x), sse2_lower(y))) ^ 0xFFFFu;
+        if (diff) {
+            i += lowest_bit(diff);
+            return ascii_lower(p[i]) - ascii_lower(q[i]);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        int d = ascii_lower(p[i]) - ascii_lower(q[i]);
+        if (d) {
+            return d;
+        }
+    }
+    return 0;
+}
 
-    /* Trim trailing whitespace */
-    char *end = start + strlen(start);
-    while (end > start && isspace((unsigned char)*(end - 1))) {
+const char *fossil_media_trim_n(const char *s, size_t len, size_t *out_len) {
+    if (!s) {
+        if (out_len) {
+            *out_len = 0;
+        }
+        return NULL;
+    }
+    size_t start = 0, end = len;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    for (; start + 16 <= len; start += 16) {
+        unsigned mask = sse2_non_space(_mm_loadu_si128((const __m128i *)(s + start)));
+        if (mask) {
+            start += lowest_bit(mask);
+            break;
+        }
+    }
+#endif
+    while (start < end && ascii_space((unsigned char)s[start])) {
+        start++;
+    }
+#if FOSSIL_MEDIA_HAVE_SSE2
+    while (end - start >= 16) {
+        unsigned mask = sse2_non_space(_mm_loadu_si128((const __m128i *)(s + end - 16)));
+        if (mask) {
+            end -= 15 - highest_bit(mask);
+            break;
+        }
+        end -= 16;
+    }
+#endif
+    while (end > start && ascii_space((unsigned char)s[end - 1])) {
         end--;
     }
+    if (out_len) {
+        *out_len = end - start;
+    }
+    return s + start;
+}
 
-    *end = '\0';
+/* -------------------------------------------------------------
+ *  Streaming output
+ * -------------------------------------------------------------
+ *  A writer stages small pieces in a fixed caller buffer and only
+ *  calls the sink when the buffer is full, on flush, or for writes
+ *  too large to stage.
+ */
+void fossil_media_writer_init(fossil_media_writer_t *w, fossil_media_sink_fn sink, void *user, char *buf, size_t cap) {
+    if (!w) {
+        return;
+    }
+    w->sink = sink;
+    w->user = user;
+    w->buf = cap ? buf : NULL;
+    w->cap = buf ? cap : 0;
+    w->len = 0;
+    w->total = 0;
+    w->error = 0;
+}
 
-    /* If trimmed part is not at original start, shift */
-    if (start != str) {
-        memmove(str, start, (size_t)(end - start) + 1);
+int fossil_media_writer_flush(fossil_media_writer_t *w) {
+    if (!w) {
+        return -1;
+    }
+    if (w->len && !w->error && w->sink) {
+        w->error = w->sink(w->user, w->buf, w->len);
     }
+    w->len = 0;
+    return w->error;
+}
 
-    return str;
+int fossil_media_writer_write(fossil_media_writer_t *w, const char *data, size_t len) {
+    if (!w || (!data && len)) {
+        return -1;
+    }
+    if (w->error) {
+        return w->error;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    w->total += len;
+    if (!w->sink) {
+        return 0;
+    }
+    if (len <= w->cap - w->len) {
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+        return 0;
+    }
+    if (fossil_media_writer_flush(w) != 0) {
+        return w->error;
+    }
+    if (len < w->cap) {
+        memcpy(w->buf, data, len);
+        w->len = len;
+        return 0;
+    }
+    w->error = w->sink(w->user, data, len);
+    return w->error;
+}
+
+int fossil_media_writer_puts(fossil_media_writer_t *w, const char *str) {
+    return fossil_media_writer_write(w, str, str ? strlen(str) : 0);
+}
+
+int fossil_media_writer_putc(fossil_media_writer_t *w, char c) {
+    if (w && !w->error && w->sink && w->len < w->cap) {
+        w->buf[w->len++] = c;
+        w->total++;
+        return 0;
+    }
+    return fossil_media_writer_write(w, &c, 1);
+}
+
+int fossil_media_sink_buffer(void *user, const char *data, size_t len) {
+    fossil_media_buffer_t *b = (fossil_media_buffer_t *)user;
+    if (!b) {
+        return -1;
+    }
+    if (b->len + len + 1 > b->cap) {
+        size_t cap = b->cap ? b->cap : 256;
+        while (cap < b->len + len + 1) {
+            cap *= 2;
+        }
+        char *grown = (char *)realloc(b->data, cap);
+        if (!grown) {
+            return -1;
+        }
+        b->data = grown;
+        b->cap = cap;
+    }
+    if (len) {
+        memcpy(b->data + b->len, data, len);
+    }
+    b->len += len;
+    b->data[b->len] = '\0';
+    return 0;
+}
+
+int fossil_media_sink_file(void *user, const char *data, size_t len) {
+    FILE *fp = (FILE *)user;
+    if (!fp) {
+        return -1;
+    }
+    return fwrite(data, 1, len, fp) == len ? 0 : -1;
+}
+
+int fossil_media_sink_fd(void *user, const char *data, size_t len) {
+    if (!user) {
+        return -1;
+    }
+    int fd = *(const int *)user;
+    while (len > 0) {
+#if defined(_WIN32)
+        int n = _write(fd, data, len > 0x40000000 ? 0x40000000u : (unsigned)len);
+        if (n <= 0) {
+            return -1;
+        }
+#else
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+#endif
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+void fossil_media_buffer_free(fossil_media_buffer_t *buf) {
+    if (!buf) {
+        return;
+    }
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+/* -------------------------------------------------------------
+ *  Arena allocation
+ * -------------------------------------------------------------
+ *  Blocks form a singly linked list, newest first. Each new block
+ *  is at least twice the previous one (capped at 1 MiB), or as big
+ *  as the request that overflowed.
+ */
+struct fossil_media_arena_block {
+    struct fossil_media_arena_block *next;
+    size_t size;
+    size_t used;
+};
+
+#define ARENA_ALIGN 16
+#define ARENA_HEADER ((sizeof(fossil_media_arena_block_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_DEFAULT_BLOCK 4096
+#define ARENA_MAX_BLOCK (1024 * 1024)
+
+void fossil_media_arena_init(fossil_media_arena_t *arena, size_t block_size) {
+    if (!arena) {
+        return;
+    }
+    arena->head = NULL;
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK;
+}
+
+void *fossil_media_arena_alloc(fossil_media_arena_t *arena, size_t size) {
+    if (!arena) {
+        return NULL;
+    }
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    fossil_media_arena_block_t *b = arena->head;
+    if (!b || b->size - b->used < size) {
+        if (!arena->block_size) {
+            arena->block_size = ARENA_DEFAULT_BLOCK;
+        }
+        size_t bytes = arena->block_size > size ? arena->block_size : size;
+        b = (fossil_media_arena_block_t *)malloc(ARENA_HEADER + bytes);
+        if (!b) {
+            return NULL;
+        }
+        b->next = arena->head;
+        b->size = bytes;
+        b->used = 0;
+        arena->head = b;
+        if (arena->block_size < ARENA_MAX_BLOCK) {
+            arena->block_size *= 2;
+        }
+    }
+    void *p = (char *)b + ARENA_HEADER + b->used;
+    b->used += size;
+    return p;
+}
+
+void *fossil_media_arena_calloc(fossil_media_arena_t *arena, size_t size) {
+    void *p = fossil_media_arena_alloc(arena, size);
+    if (p) {
+        memset(p, 0, size);
+    }
+    return p;
+}
+
+char *fossil_media_arena_strndup(fossil_media_arena_t *arena, const char *s, size_t n) {
+    if (!s) {
+        return NULL;
+    }
+    char *p = (char *)fossil_media_arena_alloc(arena, n + 1);
+    if (p) {
+        memcpy(p, s, n);
+        p[n] = '\0';
+    }
+    return p;
+}
+
+void fossil_media_arena_reset(fossil_media_arena_t *arena) {
+    if (!arena || !arena->head) {
+        return;
+    }
+    fossil_media_arena_block_t *keep = arena->head;
+    fossil_media_arena_block_t *b = keep->next;
+    while (b) {
+        fossil_media_arena_block_t *next = b->next;
+        if (b->size > keep->size) {
+            free(keep);
+            keep = b;
+        } else {
+            free(b);
+        }
+        b = next;
+    }
+    keep->next = NULL;
+    keep->used = 0;
+    arena->head = keep;
+}
+
+void fossil_media_arena_merge(fossil_media_arena_t *dst, fossil_media_arena_t *src) {
+    if (!dst || !src || !src->head) {
+        return;
+    }
+    fossil_media_arena_block_t *tail = src->head;
+    while (tail->next) {
+        tail = tail->next;
+    }
+    /* dst keeps allocating from its current block */
+    if (dst->head) {
+        tail->next = dst->head->next;
+        dst->head->next = src->head;
+    } else {
+        dst->head = src->head;
+    }
+    src->head = NULL;
+}
+
+void fossil_media_arena_destroy(fossil_media_arena_t *arena) {
+    if (!arena) {
+        return;
+    }
+    fossil_media_arena_block_t *b = arena->head;
+    while (b) {
+        fossil_media_arena_block_t *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+}
+
+/* -------------------------------------------------------------
+ *  Parallel execution
+ * -------------------------------------------------------------
+ *  A fixed set of threads drains a shared index counter. The
+ *  counter is mutex-protected; items are whole documents, so the
+ *  lock is far cheaper than the work it hands out.
+ */
+typedef struct {
+    size_t next;
+    size_t count;
+    fossil_media_task_fn fn;
+    void *ctx;
+#if defined(_WIN32)
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} parallel_job_t;
+
+typedef struct {
+    parallel_job_t *job;
+    size_t worker;
+} parallel_worker_t;
+
+static void parallel_drain(parallel_job_t *job, size_t worker) {
+    for (;;) {
+#if defined(_WIN32)
+        EnterCriticalSection(&job->lock);
+        size_t i = job->next++;
+        LeaveCriticalSection(&job->lock);
+#else
+        pthread_mutex_lock(&job->lock);
+        size_t i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+#endif
+        if (i >= job->count) {
+            return;
+        }
+        job->fn(job->ctx, i, worker);
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI parallel_thread(LPVOID arg) {
+    parallel_worker_t *w = (parallel_worker_t *)arg;
+    parallel_drain(w->job, w->worker);
+    return 0;
+}
+#else
+static void *parallel_thread(void *arg) {
+    parallel_worker_t *w = (parallel_worker_t *)arg;
+    parallel_drain(w->job, w->worker);
+    return NULL;
+}
+#endif
+
+size_t fossil_media_parallel_workers(size_t requested, size_t count) {
+    size_t n = requested;
+    if (n == 0) {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        n = (size_t)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (size_t)cpus : 1;
+#else
+        n = 1;
+#endif
+    }
+    if (n > count) {
+        n = count;
+    }
+    return n ? n : 1;
+}
+
+int fossil_media_parallel_run(size_t count, size_t workers, fossil_media_task_fn fn, void *ctx) {
+    if (!fn || workers == 0) {
+        return -1;
+    }
+    parallel_job_t job;
+    job.next = 0;
+    job.count = count;
+    job.fn = fn;
+    job.ctx = ctx;
+    if (workers > count) {
+        workers = count ? count : 1;
+    }
+    if (workers == 1) {
+        for (size_t i = 0; i < count; i++) {
+            fn(ctx, i, 0);
+        }
+        return 0;
+    }
+
+    parallel_worker_t *args = (parallel_worker_t *)malloc(workers * sizeof(*args));
+#if defined(_WIN32)
+    HANDLE *threads = (HANDLE *)malloc(workers * sizeof(*threads));
+    InitializeCriticalSection(&job.lock);
+#else
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(*threads));
+    pthread_mutex_init(&job.lock, NULL);
+#endif
+    size_t started = 0;
+    if (args && threads) {
+        for (size_t w = 1; w < workers; w++) {
+            args[started].job = &job;
+            args[started].worker = w;
+#if defined(_WIN32)
+            threads[started] = CreateThread(NULL, 0, parallel_thread, &args[started], 0, NULL);
+            if (!threads[started]) {
+                break;
+            }
+#else
+            if (pthread_create(&threads[started], NULL, parallel_thread, &args[started]) != 0) {
+                break;
+            }
+#endif
+            started++;
+        }
+    }
+
+    parallel_drain(&job, 0);
+
+    for (size_t t = 0; t < started; t++) {
+#if defined(_WIN32)
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+#else
+        pthread_join(threads[t], NULL);
+#endif
+    }
+#if defined(_WIN32)
+    DeleteCriticalSection(&job.lock);
+#else
+    pthread_mutex_destroy(&job.lock);
+#endif
+    free(threads);
+    free(args);
+    return 0;
 }
@@ -24,82 +24,858 @@
  */
 #include "fossil/media/text.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-char *fossil_media_text_trim(char *str) {
-    if (!str) return NULL;
-    char *start = str;
-    char *end;
-
-    // Skip leading spaces
-    while (isspace((unsigned char)*start)) start++;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FOSSIL_MEDIA_HAVE_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define FOSSIL_MEDIA_HAVE_SSE2 0
+#endif
 
-    if (*start == 0) return start; // Empty string
-
-    // Trim trailing spaces
-    end = start + strlen(start) - 1;
-    while (end > start && isspace((unsigned char)*end)) end--;
+char *fossil_media_text_trim(char *str) {
+    return fossil_media_trim(str);
+}
 
-    *(end + 1) = '\0';
+/* ---------- Case mapping ----------
+ *
+ * ASCII letters are mapped 16 bytes at a time: bytes in the 26-letter
+ * range get bit 0x20 flipped, everything else passes through, so the
+ * result does not depend on the locale and UTF-8 text is left intact.
+ */
+#if FOSSIL_MEDIA_HAVE_SSE2
+/* Flip bit 0x20 of every byte in [first, first + 25] */
+static __m128i text_sse2_flip(__m128i v, char first) {
+    __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - (unsigned char)first)));
+    __m128i in_range = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_xor_si128(v, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+#endif
 
-    // If start != str, move trimmed string to the beginning to avoid double free issues
-    if (start != str) {
-        memmove(str, start, strlen(start) + 1);
-        return str;
+static void text_map_ascii(char *str, char first) {
+    size_t len = strlen(str), i = 0;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        _mm_storeu_si128((__m128i*)(str + i), text_sse2_flip(v, first));
+    }
+#endif
+    for (; i < len; ++i) {
+        if ((unsigned char)(str[i] - first) < 26) str[i] ^= 0x20;
     }
-    return start;
 }
 
 char *fossil_media_text_tolower(char *str) {
     if (!str) return NULL;
-    for (char *p = str; *p; ++p) {
-        *p = (char)tolower((unsigned char)*p);
-    }
+    text_map_ascii(str, 'A');
     return str;
 }
 
 char *fossil_media_text_toupper(char *str) {
     if (!str) return NULL;
-    for (char *p = str; *p; ++p) {
-        *p = (char)toupper((unsigned char)*p);
-    }
+    text_map_ascii(str, 'a');
     return str;
 }
 
+/* ---------- Replacement ----------
+ *
+ * Output goes through a bounded cursor that keeps counting once the
+ * buffer is full, so every replace function reports the size it needs,
+ * snprintf()-style, and can be called with no buffer to query it.
+ * Copies use memmove() so a source may share storage with the output as
+ * long as the unread source stays ahead of what has been written.
+ */
+typedef struct {
+    char *dst;
+    size_t cap;     /* bytes available, including the terminator */
+    size_t len;     /* bytes produced so far, written or not */
+} text_out_t;
+
+static void text_put(text_out_t *out, const char *s, size_t n) {
+    if (out->len + 1 < out->cap) {
+        size_t room = out->cap - 1 - out->len;
+        memmove(out->dst + out->len, s, n < room ? n : room);
+    }
+    out->len += n;
+}
+
+static size_t text_finish(text_out_t *out) {
+    if (out->cap) out->dst[out->len < out->cap ? out->len : out->cap - 1] = '\0';
+    return out->len;
+}
+
+/* One left-to-right pass; each search resumes after the last match */
+static size_t text_replace_into(const char *src, const char *old_sub, size_t old_len,
+                                const char *new_sub, size_t new_len, text_out_t *out) {
+    size_t count = 0;
+    const char *end = src + strlen(src);
+    const char *pos;
+    while ((pos = fossil_media_text_find_n(src, (size_t)(end - src), old_sub, old_len)) != NULL) {
+        text_put(out, src, (size_t)(pos - src));
+        text_put(out, new_sub, new_len);
+        src = pos + old_len;
+        count++;
+    }
+    text_put(out, src, (size_t)(end - src));
+    return count;
+}
+
+size_t fossil_media_text_replace_all(const char *str, const char *old_sub, const char *new_sub,
+                                     char *out, size_t out_size, size_t *count) {
+    text_out_t o = { out, out ? out_size : 0, 0 };
+    size_t n = 0;
+    if (str) {
+        if (old_sub && *old_sub) {
+            n = text_replace_into(str, old_sub, strlen(old_sub), new_sub ? new_sub : "",
+                                  new_sub ? strlen(new_sub) : 0, &o);
+        } else {
+            text_put(&o, str, strlen(str));
+        }
+    }
+    if (count) *count = n;
+    return text_finish(&o);
+}
+
 size_t fossil_media_text_replace(char *str, const char *old_sub, const char *new_sub, size_t buf_size) {
     if (!str || !old_sub || !new_sub || buf_size == 0) return 0;
 
     size_t old_len = strlen(old_sub);
     size_t new_len = strlen(new_sub);
-    size_t count = 0;
-
     if (old_len == 0) return 0;
 
-    char *pos = strstr(str, old_sub);
-    while (pos) {
-        size_t tail_len = strlen(pos + old_len);
+    size_t count;
+    size_t len = strlen(str);
+    size_t total = fossil_media_text_replace_all(str, old_sub, new_sub, NULL, 0, &count);
+    if (count == 0 || total >= buf_size) return 0;
+
+    /*
+     * Move the text to the end of the room the result needs and rewrite it
+     * from the front: the write position never passes the unread source.
+     */
+    size_t shift = total > len ? total - len : 0;
+    if (shift) memmove(str + shift, str, len + 1);
+    text_out_t o = { str, buf_size, 0 };
+    text_replace_into(str + shift, old_sub, old_len, new_sub, new_len, &o);
+    text_finish(&o);
+    return count;
+}
+
+/* ---------- Unicode case folding ----------
+ *
+ * Simple case folding (CaseFolding.txt statuses C and S, Unicode 14):
+ * every code point maps to at most one other. The table is runs of
+ * code points sharing one offset, either consecutive or every other one
+ * (the alternating upper/lower blocks), found by binary search. ASCII
+ * never reaches it.
+ */
+typedef struct {
+    uint32_t first;
+    uint16_t count;
+    int32_t delta;
+    uint8_t stride;
+} text_fold_run_t;
+
+static const text_fold_run_t text_fold_runs[] = {
+    { 0x000B5,   1,    775, 1 },
+    { 0x000C0,  23,     32, 1 },
+    { 0x000D8,   7,     32, 1 },
+    { 0x00100,  24,      1, 2 },
+    { 0x00132,   3,      1, 2 },
+    { 0x00139,   8,      1, 2 },
+    { 0x0014A,  23,      1, 2 },
+    { 0x00178,   1,   -121, 1 },
+    { 0x00179,   3,      1, 2 },
+    { 0x0017F,   1,   -268, 1 },
+    { 0x00181,   1,    210, 1 },
+    { 0x00182,   2,      1, 2 },
+    { 0x00186,   1,    206, 1 },
+    { 0x00187,   1,      1, 1 },
+    { 0x00189,   2,    205, 1 },
+    { 0x0018B,   1,      1, 1 },
+    { 0x0018E,   1,     79, 1 },
+    { 0x0018F,   1,    202, 1 },
+    { 0x00190,   1,    203, 1 },
+    { 0x00191,   1,      1, 1 },
+    { 0x00193,   1,    205, 1 },
+    { 0x00194,   1,    207, 1 },
+    { 0x00196,   1,    211, 1 },
+    { 0x00197,   1,    209, 1 },
+    { 0x00198,   1,      1, 1 },
+    { 0x0019C,   1,    211, 1 },
+    { 0x0019D,   1,    213, 1 },
+    { 0x0019F,   1,    214, 1 },
+    { 0x001A0,   3,      1, 2 },
+    { 0x001A6,   1,    218, 1 },
+    { 0x001A7,   1,      1, 1 },
+    { 0x001A9,   1,    218, 1 },
+    { 0x001AC,   1,      1, 1 },
+    { 0x001AE,   1,    218, 1 },
+    { 0x001AF,   1,      1, 1 },
+    { 0x001B1,   2,    217, 1 },
+    { 0x001B3,   2,      1, 2 },
+    { 0x001B7,   1,    219, 1 },
+    { 0x001B8,   1,      1, 1 },
+    { 0x001BC,   1,      1, 1 },
+    { 0x001C4,   1,      2, 1 },
+    { 0x001C5,   1,      1, 1 },
+    { 0x001C7,   1,      2, 1 },
+    { 0x001C8,   1,      1, 1 },
+    { 0x001CA,   1,      2, 1 },
+    { 0x001CB,   9,      1, 2 },
+    { 0x001DE,   9,      1, 2 },
+    { 0x001F1,   1,      2, 1 },
+    { 0x001F2,   2,      1, 2 },
+    { 0x001F6,   1,    -97, 1 },
+    { 0x001F7,   1,    -56, 1 },
+    { 0x001F8,  20,      1, 2 },
+    { 0x00220,   1,   -130, 1 },
+    { 0x00222,   9,      1, 2 },
+    { 0x0023A,   1,  10795, 1 },
+    { 0x0023B,   1,      1, 1 },
+    { 0x0023D,   1,   -163, 1 },
+    { 0x0023E,   1,  10792, 1 },
+    { 0x00241,   1,      1, 1 },
+    { 0x00243,   1,   -195, 1 },
+    { 0x00244,   1,     69, 1 },
+    { 0x00245,   1,     71, 1 },
+    { 0x00246,   5,      1, 2 },
+    { 0x00345,   1,    116, 1 },
+    { 0x00370,   2,      1, 2 },
+    { 0x00376,   1,      1, 1 },
+    { 0x0037F,   1,    116, 1 },
+    { 0x00386,   1,     38, 1 },
+    { 0x00388,   3,     37, 1 },
+    { 0x0038C,   1,     64, 1 },
+    { 0x0038E,   2,     63, 1 },
+    { 0x00391,  17,     32, 1 },
+    { 0x003A3,   9,     32, 1 },
+    { 0x003C2,   1,      1, 1 },
+    { 0x003CF,   1,      8, 1 },
+    { 0x003D0,   1,    -30, 1 },
+    { 0x003D1,   1,    -25, 1 },
+    { 0x003D5,   1,    -15, 1 },
+    { 0x003D6,   1,    -22, 1 },
+    { 0x003D8,  12,      1, 2 },
+    { 0x003F0,   1,    -54, 1 },
+    { 0x003F1,   1,    -48, 1 },
+    { 0x003F4,   1,    -60, 1 },
+    { 0x003F5,   1,    -64, 1 },
+    { 0x003F7,   1,      1, 1 },
+    { 0x003F9,   1,     -7, 1 },
+    { 0x003FA,   1,      1, 1 },
+    { 0x003FD,   3,   -130, 1 },
+    { 0x00400,  16,     80, 1 },
+    { 0x00410,  32,     32, 1 },
+    { 0x00460,  17,      1, 2 },
+    { 0x0048A,  27,      1, 2 },
+    { 0x004C0,   1,     15, 1 },
+    { 0x004C1,   7,      1, 2 },
+    { 0x004D0,  48,      1, 2 },
+    { 0x00531,  38,     48, 1 },
+    { 0x010A0,  38,   7264, 1 },
+    { 0x010C7,   1,   7264, 1 },
+    { 0x010CD,   1,   7264, 1 },
+    { 0x013F8,   6,     -8, 1 },
+    { 0x01C80,   1,  -6222, 1 },
+    { 0x01C81,   1,  -6221, 1 },
+    { 0x01C82,   1,  -6212, 1 },
+    { 0x01C83,   2,  -6210, 1 },
+    { 0x01C85,   1,  -6211, 1 },
+    { 0x01C86,   1,  -6204, 1 },
+    { 0x01C87,   1,  -6180, 1 },
+    { 0x01C88,   1,  35267, 1 },
+    { 0x01C90,  43,  -3008, 1 },
+    { 0x01CBD,   3,  -3008, 1 },
+    { 0x01E00,  75,      1, 2 },
+    { 0x01E9B,   1,    -58, 1 },
+    { 0x01E9E,   1,  -7615, 1 },
+    { 0x01EA0,  48,      1, 2 },
+    { 0x01F08,   8,     -8, 1 },
+    { 0x01F18,   6,     -8, 1 },
+    { 0x01F28,   8,     -8, 1 },
+    { 0x01F38,   8,     -8, 1 },
+    { 0x01F48,   6,     -8, 1 },
+    { 0x01F59,   4,     -8, 2 },
+    { 0x01F68,   8,     -8, 1 },
+    { 0x01F88,   8,     -8, 1 },
+    { 0x01F98,   8,     -8, 1 },
+    { 0x01FA8,   8,     -8, 1 },
+    { 0x01FB8,   2,     -8, 1 },
+    { 0x01FBA,   2,    -74, 1 },
+    { 0x01FBC,   1,     -9, 1 },
+    { 0x01FBE,   1,  -7173, 1 },
+    { 0x01FC8,   4,    -86, 1 },
+    { 0x01FCC,   1,     -9, 1 },
+    { 0x01FD8,   2,     -8, 1 },
+    { 0x01FDA,   2,   -100, 1 },
+    { 0x01FE8,   2,     -8, 1 },
+    { 0x01FEA,   2,   -112, 1 },
+    { 0x01FEC,   1,     -7, 1 },
+    { 0x01FF8,   2,   -128, 1 },
+    { 0x01FFA,   2,   -126, 1 },
+    { 0x01FFC,   1,     -9, 1 },
+    { 0x02126,   1,  -7517, 1 },
+    { 0x0212A,   1,  -8383, 1 },
+    { 0x0212B,   1,  -8262, 1 },
+    { 0x02132,   1,     28, 1 },
+    { 0x02160,  16,     16, 1 },
+    { 0x02183,   1,      1, 1 },
+    { 0x024B6,  26,     26, 1 },
+    { 0x02C00,  48,     48, 1 },
+    { 0x02C60,   1,      1, 1 },
+    { 0x02C62,   1, -10743, 1 },
+    { 0x02C63,   1,  -3814, 1 },
+    { 0x02C64,   1, -10727, 1 },
+    { 0x02C67,   3,      1, 2 },
+    { 0x02C6D,   1, -10780, 1 },
+    { 0x02C6E,   1, -10749, 1 },
+    { 0x02C6F,   1, -10783, 1 },
+    { 0x02C70,   1, -10782, 1 },
+    { 0x02C72,   1,      1, 1 },
+    { 0x02C75,   1,      1, 1 },
+    { 0x02C7E,   2, -10815, 1 },
+    { 0x02C80,  50,      1, 2 },
+    { 0x02CEB,   2,      1, 2 },
+    { 0x02CF2,   1,      1, 1 },
+    { 0x0A640,  23,      1, 2 },
+    { 0x0A680,  14,      1, 2 },
+    { 0x0A722,   7,      1, 2 },
+    { 0x0A732,  31,      1, 2 },
+    { 0x0A779,   2,      1, 2 },
+    { 0x0A77D,   1, -35332, 1 },
+    { 0x0A77E,   5,      1, 2 },
+    { 0x0A78B,   1,      1, 1 },
+    { 0x0A78D,   1, -42280, 1 },
+    { 0x0A790,   2,      1, 2 },
+    { 0x0A796,  10,      1, 2 },
+    { 0x0A7AA,   1, -42308, 1 },
+    { 0x0A7AB,   1, -42319, 1 },
+    { 0x0A7AC,   1, -42315, 1 },
+    { 0x0A7AD,   1, -42305, 1 },
+    { 0x0A7AE,   1, -42308, 1 },
+    { 0x0A7B0,   1, -42258, 1 },
+    { 0x0A7B1,   1, -42282, 1 },
+    { 0x0A7B2,   1, -42261, 1 },
+    { 0x0A7B3,   1,    928, 1 },
+    { 0x0A7B4,   8,      1, 2 },
+    { 0x0A7C4,   1,    -48, 1 },
+    { 0x0A7C5,   1, -42307, 1 },
+    { 0x0A7C6,   1, -35384, 1 },
+    { 0x0A7C7,   2,      1, 2 },
+    { 0x0A7D0,   1,      1, 1 },
+    { 0x0A7D6,   2,      1, 2 },
+    { 0x0A7F5,   1,      1, 1 },
+    { 0x0AB70,  80, -38864, 1 },
+    { 0x0FF21,  26,     32, 1 },
+    { 0x10400,  40,     40, 1 },
+    { 0x104B0,  36,     40, 1 },
+    { 0x10570,  11,     39, 1 },
+    { 0x1057C,  15,     39, 1 },
+    { 0x1058C,   7,     39, 1 },
+    { 0x10594,   2,     39, 1 },
+    { 0x10C80,  51,     64, 1 },
+    { 0x118A0,  32,     32, 1 },
+    { 0x16E40,  32,     32, 1 },
+    { 0x1E900,  34,     34, 1 },
+};
+
+static uint32_t text_fold(uint32_t cp) {
+    if (cp < 0x80) return (cp - 'A' < 26) ? cp + 32 : cp;
+    size_t lo = 0, hi = sizeof(text_fold_runs) / sizeof(text_fold_runs[0]);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (text_fold_runs[mid].first <= cp) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return cp;
+    const text_fold_run_t *run = &text_fold_runs[lo - 1];
+    uint32_t off = cp - run->first;
+    if (off < (uint32_t)run->count * run->stride && off % run->stride == 0) return (uint32_t)((int32_t)cp + run->delta);
+    return cp;
+}
 
-        // Check for buffer overflow
-        if ((strlen(str) - old_len + new_len) >= buf_size) {
-            break;
+/* Decode one code point; a malformed byte decodes alone as 0x110000 + byte */
+static uint32_t text_utf8_decode(const unsigned char *s, size_t len, size_t *used) {
+    uint32_t cp;
+    *used = fossil_media_utf8_decode((const char*)s, len, &cp);
+    if (*used) return cp;
+    *used = 1;
+    return 0x110000u + s[0];
+}
+
+size_t fossil_media_text_casefold(const char *str, size_t len, char *out, size_t out_size) {
+    text_out_t o = { out, out ? out_size : 0, 0 };
+    const unsigned char *s = (const unsigned char*)str;
+    size_t i = 0;
+    if (!str) len = 0;
+    while (i < len) {
+#if FOSSIL_MEDIA_HAVE_SSE2
+        if (i + 16 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                char block[16];
+                _mm_storeu_si128((__m128i*)block, text_sse2_flip(v, 'A'));
+                text_put(&o, block, 16);
+                i += 16;
+                continue;
+            }
         }
+#endif
+        size_t used;
+        uint32_t cp = text_utf8_decode(s + i, len - i, &used);
+        if (cp >= 0x110000u) {
+            text_put(&o, str + i, 1);
+        } else {
+            char enc[4];
+            text_put(&o, enc, fossil_media_utf8_encode(text_fold(cp), enc));
+        }
+        i += used;
+    }
+    return text_finish(&o);
+}
 
-        // If new_sub is longer, move tail forward
-        if (new_len != old_len) {
-            memmove(pos + new_len, pos + old_len, tail_len + 1);
+/* Length of the common prefix of `a` and `b` with ASCII letters folded */
+static size_t text_ascii_prefix(const unsigned char *a, const unsigned char *b, size_t n) {
+    size_t i = 0;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = text_sse2_flip(_mm_loadu_si128((const __m128i*)(a + i)), 'A');
+        __m128i y = text_sse2_flip(_mm_loadu_si128((const __m128i*)(b + i)), 'A');
+        unsigned diff = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFFu;
+        if (diff) {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, diff);
+#else
+            unsigned bit = (unsigned)__builtin_ctz(diff);
+#endif
+            return i + bit;
         }
-        memcpy(pos, new_sub, new_len);
+    }
+#endif
+    while (i < n && (a[i] == b[i] || ((a[i] ^ b[i]) == 0x20 && (unsigned char)((a[i] | 0x20) - 'a') < 26))) {
+        ++i;
+    }
+    return i;
+}
 
-        count++;
-        pos = strstr(pos + new_len, old_sub);
+int fossil_media_text_casecmp(const char *a, size_t alen, const char *b, size_t blen) {
+    const unsigned char *p = (const unsigned char*)(a ? a : "");
+    const unsigned char *q = (const unsigned char*)(b ? b : "");
+    if (!a) alen = 0;
+    if (!b) blen = 0;
+    size_t i = 0, j = 0;
+    for (;;) {
+        /* equal bytes fold equally, so only differing characters are decoded */
+        size_t n = text_ascii_prefix(p + i, q + j, alen - i < blen - j ? alen - i : blen - j);
+        i += n;
+        j += n;
+        /* the prefixes are byte-equal, so both sides back up to the same boundary */
+        while (n > 0 && ((i < alen && (p[i] & 0xC0) == 0x80) || (j < blen && (q[j] & 0xC0) == 0x80))) {
+            --i;
+            --j;
+            --n;
+        }
+        if (i == alen || j == blen) break;
+        size_t used_a, used_b;
+        uint32_t ca = text_fold(text_utf8_decode(p + i, alen - i, &used_a));
+        uint32_t cb = text_fold(text_utf8_decode(q + j, blen - j, &used_b));
+        if (ca != cb) return ca < cb ? -1 : 1;
+        i += used_a;
+        j += used_b;
     }
-    return count;
+    if (i == alen && j == blen) return 0;
+    return i == alen ? -1 : 1;
+}
+
+/* ---------- Aho-Corasick automaton ----------
+ *
+ * Shared by the replacer and the searcher. The trie is compiled to a DFA:
+ * every state has a transition for each byte class, with failure links
+ * already folded in, so matching costs one table load per byte. Bytes
+ * that occur in no pattern share class 0, which keeps the table small.
+ * `match` points from each state to the deepest pattern-ending state among
+ * its suffixes, and following `fail` from there lists the shorter ones.
+ * While at the root, fossil_media_find_any() skips to the next byte that
+ * can begin a pattern.
+ */
+typedef struct {
+    unsigned char cls[256];   /* byte class, 0 for bytes in no pattern */
+    size_t classes;
+    uint32_t *next;           /* states * classes transitions */
+    uint32_t *fail;
+    uint32_t *depth;          /* length of the prefix a state stands for */
+    uint32_t *match;          /* longest pattern-ending suffix state, 0 if none */
+    uint32_t *pattern;        /* index of the pattern ending at a state */
+    char starts[17];          /* first bytes of patterns, when few enough to scan for */
+} text_automaton_t;
+
+static void text_automaton_free(text_automaton_t *a) {
+    free(a->next);
+    free(a->fail);
+    free(a->depth);
+    free(a->match);
+    free(a->pattern);
+}
+
+/* Breadth-first pass: failure links, match links and the transitions they imply */
+static int text_automaton_link(text_automaton_t *a, size_t states) {
+    uint32_t *queue = (uint32_t*)malloc(states * sizeof(*queue));
+    if (!queue) return -1;
+    size_t head = 0, tail = 0;
+    for (size_t c = 0; c < a->classes; ++c) {
+        if (a->next[c]) queue[tail++] = a->next[c];
+    }
+    while (head < tail) {
+        uint32_t s = queue[head++];
+        if (!a->match[s]) a->match[s] = a->match[a->fail[s]];
+        for (size_t c = 0; c < a->classes; ++c) {
+            uint32_t *t = &a->next[(size_t)s * a->classes + c];
+            uint32_t via_fail = a->next[(size_t)a->fail[s] * a->classes + c];
+            if (*t) {
+                a->fail[*t] = via_fail;
+                queue[tail++] = *t;
+            } else {
+                *t = via_fail;
+            }
+        }
+    }
+    free(queue);
+    return 0;
+}
+
+/* `lengths` may be NULL for NUL-terminated patterns; all must be non-empty */
+static int text_automaton_build(text_automaton_t *a, const char *const *patterns, const size_t *lengths,
+                                size_t count) {
+    memset(a, 0, sizeof(*a));
+    size_t states = 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (!patterns[i]) return -1;
+        size_t len = lengths ? lengths[i] : strlen(patterns[i]);
+        if (len == 0) return -1;
+        for (size_t k = 0; k < len; ++k) {
+            unsigned char b = (unsigned char)patterns[i][k];
+            if (!a->cls[b]) a->cls[b] = (unsigned char)++a->classes;
+        }
+        states += len;
+    }
+    a->classes++;
+
+    a->next = (uint32_t*)calloc(states * a->classes, sizeof(*a->next));
+    a->fail = (uint32_t*)calloc(states, sizeof(*a->fail));
+    a->depth = (uint32_t*)calloc(states, sizeof(*a->depth));
+    a->match = (uint32_t*)calloc(states, sizeof(*a->match));
+    a->pattern = (uint32_t*)calloc(states, sizeof(*a->pattern));
+    if (!a->next || !a->fail || !a->depth || !a->match || !a->pattern) {
+        text_automaton_free(a);
+        return -1;
+    }
+
+    size_t used = 1, nstarts = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = lengths ? lengths[i] : strlen(patterns[i]);
+        uint32_t s = 0;
+        for (size_t k = 0; k < len; ++k) {
+            uint32_t *t = &a->next[(size_t)s * a->classes + a->cls[(unsigned char)patterns[i][k]]];
+            if (!*t) {
+                *t = (uint32_t)used++;
+                a->depth[*t] = a->depth[s] + 1;
+            }
+            s = *t;
+        }
+        /* the first of duplicate patterns wins */
+        if (!a->match[s]) {
+            a->match[s] = s;
+            a->pattern[s] = (uint32_t)i;
+        }
+        /* NUL cannot be scanned for; such a set falls back to stepping every byte */
+        char first = patterns[i][0];
+        if (!first) nstarts = 17;
+        if (nstarts <= 16 && !memchr(a->starts, first, nstarts)) {
+            if (nstarts < 16) a->starts[nstarts] = first;
+            nstarts++;
+        }
+    }
+    if (nstarts > 16) a->starts[0] = '\0';
+
+    if (text_automaton_link(a, used)) {
+        text_automaton_free(a);
+        return -1;
+    }
+    return 0;
+}
+
+/* Next position at or after `i` that can begin a match, from the root */
+static size_t text_automaton_skip(const text_automaton_t *a, const char *text, size_t i, size_t len) {
+    if (!a->starts[0]) return i;
+    const char *hit = fossil_media_find_any(text + i, len - i, a->starts);
+    return hit ? (size_t)(hit - text) : len;
+}
+
+static uint32_t text_automaton_step(const text_automaton_t *a, uint32_t s, char c) {
+    return a->next[(size_t)s * a->classes + a->cls[(unsigned char)c]];
+}
+
+/* ---------- Multi-pattern replacement ----------
+ *
+ * Matching is leftmost-longest: a candidate is only committed once the
+ * automaton's depth shows no pattern can still start at or before it,
+ * then scanning resumes from the root after it. The bytes read past the
+ * candidate are read again, at most the longest pattern's length each
+ * time, so the worst case is O(n * m).
+ */
+struct fossil_media_text_replacer {
+    text_automaton_t ac;
+    char **replacements;
+    size_t *replacement_len;
+};
+
+void fossil_media_text_replacer_free(fossil_media_text_replacer_t *r) {
+    if (!r) return;
+    text_automaton_free(&r->ac);
+    free(r->replacements);
+    free(r->replacement_len);
+    free(r);
+}
+
+fossil_media_text_replacer_t *fossil_media_text_replacer_new(const char *const *patterns,
+                                                             const char *const *replacements, size_t count) {
+    if (!patterns || !replacements || count == 0) return NULL;
+    size_t replace_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!replacements[i]) return NULL;
+        replace_bytes += strlen(replacements[i]) + 1;
+    }
+    fossil_media_text_replacer_t *r = (fossil_media_text_replacer_t*)calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    if (text_automaton_build(&r->ac, patterns, NULL, count)) {
+        free(r);
+        return NULL;
+    }
+
+    /* replacement strings live in the same block as their pointer table */
+    r->replacements = (char**)malloc(count * sizeof(char*) + replace_bytes);
+    r->replacement_len = (size_t*)malloc(count * sizeof(size_t));
+    if (!r->replacements || !r->replacement_len) {
+        fossil_media_text_replacer_free(r);
+        return NULL;
+    }
+    char *text = (char*)(r->replacements + count);
+    for (size_t i = 0; i < count; ++i) {
+        r->replacement_len[i] = strlen(replacements[i]);
+        r->replacements[i] = text;
+        memcpy(text, replacements[i], r->replacement_len[i] + 1);
+        text += r->replacement_len[i] + 1;
+    }
+    return r;
+}
+
+size_t fossil_media_text_replacer_apply(const fossil_media_text_replacer_t *r, const char *str,
+                                        char *out, size_t out_size, size_t *count) {
+    text_out_t o = { out, out ? out_size : 0, 0 };
+    size_t n = 0;
+    if (r && str) {
+        size_t len = strlen(str);
+        size_t done = 0, i = 0;    /* source before `done` has been written */
+        size_t cand_start = 0, cand_len = 0;
+        uint32_t cand_pat = 0, s = 0;
+        const text_automaton_t *ac = &r->ac;
+        for (;;) {
+            if (s == 0 && !cand_len) i = text_automaton_skip(ac, str, i, len);
+            if (i < len) {
+                s = text_automaton_step(ac, s, str[i++]);
+                uint32_t m = ac->match[s];
+                if (m && (!cand_len || i - ac->depth[m] <= cand_start)) {
+                    cand_start = i - ac->depth[m];
+                    cand_len = ac->depth[m];
+                    cand_pat = ac->pattern[m];
+                }
+                /* a longer match may still start at or before the candidate */
+                if (!cand_len || i - ac->depth[s] <= cand_start) continue;
+            } else if (!cand_len) {
+                break;
+            }
+            text_put(&o, str + done, cand_start - done);
+            text_put(&o, r->replacements[cand_pat], r->replacement_len[cand_pat]);
+            done = i = cand_start + cand_len;
+            cand_len = 0;
+            s = 0;
+            n++;
+        }
+        text_put(&o, str + done, len - done);
+    }
+    if (count) *count = n;
+    return text_finish(&o);
+}
+
+/* ---------- Substring search ----------
+ *
+ * Candidates are found 16 positions at a time by comparing the needle's
+ * first and last bytes against the haystack (SSE2), and only positions
+ * where both agree are compared in full. Needles that produce many false
+ * candidates, and the last few positions, are handed to Two-Way, which
+ * is linear in the worst case and needs no allocation.
+ */
+
+/* Start of the critical factorization of `n`; `*period` gets its local period */
+static size_t text_critical_factor(const unsigned char *n, size_t m, size_t *period) {
+    size_t best[2], per[2];
+    for (int rev = 0; rev < 2; ++rev) {
+        /* maximal suffix under byte order (rev 0) or its reverse (rev 1) */
+        size_t ms = (size_t)-1, j = 0, k = 1, p = 1;
+        while (j + k < m) {
+            unsigned char a = n[j + k], b = n[ms + k];
+            if (rev ? a > b : a < b) {
+                j += k;
+                k = 1;
+                p = j - ms;
+            } else if (a == b) {
+                if (k != p) {
+                    ++k;
+                } else {
+                    j += p;
+                    k = 1;
+                }
+            } else {
+                ms = j++;
+                k = p = 1;
+            }
+        }
+        best[rev] = ms + 1;
+        per[rev] = p;
+    }
+    int pick = best[1] >= best[0];
+    *period = per[pick];
+    return best[pick];
+}
+
+static const char *text_two_way(const unsigned char *h, size_t len, const unsigned char *n, size_t m) {
+    if (len < m) return NULL;
+    size_t period;
+    size_t split = text_critical_factor(n, m, &period);
+    size_t j = 0;
+    if (memcmp(n, n + period, split) == 0) {
+        /* periodic needle: remember how much of the left part already matched */
+        size_t memory = 0;
+        while (j <= len - m) {
+            size_t i = split > memory ? split : memory;
+            while (i < m && n[i] == h[i + j]) ++i;
+            if (i < m) {
+                j += i - split + 1;
+                memory = 0;
+                continue;
+            }
+            i = split;
+            while (i > memory && n[i - 1] == h[i - 1 + j]) --i;
+            if (i <= memory) return (const char*)h + j;
+            j += period;
+            memory = m - period;
+        }
+    } else {
+        period = (split > m - split ? split : m - split) + 1;
+        while (j <= len - m) {
+            size_t i = split;
+            while (i < m && n[i] == h[i + j]) ++i;
+            if (i < m) {
+                j += i - split + 1;
+                continue;
+            }
+            i = split;
+            while (i > 0 && n[i - 1] == h[i - 1 + j]) --i;
+            if (i == 0) return (const char*)h + j;
+            j += period;
+        }
+    }
+    return NULL;
+}
+
+/* False candidates tolerated per 16 bytes scanned before switching to Two-Way */
+#define TEXT_FILTER_SLACK 64
+
+const char *fossil_media_text_find_n(const char *haystack, size_t len, const char *needle, size_t needle_len) {
+    if (!needle || (!haystack && len)) return NULL;
+    if (needle_len == 0) return haystack;
+    if (needle_len > len) return NULL;
+    if (needle_len == 1) return (const char*)memchr(haystack, needle[0], len);
+
+    const unsigned char *h = (const unsigned char*)haystack;
+    const unsigned char *n = (const unsigned char*)needle;
+    size_t i = 0;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    size_t last = needle_len - 1, misses = 0;
+    __m128i first_byte = _mm_set1_epi8((char)n[0]);
+    __m128i last_byte = _mm_set1_epi8((char)n[last]);
+    for (; i + 16 <= len - last; i += 16) {
+        __m128i a = _mm_cmpeq_epi8(first_byte, _mm_loadu_si128((const __m128i*)(h + i)));
+        __m128i b = _mm_cmpeq_epi8(last_byte, _mm_loadu_si128((const __m128i*)(h + i + last)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(a, b));
+        while (mask) {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+#else
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+#endif
+            if (memcmp(h + i + bit + 1, n + 1, needle_len - 2) == 0) return haystack + i + bit;
+            mask &= mask - 1;
+            misses++;
+        }
+        if (misses > TEXT_FILTER_SLACK + i / 16) break;
+    }
+#endif
+    return text_two_way(h + i, len - i, n, needle_len);
 }
 
 char *fossil_media_text_find(const char *haystack, const char *needle) {
     if (!haystack || !needle) return NULL;
-    return strstr(haystack, needle);
+    return (char*)fossil_media_text_find_n(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+/* ---------- Multi-needle search ---------- */
+
+struct fossil_media_text_searcher {
+    text_automaton_t ac;
+};
+
+fossil_media_text_searcher_t *fossil_media_text_searcher_new(const char *const *needles, const size_t *lengths,
+                                                             size_t count) {
+    if (!needles || count == 0) return NULL;
+    fossil_media_text_searcher_t *s = (fossil_media_text_searcher_t*)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+    if (text_automaton_build(&s->ac, needles, lengths, count)) {
+        free(s);
+        return NULL;
+    }
+    return s;
+}
+
+size_t fossil_media_text_searcher_find(const fossil_media_text_searcher_t *searcher, const char *text, size_t len,
+                                       fossil_media_text_match_fn fn, void *user) {
+    if (!searcher || (!text && len)) return 0;
+    const text_automaton_t *ac = &searcher->ac;
+    size_t found = 0, i = 0;
+    uint32_t s = 0;
+    while (i < len) {
+        if (s == 0 && (i = text_automaton_skip(ac, text, i, len)) == len) break;
+        s = text_automaton_step(ac, s, text[i++]);
+        for (uint32_t m = ac->match[s]; m; m = ac->match[ac->fail[m]]) {
+            found++;
+            if (fn && fn(user, i - ac->depth[m], ac->depth[m], ac->pattern[m])) return found;
+        }
+    }
+    return found;
+}
+
+void fossil_media_text_searcher_free(fossil_media_text_searcher_t *searcher) {
+    if (!searcher) return;
+    text_automaton_free(&searcher->ac);
+    free(searcher);
 }
 
 size_t fossil_media_text_split(char *str, char delim, char **tokens, size_t max_tokens) {
@@ -117,3 +893,38 @@ size_t fossil_media_text_split(char *str, char delim, char **tokens, size_t max_
     }
     return count;
 }
+
+int fossil_media_text_split_init(fossil_media_text_split_iter_t *it, const char *str, size_t len,
+                                 const char *delim, size_t delim_len) {
+    if (!it || (!str && len) || !delim || delim_len == 0) return -1;
+    it->str = str ? str : "";
+    it->len = len;
+    it->pos = 0;
+    it->delim = delim;
+    it->delim_len = delim_len;
+    it->any = 0;
+    return 0;
+}
+
+int fossil_media_text_split_any_init(fossil_media_text_split_iter_t *it, const char *str, size_t len,
+                                     const char *set) {
+    if (!set || !*set) return -1;
+    if (fossil_media_text_split_init(it, str, len, set, strlen(set)) != 0) return -1;
+    it->any = 1;
+    return 0;
+}
+
+int fossil_media_text_split_next(fossil_media_text_split_iter_t *it, const char **token, size_t *token_len) {
+    if (!it || it->pos > it->len) return 0;
+    const char *start = it->str + it->pos;
+    size_t rest = it->len - it->pos;
+    const char *hit;
+    if (it->any) hit = fossil_media_find_any(start, rest, it->delim);
+    else if (it->delim_len == 1) hit = memchr(start, it->delim[0], rest);
+    else hit = fossil_media_text_find_n(start, rest, it->delim, it->delim_len);
+    size_t n = hit ? (size_t)(hit - start) : rest;
+    it->pos += hit ? n + (it->any ? 1 : it->delim_len) : rest + 1;
+    if (token) *token = start;
+    if (token_len) *token_len = n;
+    return 1;
+}
@@ -24,101 +24,990 @@
  */
 #include "fossil/media/toml.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
-/* Trim whitespace in-place */
-static char *trim_whitespace(char *str) {
-    while (isspace((unsigned char)*str)) str++;
-    if (*str == 0) return str;
-    char *end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    *(end + 1) = '\0';
-    return str;
+/* ---------------------------------------------------------------------------
+ * Parser
+ *
+ * A single pass over the input with all state in toml_parser_t. Strings are
+ * decoded into a scratch buffer owned by the parser and copied out once the
+ * value is complete; numbers, booleans and date-times are converted as they
+ * are read. Everything the document keeps is allocated from the arena of its
+ * fossil_media_toml_doc_t and released at once by fossil_media_toml_free().
+ * ------------------------------------------------------------------------- */
+
+#define TOML_MAX_DEPTH 128
+
+typedef struct {
+    const char *p;
+    const char *end;
+    int depth;
+    int error;
+    fossil_media_buffer_t scratch;  /* decoded string of the value being read */
+    fossil_media_buffer_t key;      /* dotted key of the statement being read */
+    fossil_media_arena_t *arena;    /* storage of the document being built */
+} toml_parser_t;
+
+/* Key index slot: fully-qualified dotted name to entry */
+typedef struct {
+    const char *name;
+    size_t len;
+    uint64_t hash;
+    const fossil_media_toml_entry_t *entry;
+    const fossil_media_toml_table_t *table; /* header table holding the entry, NULL inside inline tables */
+} toml_slot_t;
+
+struct fossil_media_toml_doc {
+    fossil_media_arena_t arena;
+    toml_slot_t *slots;
+    size_t mask;
+};
+
+struct fossil_media_toml_key {
+    size_t len;
+    uint64_t hash;
+    char name[];
+};
+
+static void value_free(fossil_media_toml_value_t *v);
+
+static int is_bare_key_char(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
 }
 
-/* Remove inline comment from a line */
-static void remove_inline_comment(char *str) {
-    char *hash = strchr(str, '#');
-    if (hash) *hash = '\0';
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
 }
 
-/* Internal function to add a new table */
-static fossil_media_toml_table_t *add_table(fossil_media_toml_t *toml, const char *name) {
-    toml->tables = realloc(toml->tables, sizeof(fossil_media_toml_table_t) * (toml->table_count + 1));
-    fossil_media_toml_table_t *table = &toml->tables[toml->table_count++];
-    table->name = name ? fossil_media_strdup(name) : NULL;
-    table->entries = NULL;
-    table->entry_count = 0;
-    return table;
+static int at(const toml_parser_t *tp, const char *s) {
+    size_t n = strlen(s);
+    return (size_t)(tp->end - tp->p) >= n && memcmp(tp->p, s, n) == 0;
 }
 
-/* Internal function to add entry to a table */
-static void add_entry(fossil_media_toml_table_t *table, const char *key, const char *value) {
-    table->entries = realloc(table->entries, sizeof(fossil_media_toml_entry_t) * (table->entry_count + 1));
-    fossil_media_toml_entry_t *entry = &table->entries[table->entry_count++];
-    entry->key = fossil_media_strdup(key);
-    entry->value = fossil_media_strdup(value);
+static void skip_ws(toml_parser_t *tp) {
+    while (tp->p < tp->end && (*tp->p == ' ' || *tp->p == '\t')) tp->p++;
 }
 
-/* Parse a TOML value, handling quoted strings and numbers */
-static char *parse_value(char *value) {
-    value = trim_whitespace(value);
-    size_t len = strlen(value);
-    if (len >= 2 && value[0] == '"' && value[len - 1] == '"') {
-        value[len - 1] = '\0';
-        value++;
+static void skip_comment(toml_parser_t *tp) {
+    if (tp->p < tp->end && *tp->p == '#') {
+        const char *nl = (const char*)memchr(tp->p, '\n', (size_t)(tp->end - tp->p));
+        tp->p = nl ? nl : tp->end;
     }
-    return value;
 }
 
-int fossil_media_toml_parse(const char *input, fossil_media_toml_t *out_toml) {
-    memset(out_toml, 0, sizeof(*out_toml));
+static int at_newline(const toml_parser_t *tp) {
+    return tp->p < tp->end && (*tp->p == '\n' || (*tp->p == '\r' && tp->p + 1 < tp->end && tp->p[1] == '\n'));
+}
+
+static void skip_newline(toml_parser_t *tp) {
+    tp->p += *tp->p == '\r' ? 2 : 1;
+}
+
+/* Whitespace, newlines and comments (inside arrays) */
+static void skip_ws_lines(toml_parser_t *tp) {
+    for (;;) {
+        skip_ws(tp);
+        skip_comment(tp);
+        if (!at_newline(tp)) return;
+        skip_newline(tp);
+    }
+}
+
+/* End of a statement: optional comment, then a newline or the end of input */
+static int expect_eol(toml_parser_t *tp) {
+    skip_ws(tp);
+    skip_comment(tp);
+    if (tp->p >= tp->end) return 0;
+    if (!at_newline(tp)) return -1;
+    skip_newline(tp);
+    return 0;
+}
+
+static int put(fossil_media_buffer_t *buf, const char *s, size_t n) {
+    return fossil_media_sink_buffer(buf, s, n);
+}
+
+static int put_utf8(fossil_media_buffer_t *buf, uint32_t cp) {
+    char out[4];
+    return put(buf, out, fossil_media_utf8_encode(cp, out));
+}
 
-    char *data = fossil_media_strdup(input);
-    char *line = strtok(data, "\n");
-    fossil_media_toml_table_t *current_table = add_table(out_toml, NULL);
+/* --- Strings --- */
 
-    while (line) {
-        remove_inline_comment(line);
-        char *trimmed = trim_whitespace(line);
+static int parse_escape(toml_parser_t *tp, fossil_media_buffer_t *out) {
+    /* cursor on the character after the backslash */
+    if (tp->p >= tp->end) return -1;
+    char c = *tp->p++;
+    int digits = 0;
+    switch (c) {
+        case 'b': return put(out, "\b", 1);
+        case 't': return put(out, "\t", 1);
+        case 'n': return put(out, "\n", 1);
+        case 'f': return put(out, "\f", 1);
+        case 'r': return put(out, "\r", 1);
+        case 'e': return put(out, "\x1B", 1);
+        case '"': return put(out, "\"", 1);
+        case '\\': return put(out, "\\", 1);
+        case 'x': digits = 2; break;
+        case 'u': digits = 4; break;
+        case 'U': digits = 8; break;
+        default: return -1;
+    }
+    uint32_t cp = 0;
+    for (int i = 0; i < digits; ++i, ++tp->p) {
+        if (tp->p >= tp->end) return -1;
+        char h = *tp->p;
+        uint32_t d;
+        if (h >= '0' && h <= '9') d = (uint32_t)(h - '0');
+        else if (h >= 'a' && h <= 'f') d = (uint32_t)(h - 'a' + 10);
+        else if (h >= 'A' && h <= 'F') d = (uint32_t)(h - 'A' + 10);
+        else return -1;
+        cp = cp * 16 + d;
+    }
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return -1;
+    return put_utf8(out, cp);
+}
 
-        if (*trimmed == '\0') {
-            line = strtok(NULL, "\n");
+/*
+ * Basic ("..."), literal ('...') and their multi-line forms. The decoded
+ * text is appended to `out`, which the caller resets.
+ */
+static int parse_string(toml_parser_t *tp, fossil_media_buffer_t *out, int allow_multiline) {
+    char quote = *tp->p;
+    int basic = quote == '"';
+    int multiline = allow_multiline && at(tp, basic ? "\"\"\"" : "'''");
+    tp->p += multiline ? 3 : 1;
+    if (multiline && at_newline(tp)) skip_newline(tp); /* newline after the opening delimiter is trimmed */
+
+    const char *run = tp->p;
+    while (tp->p < tp->end) {
+        char c = *tp->p;
+        if (c == quote) {
+            if (!multiline) {
+                if (put(out, run, (size_t)(tp->p - run))) return -1;
+                tp->p++;
+                return 0;
+            }
+            if (at(tp, basic ? "\"\"\"" : "'''")) {
+                /* up to two more quotes may belong to the content */
+                size_t extra = 0;
+                while (extra < 2 && tp->p + 3 + extra < tp->end && tp->p[3 + extra] == quote) extra++;
+                if (put(out, run, (size_t)(tp->p - run) + extra)) return -1;
+                tp->p += 3 + extra;
+                return 0;
+            }
+            tp->p++;
             continue;
         }
+        if (c == '\n' && !multiline) return -1;
+        if (basic && c == '\\') {
+            if (put(out, run, (size_t)(tp->p - run))) return -1;
+            tp->p++;
+            if (multiline) {
+                /* line-ending backslash trims the break and following whitespace */
+                const char *q = tp->p;
+                while (q < tp->end && (*q == ' ' || *q == '\t')) q++;
+                if (q < tp->end && (*q == '\n' || *q == '\r')) {
+                    tp->p = q;
+                    while (tp->p < tp->end && (*tp->p == ' ' || *tp->p == '\t' || *tp->p == '\n' || *tp->p == '\r'))
+                        tp->p++;
+                    run = tp->p;
+                    continue;
+                }
+            }
+            if (parse_escape(tp, out)) return -1;
+            run = tp->p;
+            continue;
+        }
+        if ((unsigned char)c < 0x20 && c != '\t' && !(multiline && (c == '\n' || c == '\r'))) return -1;
+        tp->p++;
+    }
+    return -1; /* unterminated */
+}
+
+/* --- Keys ---
+ *
+ * Keys are kept in one canonical spelling: parts joined by '.', each part
+ * bare when it can be and otherwise a basic string, so `site."google.com"`
+ * and `'site'.'google.com'` are the same key and never `site.google.com`.
+ */
+
+/* Escape sequence for a byte a basic string cannot hold as-is; 0 if it can */
+static size_t escape_byte(unsigned char c, char out[8]) {
+    if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7F) return 0;
+    switch (c) {
+        case '"':  memcpy(out, "\\\"", 2); return 2;
+        case '\\': memcpy(out, "\\\\", 2); return 2;
+        case '\b': memcpy(out, "\\b", 2); return 2;
+        case '\t': memcpy(out, "\\t", 2); return 2;
+        case '\n': memcpy(out, "\\n", 2); return 2;
+        case '\f': memcpy(out, "\\f", 2); return 2;
+        case '\r': memcpy(out, "\\r", 2); return 2;
+        default:   snprintf(out, 8, "\\u%04X", c); return 6;
+    }
+}
+
+static int is_bare_key(const char *s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (!is_bare_key_char(s[i])) return 0;
+    }
+    return n > 0;
+}
+
+/* Append one key part in its canonical spelling */
+static int put_key_part(fossil_media_buffer_t *buf, const char *s, size_t n) {
+    if (is_bare_key(s, n)) return put(buf, s, n);
+    if (put(buf, "\"", 1)) return -1;
+    size_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        char esc[8];
+        size_t e = escape_byte((unsigned char)s[i], esc);
+        if (!e) continue;
+        if (put(buf, s + run, i - run) || put(buf, esc, e)) return -1;
+        run = i + 1;
+    }
+    if (put(buf, s + run, n - run)) return -1;
+    return put(buf, "\"", 1);
+}
+
+/* End of the quoted key part at `s`, or NULL when `s` does not start one */
+static const char *quoted_part_end(const char *s) {
+    if (*s != '"') return NULL;
+    for (const char *q = s + 1; *q; ++q) {
+        if (*q == '\\' && q[1]) {
+            ++q;
+        } else if (*q == '"') {
+            return q[1] == '.' || q[1] == '\0' ? q + 1 : NULL;
+        }
+    }
+    return NULL;
+}
+
+/* End of the key part at `s`; names built by hand that only look quoted are bare */
+static const char *key_part_end(const char *s) {
+    const char *q = quoted_part_end(s);
+    if (q) return q;
+    const char *dot = strchr(s, '.');
+    return dot ? dot : s + strlen(s);
+}
+
+/* Simple or dotted key, normalized into tp->key in its canonical spelling */
+static int parse_key(toml_parser_t *tp) {
+    tp->key.len = 0;
+    for (;;) {
+        skip_ws(tp);
+        if (tp->p >= tp->end) return -1;
+        if (*tp->p == '"' || *tp->p == '\'') {
+            /* no value is being read yet, so the scratch buffer is free */
+            tp->scratch.len = 0;
+            if (parse_string(tp, &tp->scratch, 0)) return -1;
+            if (put_key_part(&tp->key, tp->scratch.data ? tp->scratch.data : "", tp->scratch.len)) return -1;
+        } else {
+            const char *s = tp->p;
+            while (tp->p < tp->end && is_bare_key_char(*tp->p)) tp->p++;
+            if (tp->p == s || put(&tp->key, s, (size_t)(tp->p - s))) return -1;
+        }
+        skip_ws(tp);
+        if (tp->p >= tp->end || *tp->p != '.') break;
+        tp->p++;
+        if (put(&tp->key, ".", 1)) return -1;
+    }
+    return put(&tp->key, "", 0); /* keep it null-terminated */
+}
+
+/* --- Numbers and date-times --- */
 
-        if (*trimmed == '[' && trimmed[strlen(trimmed) - 1] == ']') {
-            trimmed[strlen(trimmed) - 1] = '\0';
-            char *table_name = trim_whitespace(trimmed + 1);
-            current_table = add_table(out_toml, table_name);
+static int scan_digits(const char **q, const char *end, int n, int *out) {
+    int v = 0;
+    for (int i = 0; i < n; ++i, ++*q) {
+        if (*q >= end || !is_digit(**q)) return -1;
+        v = v * 10 + (**q - '0');
+    }
+    *out = v;
+    return 0;
+}
+
+static int parse_time_part(const char **q, const char *end, fossil_media_toml_datetime_t *dt) {
+    if (scan_digits(q, end, 2, &dt->hour) || *q >= end || **q != ':' ||
+        (++*q, scan_digits(q, end, 2, &dt->minute))) return -1;
+    dt->second = 0;
+    if (*q < end && **q == ':') {
+        ++*q;
+        if (scan_digits(q, end, 2, &dt->second)) return -1;
+        if (*q < end && **q == '.') {
+            ++*q;
+            int32_t ns = 0, scale = 100000000;
+            if (*q >= end || !is_digit(**q)) return -1;
+            for (; *q < end && is_digit(**q); ++*q) {
+                ns += (int32_t)(**q - '0') * scale;
+                scale /= 10;
+            }
+            dt->nanosecond = ns;
         }
-        else {
-            char *eq = strchr(trimmed, '=');
-            if (eq) {
-                *eq = '\0';
-                char *key = trim_whitespace(trimmed);
-                char *value = parse_value(eq + 1);
-                add_entry(current_table, key, value);
+    }
+    if (dt->hour > 23 || dt->minute > 59 || dt->second > 60) return -1;
+    dt->has_time = 1;
+    return 0;
+}
+
+static int days_in_month(int year, int month) {
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) return 29;
+    return days[month - 1];
+}
+
+/* Date-time at the cursor; returns 1 if one was parsed, 0 if the token is not a date-time, -1 on error */
+static int parse_datetime(toml_parser_t *tp, fossil_media_toml_datetime_t *dt) {
+    const char *q = tp->p, *end = tp->end;
+    memset(dt, 0, sizeof(*dt));
+    int is_date = end - q >= 10 && is_digit(q[0]) && is_digit(q[3]) && q[4] == '-' && q[7] == '-';
+    int is_time = end - q >= 5 && is_digit(q[0]) && is_digit(q[1]) && q[2] == ':';
+    if (!is_date && !is_time) return 0;
+
+    if (is_date) {
+        if (scan_digits(&q, end, 4, &dt->year) || *q++ != '-' || scan_digits(&q, end, 2, &dt->month) ||
+            *q++ != '-' || scan_digits(&q, end, 2, &dt->day)) return -1;
+        if (dt->month < 1 || dt->month > 12 || dt->day < 1 || dt->day > days_in_month(dt->year, dt->month))
+            return -1;
+        dt->has_date = 1;
+        /* 'T', 't' or a space followed by a time */
+        if (q < end && (*q == 'T' || *q == 't' || (*q == ' ' && end - q > 3 && is_digit(q[1]) && q[3] == ':'))) {
+            ++q;
+            if (parse_time_part(&q, end, dt)) return -1;
+            if (q < end && (*q == 'Z' || *q == 'z')) {
+                ++q;
+                dt->has_offset = 1;
+            } else if (q < end && (*q == '+' || *q == '-')) {
+                int sign = *q++ == '-' ? -1 : 1, oh, om;
+                if (scan_digits(&q, end, 2, &oh) || q >= end || *q++ != ':' || scan_digits(&q, end, 2, &om) ||
+                    oh > 23 || om > 59) return -1;
+                dt->offset_minutes = (int16_t)(sign * (oh * 60 + om));
+                dt->has_offset = 1;
             }
         }
+    } else if (parse_time_part(&q, end, dt)) {
+        return -1;
+    }
+    tp->p = q;
+    return 1;
+}
+
+/* Digits with single underscores between them, in the given base */
+static int scan_int_digits(const char **q, const char *end, int base, uint64_t *out, int *overflow) {
+    uint64_t v = 0;
+    int count = 0, prev_underscore = 0;
+    for (; *q < end; ++*q) {
+        char c = **q;
+        int d;
+        if (c == '_') {
+            if (!count || prev_underscore) return -1;
+            prev_underscore = 1;
+            continue;
+        }
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else break;
+        if (d >= base) break;
+        if (v > (UINT64_MAX - (uint64_t)d) / (uint64_t)base) *overflow = 1;
+        v = v * (uint64_t)base + (uint64_t)d;
+        count++;
+        prev_underscore = 0;
+    }
+    if (!count || prev_underscore) return -1;
+    *out = v;
+    return 0;
+}
+
+static int parse_number(toml_parser_t *tp, fossil_media_toml_value_t *out) {
+    const char *q = tp->p, *end = tp->end;
+    int negative = 0, has_sign = 0;
+    if (q < end && (*q == '+' || *q == '-')) {
+        negative = *q == '-';
+        has_sign = 1;
+        q++;
+    }
+
+    if (end - q >= 3 && (memcmp(q, "inf", 3) == 0 || memcmp(q, "nan", 3) == 0)) {
+        out->type = FOSSIL_MEDIA_TOML_FLOAT;
+        out->as.floating = q[0] == 'i' ? (negative ? -HUGE_VAL : HUGE_VAL) : NAN;
+        tp->p = q + 3;
+        return 0;
+    }
 
-        line = strtok(NULL, "\n");
+    int overflow = 0;
+    uint64_t mag;
+    if (!has_sign && end - q >= 2 && q[0] == '0' && (q[1] == 'x' || q[1] == 'o' || q[1] == 'b')) {
+        int base = q[1] == 'x' ? 16 : q[1] == 'o' ? 8 : 2;
+        q += 2;
+        if (scan_int_digits(&q, end, base, &mag, &overflow) || overflow || mag > (uint64_t)INT64_MAX) return -1;
+        out->type = FOSSIL_MEDIA_TOML_INTEGER;
+        out->as.integer = (int64_t)mag;
+        tp->p = q;
+        return 0;
     }
 
-    free(data);
+    /* decimal: copy the digits without underscores for strtod */
+    const char *start = q;
+    if (q >= end || !is_digit(*q)) return -1;
+    if (*q == '0' && q + 1 < end && (is_digit(q[1]) || q[1] == '_')) return -1; /* no leading zeros */
+    if (scan_int_digits(&q, end, 10, &mag, &overflow)) return -1;
+    int is_float = 0;
+    if (q < end && *q == '.') {
+        uint64_t frac;
+        int ignored = 0;
+        q++;
+        if (scan_int_digits(&q, end, 10, &frac, &ignored)) return -1;
+        is_float = 1;
+    }
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        uint64_t exp;
+        int ignored = 0;
+        q++;
+        if (q < end && (*q == '+' || *q == '-')) q++;
+        if (scan_int_digits(&q, end, 10, &exp, &ignored)) return -1;
+        is_float = 1;
+    }
+
+    if (!is_float) {
+        if (overflow || mag > (uint64_t)INT64_MAX + (negative ? 1u : 0u)) return -1;
+        out->type = FOSSIL_MEDIA_TOML_INTEGER;
+        out->as.integer = negative ? (int64_t)(0 - mag) : (int64_t)mag;
+        tp->p = q;
+        return 0;
+    }
+
+    char digits[128];
+    size_t n = 0;
+    for (const char *r = start; r < q; ++r) {
+        if (*r == '_') continue;
+        if (n + 1 >= sizeof(digits)) return -1;
+        digits[n++] = *r;
+    }
+    digits[n] = '\0';
+    double v = strtod(digits, NULL);
+    out->type = FOSSIL_MEDIA_TOML_FLOAT;
+    out->as.floating = negative ? -v : v;
+    tp->p = q;
     return 0;
 }
 
-const char *fossil_media_toml_get(const fossil_media_toml_t *toml, const char *table_name, const char *key) {
+/* --- Values --- */
+
+static char *copy_text(toml_parser_t *tp, const char *s, size_t n) {
+    return fossil_media_arena_strndup(tp->arena, s, n);
+}
+
+static int parse_value(toml_parser_t *tp, fossil_media_toml_value_t *out);
+
+/*
+ * Make room for one more element of an arena array. The capacity is the
+ * next power of two at or above the count (at least 4), so the array moves
+ * only when the count reaches a power of two; the copies left behind add up
+ * to less than the final array.
+ */
+static void *arena_grow(toml_parser_t *tp, void *items, size_t count, size_t size) {
+    if (count && (count < 4 || (count & (count - 1)))) return items;
+    size_t cap = count ? count * 2 : 4;
+    void *grown = fossil_media_arena_alloc(tp->arena, cap * size);
+    if (grown && count) memcpy(grown, items, count * size);
+    return grown;
+}
+
+/* Add one entry to an entry array */
+static fossil_media_toml_entry_t *entries_push(toml_parser_t *tp, fossil_media_toml_entry_t **entries, size_t *count) {
+    fossil_media_toml_entry_t *grown = (fossil_media_toml_entry_t*)arena_grow(tp, *entries, *count, sizeof(*grown));
+    if (!grown) return NULL;
+    *entries = grown;
+    fossil_media_toml_entry_t *e = &grown[(*count)++];
+    memset(e, 0, sizeof(*e));
+    return e;
+}
+
+/* Text form of a value for the `value` field: decoded strings, source text otherwise */
+static char *value_text(toml_parser_t *tp, const fossil_media_toml_value_t *v, const char *src, size_t len) {
+    if (v->type == FOSSIL_MEDIA_TOML_STRING) return v->as.string.data; /* both are read-only */
+    return copy_text(tp, src, len);
+}
+
+/* Parse `key = value` at the cursor into a new entry */
+static int parse_keyval(toml_parser_t *tp, fossil_media_toml_entry_t **entries, size_t *count) {
+    if (parse_key(tp)) return -1;
+    skip_ws(tp);
+    if (tp->p >= tp->end || *tp->p != '=') return -1;
+    tp->p++;
+    skip_ws(tp);
+
+    fossil_media_toml_entry_t *e = entries_push(tp, entries, count);
+    if (!e || !(e->key = copy_text(tp, tp->key.data, tp->key.len))) return -1;
+    const char *src = tp->p;
+    if (parse_value(tp, &e->typed)) return -1;
+    e->value = value_text(tp, &e->typed, src, (size_t)(tp->p - src));
+    return e->value ? 0 : -1;
+}
+
+static int parse_array(toml_parser_t *tp, fossil_media_toml_value_t *out) {
+    out->type = FOSSIL_MEDIA_TOML_ARRAY;
+    tp->p++; /* '[' */
+    for (;;) {
+        skip_ws_lines(tp);
+        if (tp->p >= tp->end) return -1;
+        if (*tp->p == ']') {
+            tp->p++;
+            return 0;
+        }
+        fossil_media_toml_value_t *grown = (fossil_media_toml_value_t*)arena_grow(
+            tp, out->as.array.items, out->as.array.count, sizeof(*grown));
+        if (!grown) return -1;
+        out->as.array.items = grown;
+        fossil_media_toml_value_t *item = &out->as.array.items[out->as.array.count++];
+        memset(item, 0, sizeof(*item));
+        if (parse_value(tp, item)) return -1;
+        skip_ws_lines(tp);
+        if (tp->p < tp->end && *tp->p == ',') tp->p++;
+        else if (tp->p >= tp->end || *tp->p != ']') return -1;
+    }
+}
+
+static int parse_inline_table(toml_parser_t *tp, fossil_media_toml_value_t *out) {
+    out->type = FOSSIL_MEDIA_TOML_TABLE;
+    tp->p++; /* '{' */
+    skip_ws(tp);
+    if (tp->p < tp->end && *tp->p == '}') {
+        tp->p++;
+        return 0;
+    }
+    for (;;) {
+        if (parse_keyval(tp, &out->as.table.entries, &out->as.table.count)) return -1;
+        skip_ws(tp);
+        if (tp->p >= tp->end) return -1;
+        if (*tp->p == '}') {
+            tp->p++;
+            return 0;
+        }
+        if (*tp->p != ',') return -1;
+        tp->p++;
+    }
+}
+
+static int parse_value(toml_parser_t *tp, fossil_media_toml_value_t *out) {
+    if (tp->p >= tp->end) return -1;
+    if (++tp->depth > TOML_MAX_DEPTH) return -1;
+    int rc = -1;
+    char c = *tp->p;
+    if (c == '"' || c == '\'') {
+        tp->scratch.len = 0;
+        if (parse_string(tp, &tp->scratch, 1) == 0 && put(&tp->scratch, "", 0) == 0) {
+            out->type = FOSSIL_MEDIA_TOML_STRING;
+            out->as.string.length = tp->scratch.len;
+            out->as.string.data = copy_text(tp, tp->scratch.data, tp->scratch.len);
+            rc = out->as.string.data ? 0 : -1;
+        }
+    } else if (c == '[') {
+        rc = parse_array(tp, out);
+    } else if (c == '{') {
+        rc = parse_inline_table(tp, out);
+    } else if (at(tp, "true") && !(tp->p + 4 < tp->end && is_bare_key_char(tp->p[4]))) {
+        out->type = FOSSIL_MEDIA_TOML_BOOLEAN;
+        out->as.boolean = 1;
+        tp->p += 4;
+        rc = 0;
+    } else if (at(tp, "false") && !(tp->p + 5 < tp->end && is_bare_key_char(tp->p[5]))) {
+        out->type = FOSSIL_MEDIA_TOML_BOOLEAN;
+        out->as.boolean = 0;
+        tp->p += 5;
+        rc = 0;
+    } else {
+        int dt = parse_datetime(tp, &out->as.datetime);
+        if (dt > 0) {
+            out->type = FOSSIL_MEDIA_TOML_DATETIME;
+            rc = 0;
+        } else if (dt == 0) {
+            rc = parse_number(tp, out);
+        }
+        /* a number or date-time must end at a delimiter */
+        if (rc == 0 && tp->p < tp->end && !strchr(" \t\r\n#,]}", *tp->p)) rc = -1;
+        if (rc != 0) memset(out, 0, sizeof(*out)); /* nothing owned; leave it safe to free */
+    }
+    tp->depth--;
+    return rc;
+}
+
+/* --- Document --- */
+
+/* Internal function to add a new table */
+static fossil_media_toml_table_t *add_table(toml_parser_t *tp, fossil_media_toml_t *toml, const char *name, size_t len) {
+    fossil_media_toml_table_t *grown = (fossil_media_toml_table_t*)arena_grow(tp, toml->tables, toml->table_count, sizeof(*grown));
+    if (!grown) return NULL;
+    toml->tables = grown;
+    fossil_media_toml_table_t *table = &grown[toml->table_count++];
+    memset(table, 0, sizeof(*table));
+    if (name && !(table->name = copy_text(tp, name, len))) return NULL;
+    return table;
+}
+
+/* `[name]` or `[[name]]` header at the cursor */
+static int parse_header(toml_parser_t *tp, fossil_media_toml_t *toml) {
+    int array = at(tp, "[[");
+    tp->p += array ? 2 : 1;
+    if (parse_key(tp)) return -1;
+    skip_ws(tp);
+    if (!at(tp, array ? "]]" : "]")) return -1;
+    tp->p += array ? 2 : 1;
+    fossil_media_toml_table_t *table = add_table(tp, toml, tp->key.data, tp->key.len);
+    if (!table) return -1;
+    table->array_element = array;
+    return expect_eol(tp);
+}
+
+/* --- Key index ---
+ *
+ * Open addressing over the fully-qualified dotted name of every entry, built
+ * once the whole document has been read. Tables defined by `[[name]]` are
+ * numbered through a second, smaller table of counters keyed by their
+ * qualified name.
+ */
+
+typedef struct {
+    const char *name;
+    size_t len;
+    uint64_t hash;
+    size_t next; /* elements seen so far */
+    int array;   /* named by `[[name]]`; otherwise by one `[name]` */
+} toml_counter_t;
+
+/* `entry` is NULL for the name of a header table, reported in strict walks only */
+typedef int (*toml_visit_t)(void *user, const char *name, size_t len,
+                            const fossil_media_toml_entry_t *entry, const fossil_media_toml_table_t *table);
+
+typedef struct {
+    fossil_media_arena_t *arena; /* counter storage */
+    toml_counter_t *counters;
+    size_t counter_mask;
+    fossil_media_buffer_t name; /* qualified name being built */
+    toml_visit_t visit;
+    void *user;
+    int strict;                 /* parsed input: a table may only be defined once */
+} toml_indexer_t;
+
+static uint64_t toml_hash_update(uint64_t h, const char *s, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t toml_hash_final(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint64_t toml_hash(const char *s, size_t n) {
+    return toml_hash_final(toml_hash_update(14695981039346656037ULL, s, n));
+}
+
+/* Power-of-two slot count keeping the load at or below one half */
+static size_t slots_for(size_t count) {
+    size_t cap = 8;
+    while (cap < count * 2) cap *= 2;
+    return cap;
+}
+
+static size_t count_value(const fossil_media_toml_value_t *v);
+
+static size_t count_entries(const fossil_media_toml_entry_t *entries, size_t count) {
+    size_t n = count;
+    for (size_t i = 0; i < count; ++i) n += count_value(&entries[i].typed);
+    return n;
+}
+
+static size_t count_value(const fossil_media_toml_value_t *v) {
+    size_t n = 0;
+    if (v->type == FOSSIL_MEDIA_TOML_TABLE) {
+        n = count_entries(v->as.table.entries, v->as.table.count);
+    } else if (v->type == FOSSIL_MEDIA_TOML_ARRAY) {
+        for (size_t i = 0; i < v->as.array.count; ++i) n += count_value(&v->as.array.items[i]);
+    }
+    return n;
+}
+
+typedef struct {
+    fossil_media_toml_doc_t *doc;
+    const char **headers;   /* qualified names of header tables, checked once all keys are in */
+    size_t header_count;
+} toml_builder_t;
+
+static int index_insert(void *user, const char *name, size_t len,
+                        const fossil_media_toml_entry_t *entry, const fossil_media_toml_table_t *table) {
+    toml_builder_t *b = (toml_builder_t*)user;
+    fossil_media_toml_doc_t *doc = b->doc;
+    if (!entry) {
+        const char *header = fossil_media_arena_strndup(&doc->arena, name, len);
+        if (!header) return -1;
+        b->headers[b->header_count++] = header;
+        return 0;
+    }
+    uint64_t h = toml_hash(name, len);
+    for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+        toml_slot_t *slot = &doc->slots[i];
+        if (!slot->entry) {
+            if (!(slot->name = fossil_media_arena_strndup(&doc->arena, name, len))) return -1;
+            slot->len = len;
+            slot->hash = h;
+            slot->entry = entry;
+            slot->table = table;
+            return 0;
+        }
+        if (slot->hash == h && slot->len == len && memcmp(slot->name, name, len) == 0) return -1; /* defined twice */
+    }
+}
+
+/* Counter of the array of tables named by the current qualified name */
+static toml_counter_t *index_counter(toml_indexer_t *ix, int create) {
+    uint64_t h = toml_hash(ix->name.data, ix->name.len);
+    for (size_t i = (size_t)h & ix->counter_mask;; i = (i + 1) & ix->counter_mask) {
+        toml_counter_t *c = &ix->counters[i];
+        if (!c->name) {
+            if (!create) return NULL;
+            if (!(c->name = fossil_media_arena_strndup(ix->arena, ix->name.data, ix->name.len))) return NULL;
+            c->len = ix->name.len;
+            c->hash = h;
+            return c;
+        }
+        if (c->hash == h && c->len == ix->name.len && memcmp(c->name, ix->name.data, c->len) == 0) return c;
+    }
+}
+
+static int put_position(fossil_media_buffer_t *name, size_t index) {
+    char digits[32];
+    int n = snprintf(digits, sizeof(digits), "[%zu]", index);
+    return put(name, digits, (size_t)n);
+}
+
+static int index_value(toml_indexer_t *ix, const fossil_media_toml_value_t *v);
+
+static int index_entries(toml_indexer_t *ix, const fossil_media_toml_entry_t *entries, size_t count,
+                         const fossil_media_toml_table_t *table) {
+    size_t base = ix->name.len;
+    for (size_t i = 0; i < count; ++i) {
+        ix->name.len = base;
+        if (base && put(&ix->name, ".", 1)) return -1;
+        if (put(&ix->name, entries[i].key, strlen(entries[i].key))) return -1;
+        if (ix->visit(ix->user, ix->name.data, ix->name.len, &entries[i], table)) return -1;
+        if (index_value(ix, &entries[i].typed)) return -1;
+    }
+    ix->name.len = base;
+    return 0;
+}
+
+static int index_value(toml_indexer_t *ix, const fossil_media_toml_value_t *v) {
+    if (v->type == FOSSIL_MEDIA_TOML_TABLE) return index_entries(ix, v->as.table.entries, v->as.table.count, NULL);
+    if (v->type != FOSSIL_MEDIA_TOML_ARRAY) return 0;
+    size_t base = ix->name.len;
+    for (size_t i = 0; i < v->as.array.count; ++i) {
+        const fossil_media_toml_value_t *item = &v->as.array.items[i];
+        if (item->type != FOSSIL_MEDIA_TOML_TABLE && item->type != FOSSIL_MEDIA_TOML_ARRAY) continue;
+        ix->name.len = base;
+        if (put_position(&ix->name, i) || index_value(ix, item)) return -1;
+    }
+    ix->name.len = base;
+    return 0;
+}
+
+/* Qualified name of a header table: array elements get their position */
+static int index_table_name(toml_indexer_t *ix, const fossil_media_toml_table_t *table) {
+    ix->name.len = 0;
+    if (!table->name) return 0;
+    const char *s = table->name;
+    for (;;) {
+        const char *e = key_part_end(s);
+        if (ix->name.len && put(&ix->name, ".", 1)) return -1;
+        if (put(&ix->name, s, (size_t)(e - s))) return -1;
+        if (!*e) break;
+        toml_counter_t *c = index_counter(ix, 0);
+        if (c && c->array && put_position(&ix->name, c->next - 1)) return -1;
+        s = e + 1;
+    }
+
+    toml_counter_t *c = index_counter(ix, ix->strict || table->array_element);
+    if (table->array_element) {
+        if (!c || (ix->strict && c->next && !c->array)) return -1;
+        c->array = 1;
+        return put_position(&ix->name, c->next++);
+    }
+    if (ix->strict) {
+        if (!c || c->next) return -1; /* `[name]` repeated, or after `[[name]]` */
+        c->next = 1;
+        return 0;
+    }
+    return c && c->array ? put_position(&ix->name, c->next - 1) : 0;
+}
+
+/* Walk every entry of the document in order under its qualified name */
+static int index_walk(const fossil_media_toml_t *toml, fossil_media_arena_t *arena, int strict,
+                      toml_visit_t visit, void *user) {
+    toml_indexer_t ix;
+    memset(&ix, 0, sizeof(ix));
+    ix.arena = arena;
+    ix.visit = visit;
+    ix.user = user;
+    ix.strict = strict;
+    size_t counters = slots_for(toml->table_count);
+    ix.counters = (toml_counter_t*)fossil_media_arena_calloc(arena, counters * sizeof(toml_counter_t));
+    if (!ix.counters) return -1;
+    ix.counter_mask = counters - 1;
+
+    int rc = 0;
+    for (size_t i = 0; i < toml->table_count && rc == 0; ++i) {
+        const fossil_media_toml_table_t *table = &toml->tables[i];
+        rc = index_table_name(&ix, table);
+        if (rc == 0 && strict && table->name) rc = visit(user, ix.name.data, ix.name.len, NULL, table);
+        if (rc == 0) rc = index_entries(&ix, table->entries, table->entry_count, table);
+    }
+    fossil_media_buffer_free(&ix.name);
+    return rc;
+}
+
+static const toml_slot_t *probe(const fossil_media_toml_doc_t *doc, const char *name, size_t len, uint64_t h);
+
+/*
+ * Whether `name` redefines a key: a key may only sit under a table (before
+ * '.') or an array (before '['), and a header may not reopen or extend any
+ * key-value pair.
+ */
+static int index_conflict(const fossil_media_toml_doc_t *doc, const char *name, int header) {
+    uint64_t h = 14695981039346656037ULL;
+    int quoted = 0;
+    size_t i = 0;
+    for (; name[i]; h = toml_hash_update(h, name + i, 1), ++i) {
+        char c = name[i];
+        if (quoted) {
+            if (c == '\\' && name[i + 1]) h = toml_hash_update(h, name + i++, 1);
+            else if (c == '"') quoted = 0;
+            continue;
+        }
+        if (c == '"') quoted = 1;
+        if (i == 0 || (c != '.' && c != '[')) continue;
+        const toml_slot_t *slot = probe(doc, name, i, toml_hash_final(h));
+        if (slot && (header || slot->entry->typed.type != (c == '.' ? FOSSIL_MEDIA_TOML_TABLE
+                                                                     : FOSSIL_MEDIA_TOML_ARRAY))) {
+            return 1;
+        }
+    }
+    return header && probe(doc, name, i, toml_hash_final(h)) != NULL;
+}
+
+static int index_build(fossil_media_toml_t *toml) {
+    fossil_media_toml_doc_t *doc = toml->doc;
+    size_t total = 0;
+    for (size_t i = 0; i < toml->table_count; ++i) {
+        total += count_entries(toml->tables[i].entries, toml->tables[i].entry_count);
+    }
+    size_t slots = slots_for(total);
+    doc->slots = (toml_slot_t*)fossil_media_arena_calloc(&doc->arena, slots * sizeof(toml_slot_t));
+    if (!doc->slots) return -1;
+    doc->mask = slots - 1;
+
+    toml_builder_t b = { doc, NULL, 0 };
+    b.headers = (const char**)fossil_media_arena_calloc(&doc->arena, toml->table_count * sizeof(*b.headers));
+    if (!b.headers || index_walk(toml, &doc->arena, 1, index_insert, &b)) return -1;
+    for (size_t i = 0; i <= doc->mask; ++i) {
+        if (doc->slots[i].entry && index_conflict(doc, doc->slots[i].name, 0)) return -1;
+    }
+    for (size_t i = 0; i < b.header_count; ++i) {
+        if (index_conflict(doc, b.headers[i], 1)) return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    fossil_media_toml_visit_fn fn;
+    void *user;
+    int stopped; /* the walk returns -1 for a stop too; this tells it from an error */
+} toml_foreach_t;
+
+static int foreach_visit(void *user, const char *name, size_t len,
+                         const fossil_media_toml_entry_t *entry, const fossil_media_toml_table_t *table) {
+    (void)table;
+    toml_foreach_t *fe = (toml_foreach_t*)user;
+    if (!fe->fn(fe->user, name, len, entry)) return 0;
+    fe->stopped = 1;
+    return 1;
+}
+
+int fossil_media_toml_foreach(const fossil_media_toml_t *toml, fossil_media_toml_visit_fn fn, void *user) {
+    if (!toml || !fn) return -1;
+    fossil_media_arena_t arena;
+    fossil_media_arena_init(&arena, 0);
+    toml_foreach_t fe = { fn, user, 0 };
+    int rc = index_walk(toml, &arena, 0, foreach_visit, &fe);
+    fossil_media_arena_destroy(&arena);
+    return rc != 0 && !fe.stopped ? -1 : 0;
+}
+
+int fossil_media_toml_parse(const char *input, fossil_media_toml_t *out_toml) {
+    if (!out_toml) return -1;
+    memset(out_toml, 0, sizeof(*out_toml));
+    if (!input) return -1;
+
+    size_t len = strlen(input);
+    fossil_media_toml_doc_t *doc = (fossil_media_toml_doc_t*)calloc(1, sizeof(*doc));
+    if (!doc) return -1;
+    fossil_media_arena_init(&doc->arena, len < 64 * 1024 ? len * 2 + 256 : 128 * 1024);
+    out_toml->doc = doc;
+
+    toml_parser_t tp;
+    memset(&tp, 0, sizeof(tp));
+    tp.p = input;
+    tp.end = input + len;
+    tp.arena = &doc->arena;
+    if (tp.end - tp.p >= 3 && memcmp(tp.p, "\xEF\xBB\xBF", 3) == 0) tp.p += 3; /* BOM */
+
+    int rc = add_table(&tp, out_toml, NULL, 0) ? 0 : -1;
+    while (rc == 0) {
+        skip_ws_lines(&tp);
+        if (tp.p >= tp.end) break;
+        if (*tp.p == '[') {
+            rc = parse_header(&tp, out_toml);
+        } else {
+            fossil_media_toml_table_t *table = &out_toml->tables[out_toml->table_count - 1];
+            rc = parse_keyval(&tp, &table->entries, &table->entry_count);
+            if (rc == 0) rc = expect_eol(&tp);
+        }
+    }
+    if (rc == 0) rc = index_build(out_toml);
+
+    fossil_media_buffer_free(&tp.scratch);
+    fossil_media_buffer_free(&tp.key);
+    if (rc != 0) {
+        fossil_media_toml_free(out_toml);
+        return -1;
+    }
+    return 0;
+}
+
+/* --- Lookups --- */
+
+static int table_named(const fossil_media_toml_table_t *table, const char *table_name) {
+    if (!table_name || !table->name) return !table_name && !table->name;
+    return strcmp(table->name, table_name) == 0;
+}
+
+static const fossil_media_toml_entry_t *scan_entry(const fossil_media_toml_t *toml,
+                                                  const char *table_name, const char *key) {
     for (size_t i = 0; i < toml->table_count; i++) {
         fossil_media_toml_table_t *table = &toml->tables[i];
-        if ((table_name == NULL && table->name == NULL) ||
-            (table_name && table->name && strcmp(table->name, table_name) == 0)) {
+        if (table_named(table, table_name)) {
             for (size_t j = 0; j < table->entry_count; j++) {
                 if (strcmp(table->entries[j].key, key) == 0) {
-                    return table->entries[j].value;
+                    return &table->entries[j];
                 }
             }
         }
@@ -126,21 +1015,356 @@ const char *fossil_media_toml_get(const fossil_media_toml_t *toml, const char *t
     return NULL;
 }
 
+static const toml_slot_t *probe(const fossil_media_toml_doc_t *doc, const char *name, size_t len, uint64_t h) {
+    for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+        const toml_slot_t *slot = &doc->slots[i];
+        if (!slot->entry) return NULL;
+        if (slot->hash == h && slot->len == len && memcmp(slot->name, name, len) == 0) return slot;
+    }
+}
+
+static const fossil_media_toml_entry_t *find_entry_as(const fossil_media_toml_t *toml,
+                                                     const char *table_name, const char *key) {
+    const fossil_media_toml_doc_t *doc = toml->doc;
+    if (doc && doc->slots) {
+        /* hash "table.key" without building it; the hit must be that table's own key */
+        size_t tl = table_name ? strlen(table_name) : 0;
+        size_t kl = strlen(key);
+        size_t len = table_name ? tl + 1 + kl : kl;
+        uint64_t h = 14695981039346656037ULL;
+        if (table_name) h = toml_hash_update(toml_hash_update(h, table_name, tl), ".", 1);
+        h = toml_hash_final(toml_hash_update(h, key, kl));
+        for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+            const toml_slot_t *slot = &doc->slots[i];
+            if (!slot->entry) break;
+            if (slot->hash == h && slot->len == len && memcmp(slot->name + len - kl, key, kl) == 0 &&
+                (!table_name || (memcmp(slot->name, table_name, tl) == 0 && slot->name[tl] == '.'))) {
+                if (slot->table && table_named(slot->table, table_name) && strcmp(slot->entry->key, key) == 0) {
+                    return slot->entry;
+                }
+                break;
+            }
+        }
+    }
+    /* names the index spells differently, e.g. tables under `[[arrays]]` */
+    return scan_entry(toml, table_name, key);
+}
+
+static const fossil_media_toml_entry_t *find_entry(const fossil_media_toml_t *toml,
+                                                  const char *table_name, const char *key) {
+    if (!toml || !key) return NULL;
+    const fossil_media_toml_entry_t *e = find_entry_as(toml, table_name, key);
+    size_t len = strlen(key);
+    if (e || is_bare_key(key, len)) return e;
+    /* the key as written rather than canonical, e.g. `quoted key` for `"quoted key" = 1` */
+    fossil_media_buffer_t quoted = { NULL, 0, 0 };
+    if (put_key_part(&quoted, key, len) == 0 && put(&quoted, "", 0) == 0) {
+        e = find_entry_as(toml, table_name, quoted.data);
+    }
+    fossil_media_buffer_free(&quoted);
+    return e;
+}
+
+const fossil_media_toml_entry_t *fossil_media_toml_find(const fossil_media_toml_t *toml, const char *path) {
+    if (!toml || !path) return NULL;
+    size_t len = strlen(path);
+    if (toml->doc && toml->doc->slots) {
+        const toml_slot_t *slot = probe(toml->doc, path, len, toml_hash(path, len));
+        return slot ? slot->entry : NULL;
+    }
+    /* hand-built document: split before the last key part into table and key */
+    const char *dot = NULL;
+    for (const char *e = key_part_end(path); *e; e = key_part_end(e + 1)) dot = e;
+    if (!dot) return scan_entry(toml, NULL, path);
+    char *table_name = fossil_media_strdup(path);
+    if (!table_name) return NULL;
+    table_name[dot - path] = '\0';
+    const fossil_media_toml_entry_t *e = scan_entry(toml, table_name, dot + 1);
+    free(table_name);
+    return e;
+}
+
+fossil_media_toml_key_t *fossil_media_toml_key_compile(const char *path) {
+    if (!path) return NULL;
+    size_t len = strlen(path);
+    fossil_media_toml_key_t *key = (fossil_media_toml_key_t*)malloc(sizeof(*key) + len + 1);
+    if (!key) return NULL;
+    key->len = len;
+    key->hash = toml_hash(path, len);
+    memcpy(key->name, path, len + 1);
+    return key;
+}
+
+void fossil_media_toml_key_free(fossil_media_toml_key_t *key) {
+    free(key);
+}
+
+const fossil_media_toml_entry_t *fossil_media_toml_find_key(const fossil_media_toml_t *toml,
+                                                            const fossil_media_toml_key_t *key) {
+    if (!toml || !key) return NULL;
+    if (!toml->doc || !toml->doc->slots) return fossil_media_toml_find(toml, key->name);
+    const toml_slot_t *slot = probe(toml->doc, key->name, key->len, key->hash);
+    return slot ? slot->entry : NULL;
+}
+
+const char *fossil_media_toml_get(const fossil_media_toml_t *toml, const char *table_name, const char *key) {
+    const fossil_media_toml_entry_t *entry = find_entry(toml, table_name, key);
+    return entry ? entry->value : NULL;
+}
+
+const fossil_media_toml_value_t *fossil_media_toml_get_value(const fossil_media_toml_t *toml,
+                                                             const char *table_name, const char *key) {
+    const fossil_media_toml_entry_t *entry = find_entry(toml, table_name, key);
+    return entry ? &entry->typed : NULL;
+}
+
+int fossil_media_toml_get_int(const fossil_media_toml_t *toml, const char *table_name, const char *key, int64_t *out) {
+    const fossil_media_toml_value_t *v = fossil_media_toml_get_value(toml, table_name, key);
+    if (!v || !out || v->type != FOSSIL_MEDIA_TOML_INTEGER) return -1;
+    *out = v->as.integer;
+    return 0;
+}
+
+int fossil_media_toml_get_double(const fossil_media_toml_t *toml, const char *table_name, const char *key, double *out) {
+    const fossil_media_toml_value_t *v = fossil_media_toml_get_value(toml, table_name, key);
+    if (!v || !out) return -1;
+    if (v->type == FOSSIL_MEDIA_TOML_FLOAT) *out = v->as.floating;
+    else if (v->type == FOSSIL_MEDIA_TOML_INTEGER) *out = (double)v->as.integer;
+    else return -1;
+    return 0;
+}
+
+int fossil_media_toml_get_bool(const fossil_media_toml_t *toml, const char *table_name, const char *key, int *out) {
+    const fossil_media_toml_value_t *v = fossil_media_toml_get_value(toml, table_name, key);
+    if (!v || !out || v->type != FOSSIL_MEDIA_TOML_BOOLEAN) return -1;
+    *out = v->as.boolean;
+    return 0;
+}
+
+/* --- Serializer ---
+ *
+ * Writes straight into a fossil_media_writer_t, so output of any size goes
+ * through one small staging buffer. Tables keep their order in the document
+ * after the root table; keys and strings are quoted only when needed to read
+ * back the same.
+ */
+
+static void write_quoted(fossil_media_writer_t *w, const char *s, size_t n) {
+    fossil_media_writer_putc(w, '"');
+    size_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        char esc[8];
+        size_t e = escape_byte((unsigned char)s[i], esc);
+        if (!e) continue;
+        fossil_media_writer_write(w, s + run, i - run);
+        fossil_media_writer_write(w, esc, e);
+        run = i + 1;
+    }
+    fossil_media_writer_write(w, s + run, n - run);
+    fossil_media_writer_putc(w, '"');
+}
+
+/* Parsed keys are already canonical; parts of hand-built ones are quoted when not bare */
+static void write_key(fossil_media_writer_t *w, const char *key) {
+    for (;;) {
+        const char *e = key_part_end(key);
+        size_t n = (size_t)(e - key);
+        if (quoted_part_end(key) == e || is_bare_key(key, n)) fossil_media_writer_write(w, key, n);
+        else write_quoted(w, key, n);
+        if (!*e) return;
+        fossil_media_writer_putc(w, '.');
+        key = e + 1;
+    }
+}
+
+static void write_float(fossil_media_writer_t *w, double v) {
+    if (isnan(v)) {
+        fossil_media_writer_puts(w, "nan");
+        return;
+    }
+    if (isinf(v)) {
+        fossil_media_writer_puts(w, v < 0 ? "-inf" : "inf");
+        return;
+    }
+    char num[40];
+    snprintf(num, sizeof(num), "%.15g", v);
+    if (strtod(num, NULL) != v) snprintf(num, sizeof(num), "%.17g", v);
+    fossil_media_writer_puts(w, num);
+    if (!strpbrk(num, ".eEn")) fossil_media_writer_write(w, ".0", 2); /* keep it a float */
+}
+
+static void write_datetime(fossil_media_writer_t *w, const fossil_media_toml_datetime_t *dt) {
+    char out[64];
+    size_t n = 0;
+    if (dt->has_date) {
+        n += (size_t)snprintf(out + n, sizeof(out) - n, "%04d-%02d-%02d", dt->year, dt->month, dt->day);
+        if (dt->has_time) out[n++] = 'T';
+    }
+    if (dt->has_time) {
+        n += (size_t)snprintf(out + n, sizeof(out) - n, "%02d:%02d:%02d", dt->hour, dt->minute, dt->second);
+        if (dt->nanosecond > 0) {
+            char frac[16];
+            int digits = 9;
+            snprintf(frac, sizeof(frac), "%09d", (int)dt->nanosecond);
+            while (digits > 1 && frac[digits - 1] == '0') digits--;
+            n += (size_t)snprintf(out + n, sizeof(out) - n, ".%.*s", digits, frac);
+        }
+        if (dt->has_offset) {
+            int off = dt->offset_minutes;
+            if (off == 0) {
+                out[n++] = 'Z';
+            } else {
+                int a = off < 0 ? -off : off;
+                n += (size_t)snprintf(out + n, sizeof(out) - n, "%c%02d:%02d", off < 0 ? '-' : '+', a / 60, a % 60);
+            }
+        }
+    }
+    fossil_media_writer_write(w, out, n);
+}
+
+static void write_value(fossil_media_writer_t *w, const fossil_media_toml_value_t *v);
+
+static void write_entry(fossil_media_writer_t *w, const fossil_media_toml_entry_t *e) {
+    write_key(w, e->key ? e->key : "");
+    fossil_media_writer_write(w, " = ", 3);
+    if (e->typed.type == FOSSIL_MEDIA_TOML_STRING && !e->typed.as.string.data) {
+        /* hand-built entry with only the text form */
+        const char *text = e->value ? e->value : "";
+        write_quoted(w, text, strlen(text));
+    } else {
+        write_value(w, &e->typed);
+    }
+}
+
+static void write_value(fossil_media_writer_t *w, const fossil_media_toml_value_t *v) {
+    char num[32];
+    switch (v->type) {
+        case FOSSIL_MEDIA_TOML_STRING:
+            write_quoted(w, v->as.string.data ? v->as.string.data : "", v->as.string.data ? v->as.string.length : 0);
+            break;
+        case FOSSIL_MEDIA_TOML_INTEGER:
+            snprintf(num, sizeof(num), "%lld", (long long)v->as.integer);
+            fossil_media_writer_puts(w, num);
+            break;
+        case FOSSIL_MEDIA_TOML_FLOAT:
+            write_float(w, v->as.floating);
+            break;
+        case FOSSIL_MEDIA_TOML_BOOLEAN:
+            fossil_media_writer_puts(w, v->as.boolean ? "true" : "false");
+            break;
+        case FOSSIL_MEDIA_TOML_DATETIME:
+            write_datetime(w, &v->as.datetime);
+            break;
+        case FOSSIL_MEDIA_TOML_ARRAY:
+            fossil_media_writer_putc(w, '[');
+            for (size_t i = 0; i < v->as.array.count; ++i) {
+                if (i) fossil_media_writer_write(w, ", ", 2);
+                write_value(w, &v->as.array.items[i]);
+            }
+            fossil_media_writer_putc(w, ']');
+            break;
+        case FOSSIL_MEDIA_TOML_TABLE:
+            if (!v->as.table.count) {
+                fossil_media_writer_write(w, "{}", 2);
+                break;
+            }
+            fossil_media_writer_write(w, "{ ", 2);
+            for (size_t i = 0; i < v->as.table.count; ++i) {
+                if (i) fossil_media_writer_write(w, ", ", 2);
+                write_entry(w, &v->as.table.entries[i]);
+            }
+            fossil_media_writer_write(w, " }", 2);
+            break;
+    }
+}
+
+static void write_table(fossil_media_writer_t *w, const fossil_media_toml_table_t *table, int first) {
+    if (table->name) {
+        if (!first) fossil_media_writer_putc(w, '\n');
+        fossil_media_writer_write(w, table->array_element ? "[[" : "[", table->array_element ? 2 : 1);
+        write_key(w, table->name);
+        fossil_media_writer_write(w, table->array_element ? "]]\n" : "]\n", table->array_element ? 3 : 2);
+    }
+    for (size_t i = 0; i < table->entry_count; ++i) {
+        write_entry(w, &table->entries[i]);
+        fossil_media_writer_putc(w, '\n');
+    }
+}
+
+int fossil_media_toml_write(const fossil_media_toml_t *toml, fossil_media_sink_fn sink, void *user) {
+    if (!toml || !sink) return -1;
+    char buf[4096];
+    fossil_media_writer_t w;
+    fossil_media_writer_init(&w, sink, user, buf, sizeof(buf));
+
+    /* root keys must precede every header, wherever a hand-built root sits */
+    int first = 1;
+    for (size_t i = 0; i < toml->table_count; ++i) {
+        if (toml->tables[i].name) continue;
+        write_table(&w, &toml->tables[i], first);
+        if (toml->tables[i].entry_count) first = 0;
+    }
+    for (size_t i = 0; i < toml->table_count; ++i) {
+        if (!toml->tables[i].name) continue;
+        write_table(&w, &toml->tables[i], first);
+        first = 0;
+    }
+    return fossil_media_writer_flush(&w);
+}
+
+char *fossil_media_toml_write_string(const fossil_media_toml_t *toml) {
+    fossil_media_buffer_t out = { NULL, 0, 0 };
+    if (fossil_media_toml_write(toml, fossil_media_sink_buffer, &out) != 0 ||
+        fossil_media_sink_buffer(&out, "", 0) != 0) {
+        fossil_media_buffer_free(&out);
+        return NULL;
+    }
+    return out.data;
+}
+
+/* --- Cleanup --- */
+
+static void entries_free(fossil_media_toml_entry_t *entries, size_t count) {
+    for (size_t j = 0; j < count; j++) {
+        free(entries[j].key);
+        free(entries[j].value);
+        value_free(&entries[j].typed);
+    }
+    free(entries);
+}
+
+static void value_free(fossil_media_toml_value_t *v) {
+    switch (v->type) {
+        case FOSSIL_MEDIA_TOML_STRING:
+            free(v->as.string.data);
+            break;
+        case FOSSIL_MEDIA_TOML_ARRAY:
+            for (size_t i = 0; i < v->as.array.count; ++i) value_free(&v->as.array.items[i]);
+            free(v->as.array.items);
+            break;
+        case FOSSIL_MEDIA_TOML_TABLE:
+            entries_free(v->as.table.entries, v->as.table.count);
+            break;
+        default:
+            break;
+    }
+}
+
 void fossil_media_toml_free(fossil_media_toml_t *toml) {
-    if (!toml || !toml->tables) return;
+    if (!toml) return;
+    if (toml->doc) {
+        fossil_media_arena_destroy(&toml->doc->arena);
+        free(toml->doc);
+        memset(toml, 0, sizeof(*toml));
+        return;
+    }
+    /* hand-built document: every piece was allocated separately */
+    if (!toml->tables) return;
     for (size_t i = 0; i < toml->table_count; i++) {
         fossil_media_toml_table_t *table = &toml->tables[i];
-        if (table->name) free(table->name);
-        if (table->entries) {
-            for (size_t j = 0; j < table->entry_count; j++) {
-                if (table->entries[j].key) free(table->entries[j].key);
-                if (table->entries[j].value) free(table->entries[j].value);
-            }
-            free(table->entries);
-        }
+        free(table->name);
+        entries_free(table->entries, table->entry_count);
     }
     free(toml->tables);
-    toml->tables = NULL;
-    toml->table_count = 0;
     memset(toml, 0, sizeof(*toml));
 }
@@ -0,0 +1,415 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include "fossil/media/utf8.h"
+#include "fossil/media/media.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FOSSIL_MEDIA_HAVE_SSE2 1
+#else
+#define FOSSIL_MEDIA_HAVE_SSE2 0
+#endif
+
+#if FOSSIL_MEDIA_HAVE_SSE2 && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define FOSSIL_MEDIA_HAVE_SSSE3 1
+#else
+#define FOSSIL_MEDIA_HAVE_SSSE3 0
+#endif
+
+/* ---------- Single code points ---------- */
+
+size_t fossil_media_utf8_decode(const char *str, size_t len, uint32_t *cp) {
+    const unsigned char *s = (const unsigned char*)str;
+    if (!s || len == 0) return 0;
+    unsigned char c = s[0];
+    size_t n;
+    uint32_t v, min;
+    if (c < 0x80) {
+        if (cp) *cp = c;
+        return 1;
+    }
+    if (c >= 0xC2 && c <= 0xDF) {
+        n = 2; v = c & 0x1Fu; min = 0x80;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        n = 3; v = c & 0x0Fu; min = 0x800;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        n = 4; v = c & 0x07u; min = 0x10000;
+    } else {
+        return 0;
+    }
+    if (len < n) return 0;
+    for (size_t k = 1; k < n; ++k) {
+        if ((s[k] & 0xC0) != 0x80) return 0;
+        v = (v << 6) | (s[k] & 0x3Fu);
+    }
+    if (v < min || v > 0x10FFFF || (v >= 0xD800 && v <= 0xDFFF)) return 0;
+    if (cp) *cp = v;
+    return n;
+}
+
+size_t fossil_media_utf8_encode(uint32_t cp, char *out) {
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) cp = 0xFFFD;
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* ---------- Validation ---------- */
+
+#if FOSSIL_MEDIA_HAVE_SSE2
+static int utf8_ascii16(const unsigned char *s) {
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)s)) == 0;
+}
+#endif
+
+/* Offset of the first malformed sequence at or after `i` (a character start), or `len` */
+static size_t utf8_scan(const unsigned char *s, size_t len, size_t i) {
+    while (i < len) {
+#if FOSSIL_MEDIA_HAVE_SSE2
+        if (i + 16 <= len && utf8_ascii16(s + i)) {
+            i += 16;
+            continue;
+        }
+#endif
+        if (s[i] < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t n = fossil_media_utf8_decode((const char*)s + i, len - i, NULL);
+        if (n == 0) return i;
+        i += n;
+    }
+    return len;
+}
+
+#if FOSSIL_MEDIA_HAVE_SSSE3
+/*
+ * Keiser-Lemire validation ("Validating UTF-8 In Less Than One Instruction
+ * Per Byte"). Each byte is classified by three 16-entry lookups (high and
+ * low nibble of the previous byte, high nibble of the current one); the
+ * AND of the three is non-zero exactly for invalid two-byte patterns.
+ * Third and fourth bytes of longer sequences are checked separately.
+ */
+#define UTF8_TOO_SHORT      (1 << 0)
+#define UTF8_TOO_LONG       (1 << 1)
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)
+#define UTF8_SURROGATE      (1 << 4)
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static __m128i utf8_high_nibbles(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+static __m128i utf8_block_errors(__m128i in, __m128i prev) {
+    const __m128i byte_1_high = _mm_setr_epi8(
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m128i byte_1_low = _mm_setr_epi8(
+        (char)(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+        (char)(UTF8_CARRY | UTF8_OVERLONG_2),
+        (char)UTF8_CARRY, (char)UTF8_CARRY,
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+        (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000));
+    const __m128i byte_2_high = _mm_setr_epi8(
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+        (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+        (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+        (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(byte_1_high, utf8_high_nibbles(prev1)),
+                      _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, _mm_set1_epi8(0x0F)))),
+        _mm_shuffle_epi8(byte_2_high, utf8_high_nibbles(in)));
+    /* only 111xxxxx two back and 1111xxxx three back end up >= 0x80 */
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 14), _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(in, prev, 13), _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must_23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must_23, special);
+}
+
+/* Start of the first 16-byte block holding an error (`len` for the padding), or SIZE_MAX */
+static size_t utf8_check_blocks(const unsigned char *s, size_t len) {
+    /* a lead byte in the last three positions still expects continuations */
+    const __m128i incomplete_max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    __m128i prev = _mm_setzero_si128(), prev_incomplete = _mm_setzero_si128();
+    unsigned char tail[16];
+    /* the zero padding of the last block flushes sequences cut off at the end */
+    for (size_t b = 0; b <= len; b += 16) {
+        __m128i in, err;
+        if (b + 16 <= len) {
+            in = _mm_loadu_si128((const __m128i*)(s + b));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + b, len - b);
+            in = _mm_loadu_si128((const __m128i*)tail);
+        }
+        if (_mm_movemask_epi8(in) == 0) {
+            err = prev_incomplete;
+        } else {
+            err = utf8_block_errors(in, prev);
+            prev_incomplete = _mm_subs_epu8(in, incomplete_max);
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(err, _mm_setzero_si128())) != 0xFFFF) return b;
+        prev = in;
+        if (b + 16 > len) break;
+    }
+    return SIZE_MAX;
+}
+#endif
+
+int fossil_media_utf8_validate(const char *str, size_t len, size_t *error_pos) {
+    const unsigned char *s = (const unsigned char*)str;
+    size_t bad;
+    if (!s) {
+        if (error_pos) *error_pos = 0;
+        return len ? -1 : 0;
+    }
+#if FOSSIL_MEDIA_HAVE_SSSE3
+    bad = utf8_check_blocks(s, len);
+    if (bad == SIZE_MAX) {
+        bad = len;
+    } else {
+        /* errors are reported in the block of their last byte; rescan from
+         * the character boundary at most three bytes before it */
+        size_t from = bad > 4 ? bad - 4 : 0;
+        for (int k = 0; k < 3 && from < bad && (s[from] & 0xC0) == 0x80; ++k) ++from;
+        bad = utf8_scan(s, len, from);
+        if (bad == len) bad = utf8_scan(s, len, 0);
+    }
+#else
+    bad = utf8_scan(s, len, 0);
+#endif
+    if (bad == len) return 0;
+    if (error_pos) *error_pos = bad;
+    return -1;
+}
+
+/* ---------- Counting ---------- */
+
+size_t fossil_media_utf8_count(const char *str, size_t len) {
+    const unsigned char *s = (const unsigned char*)str;
+    size_t i = 0, continuations = 0;
+    if (!s) return 0;
+#if FOSSIL_MEDIA_HAVE_SSE2
+    /* continuation bytes 0x80..0xBF are the signed bytes below -64 */
+    const __m128i limit = _mm_set1_epi8(-64), one = _mm_set1_epi8(1);
+    while (i + 16 <= len) {
+        /* per-lane byte counters would overflow after 255 blocks */
+        size_t end = i + 255 * 16 <= len ? i + 255 * 16 : len;
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= end; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+            acc = _mm_add_epi8(acc, _mm_and_si128(_mm_cmplt_epi8(v, limit), one));
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        continuations += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+    for (; i < len; ++i) continuations += (s[i] & 0xC0) == 0x80;
+    return len - continuations;
+}
+
+/* ---------- Transcoding ---------- */
+
+int fossil_media_utf8_to_utf16(const char *src, size_t len, uint16_t *dst, size_t dst_cap, size_t *dst_len) {
+    const unsigned char *s = (const unsigned char*)src;
+    size_t i = 0, n = 0;
+    int rc = 0;
+    if (!s && len) rc = -1;
+    while (rc == 0 && i < len) {
+#if FOSSIL_MEDIA_HAVE_SSE2
+        if (i + 16 <= len && utf8_ascii16(s + i)) {
+            if (dst && n + 16 <= dst_cap) {
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                _mm_storeu_si128((__m128i*)(dst + n), _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+                _mm_storeu_si128((__m128i*)(dst + n + 8), _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+            }
+            i += 16;
+            n += 16;
+            continue;
+        }
+#endif
+        uint32_t cp;
+        size_t used = fossil_media_utf8_decode(src + i, len - i, &cp);
+        if (used == 0) {
+            rc = -1;
+            break;
+        }
+        i += used;
+        if (cp >= 0x10000) {
+            if (dst && n + 2 <= dst_cap) {
+                dst[n] = (uint16_t)(0xD800 + ((cp - 0x10000) >> 10));
+                dst[n + 1] = (uint16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+            }
+            n += 2;
+        } else {
+            if (dst && n < dst_cap) dst[n] = (uint16_t)cp;
+            ++n;
+        }
+    }
+    if (dst_len) *dst_len = n;
+    if (dst && n > dst_cap) rc = -1;
+    return rc;
+}
+
+int fossil_media_utf16_to_utf8(const uint16_t *src, size_t len, char *dst, size_t dst_cap, size_t *dst_len) {
+    size_t i = 0, n = 0;
+    int rc = 0;
+    if (!src && len) rc = -1;
+    while (rc == 0 && i < len) {
+#if FOSSIL_MEDIA_HAVE_SSE2
+        if (i + 8 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i high = _mm_and_si128(v, _mm_set1_epi16((short)0xFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xFFFF) {
+                if (dst && n + 8 <= dst_cap) _mm_storel_epi64((__m128i*)(dst + n), _mm_packus_epi16(v, v));
+                i += 8;
+                n += 8;
+                continue;
+            }
+        }
+#endif
+        uint32_t cp = src[i++];
+        if (cp >= 0xD800 && cp <= 0xDBFF && i < len && src[i] >= 0xDC00 && src[i] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (uint32_t)(src[i++] - 0xDC00);
+        } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+            rc = -1;
+            break;
+        }
+        char enc[4];
+        size_t k = fossil_media_utf8_encode(cp, enc);
+        if (dst && n + k <= dst_cap) memcpy(dst + n, enc, k);
+        n += k;
+    }
+    if (dst_len) *dst_len = n;
+    if (dst && n > dst_cap) rc = -1;
+    return rc;
+}
+
+int fossil_media_utf8_to_utf32(const char *src, size_t len, uint32_t *dst, size_t dst_cap, size_t *dst_len) {
+    const unsigned char *s = (const unsigned char*)src;
+    size_t i = 0, n = 0;
+    int rc = 0;
+    if (!s && len) rc = -1;
+    while (rc == 0 && i < len) {
+#if FOSSIL_MEDIA_HAVE_SSE2
+        if (i + 16 <= len && utf8_ascii16(s + i)) {
+            if (dst && n + 16 <= dst_cap) {
+                const __m128i zero = _mm_setzero_si128();
+                __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+                __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+                _mm_storeu_si128((__m128i*)(dst + n), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128((__m128i*)(dst + n + 4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128((__m128i*)(dst + n + 8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128((__m128i*)(dst + n + 12), _mm_unpackhi_epi16(hi, zero));
+            }
+            i += 16;
+            n += 16;
+            continue;
+        }
+#endif
+        uint32_t cp;
+        size_t used = fossil_media_utf8_decode(src + i, len - i, &cp);
+        if (used == 0) {
+            rc = -1;
+            break;
+        }
+        i += used;
+        if (dst && n < dst_cap) dst[n] = cp;
+        ++n;
+    }
+    if (dst_len) *dst_len = n;
+    if (dst && n > dst_cap) rc = -1;
+    return rc;
+}
+
+int fossil_media_utf32_to_utf8(const uint32_t *src, size_t len, char *dst, size_t dst_cap, size_t *dst_len) {
+    size_t n = 0;
+    int rc = 0;
+    if (!src && len) rc = -1;
+    for (size_t i = 0; rc == 0 && i < len; ++i) {
+        uint32_t cp = src[i];
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            rc = -1;
+            break;
+        }
+        if (cp < 0x80) {
+            if (dst && n < dst_cap) dst[n] = (char)cp;
+            ++n;
+            continue;
+        }
+        char enc[4];
+        size_t k = fossil_media_utf8_encode(cp, enc);
+        if (dst && n + k <= dst_cap) memcpy(dst + n, enc, k);
+        n += k;
+    }
+    if (dst_len) *dst_len = n;
+    if (dst && n > dst_cap) rc = -1;
+    return rc;
+}
@@ -25,6 +25,7 @@
 #define _GNU_SOURCE
 #include "fossil/media/xml.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -150,6 +151,11 @@ const char *fossil_media_xml_get_attribute(const fossil_media_xml_node_t *node,
  */
 fossil_media_xml_node_t *
 fossil_media_xml_parse(const char *xml_text, fossil_media_xml_error_t *err_out) {
+    /* XML documents must be well-formed in their encoding, UTF-8 here */
+    if (xml_text && fossil_media_utf8_validate(xml_text, strlen(xml_text), NULL) != 0) {
+        if (err_out) *err_out = FOSSIL_MEDIA_XML_ERR_PARSE;
+        return NULL;
+    }
     /* For now, return a dummy root node with text child (placeholder parser) */
     fossil_media_xml_node_t *root = fossil_media_xml_new_element("root");
     if (!root) {
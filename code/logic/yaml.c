@@ -24,127 +24,921 @@
  */
 #include "fossil/media/yaml.h"
 #include "fossil/media/media.h"
+#include "fossil/media/utf8.h"
+#include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 
-#if defined(_WIN32) && !defined(__MINGW32__)
-    // Windows has strtok_s instead of strtok_r
-    #define strtok_r(str, delim, saveptr) strtok_s((str), (delim), (saveptr))
+#ifdef _WIN32
+#include <io.h>
+#define yaml_read_fd(fd, buf, n) _read((fd), (buf), (unsigned)(n))
+#else
+#include <unistd.h>
+#define yaml_read_fd(fd, buf, n) read((fd), (buf), (n))
 #endif
 
+/* ---------------------------------------------------------------------------
+ * Scanner / parser
+ *
+ * The parser works directly on the input buffer. It always keeps the cursor
+ * on the first content character of the next non-blank, non-comment line and
+ * records that line's indentation, so each block construct only has to
+ * compare indentations to know where it ends. Scalars are reported as
+ * pointers into the input unless quoting, escapes or folding require a
+ * decoded copy in the scratch buffer.
+ * ------------------------------------------------------------------------- */
+
+#define YAML_MAX_DEPTH 256
+#define YAML_STOP 1 /* internal: a builder asked to stop, not an error */
+
+typedef enum {
+    CTX_DOCUMENT,   /* root of a document */
+    CTX_NEXT_LINE,  /* value on its own, more-indented line */
+    CTX_SEQ_ITEM,   /* after "- " on the same line */
+    CTX_INLINE      /* after "key: " on the same line */
+} yaml_ctx_t;
+
+typedef struct {
+    const char *end;
+    const char *p;          /* cursor */
+    const char *line_start; /* start of the cursor's line */
+    size_t line;            /* 1-based line of the cursor */
+    long ind;               /* indentation of the current content line, -1 at EOF or a marker */
+    size_t blanks;          /* blank lines skipped by the last seek */
+    int depth;
+    int error;              /* nonzero stops parsing */
+    fossil_media_buffer_t scratch;
+    fossil_media_yaml_event_fn fn;
+    void *user;
+} yaml_parser_t;
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static int is_eol(const yaml_parser_t *yp, const char *q) {
+    return q >= yp->end || *q == '\n' || *q == '\r';
+}
+
+static int is_ws_or_eol(const yaml_parser_t *yp, const char *q) {
+    return is_eol(yp, q) || is_blank(*q);
+}
+
+static const char *line_end(const yaml_parser_t *yp, const char *q) {
+    while (!is_eol(yp, q)) q++;
+    return q;
+}
+
+static void next_line(yaml_parser_t *yp) {
+    const char *nl = yp->p < yp->end ? (const char*)memchr(yp->p, '\n', (size_t)(yp->end - yp->p)) : NULL;
+    yp->p = nl ? nl + 1 : yp->end;
+    yp->line_start = yp->p;
+    yp->line++;
+}
+
+/* `---` or `...` at column 0 followed by whitespace or end of line */
+static int at_marker(const yaml_parser_t *yp, const char *m) {
+    const char *q = yp->p;
+    return q == yp->line_start && yp->end - q >= 3 && memcmp(q, m, 3) == 0 && is_ws_or_eol(yp, q + 3);
+}
+
+/* Move to the first content character of the next content line (cursor at a line start) */
+static void seek_content(yaml_parser_t *yp) {
+    yp->blanks = 0;
+    for (;;) {
+        const char *q = yp->p;
+        while (q < yp->end && is_blank(*q)) q++;
+        if (q >= yp->end) {
+            yp->p = yp->end;
+            yp->ind = -1;
+            return;
+        }
+        if (*q == '\n' || *q == '\r') {
+            yp->blanks++;
+            next_line(yp);
+            continue;
+        }
+        if (*q == '#') {
+            next_line(yp);
+            continue;
+        }
+        yp->p = q;
+        yp->ind = (long)(q - yp->line_start);
+        if (at_marker(yp, "---") || at_marker(yp, "...")) yp->ind = -1;
+        return;
+    }
+}
+
+/* Finish the current line (ignoring a trailing comment) and seek the next content line */
+static void advance(yaml_parser_t *yp) {
+    next_line(yp);
+    seek_content(yp);
+}
+
+static void skip_blanks(yaml_parser_t *yp) {
+    while (yp->p < yp->end && is_blank(*yp->p)) yp->p++;
+}
+
+static int at_line_end(yaml_parser_t *yp) {
+    skip_blanks(yp);
+    return is_eol(yp, yp->p) || *yp->p == '#';
+}
+
+static void put(yaml_parser_t *yp, const char *s, size_t n) {
+    if (!yp->error && fossil_media_sink_buffer(&yp->scratch, s, n) != 0) yp->error = -1;
+}
+
+static void put_char(yaml_parser_t *yp, char c) {
+    put(yp, &c, 1);
+}
+
+static void put_utf8(yaml_parser_t *yp, uint32_t cp) {
+    char buf[4];
+    put(yp, buf, fossil_media_utf8_encode(cp, buf));
+}
+
+static void trim_scratch(yaml_parser_t *yp) {
+    while (yp->scratch.len && is_blank(yp->scratch.data[yp->scratch.len - 1])) yp->scratch.len--;
+}
+
+/* --- Core schema --- */
+
+static int match_any(const char *s, size_t n, const char *const *words) {
+    for (; *words; ++words) {
+        if (strlen(*words) == n && memcmp(*words, s, n) == 0) return 1;
+    }
+    return 0;
+}
+
+static int all_digits(const char *s, size_t n, const char *set) {
+    if (n == 0) return 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!memchr(set, s[i], strlen(set))) return 0;
+    }
+    return 1;
+}
+
+static fossil_media_yaml_type_t resolve_plain(const char *s, size_t n) {
+    static const char *const nulls[] = { "~", "null", "Null", "NULL", NULL };
+    static const char *const bools[] = { "true", "True", "TRUE", "false", "False", "FALSE", NULL };
+    static const char *const specials[] = {
+        ".inf", ".Inf", ".INF", "+.inf", "+.Inf", "+.INF", "-.inf", "-.Inf", "-.INF",
+        ".nan", ".NaN", ".NAN", NULL
+    };
+    if (n == 0 || match_any(s, n, nulls)) return FOSSIL_MEDIA_YAML_TYPE_NULL;
+    if (match_any(s, n, bools)) return FOSSIL_MEDIA_YAML_TYPE_BOOL;
+    if (match_any(s, n, specials)) return FOSSIL_MEDIA_YAML_TYPE_FLOAT;
+    if (n > 2 && s[0] == '0' && s[1] == 'o' && all_digits(s + 2, n - 2, "01234567")) return FOSSIL_MEDIA_YAML_TYPE_INT;
+    if (n > 2 && s[0] == '0' && s[1] == 'x' && all_digits(s + 2, n - 2, "0123456789abcdefABCDEF")) return FOSSIL_MEDIA_YAML_TYPE_INT;
+
+    size_t i = (s[0] == '-' || s[0] == '+') ? 1 : 0;
+    size_t int_digits = 0, frac_digits = 0;
+    while (i < n && s[i] >= '0' && s[i] <= '9') { i++; int_digits++; }
+    if (i == n) return int_digits ? FOSSIL_MEDIA_YAML_TYPE_INT : FOSSIL_MEDIA_YAML_TYPE_STRING;
+    if (s[i] == '.') {
+        i++;
+        while (i < n && s[i] >= '0' && s[i] <= '9') { i++; frac_digits++; }
+    }
+    if (int_digits + frac_digits == 0) return FOSSIL_MEDIA_YAML_TYPE_STRING;
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < n && (s[i] == '-' || s[i] == '+')) i++;
+        size_t exp_digits = 0;
+        while (i < n && s[i] >= '0' && s[i] <= '9') { i++; exp_digits++; }
+        if (!exp_digits) return FOSSIL_MEDIA_YAML_TYPE_STRING;
+    }
+    return i == n ? FOSSIL_MEDIA_YAML_TYPE_FLOAT : FOSSIL_MEDIA_YAML_TYPE_STRING;
+}
+
+/* --- Event emission --- */
+
+static void emit_event(yaml_parser_t *yp, fossil_media_yaml_event_type_t type, const char *value, size_t len,
+                       fossil_media_yaml_style_t style, fossil_media_yaml_type_t scalar_type, int flow,
+                       size_t line, size_t column) {
+    if (yp->error) return;
+    fossil_media_yaml_event_t ev;
+    ev.type = type;
+    ev.value = value;
+    ev.length = len;
+    ev.scalar_type = scalar_type;
+    ev.style = style;
+    ev.flow = flow;
+    ev.line = line;
+    ev.column = column;
+    int rc = yp->fn(&ev, yp->user);
+    if (rc) yp->error = rc;
+}
+
+static void emit(yaml_parser_t *yp, fossil_media_yaml_event_type_t type, const char *value, size_t len,
+                 fossil_media_yaml_style_t style, int flow, size_t line, size_t column) {
+    fossil_media_yaml_type_t scalar_type = FOSSIL_MEDIA_YAML_TYPE_STRING;
+    if (type == FOSSIL_MEDIA_YAML_EVENT_SCALAR && style == FOSSIL_MEDIA_YAML_STYLE_PLAIN)
+        scalar_type = resolve_plain(value, len);
+    emit_event(yp, type, value, len, style, scalar_type, flow, line, column);
+}
+
+/* `force_str` (`!!str`, plain mapping keys) keeps the style but skips type resolution */
+static void emit_scalar(yaml_parser_t *yp, const char *value, size_t len, fossil_media_yaml_style_t style,
+                        int force_str, size_t line, size_t column) {
+    fossil_media_yaml_type_t scalar_type = FOSSIL_MEDIA_YAML_TYPE_STRING;
+    if (!force_str && style == FOSSIL_MEDIA_YAML_STYLE_PLAIN) scalar_type = resolve_plain(value, len);
+    emit_event(yp, FOSSIL_MEDIA_YAML_EVENT_SCALAR, value, len, style, scalar_type, 0, line, column);
+}
+
+static void emit_null(yaml_parser_t *yp) {
+    emit(yp, FOSSIL_MEDIA_YAML_EVENT_SCALAR, "", 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0, yp->line,
+         (size_t)(yp->p - yp->line_start));
+}
+
+/* --- Scalars --- */
+
+/* Trimmed plain text on the cursor's line, stopping at a comment */
+static const char *plain_line(const yaml_parser_t *yp, const char *q, const char **out_end) {
+    const char *e = q;
+    for (const char *r = q; !is_eol(yp, r); ++r) {
+        if (*r == '#' && r > q && is_blank(r[-1])) break;
+        if (!is_blank(*r)) e = r + 1;
+    }
+    *out_end = e;
+    return e;
+}
+
+/* Position of the `:` that makes the line starting at q a mapping entry, or NULL */
+static const char *key_colon(const yaml_parser_t *yp, const char *q) {
+    if (is_eol(yp, q)) return NULL;
+    if (*q == '"' || *q == '\'') {
+        char quote = *q++;
+        for (; !is_eol(yp, q); ++q) {
+            if (quote == '"' && *q == '\\' && !is_eol(yp, q + 1)) { ++q; continue; }
+            if (*q == quote) {
+                if (quote == '\'' && !is_eol(yp, q + 1) && q[1] == '\'') { ++q; continue; }
+                break;
+            }
+        }
+        if (is_eol(yp, q)) return NULL;
+        for (++q; !is_eol(yp, q) && is_blank(*q); ++q) {}
+        return (!is_eol(yp, q) && *q == ':' && is_ws_or_eol(yp, q + 1)) ? q : NULL;
+    }
+    if (strchr("[]{}#&*!|>%@`,?", *q) || (*q == '-' && is_ws_or_eol(yp, q + 1))) return NULL;
+    for (const char *r = q; !is_eol(yp, r); ++r) {
+        if (*r == '#' && r > q && is_blank(r[-1])) return NULL;
+        if (*r == ':' && is_ws_or_eol(yp, r + 1)) return r;
+    }
+    return NULL;
+}
+
+static int is_seq_entry(const yaml_parser_t *yp, const char *q) {
+    return !is_eol(yp, q) && *q == '-' && is_ws_or_eol(yp, q + 1);
+}
+
+/* `? key` starts a complex key, which the tree and the emitter cannot hold */
+static int is_complex_key(const yaml_parser_t *yp, const char *q) {
+    return !is_eol(yp, q) && *q == '?' && is_ws_or_eol(yp, q + 1);
+}
+
+static void put_escape(yaml_parser_t *yp) {
+    /* cursor on the character after the backslash */
+    char c = *yp->p++;
+    int digits = 0;
+    switch (c) {
+        case '0': put_char(yp, '\0'); return;
+        case 'a': put_char(yp, '\a'); return;
+        case 'b': put_char(yp, '\b'); return;
+        case 't': case '\t': put_char(yp, '\t'); return;
+        case 'n': put_char(yp, '\n'); return;
+        case 'v': put_char(yp, '\v'); return;
+        case 'f': put_char(yp, '\f'); return;
+        case 'r': put_char(yp, '\r'); return;
+        case 'e': put_char(yp, 0x1B); return;
+        case ' ': case '"': case '/': case '\\': put_char(yp, c); return;
+        case 'N': put_utf8(yp, 0x85); return;
+        case '_': put_utf8(yp, 0xA0); return;
+        case 'L': put_utf8(yp, 0x2028); return;
+        case 'P': put_utf8(yp, 0x2029); return;
+        case 'x': digits = 2; break;
+        case 'u': digits = 4; break;
+        case 'U': digits = 8; break;
+        default: put_char(yp, '\\'); put_char(yp, c); return;
+    }
+    uint32_t cp = 0;
+    for (int i = 0; i < digits; ++i, ++yp->p) {
+        char h = yp->p < yp->end ? *yp->p : '\0';
+        uint32_t d;
+        if (h >= '0' && h <= '9') d = (uint32_t)(h - '0');
+        else if (h >= 'a' && h <= 'f') d = (uint32_t)(h - 'a' + 10);
+        else if (h >= 'A' && h <= 'F') d = (uint32_t)(h - 'A' + 10);
+        else { yp->error = -1; return; }
+        cp = cp * 16 + d;
+    }
+    put_utf8(yp, cp);
+}
 
 /*
- * Enhanced YAML parser: supports nested maps (basic indentation-based hierarchy)
- * Updated to survive all listed test cases.
+ * Scan a quoted scalar at the cursor. Single-line scalars without escapes are
+ * returned in place; everything else is decoded into scratch with line folding.
  */
-fossil_media_yaml_node_t *fossil_media_yaml_parse(const char *input) {
-    if (!input || !*input) return NULL;
+static int scan_quoted(yaml_parser_t *yp, const char **out, size_t *out_len) {
+    char quote = *yp->p++;
+    const char *start = yp->p;
+    const char *r = start;
+    while (!is_eol(yp, r) && *r != quote && !(quote == '"' && *r == '\\')) r++;
+    if (!is_eol(yp, r) && *r == quote && !(quote == '\'' && !is_eol(yp, r + 1) && r[1] == '\'')) {
+        *out = start;
+        *out_len = (size_t)(r - start);
+        yp->p = r + 1;
+        return 0;
+    }
 
-    fossil_media_yaml_node_t *root = NULL, *last = NULL;
-    fossil_media_yaml_node_t **stack = NULL;
-    size_t stack_size = 0, stack_cap = 0;
-    int parsed_any = 0;
-
-    char *copy = fossil_media_strdup(input);
-    if (!copy) return NULL;
-
-    char *saveptr = NULL;
-    char *line = strtok_r(copy, "\n", &saveptr);
-    while (line) {
-        char *orig_line = line;
-        // Count indent (spaces/tabs before first non-space/tab)
-        size_t indent = 0;
-        while (orig_line[indent] == ' ' || orig_line[indent] == '\t') indent++;
-        line = orig_line + indent;
-
-        // Skip lines that are only whitespace
-        if (*line == '\0' || strspn(line, " \t") == strlen(line)) {
-            line = strtok_r(NULL, "\n", &saveptr);
+    yp->scratch.len = 0;
+    while (yp->p < yp->end && !yp->error) {
+        char c = *yp->p;
+        if (c == quote) {
+            if (quote == '\'' && yp->p + 1 < yp->end && yp->p[1] == '\'') {
+                put_char(yp, '\'');
+                yp->p += 2;
+                continue;
+            }
+            yp->p++;
+            put(yp, "", 0);
+            *out = yp->scratch.data ? yp->scratch.data : "";
+            *out_len = yp->scratch.len;
+            return yp->error;
+        }
+        if (quote == '"' && c == '\\' && yp->p + 1 < yp->end) {
+            yp->p++;
+            if (*yp->p == '\n' || *yp->p == '\r') {
+                /* escaped line break: join without a space */
+                next_line(yp);
+                skip_blanks(yp);
+                continue;
+            }
+            put_escape(yp);
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            size_t breaks = 0;
+            trim_scratch(yp);
+            next_line(yp);
+            skip_blanks(yp);
+            while (yp->p < yp->end && (*yp->p == '\n' || *yp->p == '\r')) {
+                breaks++;
+                next_line(yp);
+                skip_blanks(yp);
+            }
+            if (breaks == 0) put_char(yp, ' ');
+            while (breaks--) put_char(yp, '\n');
             continue;
         }
+        put_char(yp, c);
+        yp->p++;
+    }
+    return -1; /* unterminated */
+}
+
+/*
+ * Scan a plain scalar in block context, folding continuation lines that are
+ * indented past `parent_indent` and are not mapping entries. Leaves the cursor
+ * on the next content line.
+ */
+static void scan_plain_block(yaml_parser_t *yp, long parent_indent, const char **out, size_t *out_len) {
+    const char *e;
+    const char *s = yp->p;
+    plain_line(yp, s, &e);
+    *out = s;
+    *out_len = (size_t)(e - s);
+    int multi = 0;
+    advance(yp);
+    while (!yp->error && yp->ind > parent_indent && !key_colon(yp, yp->p)) {
+        if (!multi) {
+            yp->scratch.len = 0;
+            put(yp, *out, *out_len);
+            multi = 1;
+        }
+        if (yp->blanks == 0) put_char(yp, ' ');
+        for (size_t i = 0; i < yp->blanks; ++i) put_char(yp, '\n');
+        s = yp->p;
+        plain_line(yp, s, &e);
+        put(yp, s, (size_t)(e - s));
+        advance(yp);
+    }
+    if (multi && !yp->error) {
+        *out = yp->scratch.data;
+        *out_len = yp->scratch.len;
+    }
+}
+
+/* Literal (|) or folded (>) block scalar; cursor on the indicator */
+static void parse_block_scalar(yaml_parser_t *yp, long parent_indent, size_t line, size_t column) {
+    int folded = *yp->p++ == '>';
+    char chomp = 'c';
+    long explicit_indent = 0;
+    while (!is_eol(yp, yp->p) && !is_blank(*yp->p) && *yp->p != '#') {
+        if (*yp->p == '+' || *yp->p == '-') chomp = *yp->p;
+        else if (*yp->p >= '1' && *yp->p <= '9') explicit_indent = *yp->p - '0';
+        yp->p++;
+    }
+    next_line(yp);
+
+    long base = parent_indent < 0 ? 0 : parent_indent;
+    long indent = explicit_indent ? base + explicit_indent : -1;
+    if (indent < 0) {
+        /* auto-detect from the first non-empty line */
+        const char *q = yp->p;
+        while (q < yp->end) {
+            const char *t = q;
+            while (t < yp->end && *t == ' ') t++;
+            if (t < yp->end && *t != '\n' && *t != '\r') { indent = (long)(t - q); break; }
+            const char *nl = (const char*)memchr(t, '\n', (size_t)(yp->end - t));
+            if (!nl) break;
+            q = nl + 1;
+        }
+        if (indent <= parent_indent) indent = parent_indent + 1;
+    }
 
-        char *sep = strchr(line, ':');
-        if (!sep) {
-            line = strtok_r(NULL, "\n", &saveptr);
+    yp->scratch.len = 0;
+    size_t pending = 0;      /* empty lines since the last content line */
+    int have_content = 0;
+    int prev_more = 0;       /* previous content line was more indented (folded only) */
+    while (yp->p < yp->end && !yp->error) {
+        const char *q = yp->p;
+        long spaces = 0;
+        while (q < yp->end && *q == ' ' && spaces < indent) { q++; spaces++; }
+        int empty = is_eol(yp, q) || (spaces < indent && line_end(yp, q) == q);
+        if (!empty && spaces < indent) break;
+        if (!empty && yp->p == yp->line_start && (at_marker(yp, "---") || at_marker(yp, "..."))) break;
+        if (empty) {
+            /* blank line, possibly with fewer spaces than the content */
+            const char *t = q;
+            while (t < yp->end && *t == ' ') t++;
+            if (!is_eol(yp, t)) break;
+            pending++;
+            next_line(yp);
             continue;
         }
+        const char *e = line_end(yp, q);
+        int more = is_blank(*q);
+        if (have_content) {
+            if (folded && !prev_more && !more) {
+                if (pending == 0) put_char(yp, ' ');
+            } else {
+                put_char(yp, '\n');
+            }
+        }
+        for (size_t i = 0; i < pending; ++i) put_char(yp, '\n');
+        pending = 0;
+        put(yp, q, (size_t)(e - q));
+        have_content = 1;
+        prev_more = more;
+        next_line(yp);
+    }
+    if (chomp != '-' && have_content) put_char(yp, '\n');
+    if (chomp == '+') {
+        for (size_t i = 0; i < pending; ++i) put_char(yp, '\n');
+    }
+    put(yp, "", 0);
+    emit_scalar(yp, yp->scratch.data ? yp->scratch.data : "", yp->scratch.len,
+                folded ? FOSSIL_MEDIA_YAML_STYLE_FOLDED : FOSSIL_MEDIA_YAML_STYLE_LITERAL, 0, line, column);
+    seek_content(yp);
+}
+
+/* --- Flow collections --- */
 
-        // Accept "key:" (colon at end) as valid, value is empty string
-        *sep = '\0';
-        char *key = fossil_media_trim(line);
-        char *value = fossil_media_trim(sep + 1);
+static int flow_skip(yaml_parser_t *yp) {
+    while (yp->p < yp->end) {
+        char c = *yp->p;
+        if (is_blank(c)) yp->p++;
+        else if (c == '\n' || c == '\r') next_line(yp);
+        else if (c == '#' && (yp->p == yp->line_start || is_blank(yp->p[-1]))) yp->p = line_end(yp, yp->p);
+        else return 0;
+    }
+    return -1; /* unterminated collection */
+}
+
+static int is_flow_indicator(char c) {
+    return c == ',' || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+static void skip_properties(yaml_parser_t *yp, int *force_str);
+
+static void parse_flow_node(yaml_parser_t *yp) {
+    if (yp->error) return;
+    if (flow_skip(yp)) { yp->error = -1; return; }
+    int force_str = 0;
+    skip_properties(yp, &force_str);
+    if (flow_skip(yp)) { yp->error = -1; return; }
 
-        // Remove trailing spaces from value
-        if (value) {
-            size_t vlen = strlen(value);
-            while (vlen > 0 && (value[vlen - 1] == ' ' || value[vlen - 1] == '\t')) {
-                value[vlen - 1] = '\0';
-                vlen--;
+    size_t line = yp->line, column = (size_t)(yp->p - yp->line_start);
+    char c = *yp->p;
+    if (is_complex_key(yp, yp->p)) { yp->error = -1; return; }
+    if (c == '[' || c == '{') {
+        if (++yp->depth > YAML_MAX_DEPTH) { yp->error = -1; return; }
+        int is_map = c == '{';
+        char close = is_map ? '}' : ']';
+        emit(yp, is_map ? FOSSIL_MEDIA_YAML_EVENT_MAPPING_START : FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START,
+             NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 1, line, column);
+        yp->p++;
+        while (!yp->error) {
+            if (flow_skip(yp)) { yp->error = -1; break; }
+            if (*yp->p == close) { yp->p++; break; }
+            parse_flow_node(yp);
+            if (is_map) {
+                if (flow_skip(yp)) { yp->error = -1; break; }
+                if (*yp->p == ':') {
+                    yp->p++;
+                    if (flow_skip(yp)) { yp->error = -1; break; }
+                    if (*yp->p == ',' || *yp->p == close) emit_null(yp);
+                    else parse_flow_node(yp);
+                } else {
+                    emit_null(yp);
+                }
             }
+            if (flow_skip(yp)) { yp->error = -1; break; }
+            if (*yp->p == ',') yp->p++;
+            else if (*yp->p != close) { yp->error = -1; break; }
+        }
+        emit(yp, is_map ? FOSSIL_MEDIA_YAML_EVENT_MAPPING_END : FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END,
+             NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 1, yp->line, (size_t)(yp->p - yp->line_start));
+        yp->depth--;
+        return;
+    }
+    if (c == '"' || c == '\'') {
+        const char *v;
+        size_t n;
+        if (scan_quoted(yp, &v, &n)) { yp->error = -1; return; }
+        emit_scalar(yp, v, n, c == '"' ? FOSSIL_MEDIA_YAML_STYLE_DOUBLE_QUOTED : FOSSIL_MEDIA_YAML_STYLE_SINGLE_QUOTED,
+                    force_str, line, column);
+        return;
+    }
+    /* plain scalar: up to an indicator, ": ", " #" or the end of the line */
+    const char *s = yp->p, *e = yp->p;
+    while (!is_eol(yp, yp->p)) {
+        char d = *yp->p;
+        if (is_flow_indicator(d)) break;
+        if (d == ':' && (is_ws_or_eol(yp, yp->p + 1) || is_flow_indicator(yp->p[1]))) break;
+        if (d == '#' && yp->p > s && is_blank(yp->p[-1])) break;
+        yp->p++;
+        if (!is_blank(d)) e = yp->p;
+    }
+    emit_scalar(yp, s, (size_t)(e - s), FOSSIL_MEDIA_YAML_STYLE_PLAIN, force_str, line, column);
+}
+
+/* --- Block collections --- */
+
+static void parse_node(yaml_parser_t *yp, long parent_indent, yaml_ctx_t ctx);
+
+/* Anchors (&a) and tags (!t) before a node; only !!str changes anything */
+static void skip_properties(yaml_parser_t *yp, int *force_str) {
+    while (yp->p < yp->end && (*yp->p == '&' || *yp->p == '!')) {
+        const char *s = yp->p;
+        while (!is_ws_or_eol(yp, yp->p) && !is_flow_indicator(*yp->p)) yp->p++;
+        if ((size_t)(yp->p - s) == 5 && memcmp(s, "!!str", 5) == 0) *force_str = 1;
+        skip_blanks(yp);
+    }
+}
+
+static void parse_block_sequence(yaml_parser_t *yp, long col) {
+    emit(yp, FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START, NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+         yp->line, (size_t)col);
+    while (!yp->error && yp->ind == col && is_seq_entry(yp, yp->p)) {
+        yp->p++;
+        if (at_line_end(yp)) {
+            advance(yp);
+            if (yp->ind > col) parse_node(yp, col, CTX_NEXT_LINE);
+            else emit_null(yp);
+        } else {
+            /* compact form: "- key: v" lines up the item's content at this column */
+            yp->ind = (long)(yp->p - yp->line_start);
+            parse_node(yp, col, CTX_SEQ_ITEM);
         }
+    }
+    emit(yp, FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END, NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+         yp->line, (size_t)col);
+}
 
-        if (!key || !*key) {
-            line = strtok_r(NULL, "\n", &saveptr);
+/*
+ * Block mapping whose keys sit at column `col`. `value`/`len` carry a scalar
+ * written on the parent key's line (the legacy "key: value + indented block"
+ * form); they are NULL for ordinary mappings.
+ */
+static void parse_block_mapping(yaml_parser_t *yp, long col, const char *value, size_t len) {
+    emit(yp, FOSSIL_MEDIA_YAML_EVENT_MAPPING_START, value, len, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+         yp->line, (size_t)col);
+    while (!yp->error && yp->ind >= col) {
+        if (yp->ind > col) {
+            /* stray deeper line left over after a flow value */
+            advance(yp);
             continue;
         }
-        if (!value) value = "";
-
-        fossil_media_yaml_node_t *node = calloc(1, sizeof(*node));
-        if (!node) break;
-        node->key = fossil_media_strdup(key);
-        node->value = fossil_media_strdup(value);
-        node->indent = indent;
-        node->next = NULL;
-        node->child = NULL;
-
-        // Stack management for hierarchy
-        // Treat tabs and spaces as equivalent for indentation comparison
-        while (stack_size > 0) {
-            size_t parent_indent = stack[stack_size - 1]->indent;
-            if (parent_indent < indent)
-                break;
-            stack_size--;
+        if (is_complex_key(yp, yp->p)) { yp->error = -1; break; }
+        const char *colon = key_colon(yp, yp->p);
+        if (!colon) {
+            /* not a key: skipped, as the original line parser did */
+            advance(yp);
+            continue;
         }
+        size_t line = yp->line, column = (size_t)(yp->p - yp->line_start);
+        if (*yp->p == '"' || *yp->p == '\'') {
+            char quote = *yp->p;
+            const char *k;
+            size_t klen;
+            if (scan_quoted(yp, &k, &klen)) { yp->error = -1; break; }
+            emit_scalar(yp, k, klen, quote == '"' ? FOSSIL_MEDIA_YAML_STYLE_DOUBLE_QUOTED
+                                                  : FOSSIL_MEDIA_YAML_STYLE_SINGLE_QUOTED, 0, line, column);
+        } else {
+            const char *e = colon;
+            while (e > yp->p && is_blank(e[-1])) e--;
+            emit_scalar(yp, yp->p, (size_t)(e - yp->p), FOSSIL_MEDIA_YAML_STYLE_PLAIN, 1, line, column);
+        }
+        yp->p = colon + 1;
+        if (at_line_end(yp)) {
+            advance(yp);
+            if (yp->ind > col) parse_node(yp, col, CTX_NEXT_LINE);
+            else if (yp->ind == col && is_seq_entry(yp, yp->p)) parse_block_sequence(yp, col);
+            else emit_null(yp);
+        } else {
+            parse_node(yp, col, CTX_INLINE);
+        }
+    }
+    emit(yp, FOSSIL_MEDIA_YAML_EVENT_MAPPING_END, NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+         yp->line, (size_t)col);
+}
 
-        if (stack_size == 0) {
-            // Top-level node
-            if (!root) root = node;
-            else last->next = node;
-            last = node;
+/* Parse the node starting at the cursor; it must stay indented past `parent_indent` */
+static void parse_node(yaml_parser_t *yp, long parent_indent, yaml_ctx_t ctx) {
+    if (yp->error) return;
+    if (++yp->depth > YAML_MAX_DEPTH) { yp->error = -1; return; }
+
+    int force_str = 0;
+    skip_properties(yp, &force_str);
+    if (at_line_end(yp)) {
+        /* properties alone on the line: the node follows on the next lines */
+        advance(yp);
+        if (yp->ind > parent_indent) parse_node(yp, parent_indent, CTX_NEXT_LINE);
+        else emit_null(yp);
+        yp->depth--;
+        return;
+    }
+
+    long col = (long)(yp->p - yp->line_start);
+    size_t line = yp->line;
+    char c = *yp->p;
+
+    if (ctx != CTX_INLINE && is_complex_key(yp, yp->p)) {
+        yp->error = -1;
+    } else if (ctx != CTX_INLINE && is_seq_entry(yp, yp->p)) {
+        parse_block_sequence(yp, col);
+    } else if (c == '[' || c == '{') {
+        parse_flow_node(yp);
+        if (!yp->error) advance(yp);
+    } else if (c == '|' || c == '>') {
+        parse_block_scalar(yp, parent_indent, line, (size_t)col);
+    } else if (c == '*') {
+        const char *s = yp->p, *e;
+        plain_line(yp, s, &e);
+        emit_scalar(yp, s, (size_t)(e - s), FOSSIL_MEDIA_YAML_STYLE_PLAIN, 1, line, (size_t)col);
+        advance(yp);
+    } else if (ctx != CTX_INLINE && key_colon(yp, yp->p)) {
+        parse_block_mapping(yp, col, NULL, 0);
+    } else {
+        const char *v;
+        size_t n;
+        fossil_media_yaml_style_t style = FOSSIL_MEDIA_YAML_STYLE_PLAIN;
+        if (c == '"' || c == '\'') {
+            style = c == '"' ? FOSSIL_MEDIA_YAML_STYLE_DOUBLE_QUOTED : FOSSIL_MEDIA_YAML_STYLE_SINGLE_QUOTED;
+            if (scan_quoted(yp, &v, &n)) { yp->error = -1; yp->depth--; return; }
+            advance(yp);
+        } else {
+            scan_plain_block(yp, parent_indent, &v, &n);
+        }
+        if (!yp->error && yp->ind > parent_indent && key_colon(yp, yp->p)) {
+            /* scalar followed by a more-indented block of keys (legacy form) */
+            parse_block_mapping(yp, yp->ind, v, n);
         } else {
-            // Child node
-            fossil_media_yaml_node_t *parent = stack[stack_size - 1];
-            if (!parent->child) parent->child = node;
-            else {
-                fossil_media_yaml_node_t *sibling = parent->child;
-                while (sibling->next) sibling = sibling->next;
-                sibling->next = node;
+            emit_scalar(yp, v, n, style, force_str, line, (size_t)col);
+        }
+    }
+    yp->depth--;
+}
+
+int fossil_media_yaml_parse_events(const char *input, size_t len, fossil_media_yaml_event_fn fn, void *user) {
+    if ((!input && len) || !fn) return -1;
+
+    yaml_parser_t yp;
+    memset(&yp, 0, sizeof(yp));
+    yp.p = input ? input : "";
+    yp.end = yp.p + len;
+    yp.line_start = yp.p;
+    yp.line = 1;
+    yp.fn = fn;
+    yp.user = user;
+
+    seek_content(&yp);
+    while (!yp.error) {
+        /* directives only matter before an explicit document start */
+        while (yp.p < yp.end && yp.p == yp.line_start && *yp.p == '%') advance(&yp);
+        if (at_marker(&yp, "...")) {
+            advance(&yp);
+            continue;
+        }
+        int explicit_start = at_marker(&yp, "---");
+        if (!explicit_start && yp.p >= yp.end) break;
+
+        emit(&yp, FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_START, NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+             yp.line, 0);
+        if (explicit_start) {
+            yp.p += 3;
+            if (!at_line_end(&yp)) {
+                parse_node(&yp, -1, CTX_DOCUMENT);
+            } else {
+                advance(&yp);
+                if (yp.ind >= 0) parse_node(&yp, -1, CTX_DOCUMENT);
+                else emit_null(&yp);
             }
+        } else {
+            parse_node(&yp, -1, CTX_DOCUMENT);
         }
+        while (!yp.error && yp.ind >= 0) advance(&yp); /* content the root did not claim */
+        emit(&yp, FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_END, NULL, 0, FOSSIL_MEDIA_YAML_STYLE_PLAIN, 0,
+             yp.line, 0);
+        if (!yp.error && at_marker(&yp, "...")) advance(&yp);
+    }
+
+    fossil_media_buffer_free(&yp.scratch);
+    return yp.error;
+}
+
+/* ---------------------------------------------------------------------------
+ * Tree building
+ *
+ * Events of the first document are turned into nodes allocated from an
+ * arena owned by the document. Each open collection keeps a tail pointer so
+ * appending a node is O(1).
+ * ------------------------------------------------------------------------- */
+
+/* One entry of a document's lookup index */
+typedef struct {
+    const fossil_media_yaml_node_t *parent; /* NULL for top-level nodes */
+    const fossil_media_yaml_node_t *node;   /* NULL marks an empty slot */
+    uint64_t hash;
+    size_t index;                           /* sequence position, or SIZE_MAX for a key */
+} yaml_slot_t;
+
+struct fossil_media_yaml_doc {
+    fossil_media_arena_t arena;
+    size_t count;        /* nodes in the tree */
+    yaml_slot_t *slots;  /* lookup index, built on first use */
+    size_t mask;         /* slot count - 1 */
+    int borrowed;        /* owned by a stream reader, not by the tree */
+};
+
+typedef struct {
+    fossil_media_yaml_node_t *owner; /* node holding this collection, NULL for the root */
+    fossil_media_yaml_node_t *tail;
+    int is_map;
+} yaml_frame_t;
+
+typedef struct {
+    fossil_media_yaml_doc_t *doc;
+    fossil_media_yaml_node_t *head;
+    yaml_frame_t *stack;
+    size_t depth;
+    size_t cap;
+    char *pending_key;   /* key waiting for its value */
+    size_t pending_col;
+    int expect_key;
+    int started;         /* a document was seen */
+} yaml_builder_t;
+
+static char *arena_copy(yaml_builder_t *b, const char *s, size_t n) {
+    return fossil_media_arena_strndup(&b->doc->arena, s ? s : "", s ? n : 0);
+}
+
+static fossil_media_yaml_node_t *builder_add(yaml_builder_t *b, fossil_media_yaml_type_t type,
+                                             const char *value, size_t len, size_t column) {
+    yaml_frame_t *f = &b->stack[b->depth - 1];
+    fossil_media_yaml_node_t *n = (fossil_media_yaml_node_t*)fossil_media_arena_calloc(&b->doc->arena, sizeof(*n));
+    if (!n || !(n->value = arena_copy(b, value, len))) return NULL;
+    b->doc->count++;
+    n->type = type;
+    n->key = f->is_map ? b->pending_key : NULL;
+    n->indent = f->is_map ? b->pending_col : column;
+    if (f->tail) f->tail->next = n;
+    else if (f->owner) f->owner->child = n;
+    else b->head = n;
+    f->tail = n;
+    b->pending_key = NULL;
+    b->expect_key = f->is_map;
+    return n;
+}
+
+static int builder_push(yaml_builder_t *b, fossil_media_yaml_node_t *owner, int is_map) {
+    if (b->depth == b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 16;
+        yaml_frame_t *grown = (yaml_frame_t*)realloc(b->stack, cap * sizeof(*grown));
+        if (!grown) return -1;
+        b->stack = grown;
+        b->cap = cap;
+    }
+    b->stack[b->depth].owner = owner;
+    b->stack[b->depth].tail = NULL;
+    b->stack[b->depth].is_map = is_map;
+    b->depth++;
+    b->expect_key = is_map;
+    return 0;
+}
 
-        // Push to stack
-        if (stack_size == stack_cap) {
-            stack_cap = stack_cap ? stack_cap * 2 : 8;
-            stack = realloc(stack, stack_cap * sizeof(*stack));
+static int builder_event(const fossil_media_yaml_event_t *ev, void *user) {
+    yaml_builder_t *b = (yaml_builder_t*)user;
+    switch (ev->type) {
+        case FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_START:
+            b->started = 1;
+            return 0;
+        case FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_END:
+            return YAML_STOP;
+        case FOSSIL_MEDIA_YAML_EVENT_MAPPING_START:
+        case FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START: {
+            int is_map = ev->type == FOSSIL_MEDIA_YAML_EVENT_MAPPING_START;
+            if (b->depth == 0) return builder_push(b, NULL, is_map);
+            fossil_media_yaml_node_t *n = builder_add(b, is_map ? FOSSIL_MEDIA_YAML_TYPE_MAPPING
+                                                                : FOSSIL_MEDIA_YAML_TYPE_SEQUENCE,
+                                                      ev->value, ev->length, ev->column);
+            return n ? builder_push(b, n, is_map) : -1;
         }
-        stack[stack_size++] = node;
-        parsed_any = 1;
+        case FOSSIL_MEDIA_YAML_EVENT_MAPPING_END:
+        case FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END:
+            if (b->depth) b->depth--;
+            b->expect_key = b->depth ? b->stack[b->depth - 1].is_map : 0;
+            return 0;
+        case FOSSIL_MEDIA_YAML_EVENT_SCALAR:
+            if (b->depth == 0) return 0; /* a lone root scalar has no node form */
+            if (b->stack[b->depth - 1].is_map && b->expect_key) {
+                b->pending_key = arena_copy(b, ev->value, ev->length);
+                b->pending_col = ev->column;
+                b->expect_key = 0;
+                return b->pending_key ? 0 : -1;
+            }
+            return builder_add(b, ev->scalar_type, ev->value, ev->length, ev->column) ? 0 : -1;
+    }
+    return 0;
+}
+
+/*
+ * Build the first document of `input` into `doc`, whose arena must be empty.
+ * Returns 1 if a document was found, 0 if the input held none, -1 on error.
+ */
+static int yaml_build(fossil_media_yaml_doc_t *doc, const char *input, size_t len,
+                      fossil_media_yaml_node_t **out_head) {
+    yaml_builder_t b;
+    memset(&b, 0, sizeof(b));
+    b.doc = doc;
+    doc->count = 0;
+    doc->slots = NULL;
+    doc->mask = 0;
 
-        line = strtok_r(NULL, "\n", &saveptr);
+    int rc = fossil_media_yaml_parse_events(input, len, builder_event, &b);
+    free(b.stack);
+    *out_head = NULL;
+    if (rc != 0 && rc != YAML_STOP) return -1;
+    if (b.head) {
+        b.head->doc = doc;
+        *out_head = b.head;
     }
+    return b.started;
+}
+
+/* Arena block size suited to an input of `len` bytes */
+static size_t yaml_arena_hint(size_t len) {
+    return len < 64 * 1024 ? len * 2 + 256 : 128 * 1024;
+}
+
+fossil_media_yaml_node_t *fossil_media_yaml_parse(const char *input) {
+    if (!input || !*input) return NULL;
 
-    if (stack)
-        free(stack);
-    if (copy)
-        free(copy);
+    size_t len = strlen(input);
+    fossil_media_yaml_doc_t *doc = (fossil_media_yaml_doc_t*)calloc(1, sizeof(*doc));
+    if (!doc) return NULL;
+    fossil_media_arena_init(&doc->arena, yaml_arena_hint(len));
 
-    // If root is NULL, return NULL (no valid nodes parsed)
-    return parsed_any ? root : NULL;
+    fossil_media_yaml_node_t *head;
+    if (yaml_build(doc, input, len, &head) < 0 || !head) {
+        fossil_media_arena_destroy(&doc->arena);
+        free(doc);
+        return NULL;
+    }
+    return head;
 }
 
 void fossil_media_yaml_free(fossil_media_yaml_node_t *head) {
+    if (head && head->doc) {
+        /* parsed trees live entirely in their document's arena */
+        fossil_media_yaml_doc_t *doc = head->doc;
+        if (doc->borrowed) return;
+        fossil_media_arena_destroy(&doc->arena);
+        free(doc);
+        return;
+    }
     while (head) {
         fossil_media_yaml_node_t *next = head->next;
         fossil_media_yaml_free(head->child);
@@ -156,8 +950,9 @@ void fossil_media_yaml_free(fossil_media_yaml_node_t *head) {
 }
 
 const char *fossil_media_yaml_get(const fossil_media_yaml_node_t *head, const char *key) {
+    if (!key) return NULL;
     for (; head; head = head->next) {
-        if (strcmp(head->key, key) == 0)
+        if (head->key && strcmp(head->key, key) == 0)
             return head->value;
         const char *val = fossil_media_yaml_get(head->child, key);
         if (val) return val;
@@ -168,8 +963,901 @@ const char *fossil_media_yaml_get(const fossil_media_yaml_node_t *head, const ch
 void fossil_media_yaml_print(const fossil_media_yaml_node_t *head) {
     for (; head; head = head->next) {
         for (size_t i = 0; i < head->indent; i++) printf(" ");
-        printf("%s: %s\n", head->key, head->value);
+        if (head->key) printf("%s: %s\n", head->key, head->value);
+        else printf("- %s\n", head->value);
         if (head->child)
             fossil_media_yaml_print(head->child);
     }
 }
+
+/* ---------------------------------------------------------------------------
+ * Path lookups
+ *
+ * A document's index maps (parent node, key) and (parent sequence, position)
+ * to the child node with one open-addressing table, so resolving a path
+ * costs one probe per segment instead of a walk over the tree.
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    const char *key;  /* NULL for a sequence position */
+    size_t len;
+    size_t index;     /* SIZE_MAX for a key */
+    uint64_t hash;    /* hash of the key or position, before mixing in the parent */
+} yaml_segment_t;
+
+struct fossil_media_yaml_path {
+    size_t count;
+    yaml_segment_t *segments;
+};
+
+static uint64_t yaml_hash_bytes(const char *s, size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t yaml_hash_index(size_t index) {
+    return ((uint64_t)index + 1) * 0x9E3779B97F4A7C15ULL;
+}
+
+static uint64_t yaml_hash_mix(const fossil_media_yaml_node_t *parent, uint64_t h) {
+    h ^= (uint64_t)(uintptr_t)parent * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static int yaml_segment_matches(const fossil_media_yaml_node_t *node, size_t position, const yaml_segment_t *seg) {
+    if (!seg->key) return !node->key && position == seg->index;
+    return node->key && strncmp(node->key, seg->key, seg->len) == 0 && node->key[seg->len] == '\0';
+}
+
+static const yaml_slot_t *yaml_index_probe(const fossil_media_yaml_doc_t *doc,
+                                           const fossil_media_yaml_node_t *parent,
+                                           const yaml_segment_t *seg, uint64_t h) {
+    for (size_t i = (size_t)h & doc->mask;; i = (i + 1) & doc->mask) {
+        const yaml_slot_t *slot = &doc->slots[i];
+        if (!slot->node) return slot;
+        if (slot->hash == h && slot->parent == parent && slot->index == seg->index &&
+            yaml_segment_matches(slot->node, slot->index, seg))
+            return slot;
+    }
+}
+
+static void yaml_index_add(fossil_media_yaml_doc_t *doc, const fossil_media_yaml_node_t *parent,
+                           const fossil_media_yaml_node_t *list) {
+    size_t position = 0;
+    for (const fossil_media_yaml_node_t *n = list; n; n = n->next) {
+        yaml_segment_t seg;
+        seg.key = n->key;
+        seg.len = n->key ? strlen(n->key) : 0;
+        seg.index = n->key ? SIZE_MAX : position++;
+        seg.hash = n->key ? yaml_hash_bytes(seg.key, seg.len) : yaml_hash_index(seg.index);
+        uint64_t h = yaml_hash_mix(parent, seg.hash);
+        yaml_slot_t *slot = (yaml_slot_t*)yaml_index_probe(doc, parent, &seg, h);
+        if (!slot->node) {
+            /* a repeated key keeps its first occurrence */
+            slot->parent = parent;
+            slot->node = n;
+            slot->hash = h;
+            slot->index = seg.index;
+        }
+        if (n->child) yaml_index_add(doc, n, n->child);
+    }
+}
+
+int fossil_media_yaml_index(const fossil_media_yaml_node_t *head) {
+    if (!head || !head->doc) return -1;
+    fossil_media_yaml_doc_t *doc = head->doc;
+    if (doc->slots) return 0;
+
+    size_t cap = 16;
+    while (cap < doc->count * 2) cap *= 2;
+    yaml_slot_t *slots = (yaml_slot_t*)fossil_media_arena_calloc(&doc->arena, cap * sizeof(*slots));
+    if (!slots) return -1;
+    doc->slots = slots;
+    doc->mask = cap - 1;
+    yaml_index_add(doc, NULL, head);
+    return 0;
+}
+
+/* Split `path` into cp->segments, copying key text to `text`; 0 on success, -1 on a syntax error */
+static int yaml_path_parse(fossil_media_yaml_path_t *cp, const char *path, char *text) {
+    const char *p = path;
+    while (*p) {
+        yaml_segment_t *seg = &cp->segments[cp->count];
+        if (*p == '[') {
+            p++;
+            if (*p == '"' || *p == '\'') {
+                char quote = *p++;
+                const char *q = strchr(p, quote);
+                if (!q || q[1] != ']') return -1;
+                seg->key = text;
+                seg->len = (size_t)(q - p);
+                memcpy(text, p, seg->len);
+                text += seg->len;
+                *text++ = '\0';
+                seg->index = SIZE_MAX;
+                seg->hash = yaml_hash_bytes(seg->key, seg->len);
+                p = q + 2;
+            } else {
+                if (*p < '0' || *p > '9') return -1;
+                size_t index = 0;
+                while (*p >= '0' && *p <= '9' && index < SIZE_MAX / 10 - 1)
+                    index = index * 10 + (size_t)(*p++ - '0');
+                if (*p != ']') return -1;
+                p++;
+                seg->key = NULL;
+                seg->len = 0;
+                seg->index = index;
+                seg->hash = yaml_hash_index(index);
+            }
+        } else {
+            const char *q = p;
+            while (*q && *q != '.' && *q != '[') q++;
+            if (q == p) return -1;
+            seg->key = text;
+            seg->len = (size_t)(q - p);
+            memcpy(text, p, seg->len);
+            text += seg->len;
+            *text++ = '\0';
+            seg->index = SIZE_MAX;
+            seg->hash = yaml_hash_bytes(seg->key, seg->len);
+            p = q;
+        }
+        cp->count++;
+        if (*p == '.') {
+            p++;
+            if (!*p || *p == '[') return -1; /* a dot must be followed by a key */
+        } else if (*p && *p != '[') {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+fossil_media_yaml_path_t *fossil_media_yaml_path_compile(const char *path) {
+    if (!path || !*path) return NULL;
+
+    /* one allocation: header, segments (at most one per byte), then key text */
+    size_t len = strlen(path);
+    size_t header = sizeof(fossil_media_yaml_path_t);
+    header = (header + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    fossil_media_yaml_path_t *cp = (fossil_media_yaml_path_t*)malloc(header + (len + 1) * sizeof(yaml_segment_t) + len + 1);
+    if (!cp) return NULL;
+    cp->count = 0;
+    cp->segments = (yaml_segment_t*)((char*)cp + header);
+    char *text = (char*)(cp->segments + len + 1);
+
+    if (yaml_path_parse(cp, path, text) != 0) {
+        free(cp);
+        return NULL;
+    }
+    return cp;
+}
+
+void fossil_media_yaml_path_free(fossil_media_yaml_path_t *path) {
+    free(path);
+}
+
+const fossil_media_yaml_node_t *fossil_media_yaml_path_find(const fossil_media_yaml_node_t *head,
+                                                            const fossil_media_yaml_path_t *path) {
+    if (!head || !path) return NULL;
+    fossil_media_yaml_doc_t *doc = head->doc;
+    if (doc && fossil_media_yaml_index(head) != 0) doc = NULL;
+
+    const fossil_media_yaml_node_t *parent = NULL;
+    const fossil_media_yaml_node_t *list = head;
+    for (size_t i = 0; i < path->count; ++i) {
+        const yaml_segment_t *seg = &path->segments[i];
+        const fossil_media_yaml_node_t *found = NULL;
+        if (doc) {
+            found = yaml_index_probe(doc, parent, seg, yaml_hash_mix(parent, seg->hash))->node;
+        } else {
+            /* hand-built tree: walk the siblings */
+            size_t position = 0;
+            for (const fossil_media_yaml_node_t *n = list; n && !found; n = n->next) {
+                if (yaml_segment_matches(n, position, seg)) found = n;
+                if (!n->key) position++;
+            }
+        }
+        if (!found) return NULL;
+        parent = found;
+        list = found->child;
+    }
+    return parent;
+}
+
+const fossil_media_yaml_node_t *fossil_media_yaml_find(const fossil_media_yaml_node_t *head, const char *path) {
+    fossil_media_yaml_path_t *cp = fossil_media_yaml_path_compile(path);
+    const fossil_media_yaml_node_t *node = fossil_media_yaml_path_find(head, cp);
+    fossil_media_yaml_path_free(cp);
+    return node;
+}
+
+const char *fossil_media_yaml_get_path(const fossil_media_yaml_node_t *head, const char *path) {
+    const fossil_media_yaml_node_t *node = fossil_media_yaml_find(head, path);
+    return node ? node->value : NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * Multi-document streams
+ *
+ * A `---` or `...` line at column 0 always ends the current document, even
+ * inside block or quoted scalars, so the stream can be cut at those lines
+ * without parsing it. Every piece then holds at most one document.
+ * ------------------------------------------------------------------------- */
+
+#define YAML_STREAM_BLOCK (64 * 1024)
+
+struct fossil_media_yaml_stream {
+    const char *data;  /* window over the input */
+    size_t len;
+    size_t pos;        /* start of the next piece */
+    size_t scan;       /* where the marker search resumes */
+    int fd;            /* -1 for buffer input */
+    int eof;
+    char *buf;         /* read buffer for descriptor input */
+    size_t cap;
+    fossil_media_yaml_doc_t doc; /* reused for every document */
+};
+
+/* 1 if a marker line starts at `d`, 0 if not, -1 if more bytes are needed to tell */
+static int yaml_marker_at(const char *d, size_t avail, int final) {
+    const char *m = (avail && d[0] == '.') ? "..." : "---";
+    for (size_t k = 0; k < avail && k < 3; ++k) {
+        if (d[k] != m[k]) return 0;
+    }
+    if (avail < 4) return final ? avail == 3 : -1;
+    return d[3] == ' ' || d[3] == '\t' || d[3] == '\n' || d[3] == '\r';
+}
+
+/*
+ * Find the first marker line after the line at `*scan`. Returns 1 with its
+ * offset in `*out`, 0 when the data ends without one (only if `final`), or
+ * -1 when more data is needed; `*scan` is left where the search can resume.
+ */
+static int yaml_next_marker(const char *d, size_t len, size_t *scan, int final, size_t *out) {
+    for (;;) {
+        const char *nl = *scan < len ? (const char*)memchr(d + *scan, '\n', len - *scan) : NULL;
+        if (!nl) {
+            if (!final) return -1;
+            *out = len;
+            return 0;
+        }
+        size_t i = (size_t)(nl - d) + 1;
+        int m = yaml_marker_at(d + i, len - i, final);
+        if (m < 0) return -1;
+        if (m) {
+            *out = i;
+            return 1;
+        }
+        *scan = i;
+    }
+}
+
+/* Descriptor input: drop consumed bytes and read another block */
+static int yaml_stream_fill(fossil_media_yaml_stream_t *st) {
+    if (st->pos) {
+        memmove(st->buf, st->buf + st->pos, st->len - st->pos);
+        st->len -= st->pos;
+        st->scan -= st->pos;
+        st->pos = 0;
+    }
+    if (st->len == st->cap) {
+        size_t cap = st->cap ? st->cap * 2 : YAML_STREAM_BLOCK;
+        char *grown = (char*)realloc(st->buf, cap);
+        if (!grown) return -1;
+        st->buf = grown;
+        st->cap = cap;
+    }
+    for (;;) {
+        long n = (long)yaml_read_fd(st->fd, st->buf + st->len, st->cap - st->len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) st->eof = 1;
+        st->len += (size_t)n;
+        st->data = st->buf;
+        return 0;
+    }
+}
+
+static fossil_media_yaml_stream_t *yaml_stream_new(void) {
+    fossil_media_yaml_stream_t *st = (fossil_media_yaml_stream_t*)calloc(1, sizeof(*st));
+    if (!st) return NULL;
+    st->fd = -1;
+    st->doc.borrowed = 1;
+    fossil_media_arena_init(&st->doc.arena, 16 * 1024);
+    return st;
+}
+
+fossil_media_yaml_stream_t *fossil_media_yaml_stream_open_buffer(const char *data, size_t len) {
+    if (!data && len) return NULL;
+    fossil_media_yaml_stream_t *st = yaml_stream_new();
+    if (!st) return NULL;
+    st->data = data ? data : "";
+    st->len = len;
+    st->eof = 1;
+    return st;
+}
+
+fossil_media_yaml_stream_t *fossil_media_yaml_stream_open_fd(int fd) {
+    if (fd < 0) return NULL;
+    fossil_media_yaml_stream_t *st = yaml_stream_new();
+    if (!st) return NULL;
+    st->fd = fd;
+    st->data = "";
+    return st;
+}
+
+int fossil_media_yaml_stream_next(fossil_media_yaml_stream_t *stream, fossil_media_yaml_node_t **out_doc) {
+    if (!stream || !out_doc) return -1;
+    *out_doc = NULL;
+
+    fossil_media_yaml_stream_t *st = stream;
+    for (;;) {
+        if (st->pos >= st->len && st->eof) return 0;
+        if (st->scan < st->pos) st->scan = st->pos;
+
+        size_t end;
+        if (yaml_next_marker(st->data, st->len, &st->scan, st->eof, &end) < 0) {
+            if (st->fd < 0 || yaml_stream_fill(st) != 0) return -1;
+            continue;
+        }
+
+        fossil_media_arena_reset(&st->doc.arena);
+        fossil_media_yaml_node_t *head;
+        int rc = yaml_build(&st->doc, st->data + st->pos, end - st->pos, &head);
+        st->pos = st->scan = end;
+        if (rc < 0) return -1;
+        if (rc > 0) {
+            *out_doc = head;
+            return 1;
+        }
+        /* a piece holding only comments or directives */
+    }
+}
+
+void fossil_media_yaml_stream_close(fossil_media_yaml_stream_t *stream) {
+    if (!stream) return;
+    fossil_media_arena_destroy(&stream->doc.arena);
+    free(stream->buf);
+    free(stream);
+}
+
+typedef struct {
+    const char *data;
+    const size_t *cuts;              /* piece i is [cuts[i], cuts[i + 1]) */
+    fossil_media_yaml_node_t **heads;
+    int *status;                     /* yaml_build() result per piece */
+} yaml_batch_t;
+
+static void yaml_parse_piece(void *ctx, size_t index, size_t worker) {
+    yaml_batch_t *batch = (yaml_batch_t*)ctx;
+    (void)worker;
+    size_t start = batch->cuts[index], len = batch->cuts[index + 1] - start;
+    fossil_media_yaml_doc_t *doc = (fossil_media_yaml_doc_t*)calloc(1, sizeof(*doc));
+    if (!doc) {
+        batch->status[index] = -1;
+        return;
+    }
+    fossil_media_arena_init(&doc->arena, yaml_arena_hint(len));
+    batch->status[index] = yaml_build(doc, batch->data + start, len, &batch->heads[index]);
+    if (!batch->heads[index]) {
+        /* no tree to own the document */
+        fossil_media_arena_destroy(&doc->arena);
+        free(doc);
+    }
+}
+
+int fossil_media_yaml_parse_all(const char *data, size_t len, size_t threads,
+                                fossil_media_yaml_node_t ***out_docs, size_t *out_count) {
+    if ((!data && len) || !out_docs || !out_count) return -1;
+    *out_docs = NULL;
+    *out_count = 0;
+    if (!data) data = "";
+
+    /* pre-scan: cut points at every marker line */
+    size_t *cuts = NULL, ncuts = 0, cap = 0;
+    size_t scan = 0, end = 0;
+    int more = 1;
+    while (more) {
+        if (ncuts + 2 > cap) {
+            cap = cap ? cap * 2 : 64;
+            size_t *grown = (size_t*)realloc(cuts, cap * sizeof(*cuts));
+            if (!grown) {
+                free(cuts);
+                return -1;
+            }
+            cuts = grown;
+        }
+        cuts[ncuts++] = scan;
+        more = yaml_next_marker(data, len, &scan, 1, &end) > 0;
+        scan = end;
+    }
+    cuts[ncuts] = len;
+
+    size_t pieces = ncuts;
+    yaml_batch_t batch;
+    batch.data = data;
+    batch.cuts = cuts;
+    batch.heads = (fossil_media_yaml_node_t**)calloc(pieces, sizeof(*batch.heads));
+    batch.status = (int*)calloc(pieces, sizeof(*batch.status));
+    int rc = -1;
+    if (batch.heads && batch.status &&
+        fossil_media_parallel_run(pieces, fossil_media_parallel_workers(threads, pieces), yaml_parse_piece, &batch) == 0) {
+        rc = 0;
+        for (size_t i = 0; i < pieces; ++i) {
+            if (batch.status[i] < 0) rc = -1;
+        }
+    }
+
+    if (rc == 0) {
+        /* keep one entry per piece that held a document, in order */
+        size_t count = 0;
+        for (size_t i = 0; i < pieces; ++i) {
+            if (batch.status[i] > 0) batch.heads[count++] = batch.heads[i];
+        }
+        *out_docs = batch.heads;
+        *out_count = count;
+    } else if (batch.heads) {
+        for (size_t i = 0; i < pieces; ++i) fossil_media_yaml_free(batch.heads[i]);
+        free(batch.heads);
+    }
+    free(batch.status);
+    free(cuts);
+    return rc;
+}
+
+void fossil_media_yaml_free_all(fossil_media_yaml_node_t **docs, size_t count) {
+    if (!docs) return;
+    for (size_t i = 0; i < count; ++i) fossil_media_yaml_free(docs[i]);
+    free(docs);
+}
+
+/* ---------------------------------------------------------------------------
+ * Emitting
+ *
+ * The emitter writes block style by default and keeps only a stack of open
+ * collections. Nothing is written for a collection until its first entry
+ * arrives, which is what allows empty collections to come out as `{}`/`[]`
+ * and a mapping inside a sequence item to start on the dash's line.
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    unsigned char is_map;
+    unsigned char flow;
+    unsigned char expect_key;
+    unsigned char has_value;  /* MAPPING_START carried a scalar (legacy form) */
+    size_t col;               /* column of the entries (block style) */
+    size_t count;             /* entries written so far */
+} yaml_emit_frame_t;
+
+struct fossil_media_yaml_emitter {
+    fossil_media_writer_t w;
+    fossil_media_yaml_emit_options_t opt;
+    yaml_emit_frame_t *stack;
+    size_t depth;
+    size_t cap;
+    size_t docs;       /* documents started */
+    int in_doc;
+    int line_open;     /* the current line has content and no newline yet */
+    int need_space;    /* the next token on this line needs a separating space */
+    int after_dash;    /* the last token was a sequence dash */
+    int error;
+    char buf[4096];
+};
+
+/* Scalar style chosen by yaml_scalar_style() */
+enum { YAML_OUT_PLAIN, YAML_OUT_SINGLE, YAML_OUT_DOUBLE, YAML_OUT_LITERAL, YAML_OUT_EMPTY };
+
+static void em_write(fossil_media_yaml_emitter_t *e, const char *s, size_t n) {
+    if (!e->error) e->error = fossil_media_writer_write(&e->w, s, n);
+}
+
+static void em_puts(fossil_media_yaml_emitter_t *e, const char *s) {
+    em_write(e, s, strlen(s));
+}
+
+static void em_spaces(fossil_media_yaml_emitter_t *e, size_t n) {
+    static const char spaces[] = "                                ";
+    while (n) {
+        size_t k = n < sizeof(spaces) - 1 ? n : sizeof(spaces) - 1;
+        em_write(e, spaces, k);
+        n -= k;
+    }
+}
+
+static void em_newline(fossil_media_yaml_emitter_t *e) {
+    if (e->line_open) em_write(e, "\n", 1);
+    e->line_open = 0;
+    e->need_space = 0;
+    e->after_dash = 0;
+}
+
+/* Begin a token on the current line */
+static void em_token(fossil_media_yaml_emitter_t *e) {
+    if (e->need_space) em_write(e, " ", 1);
+    e->need_space = 0;
+    e->after_dash = 0;
+    e->line_open = 1;
+}
+
+/* Begin a block entry at `col`, on the dash's line when directly after one */
+static void em_block_entry(fossil_media_yaml_emitter_t *e, size_t col) {
+    if (e->line_open && e->after_dash) {
+        em_token(e);
+        return;
+    }
+    em_newline(e);
+    em_spaces(e, col);
+    e->line_open = 1;
+}
+
+/*
+ * Pick a style for a scalar with one scan over its bytes. `flow` adds the
+ * flow indicators to the unsafe set, `is_key` rules out block scalars and
+ * skips the check that a plain string does not read back as another type.
+ */
+static int yaml_scalar_style(const fossil_media_yaml_emitter_t *e, const char *s, size_t n,
+                             fossil_media_yaml_type_t type, int flow, int is_key) {
+    if (n == 0) return type == FOSSIL_MEDIA_YAML_TYPE_NULL ? YAML_OUT_EMPTY : YAML_OUT_SINGLE;
+
+    int unsafe = 0, newline = 0, control = 0, cr = 0;
+    unsigned char first = (unsigned char)s[0];
+    if (strchr("&*!|>'\"%@`#,[]{}", first) ||
+        (strchr("-?:", first) && (n == 1 || s[1] == ' ' || s[1] == '\t')) ||
+        first == ' ' || s[n - 1] == ' ' || s[n - 1] == ':' ||
+        (n >= 3 && (memcmp(s, "---", 3) == 0 || memcmp(s, "...", 3) == 0)))
+        unsafe = 1;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '\n') newline = 1;
+        else if (c == '\r') cr = 1;
+        else if ((c < 0x20 && c != '\t') || c == 0x7F) control = 1;
+        else if (c == '\t') unsafe = 1;
+        else if (c == ':' && i + 1 < n && (s[i + 1] == ' ' || (flow && strchr(",[]{}", s[i + 1])))) unsafe = 1;
+        else if (c == '#' && i > 0 && s[i - 1] == ' ') unsafe = 1;
+        else if (flow && strchr(",[]{}", c)) unsafe = 1;
+    }
+
+    if (type != FOSSIL_MEDIA_YAML_TYPE_STRING && !unsafe && !newline && !control && !cr) return YAML_OUT_PLAIN;
+    if (control || cr) return YAML_OUT_DOUBLE;
+    if (newline) {
+        int literal_ok = !flow && !is_key && e->opt.quote == FOSSIL_MEDIA_YAML_QUOTE_AUTO &&
+                         first != ' ' && first != '\n' && first != '\t';
+        return literal_ok ? YAML_OUT_LITERAL : YAML_OUT_DOUBLE;
+    }
+    if (!is_key && e->opt.quote == FOSSIL_MEDIA_YAML_QUOTE_DOUBLE) return YAML_OUT_DOUBLE;
+    if (!is_key && e->opt.quote == FOSSIL_MEDIA_YAML_QUOTE_SINGLE) return YAML_OUT_SINGLE;
+    if (unsafe) return YAML_OUT_SINGLE;
+    if (!is_key && resolve_plain(s, n) != FOSSIL_MEDIA_YAML_TYPE_STRING) return YAML_OUT_SINGLE;
+    return YAML_OUT_PLAIN;
+}
+
+static void em_double_quoted(fossil_media_yaml_emitter_t *e, const char *s, size_t n) {
+    static const char hex[] = "0123456789ABCDEF";
+    em_write(e, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned char c = (unsigned char)s[i];
+        const char *esc = NULL;
+        char code[4];
+        switch (c) {
+            case '"': esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\t': esc = "\\t"; break;
+            case '\r': esc = "\\r"; break;
+            case '\0': esc = "\\0"; break;
+            default:
+                if (c < 0x20 || c == 0x7F) {
+                    code[0] = 'x';
+                    code[1] = hex[c >> 4];
+                    code[2] = hex[c & 15];
+                    code[3] = '\0';
+                }
+                break;
+        }
+        if (!esc && c >= 0x20 && c != 0x7F) continue;
+        em_write(e, s + run, i - run);
+        if (esc) {
+            em_puts(e, esc);
+        } else {
+            em_write(e, "\\", 1);
+            em_write(e, code, 3);
+        }
+        run = i + 1;
+    }
+    em_write(e, s + run, n - run);
+    em_write(e, "\"", 1);
+}
+
+static void em_single_quoted(fossil_media_yaml_emitter_t *e, const char *s, size_t n) {
+    em_write(e, "'", 1);
+    const char *q;
+    while ((q = (const char*)memchr(s, '\'', n)) != NULL) {
+        em_write(e, s, (size_t)(q - s) + 1);
+        em_write(e, "'", 1);
+        n -= (size_t)(q - s) + 1;
+        s = q + 1;
+    }
+    em_write(e, s, n);
+    em_write(e, "'", 1);
+}
+
+/* `|` block scalar whose lines are indented to `col` */
+static void em_literal(fossil_media_yaml_emitter_t *e, const char *s, size_t n, size_t col) {
+    size_t trailing = 0;
+    while (trailing < n && s[n - 1 - trailing] == '\n') trailing++;
+    n -= trailing;
+    em_puts(e, trailing == 0 ? "|-" : trailing == 1 ? "|" : "|+");
+    while (n) {
+        const char *nl = (const char*)memchr(s, '\n', n);
+        size_t len = nl ? (size_t)(nl - s) : n;
+        em_newline(e);
+        if (len) {
+            em_spaces(e, col);
+            em_write(e, s, len);
+        }
+        e->line_open = 1;
+        if (!nl) break;
+        n -= len + 1;
+        s = nl + 1;
+    }
+    em_newline(e);
+    for (size_t i = 1; i < trailing; ++i) em_write(e, "\n", 1);
+}
+
+static void em_scalar(fossil_media_yaml_emitter_t *e, const char *s, size_t n, fossil_media_yaml_type_t type,
+                      int flow, int is_key, size_t block_col) {
+    int style = yaml_scalar_style(e, s, n, type, flow, is_key);
+    if (style == YAML_OUT_EMPTY) {
+        if (flow) {
+            em_token(e);
+            em_write(e, "~", 1);
+        }
+        return;
+    }
+    em_token(e);
+    switch (style) {
+        case YAML_OUT_PLAIN: em_write(e, s, n); break;
+        case YAML_OUT_SINGLE: em_single_quoted(e, s, n); break;
+        case YAML_OUT_DOUBLE: em_double_quoted(e, s, n); break;
+        default: em_literal(e, s, n, block_col); break;
+    }
+}
+
+static int em_push(fossil_media_yaml_emitter_t *e, int is_map, int flow, size_t col, int has_value) {
+    if (e->depth == e->cap) {
+        size_t cap = e->cap ? e->cap * 2 : 16;
+        yaml_emit_frame_t *grown = (yaml_emit_frame_t*)realloc(e->stack, cap * sizeof(*grown));
+        if (!grown) return -1;
+        e->stack = grown;
+        e->cap = cap;
+    }
+    yaml_emit_frame_t *f = &e->stack[e->depth++];
+    f->is_map = (unsigned char)is_map;
+    f->flow = (unsigned char)flow;
+    f->expect_key = (unsigned char)is_map;
+    f->has_value = (unsigned char)has_value;
+    f->col = col;
+    f->count = 0;
+    return 0;
+}
+
+/* A value (scalar or whole collection) has been written in the top frame */
+static void em_value_done(fossil_media_yaml_emitter_t *e) {
+    if (e->depth && e->stack[e->depth - 1].is_map) e->stack[e->depth - 1].expect_key = 1;
+}
+
+static void em_document_start(fossil_media_yaml_emitter_t *e) {
+    if (e->docs > 0 || e->opt.explicit_start) {
+        em_newline(e);
+        em_write(e, "---", 3);
+        e->line_open = 1;
+        e->need_space = 1;
+    }
+    e->docs++;
+    e->in_doc = 1;
+}
+
+int fossil_media_yaml_emitter_event(const fossil_media_yaml_event_t *event, void *emitter) {
+    fossil_media_yaml_emitter_t *e = (fossil_media_yaml_emitter_t*)emitter;
+    if (!e || !event) return -1;
+    if (e->error) return e->error;
+
+    if (event->type == FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_START) {
+        if (e->depth) return e->error = -1;
+        em_document_start(e);
+        return e->error;
+    }
+    if (event->type == FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_END) {
+        if (e->depth) return e->error = -1;
+        em_newline(e);
+        e->in_doc = 0;
+        return e->error;
+    }
+    if (event->type == FOSSIL_MEDIA_YAML_EVENT_MAPPING_END || event->type == FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END) {
+        if (!e->depth) return e->error = -1;
+        yaml_emit_frame_t *f = &e->stack[e->depth - 1];
+        if ((event->type == FOSSIL_MEDIA_YAML_EVENT_MAPPING_END) != f->is_map || (f->is_map && !f->expect_key))
+            return e->error = -1;
+        if (f->flow) {
+            em_write(e, f->is_map ? "}" : "]", 1);
+            e->line_open = 1;
+        } else if (f->count == 0 && !f->has_value) {
+            em_token(e);
+            em_write(e, f->is_map ? "{}" : "[]", 2);
+        }
+        e->depth--;
+        em_value_done(e);
+        return e->error;
+    }
+
+    /* a node: a scalar or the start of a collection */
+    if (!e->in_doc) {
+        if (e->docs && !e->depth) em_newline(e);
+        em_document_start(e);
+    }
+    yaml_emit_frame_t *parent = e->depth ? &e->stack[e->depth - 1] : NULL;
+    int is_key = parent && parent->is_map && parent->expect_key;
+    int flow = parent && parent->flow;
+    int is_scalar = event->type == FOSSIL_MEDIA_YAML_EVENT_SCALAR;
+    if (is_key && !is_scalar) return e->error = -1; /* complex keys are not supported */
+
+    /* separator / dash / indentation that introduces the node */
+    if (parent && (is_key || !parent->is_map)) {
+        if (flow) {
+            if (parent->count) em_write(e, ",", 1);
+            e->need_space = parent->count > 0;
+        } else if (is_key) {
+            em_block_entry(e, parent->col);
+        } else {
+            em_block_entry(e, parent->col);
+            em_write(e, "-", 1);
+            e->need_space = 1;
+            e->after_dash = 1;
+        }
+        parent->count++;
+    }
+
+    /* column of nested block content */
+    size_t step = e->opt.indent ? e->opt.indent : 2;
+    size_t child_col = !parent ? 0 : parent->is_map ? parent->col + step : parent->col + 2;
+
+    if (is_scalar) {
+        fossil_media_yaml_type_t type = event->scalar_type;
+        if (event->style != FOSSIL_MEDIA_YAML_STYLE_PLAIN) type = FOSSIL_MEDIA_YAML_TYPE_STRING;
+        int after_dash = e->after_dash;
+        em_scalar(e, event->value ? event->value : "", event->value ? event->length : 0, type,
+                  flow, is_key, parent ? parent->col + step : step);
+        if (after_dash && e->after_dash) e->after_dash = 0; /* empty item: nothing may join the dash line */
+        if (is_key) {
+            em_write(e, ":", 1);
+            e->need_space = 1;
+            parent->expect_key = 0;
+        } else {
+            em_value_done(e);
+        }
+        return e->error;
+    }
+
+    int is_map = event->type == FOSSIL_MEDIA_YAML_EVENT_MAPPING_START;
+    if (!is_map && event->type != FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START) return e->error = -1;
+    int child_flow = flow || event->flow;
+    int has_value = is_map && !child_flow && event->value && event->length;
+    if (child_flow) {
+        em_token(e);
+        em_write(e, is_map ? "{" : "[", 1);
+    } else if (has_value) {
+        /* legacy "key: value" followed by indented entries; the value must
+         * stay on one line, which key styling guarantees */
+        em_scalar(e, event->value, event->length, FOSSIL_MEDIA_YAML_TYPE_STRING, 0, 1, child_col);
+        e->after_dash = 0;
+    }
+    if (em_push(e, is_map, child_flow, child_col, has_value) != 0) return e->error = -1;
+    return e->error;
+}
+
+fossil_media_yaml_emitter_t *fossil_media_yaml_emitter_new(const fossil_media_yaml_emit_options_t *options,
+                                                           fossil_media_sink_fn sink, void *user) {
+    if (!sink) return NULL;
+    fossil_media_yaml_emitter_t *e = (fossil_media_yaml_emitter_t*)calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    if (options) e->opt = *options;
+    fossil_media_writer_init(&e->w, sink, user, e->buf, sizeof(e->buf));
+    return e;
+}
+
+int fossil_media_yaml_emitter_finish(fossil_media_yaml_emitter_t *emitter) {
+    if (!emitter) return -1;
+    if (emitter->depth && !emitter->error) emitter->error = -1;
+    em_newline(emitter);
+    int rc = fossil_media_writer_flush(&emitter->w);
+    return emitter->error ? emitter->error : rc;
+}
+
+void fossil_media_yaml_emitter_free(fossil_media_yaml_emitter_t *emitter) {
+    if (!emitter) return;
+    free(emitter->stack);
+    free(emitter);
+}
+
+static void yaml_emit_event(fossil_media_yaml_emitter_t *e, fossil_media_yaml_event_type_t type,
+                            const char *value, fossil_media_yaml_type_t scalar_type) {
+    fossil_media_yaml_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.value = value;
+    ev.length = value ? strlen(value) : 0;
+    ev.scalar_type = scalar_type;
+    fossil_media_yaml_emitter_event(&ev, e);
+}
+
+static void yaml_emit_list(fossil_media_yaml_emitter_t *e, const fossil_media_yaml_node_t *list, int as_map);
+
+static void yaml_emit_value(fossil_media_yaml_emitter_t *e, const fossil_media_yaml_node_t *n) {
+    if (n->type == FOSSIL_MEDIA_YAML_TYPE_SEQUENCE) {
+        yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+        yaml_emit_list(e, n->child, 0);
+        yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    } else if (n->type == FOSSIL_MEDIA_YAML_TYPE_MAPPING || n->child) {
+        /* a scalar with children is the legacy "value plus nested keys" form */
+        yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_MAPPING_START, n->value, FOSSIL_MEDIA_YAML_TYPE_STRING);
+        yaml_emit_list(e, n->child, 1);
+        yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_MAPPING_END, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    } else {
+        yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_SCALAR, n->value ? n->value : "", n->type);
+    }
+}
+
+static void yaml_emit_list(fossil_media_yaml_emitter_t *e, const fossil_media_yaml_node_t *list, int as_map) {
+    for (const fossil_media_yaml_node_t *n = list; n && !e->error; n = n->next) {
+        if (as_map) {
+            yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_SCALAR, n->key ? n->key : "", FOSSIL_MEDIA_YAML_TYPE_STRING);
+        } else if (n->key) {
+            /* a keyed node among sequence items becomes a one-entry mapping */
+            yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_MAPPING_START, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+            yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_SCALAR, n->key, FOSSIL_MEDIA_YAML_TYPE_STRING);
+            yaml_emit_value(e, n);
+            yaml_emit_event(e, FOSSIL_MEDIA_YAML_EVENT_MAPPING_END, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+            continue;
+        }
+        yaml_emit_value(e, n);
+    }
+}
+
+int fossil_media_yaml_emit(const fossil_media_yaml_node_t *head, const fossil_media_yaml_emit_options_t *options,
+                           fossil_media_sink_fn sink, void *user) {
+    if (!head || !sink) return -1;
+    fossil_media_yaml_emitter_t e;
+    memset(&e, 0, sizeof(e));
+    if (options) e.opt = *options;
+    fossil_media_writer_init(&e.w, sink, user, e.buf, sizeof(e.buf));
+
+    int as_map = head->key != NULL;
+    fossil_media_yaml_event_type_t start = as_map ? FOSSIL_MEDIA_YAML_EVENT_MAPPING_START : FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_START;
+    yaml_emit_event(&e, FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_START, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    yaml_emit_event(&e, start, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    yaml_emit_list(&e, head, as_map);
+    yaml_emit_event(&e, (fossil_media_yaml_event_type_t)(start + 1), NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    yaml_emit_event(&e, FOSSIL_MEDIA_YAML_EVENT_DOCUMENT_END, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING);
+    int rc = fossil_media_yaml_emitter_finish(&e);
+    free(e.stack);
+    return rc;
+}
+
+char *fossil_media_yaml_emit_string(const fossil_media_yaml_node_t *head, const fossil_media_yaml_emit_options_t *options) {
+    fossil_media_buffer_t out = { NULL, 0, 0 };
+    if (fossil_media_yaml_emit(head, options, fossil_media_sink_buffer, &out) != 0 ||
+        fossil_media_sink_buffer(&out, "", 0) != 0) {
+        fossil_media_buffer_free(&out);
+        return NULL;
+    }
+    return out.data;
+}
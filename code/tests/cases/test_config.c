@@ -0,0 +1,356 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(c_config_fixture);
+
+FOSSIL_SETUP(c_config_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(c_config_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+static const char *config_defaults_ini =
+    "[server]\n"
+    "host = localhost\n"
+    "port = 8080\n"
+    "debug = no\n"
+    "[log]\n"
+    "level = info\n";
+
+static const char *config_site_toml =
+    "[server]\n"
+    "port = 9090\n"
+    "ratio = 0.25\n"
+    "tags = [\"a\", \"b\"]\n"
+    "[[replica]]\n"
+    "name = \"r1\"\n"
+    "[[replica]]\n"
+    "name = \"r2\"\n";
+
+static const char *config_host_yaml =
+    "server:\n"
+    "  host: web-1\n"
+    "  workers: 0x10\n"
+    "log:\n"
+    "  targets:\n"
+    "    - stderr\n"
+    "    - file\n";
+
+static const char *config_env_fson =
+    "{\n"
+    "    server: object: {\n"
+    "        debug: bool: true\n"
+    "    }\n"
+    "}";
+
+FOSSIL_TEST_CASE(c_test_config_precedence) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_NOT_CNULL(cfg);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "defaults.ini", config_defaults_ini, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_string(cfg, "site.toml", config_site_toml, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(2, fossil_media_config_add_string(cfg, "host.yaml", config_host_yaml, FOSSIL_MEDIA_CONFIG_YAML));
+    ASSUME_ITS_EQUAL_I32(3, fossil_media_config_add_string(cfg, "env", config_env_fson, FOSSIL_MEDIA_CONFIG_FSON));
+    ASSUME_ITS_EQUAL_SIZE(4, fossil_media_config_layer_count(cfg));
+
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.host"), "web-1") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.port"), "9090") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "log.level"), "info") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.tags[1]"), "b") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "replica[1].name"), "r2") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "log.targets[0]"), "stderr") == 0);
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "server.missing"));
+
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(snap, "server.host"), "host.yaml") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(snap, "server.port"), "site.toml") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(snap, "server.debug"), "env") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(snap, "log.level"), "defaults.ini") == 0);
+
+    const fossil_media_config_value_t *v = fossil_media_config_lookup(snap, "server.port");
+    ASSUME_NOT_CNULL(v);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_CONFIG_INTEGER, v->type);
+    ASSUME_ITS_EQUAL_SIZE(1, v->layer);
+
+    /* every key once, highest precedence first */
+    ASSUME_ITS_EQUAL_SIZE(12, fossil_media_config_count(snap));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_at(snap, 0)->key, "server.debug") == 0);
+    ASSUME_ITS_CNULL(fossil_media_config_at(snap, 12));
+
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_typed_getters) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "defaults.ini", config_defaults_ini, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_string(cfg, "site.toml", config_site_toml, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(2, fossil_media_config_add_string(cfg, "host.yml", config_host_yaml, FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+
+    int64_t i = 0;
+    double d = 0;
+    int b = -1;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "server.port", &i));
+    ASSUME_ITS_TRUE(i == 9090);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "server.workers", &i));
+    ASSUME_ITS_TRUE(i == 16);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_double(snap, "server.ratio", &d));
+    ASSUME_ITS_TRUE(d == 0.25);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_double(snap, "server.port", &d));
+    ASSUME_ITS_TRUE(d == 9090.0);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_bool(snap, "server.debug", &b));
+    ASSUME_ITS_EQUAL_I32(0, b);
+    ASSUME_ITS_TRUE(fossil_media_config_get_int(snap, "server.host", &i) != 0);
+    ASSUME_ITS_TRUE(fossil_media_config_get_bool(snap, "log.level", &b) != 0);
+    ASSUME_ITS_TRUE(fossil_media_config_get_int(snap, "nope", &i) != 0);
+
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_int_strings) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "env.ini",
+        "[n]\nlead = 010\neight = 08\nhex = 0x1F\nneg = -0X10\nnohex = 0x\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+
+    int64_t i = 0;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "n.lead", &i));
+    ASSUME_ITS_TRUE(i == 10);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "n.eight", &i));
+    ASSUME_ITS_TRUE(i == 8);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "n.hex", &i));
+    ASSUME_ITS_TRUE(i == 31);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_get_int(snap, "n.neg", &i));
+    ASSUME_ITS_TRUE(i == -16);
+    ASSUME_ITS_TRUE(fossil_media_config_get_int(snap, "n.nohex", &i) != 0);
+
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_arrays_replace) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "site.toml",
+        "hosts = [\"a\", \"b\", \"c\"]\n"
+        "ports = [1, 2]\n"
+        "db = \"sqlite\"\n"
+        "[server]\n"
+        "host = \"a\"\n"
+        "port = 1\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_string(cfg, "host.yaml",
+        "hosts: [z]\n"
+        "ports: []\n"
+        "server:\n"
+        "  port: 2\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+
+    /* arrays are replaced whole, empty ones included */
+    ASSUME_ITS_EQUAL_CSTR("z", fossil_media_config_get(snap, "hosts[0]"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "hosts[1]"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "hosts[2]"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "ports[0]"));
+    /* tables still merge */
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_config_get(snap, "server.port"));
+    ASSUME_ITS_EQUAL_CSTR("a", fossil_media_config_get(snap, "server.host"));
+    ASSUME_ITS_EQUAL_CSTR("sqlite", fossil_media_config_get(snap, "db"));
+    ASSUME_ITS_EQUAL_SIZE(4, fossil_media_config_count(snap));
+    fossil_media_config_snapshot_free(snap);
+
+    /* a scalar hides a lower table, and a list hides a lower scalar of the same name */
+    ASSUME_ITS_EQUAL_I32(2, fossil_media_config_add_string(cfg, "env.yaml",
+        "server: off\n"
+        "db: [pg]\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+    ASSUME_ITS_EQUAL_CSTR("off", fossil_media_config_get(snap, "server"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "server.port"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "server.host"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "db"));
+    ASSUME_ITS_EQUAL_CSTR("pg", fossil_media_config_get(snap, "db[0]"));
+    fossil_media_config_snapshot_free(snap);
+
+    /* and a table hides a lower scalar or list of the same name */
+    ASSUME_ITS_EQUAL_I32(3, fossil_media_config_add_string(cfg, "local.toml",
+        "server.port = 3\n"
+        "db.name = \"x\"\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "server"));
+    ASSUME_ITS_EQUAL_CSTR("3", fossil_media_config_get(snap, "server.port"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "db[0]"));
+    ASSUME_ITS_EQUAL_CSTR("x", fossil_media_config_get(snap, "db.name"));
+    ASSUME_ITS_EQUAL_CSTR("z", fossil_media_config_get(snap, "hosts[0]"));
+    ASSUME_ITS_EQUAL_SIZE(3, fossil_media_config_count(snap));
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_toml_datetimes) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "site.toml",
+        "when = [1979-05-27, 1979-05-27T07:32:00.500-07:00, 07:32:00]\n"
+        "at = 1979-05-27 07:32:00\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+    ASSUME_ITS_EQUAL_CSTR("1979-05-27", fossil_media_config_get(snap, "when[0]"));
+    ASSUME_ITS_EQUAL_CSTR("1979-05-27T07:32:00.5-07:00", fossil_media_config_get(snap, "when[1]"));
+    ASSUME_ITS_EQUAL_CSTR("07:32:00", fossil_media_config_get(snap, "when[2]"));
+    ASSUME_ITS_EQUAL_CSTR("1979-05-27 07:32:00", fossil_media_config_get(snap, "at"));
+    ASSUME_ITS_EQUAL_SIZE(4, fossil_media_config_count(snap));
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_key_spelling) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "defaults.ini",
+        "[server]\nmy key = a\n[server.tls]\nport = 1\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_string(cfg, "site.toml",
+        "[server]\n\"my key\" = \"b\"\n[server.tls]\nport = 2\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(2, fossil_media_config_add_string(cfg, "host.yaml",
+        "site:\n  google.com: up\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+
+    /* the TOML layer overrides the INI keys, quoted or dotted */
+    ASSUME_ITS_EQUAL_CSTR("b", fossil_media_config_get(snap, "server.\"my key\""));
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_config_get(snap, "server.tls.port"));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "server.my key"));
+    ASSUME_ITS_EQUAL_CSTR("up", fossil_media_config_get(snap, "site.\"google.com\""));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "site.google.com"));
+    ASSUME_ITS_EQUAL_SIZE(3, fossil_media_config_count(snap));
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_update_layer) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "defaults.ini", config_defaults_ini, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_string(cfg, "env.ini", "[server]\nport = 1\n", FOSSIL_MEDIA_CONFIG_AUTO));
+    fossil_media_config_snapshot_t *before = fossil_media_config_snapshot(cfg);
+
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_update(cfg, 1, "[log]\nlevel = debug\n"));
+    fossil_media_config_snapshot_t *after = fossil_media_config_snapshot(cfg);
+
+    /* the old snapshot is untouched */
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(before, "server.port"), "1") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(before, "log.level"), "info") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(after, "server.port"), "8080") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(after, "log.level"), "debug") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(after, "server.port"), "defaults.ini") == 0);
+
+    /* an empty update clears the layer; text layers cannot be reloaded */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_update(cfg, 1, ""));
+    ASSUME_ITS_TRUE(fossil_media_config_update(cfg, 5, "[a]\nb=c\n") != 0);
+    ASSUME_ITS_TRUE(fossil_media_config_reload(cfg, 1) != 0);
+
+    fossil_media_config_snapshot_free(before);
+    fossil_media_config_snapshot_free(after);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_reload_file) {
+    const char *path = "test_tmp_config.toml";
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_write_file(path, "[server]\nport = 1\n"));
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_add_string(cfg, "defaults.ini", config_defaults_ini, FOSSIL_MEDIA_CONFIG_AUTO));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_config_add_file(cfg, path, FOSSIL_MEDIA_CONFIG_AUTO));
+
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.port"), "1") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_origin(snap, "server.port"), path) == 0);
+    fossil_media_config_snapshot_free(snap);
+
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_write_file(path, "[server]\nport = 2\n"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_config_reload(cfg, 1));
+    snap = fossil_media_config_snapshot(cfg);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.port"), "2") == 0);
+    fossil_media_config_snapshot_free(snap);
+
+    /* a broken edit keeps what was loaded */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_write_file(path, "[server\nport = = 3\n"));
+    ASSUME_ITS_TRUE(fossil_media_config_reload(cfg, 1) != 0);
+    snap = fossil_media_config_snapshot(cfg);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_config_get(snap, "server.port"), "2") == 0);
+    fossil_media_config_snapshot_free(snap);
+
+    remove(path);
+    fossil_media_config_free(cfg);
+}
+
+FOSSIL_TEST_CASE(c_test_config_errors) {
+    fossil_media_config_t *cfg = fossil_media_config_new();
+    ASSUME_ITS_TRUE(fossil_media_config_add_string(cfg, "no-extension", "[a]\nb=c\n", FOSSIL_MEDIA_CONFIG_AUTO) < 0);
+    ASSUME_ITS_TRUE(fossil_media_config_add_string(cfg, "bad.toml", "x = = 1\n", FOSSIL_MEDIA_CONFIG_AUTO) < 0);
+    ASSUME_ITS_TRUE(fossil_media_config_add_file(cfg, "no_such_file.ini", FOSSIL_MEDIA_CONFIG_AUTO) < 0);
+    ASSUME_ITS_EQUAL_SIZE(0, fossil_media_config_layer_count(cfg));
+
+    fossil_media_config_snapshot_t *snap = fossil_media_config_snapshot(cfg);
+    ASSUME_NOT_CNULL(snap);
+    ASSUME_ITS_EQUAL_SIZE(0, fossil_media_config_count(snap));
+    ASSUME_ITS_CNULL(fossil_media_config_get(snap, "a.b"));
+    fossil_media_config_snapshot_free(snap);
+    fossil_media_config_free(cfg);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_GROUP(c_config_tests) {
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_precedence);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_typed_getters);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_int_strings);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_arrays_replace);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_toml_datetimes);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_key_spelling);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_update_layer);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_reload_file);
+    FOSSIL_TEST_ADD(c_config_fixture, c_test_config_errors);
+
+    FOSSIL_TEST_REGISTER(c_config_fixture);
+} // end of tests
@@ -0,0 +1,102 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(cpp_config_fixture);
+
+FOSSIL_SETUP(cpp_config_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(cpp_config_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+using fossil::media::Config;
+using fossil::media::ConfigSnapshot;
+
+FOSSIL_TEST_CASE(cpp_config_layers) {
+    Config cfg;
+    cfg.add_string("defaults.ini", "[server]\nport = 8080\nname = base\n", FOSSIL_MEDIA_CONFIG_AUTO);
+    size_t env = cfg.add_string("env.toml", "[server]\nport = 9090\ndebug = true\n", FOSSIL_MEDIA_CONFIG_TOML);
+
+    ConfigSnapshot snap = cfg.snapshot();
+    ASSUME_ITS_TRUE(snap.get("server.name") == "base");
+    ASSUME_ITS_TRUE(snap.get_int("server.port") == 9090);
+    ASSUME_ITS_TRUE(snap.get_bool("server.debug"));
+    ASSUME_ITS_TRUE(snap.origin("server.port") == "env.toml");
+    ASSUME_ITS_TRUE(snap.get("missing", "fallback") == "fallback");
+    ASSUME_ITS_TRUE(snap.get_double("missing", 1.5) == 1.5);
+    ASSUME_ITS_TRUE(!snap.contains("missing"));
+    ASSUME_ITS_EQUAL_SIZE(3, snap.size());
+
+    ASSUME_ITS_TRUE(cfg.update(env, "[server]\nport = 7070\n"));
+    ConfigSnapshot next = cfg.snapshot();
+    ASSUME_ITS_TRUE(next.get_int("server.port") == 7070);
+    ASSUME_ITS_TRUE(!next.get_bool("server.debug"));
+    ASSUME_ITS_TRUE(snap.get_int("server.port") == 9090);
+}
+
+FOSSIL_TEST_CASE(cpp_config_throw_on_bad_layer) {
+    Config cfg;
+    bool thrown = false;
+    try {
+        cfg.add_file("no_such_file.yaml");
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSUME_ITS_TRUE(thrown);
+
+    Config moved(std::move(cfg));
+    ASSUME_ITS_TRUE(moved.get() != nullptr);
+    ASSUME_ITS_TRUE(cfg.get() == nullptr);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_GROUP(cpp_config_tests) {
+    FOSSIL_TEST_ADD(cpp_config_fixture, cpp_config_layers);
+    FOSSIL_TEST_ADD(cpp_config_fixture, cpp_config_throw_on_bad_layer);
+
+    FOSSIL_TEST_REGISTER(cpp_config_fixture);
+} // end of tests
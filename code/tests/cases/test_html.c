@@ -282,6 +282,40 @@ FOSSIL_TEST_CASE(c_test_html_unclosed_tag) {
     fossil_media_html_free(doc);
 }
 
+FOSSIL_TEST_CASE(c_test_html_several_unquoted_attributes) {
+    const char *html = "<a href=x title=y class=z data-n=\"q\" rel=last>link</a>";
+    fossil_media_html_doc_t *doc = NULL;
+    int rc = fossil_media_html_load_string(html, &doc);
+    ASSUME_ITS_EQUAL_I32(rc, FOSSIL_MEDIA_HTML_OK);
+    fossil_media_html_node_t *a = fossil_media_html_find_by_tag(fossil_media_html_root(doc), "a");
+    ASSUME_NOT_CNULL(a);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(a, "href"), "x") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(a, "title"), "y") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(a, "class"), "z") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(a, "data-n"), "q") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(a, "rel"), "last") == 0);
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_set_attr_repeatedly) {
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_load_string("<p class=a></p>", &doc), FOSSIL_MEDIA_HTML_OK);
+    fossil_media_html_node_t *p = fossil_media_html_find_by_tag(fossil_media_html_root(doc), "p");
+    ASSUME_NOT_CNULL(p);
+    char value[64];
+    for (int i = 0; i < 2000; ++i) {
+        /* alternate growing and shrinking values, and add fresh attributes */
+        snprintf(value, sizeof(value), "%.*s%d", i % 40, "cccccccccccccccccccccccccccccccccccccccc", i);
+        ASSUME_ITS_EQUAL_I32(fossil_media_html_set_attr(p, "class", value), FOSSIL_MEDIA_HTML_OK);
+        ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(p, "class"), value) == 0);
+    }
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_set_attr(p, "id", "x"), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_set_attr(p, "title", "t"), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(p, "id"), "x") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_html_get_attr(p, "title"), "t") == 0);
+    fossil_media_html_free(doc);
+}
+
 FOSSIL_TEST_CASE(c_test_html_attribute_no_quotes) {
     const char *html = "<div id=main></div>";
     fossil_media_html_doc_t *doc = NULL;
@@ -467,6 +501,349 @@ FOSSIL_TEST_CASE(c_test_html_complete_document) {
     fossil_media_html_free(doc);
 }
 
+FOSSIL_TEST_CASE(c_test_html_select_id_class_tag) {
+    const char *html =
+        "<div id=\"main\" class=\"box wide\">"
+        "<p class=\"note\">One</p><p>Two</p><span class=\"note\">Three</span>"
+        "</div>";
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_load_string(html, &doc), FOSSIL_MEDIA_HTML_OK);
+
+    fossil_media_html_selector_t *sel = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("#main", &sel), FOSSIL_MEDIA_HTML_OK);
+    fossil_media_html_node_t *main_div = fossil_media_html_select_first(doc, sel);
+    ASSUME_NOT_CNULL(main_div);
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_tag(main_div), "div");
+    fossil_media_html_selector_free(sel);
+
+    fossil_media_html_node_list_t list = {0};
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile(".note", &sel), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_select(doc, sel, &list), 2);
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_tag(list.nodes[0]), "p");
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_tag(list.nodes[1]), "span");
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_node_list_free(&list);
+
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("div.box.wide > p", &sel), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_select(doc, sel, &list), 2);
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_node_list_free(&list);
+
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_select_attr_and_nth_child) {
+    const char *html =
+        "<ul><li><a href=\"https://x.org/a\">A</a></li><li><a href=\"/b\">B</a></li>"
+        "<li><a href=\"https://y.org/c\">C</a></li></ul>";
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_load_string(html, &doc), FOSSIL_MEDIA_HTML_OK);
+
+    fossil_media_html_selector_t *sel = NULL;
+    fossil_media_html_node_list_t list = {0};
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("a[href^=\"https://\"]", &sel), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_select(doc, sel, &list), 2);
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_node_list_free(&list);
+
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("ul li:nth-child(2) a", &sel), FOSSIL_MEDIA_HTML_OK);
+    fossil_media_html_node_t *a = fossil_media_html_select_first(doc, sel);
+    ASSUME_NOT_CNULL(a);
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_get_attr(a, "href"), "/b");
+    fossil_media_html_selector_free(sel);
+
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("li:nth-child(odd)", &sel), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_select(doc, sel, &list), 2);
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_node_list_free(&list);
+
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_select_all_iterator) {
+    const char *html = "<div><p>1</p><section><p>2</p></section><p>3</p></div>";
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_load_string(html, &doc), FOSSIL_MEDIA_HTML_OK);
+
+    fossil_media_html_selector_t *sel = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("div p, section", &sel), FOSSIL_MEDIA_HTML_OK);
+
+    fossil_media_html_select_iter_t it;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_select_all(doc, sel, &it), FOSSIL_MEDIA_HTML_OK);
+    const char *expected[] = { "p", "section", "p", "p" };
+    size_t count = 0;
+    fossil_media_html_node_t *n;
+    while ((n = fossil_media_html_select_next(&it)) != NULL) {
+        ASSUME_ITS_TRUE(count < 4);
+        ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_tag(n), expected[count]);
+        count++;
+    }
+    ASSUME_ITS_EQUAL_SIZE(count, 4);
+
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_select_index_invalidation) {
+    const char *html = "<div id=\"a\"></div><div></div>";
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_load_string(html, &doc), FOSSIL_MEDIA_HTML_OK);
+
+    fossil_media_html_selector_t *sel = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("#b", &sel), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_CNULL(fossil_media_html_select_first(doc, sel));
+
+    fossil_media_html_node_t *second = fossil_media_html_next_sibling(fossil_media_html_first_child(fossil_media_html_root(doc)));
+    ASSUME_NOT_CNULL(second);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_set_attr(second, "id", "b"), FOSSIL_MEDIA_HTML_OK);
+    ASSUME_ITS_TRUE(fossil_media_html_select_first(doc, sel) == second);
+
+    fossil_media_html_selector_free(sel);
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_selector_invalid) {
+    fossil_media_html_selector_t *sel = NULL;
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("div >", &sel), FOSSIL_MEDIA_HTML_ERR_PARSE);
+    ASSUME_ITS_CNULL(sel);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("a[href", &sel), FOSSIL_MEDIA_HTML_ERR_PARSE);
+    ASSUME_ITS_EQUAL_I32(fossil_media_html_selector_compile("p:hover", &sel), FOSSIL_MEDIA_HTML_ERR_PARSE);
+}
+
+static int c_rewrite_strip_script(fossil_media_html_element_t *el, void *user) {
+    (void)user;
+    fossil_media_html_element_remove(el);
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int c_rewrite_link(fossil_media_html_element_t *el, void *user) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s%s", (const char *)user, fossil_media_html_element_get_attr(el, "href"));
+    return fossil_media_html_element_set_attr(el, "href", buf);
+}
+
+static int c_rewrite_text(fossil_media_html_text_chunk_t *chunk, void *user) {
+    (void)user;
+    size_t len = 0;
+    const char *data = fossil_media_html_text_chunk_data(chunk, &len);
+    if (len == 6 && memcmp(data, "secret", 6) == 0)
+        fossil_media_html_text_chunk_replace(chunk, "******");
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static int c_rewrite_unwrap(fossil_media_html_element_t *el, void *user) {
+    (void)user;
+    fossil_media_html_element_unwrap(el);
+    return FOSSIL_MEDIA_HTML_OK;
+}
+
+static char *c_run_rewriter(const char *html, size_t chunk) {
+    fossil_media_buffer_t out = {0};
+    fossil_media_html_rewriter_t *rw = NULL;
+    if (fossil_media_html_rewriter_new(fossil_media_sink_buffer, &out, &rw) != FOSSIL_MEDIA_HTML_OK) return NULL;
+    fossil_media_html_rewriter_on_element(rw, "script", c_rewrite_strip_script, NULL);
+    fossil_media_html_rewriter_on_element(rw, "a[href^='/']", c_rewrite_link, (void *)"https://proxy.test");
+    fossil_media_html_rewriter_on_element(rw, "font", c_rewrite_unwrap, NULL);
+    fossil_media_html_rewriter_on_text(rw, "p.private", c_rewrite_text, NULL);
+
+    size_t len = strlen(html);
+    int rc = FOSSIL_MEDIA_HTML_OK;
+    for (size_t off = 0; off < len && rc == FOSSIL_MEDIA_HTML_OK; off += chunk) {
+        size_t n = len - off < chunk ? len - off : chunk;
+        rc = fossil_media_html_rewriter_write(rw, html + off, n);
+    }
+    if (rc == FOSSIL_MEDIA_HTML_OK) rc = fossil_media_html_rewriter_end(rw);
+    fossil_media_html_rewriter_free(rw);
+    if (rc != FOSSIL_MEDIA_HTML_OK) {
+        fossil_media_buffer_free(&out);
+        return NULL;
+    }
+    return out.data ? out.data : fossil_media_strdup("");
+}
+
+FOSSIL_TEST_CASE(c_test_html_rewriter_strip_and_rewrite) {
+    const char *html =
+        "<!DOCTYPE html><html><head><script type=\"text/javascript\">if (a < b) { x = \"</p>\"; }</script></head>"
+        "<body><!-- keep --><a href=\"/docs\" class='x'>Docs</a><a href=\"https://e.org\">Ext</a>"
+        "<p class=\"private\">secret</p><p>secret</p><font color=red>plain</font><br></body></html>";
+    const char *expected =
+        "<!DOCTYPE html><html><head></head>"
+        "<body><!-- keep --><a href=\"https://proxy.test/docs\" class=\"x\">Docs</a><a href=\"https://e.org\">Ext</a>"
+        "<p class=\"private\">******</p><p>secret</p>plain<br></body></html>";
+
+    char *whole = c_run_rewriter(html, strlen(html));
+    ASSUME_NOT_CNULL(whole);
+    ASSUME_ITS_EQUAL_CSTR(whole, expected);
+    free(whole);
+
+    /* chunk boundaries inside tags, comments and the script body */
+    char *tiny = c_run_rewriter(html, 3);
+    ASSUME_NOT_CNULL(tiny);
+    ASSUME_ITS_EQUAL_CSTR(tiny, expected);
+    free(tiny);
+}
+
+FOSSIL_TEST_CASE(c_test_html_rewriter_passthrough) {
+    const char *html = "<div data-x='a\"b'>text &amp; more<img src=x.png><?pi?><![CDATA[<x>]]></div>";
+    char *out = c_run_rewriter(html, 5);
+    ASSUME_NOT_CNULL(out);
+    ASSUME_ITS_EQUAL_CSTR(out, html);
+    free(out);
+
+    /* a rewritten tag whose value holds both quotes has its double quotes escaped */
+    out = c_run_rewriter("<a href=/x title=x\"y'z&amp;>t</a>", 4);
+    ASSUME_NOT_CNULL(out);
+    ASSUME_ITS_EQUAL_CSTR(out, "<a href=\"https://proxy.test/x\" title=\"x&quot;y'z&amp;\">t</a>");
+    free(out);
+}
+
+FOSSIL_TEST_CASE(c_test_html_extract_text) {
+    const char *html =
+        "<!DOCTYPE html><html><head><title>T</title>"
+        "<style>p { color: red; }</style>"
+        "<script>if (a < b) { document.write('</p>'); }</SCRIPT></head>"
+        "<body>  <h1>Caf&eacute; &amp; Bar</h1>\n\n"
+        "<!-- hidden <b>comment</b> -->"
+        "<p>Price:&nbsp;5&#8364; &lt;cheap&gt; &bogus; a < b</p>"
+        "<p>x<b>y</b>z &#x1F600;</p></body></html>";
+    char *text = NULL;
+    size_t len = 0;
+    int rc = fossil_media_html_extract_text(html, strlen(html), &text, &len);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, rc);
+    ASSUME_ITS_EQUAL_CSTR(text,
+        "T Caf\xC3\xA9 & Bar Price:\xC2\xA0" "5\xE2\x82\xAC <cheap> &bogus; a < b xyz \xF0\x9F\x98\x80");
+    ASSUME_ITS_EQUAL_SIZE(strlen(text), len);
+    free(text);
+}
+
+FOSSIL_TEST_CASE(c_test_html_extract_text_edge_cases) {
+    char *text = NULL;
+    size_t len = 1;
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_extract_text("", 0, &text, &len));
+    ASSUME_ITS_EQUAL_CSTR(text, "");
+    ASSUME_ITS_EQUAL_SIZE((size_t)0, len);
+    free(text);
+
+    const char *unterminated = "<p title=\"a>b\">ok</p><script>never closed";
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK,
+                         fossil_media_html_extract_text(unterminated, strlen(unterminated), &text, NULL));
+    ASSUME_ITS_EQUAL_CSTR(text, "ok");
+    free(text);
+
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_ERR_INVALID_ARG,
+                         fossil_media_html_extract_text(NULL, 4, &text, NULL));
+}
+
+FOSSIL_TEST_CASE(c_test_html_serialize_faithful) {
+    const char *html =
+        "<!DOCTYPE html><?xml-stylesheet href=\"a.css\"?><html><head><meta charset=\"UTF-8\">"
+        "<script>if (a && b) go();</script></head>"
+        "<body><!-- note --><p class=\"x\" title=\"a &quot;b&quot; &amp; c\">1 &lt; 2 &amp;&amp; Tom&#39;s<br>next</p>"
+        "<img src=\"x.png\"/><![CDATA[raw]]></body></html>";
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_load_string(html, &doc));
+
+    const char *expected =
+        "<!DOCTYPE html><?xml-stylesheet href=\"a.css\"?><html><head><meta charset=\"UTF-8\">"
+        "<script>if (a && b) go();</script></head>"
+        "<body><!-- note --><p class=\"x\" title=\"a &quot;b&quot; &amp; c\">1 &lt; 2 &amp;&amp; Tom's<br>next</p>"
+        "<img src=\"x.png\"><![CDATA[raw]]></body></html>";
+    char *out = fossil_media_html_serialize(doc);
+    ASSUME_NOT_CNULL(out);
+    ASSUME_ITS_EQUAL_CSTR(out, expected);
+
+    /* parsing the output again yields the same serialization */
+    fossil_media_html_doc_t *again = NULL;
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_load_string(out, &again));
+    char *out2 = fossil_media_html_serialize(again);
+    ASSUME_ITS_EQUAL_CSTR(out2, expected);
+
+    free(out2);
+    free(out);
+    fossil_media_html_free(again);
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_serialize_sink_and_buffer) {
+    fossil_media_html_doc_t *doc = NULL;
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK,
+                         fossil_media_html_load_string("<ul><li>a</li><li>b &gt; c</li></ul>", &doc));
+
+    size_t need = 0;
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_serialize_buffer(doc, NULL, 0, &need));
+    ASSUME_ITS_EQUAL_SIZE(strlen("<ul><li>a</li><li>b &gt; c</li></ul>"), need);
+
+    char small[8];
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_ERR_NOMEM,
+                         fossil_media_html_serialize_buffer(doc, small, sizeof(small), NULL));
+
+    char exact[64];
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_serialize_buffer(doc, exact, need + 1, NULL));
+    ASSUME_ITS_EQUAL_CSTR(exact, "<ul><li>a</li><li>b &gt; c</li></ul>");
+
+    fossil_media_buffer_t sunk = { NULL, 0, 0 };
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_serialize_to(doc, fossil_media_sink_buffer, &sunk));
+    ASSUME_ITS_EQUAL_CSTR(sunk.data, exact);
+    fossil_media_buffer_free(&sunk);
+
+    fossil_media_html_free(doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_parse_batch) {
+    char big[4001];
+    for (size_t i = 0; i < 1000; ++i) memcpy(big + i * 4, "<br>", 4);
+    big[4000] = '\0';
+    const char *inputs[] = {
+        "<p id=\"a\">one</p>",
+        "<ul><li>1</li><li>2</li></ul>",
+        NULL,
+        big,
+        "<div><span>deep</span></div>"
+    };
+    fossil_media_html_batch_result_t results[5];
+    fossil_media_html_batch_options_t opts = { 3, 1024 };
+
+    int failed = fossil_media_html_parse_batch(inputs, 5, &opts, results);
+    ASSUME_ITS_EQUAL_I32(2, failed);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, results[0].status);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_ERR_INVALID_ARG, results[2].status);
+    ASSUME_ITS_CNULL(results[2].doc);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_ERR_TIMEOUT, results[3].status);
+    ASSUME_ITS_CNULL(results[3].doc);
+
+    char *out = fossil_media_html_serialize(results[1].doc);
+    ASSUME_ITS_EQUAL_CSTR(out, "<ul><li>1</li><li>2</li></ul>");
+    free(out);
+    fossil_media_html_node_t *span = fossil_media_html_find_by_tag(fossil_media_html_root(results[4].doc), "span");
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_text(fossil_media_html_first_child(span)), "deep");
+
+    for (size_t i = 0; i < 5; ++i) fossil_media_html_free(results[i].doc);
+}
+
+FOSSIL_TEST_CASE(c_test_html_parse_batch_matches_serial) {
+    enum { COUNT = 64 };
+    char pages[COUNT][96];
+    const char *inputs[COUNT];
+    for (int i = 0; i < COUNT; ++i) {
+        snprintf(pages[i], sizeof(pages[i]), "<div class=\"c%d\"><p>page %d</p><br><i>%d</i></div>", i, i, i * 7);
+        inputs[i] = pages[i];
+    }
+    fossil_media_html_batch_result_t results[COUNT];
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_html_parse_batch(inputs, COUNT, NULL, results));
+
+    for (int i = 0; i < COUNT; ++i) {
+        fossil_media_html_doc_t *serial = NULL;
+        ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_HTML_OK, fossil_media_html_load_string(inputs[i], &serial));
+        char *a = fossil_media_html_serialize(serial);
+        char *b = fossil_media_html_serialize(results[i].doc);
+        ASSUME_ITS_EQUAL_CSTR(a, b);
+        free(a);
+        free(b);
+        fossil_media_html_free(serial);
+        fossil_media_html_free(results[i].doc);
+    }
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -485,12 +862,27 @@ FOSSIL_TEST_GROUP(c_html_tests) {
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_nested_elements);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_unclosed_tag);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_attribute_no_quotes);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_several_unquoted_attributes);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_set_attr_repeatedly);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_multiple_comments);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_empty_tag);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_large_input_timeout);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_tag_with_single_quotes);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_text_outside_tags);
     FOSSIL_TEST_ADD(c_html_fixture, c_test_html_complete_document);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_select_id_class_tag);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_select_attr_and_nth_child);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_select_all_iterator);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_select_index_invalidation);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_selector_invalid);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_rewriter_strip_and_rewrite);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_rewriter_passthrough);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_extract_text);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_extract_text_edge_cases);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_serialize_faithful);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_serialize_sink_and_buffer);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_parse_batch);
+    FOSSIL_TEST_ADD(c_html_fixture, c_test_html_parse_batch_matches_serial);
 
     FOSSIL_TEST_REGISTER(c_html_fixture);
 }
@@ -368,6 +368,71 @@ FOSSIL_TEST_CASE(cpp_test_html_large_input_timeout) {
     ASSUME_ITS_TRUE(threw);
 }
 
+FOSSIL_TEST_CASE(cpp_test_html_select) {
+    fossil::media::Html doc = fossil::media::Html::from_string(
+        "<div class=\"item\">A</div><div class=\"item\">B</div><p class=\"item\">C</p>");
+    ASSUME_ITS_TRUE(doc.is_valid());
+
+    fossil::media::HtmlSelector sel("div.item");
+    std::vector<fossil_media_html_node_t*> divs = doc.select(sel);
+    ASSUME_ITS_EQUAL_SIZE(divs.size(), 2);
+
+    std::vector<fossil_media_html_node_t*> items = doc.select(".item");
+    ASSUME_ITS_EQUAL_SIZE(items.size(), 3);
+    ASSUME_ITS_EQUAL_CSTR(fossil_media_html_node_tag(items[2]), "p");
+}
+
+FOSSIL_TEST_CASE(cpp_test_html_selector_invalid_throws) {
+    bool threw = false;
+    try {
+        fossil::media::HtmlSelector sel("[");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSUME_ITS_TRUE(threw);
+}
+
+FOSSIL_TEST_CASE(cpp_test_html_rewriter) {
+    std::string out;
+    fossil::media::HtmlRewriter rw([&out](const char *data, size_t len) { out.append(data, len); });
+    rw.on_element("img", [](fossil_media_html_element_t *el) {
+        fossil_media_html_element_set_attr(el, "loading", "lazy");
+    });
+    rw.on_element("iframe", [](fossil_media_html_element_t *el) {
+        fossil_media_html_element_remove(el);
+    });
+    rw.write("<p>a<img src=\"x.png\"><ifr");
+    rw.write("ame src=\"ad\"><b>ad</b></iframe>b</p>");
+    rw.end();
+    ASSUME_ITS_EQUAL_CSTR(out.c_str(), "<p>a<img src=\"x.png\" loading=\"lazy\">b</p>");
+}
+
+FOSSIL_TEST_CASE(cpp_test_html_extract_text) {
+    std::string text = fossil::media::Html::extract_text(
+        "<div>Hello <em>big</em>\n  world</div><script>x()</script><p>&quot;ok&quot;</p>");
+    ASSUME_ITS_EQUAL_CSTR(text.c_str(), "Hello big world \"ok\"");
+}
+
+FOSSIL_TEST_CASE(cpp_test_html_serialize_stream) {
+    fossil::media::Html doc = fossil::media::Html::from_string("<p id=\"a\">x &amp; y<br></p>");
+    std::string out;
+    doc.serialize([&out](const char *data, size_t len) { out.append(data, len); });
+    ASSUME_ITS_EQUAL_CSTR(out.c_str(), "<p id=\"a\">x &amp; y<br></p>");
+    std::string whole = doc.serialize();
+    ASSUME_ITS_EQUAL_CSTR(whole.c_str(), out.c_str());
+}
+
+FOSSIL_TEST_CASE(cpp_test_html_parse_batch) {
+    std::vector<std::string> pages = { "<p>a</p>", "<p>b</p>", "<p>c</p>" };
+    std::vector<fossil::media::Html> docs = fossil::media::Html::parse_batch(pages, 2);
+    ASSUME_ITS_EQUAL_SIZE(pages.size(), docs.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        ASSUME_ITS_TRUE(docs[i].is_valid());
+        std::string out = docs[i].serialize();
+        ASSUME_ITS_EQUAL_CSTR(out.c_str(), pages[i].c_str());
+    }
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -392,6 +457,12 @@ FOSSIL_TEST_GROUP(cpp_html_tests) {
     FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_text_outside_tags);
     FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_complete_document);
     FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_large_input_timeout);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_select);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_selector_invalid_throws);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_rewriter);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_extract_text);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_serialize_stream);
+    FOSSIL_TEST_ADD(cpp_html_fixture, cpp_test_html_parse_batch);
 
     FOSSIL_TEST_REGISTER(cpp_html_fixture);
 }
@@ -283,6 +283,286 @@ FOSSIL_TEST_CASE(c_test_ini_key_without_value) {
     fossil_media_ini_free(&ini);
 }
 
+FOSSIL_TEST_CASE(c_test_ini_load_buffer_unterminated) {
+    const char data[] = { '[', 's', ']', '\n', 'k', '=', 'v', '1', '\n', 'x', '=', '9', '9' };
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_buffer(data, sizeof(data), &ini));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "s", "k"), "v1") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "s", "x"), "99") == 0);
+
+    /* set() keeps working on a loaded document */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "s", "k", "v"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "s", "x", "a much longer value"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "new", "n", "1"));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "s", "k"), "v") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "s", "x"), "a much longer value") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "new", "n"), "1") == 0);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_multiline_exact) {
+    const char *ini_data =
+        "[multi]\n"
+        "desc=\"This is a\n"
+        "  multiline  \n"
+        "value\" trailing\n"
+        "after=1\n"
+        "open='never closed\n"
+        "tail";
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string(ini_data, &ini));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "multi", "desc"), "This is a\nmultiline\nvalue") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "multi", "after"), "1") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "multi", "open"), "never closed\ntail") == 0);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_load_large_file) {
+    const char *test_path = "test_tmp_large.ini";
+    FILE *f = fopen(test_path, "wb");
+    ASSUME_NOT_CNULL(f);
+    for (int i = 0; i < 1000; ++i) {
+        fprintf(f, "; section %d\n[sec%d]\n", i, i);
+        for (int j = 0; j < 10; ++j) fprintf(f, "key%d = value %d.%d  # note\n", j, i, j);
+    }
+    fclose(f);
+
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_file(test_path, &ini));
+    ASSUME_ITS_TRUE(ini.section_count == 1000);
+    ASSUME_ITS_TRUE(ini.sections[999].entry_count == 10);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "sec0", "key0"), "value 0.0") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "sec999", "key9"), "value 999.9") == 0);
+    fossil_media_ini_free(&ini);
+    remove(test_path);
+
+    ASSUME_ITS_TRUE(fossil_media_ini_load_file("does_not_exist.ini", &ini) != 0);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_typed_getters) {
+    const char *ini_data =
+        "[t]\n"
+        "n = -42\n"
+        "hex = 0x1F\n"
+        "lead = 010\n"
+        "eight = -08\n"
+        "upper = 0X1f\n"
+        "nohex = 0x\n"
+        "pi = 3.25\n"
+        "on = Yes\n"
+        "off = 0\n"
+        "timeout = 1h 30m\n"
+        "short = 250ms\n"
+        "bare = 2\n"
+        "spaced = 1.5 s 20 ms\n"
+        "cache = 64KiB\n"
+        "disk = 1.5 GB\n"
+        "bad = 12abc\n";
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string(ini_data, &ini));
+
+    int64_t i = 0;
+    double d = 0;
+    int b = -1;
+    uint64_t u = 0;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "n", &i));
+    ASSUME_ITS_TRUE(i == -42);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "hex", &i));
+    ASSUME_ITS_TRUE(i == 31);
+    /* leading zeros are decimal, not octal */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "lead", &i));
+    ASSUME_ITS_TRUE(i == 10);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "eight", &i));
+    ASSUME_ITS_TRUE(i == -8);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "upper", &i));
+    ASSUME_ITS_TRUE(i == 31);
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_int(&ini, "t", "nohex", &i));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_double(&ini, "t", "pi", &d));
+    ASSUME_ITS_TRUE(d == 3.25);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_bool(&ini, "t", "on", &b));
+    ASSUME_ITS_EQUAL_I32(1, b);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_bool(&ini, "t", "off", &b));
+    ASSUME_ITS_EQUAL_I32(0, b);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_duration(&ini, "t", "timeout", &u));
+    ASSUME_ITS_TRUE(u == 5400000);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_duration(&ini, "t", "short", &u));
+    ASSUME_ITS_TRUE(u == 250);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_duration(&ini, "t", "bare", &u));
+    ASSUME_ITS_TRUE(u == 2000);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_duration(&ini, "t", "spaced", &u));
+    ASSUME_ITS_TRUE(u == 1520);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_size(&ini, "t", "cache", &u));
+    ASSUME_ITS_TRUE(u == 65536);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_size(&ini, "t", "disk", &u));
+    ASSUME_ITS_TRUE(u == 1500000000ULL);
+
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_int(&ini, "t", "bad", &i));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_int(&ini, "t", "bad", &i)); /* cached failure */
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_size(&ini, "t", "bad", &u));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_bool(&ini, "t", "pi", &b));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_int(&ini, "t", "missing", &i));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_ini_get_int(&ini, "nope", "n", &i));
+
+    /* set() drops the cached conversion, also when the storage is reused */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "n", &i));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "t", "n", "7"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "n", &i));
+    ASSUME_ITS_TRUE(i == 7);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "t", "bad", "12"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_get_int(&ini, "t", "bad", &i));
+    ASSUME_ITS_TRUE(i == 12);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_indexed_lookups) {
+    fossil_media_ini_t ini = {0};
+    char section[32], key[32], value[32];
+    int ok = 1;
+    for (int i = 0; i < 200; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            snprintf(section, sizeof(section), "s%d", i);
+            snprintf(key, sizeof(key), "k%d", j);
+            snprintf(value, sizeof(value), "%d", i * 100 + j);
+            if (fossil_media_ini_set(&ini, section, key, value) != 0) ok = 0;
+        }
+    }
+    for (int i = 0; i < 200; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            int64_t v = -1;
+            snprintf(section, sizeof(section), "s%d", i);
+            snprintf(key, sizeof(key), "k%d", j);
+            if (fossil_media_ini_get_int(&ini, section, key, &v) != 0 || v != i * 100 + j) ok = 0;
+        }
+    }
+    ASSUME_ITS_TRUE(ok);
+    ASSUME_ITS_TRUE(ini.section_count == 200);
+    fossil_media_ini_free(&ini);
+
+    /* a repeated header is a separate section; lookups see the first */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string("[a]\nx=1\n[b]\ny=2\n[a]\nx=3\nz=4\n", &ini));
+    ASSUME_ITS_TRUE(ini.section_count == 3);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "a", "x"), "1") == 0);
+    ASSUME_ITS_CNULL(fossil_media_ini_get(&ini, "a", "z"));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&ini, "b", "y"), "2") == 0);
+    fossil_media_ini_free(&ini);
+}
+
+static char *ini_save_text(const fossil_media_ini_t *ini) {
+    const char *path = "test_tmp_patch.ini";
+    if (fossil_media_ini_save_file(path, ini) != 0) return NULL;
+    char *text = fossil_media_read_file(path, NULL);
+    remove(path);
+    return text;
+}
+
+FOSSIL_TEST_CASE(c_test_ini_save_preserves_source) {
+    const char *source =
+        "; service settings\n"
+        "[server]\n"
+        "host = example.org   ; primary\n"
+        "\n"
+        "port=80\n"
+        "# tuning\n"
+        "[limits]\n"
+        "desc = \"two\n"
+        "lines\"\n"
+        "max = 5";
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string(source, &ini));
+
+    /* nothing changed: the exact bytes come back */
+    char *text = ini_save_text(&ini);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_TRUE(strcmp(text, source) == 0);
+    free(text);
+
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "server", "host", "example.net"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "server", "port", "80")); /* same value */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "server", "timeout", "30s"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "limits", "desc", "one"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "limits", "min", "1"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "extra", "note", " padded "));
+    text = ini_save_text(&ini);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_TRUE(strcmp(text,
+        "; service settings\n"
+        "[server]\n"
+        "host = example.net   ; primary\n"
+        "\n"
+        "port=80\n"
+        "timeout=30s\n"
+        "# tuning\n"
+        "[limits]\n"
+        "desc = one\n"
+        "max = 5\n"
+        "min=1\n"
+        "\n"
+        "[extra]\n"
+        "note=\" padded \"\n") == 0);
+
+    /* and it reads back to the same values */
+    fossil_media_ini_t again;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string(text, &again));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&again, "server", "host"), "example.net") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&again, "server", "timeout"), "30s") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&again, "limits", "desc"), "one") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_ini_get(&again, "extra", "note"), " padded ") == 0);
+    fossil_media_ini_free(&again);
+    free(text);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_save_keeps_crlf) {
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_string("[a]\r\nk = 1\r\n[b]\r\nx = 2", &ini));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "a", "k", "3"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "a", "new", "4"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "b", "y", "5"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "c", "z", "6"));
+    char *text = ini_save_text(&ini);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_EQUAL_CSTR("[a]\r\nk = 3\r\nnew=4\r\n[b]\r\nx = 2\r\ny=5\r\n\r\n[c]\r\nz=6\r\n", text);
+    free(text);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_borrowed_source) {
+    const char *source = "[a]\nk = 1 ; note\n";
+    char *data = fossil_media_strdup(source);
+    ASSUME_NOT_CNULL(data);
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_buffer(data, strlen(data), &ini));
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_ini_get(&ini, "a", "k"));
+
+    /* set() copies the text, so the caller's buffer may go after it */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "a", "k", "2"));
+    memset(data, 'x', strlen(data));
+    free(data);
+    char *text = ini_save_text(&ini);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_EQUAL_CSTR("[a]\nk = 2 ; note\n", text);
+    free(text);
+    fossil_media_ini_free(&ini);
+}
+
+FOSSIL_TEST_CASE(c_test_ini_save_replaces_atomically) {
+    const char *path = "test_tmp_atomic.ini";
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_write_file(path, "[a]\nk=1\n"));
+    fossil_media_ini_t ini;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_load_file(path, &ini));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_set(&ini, "a", "k", "22"));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_ini_save_file(path, &ini));
+    fossil_media_ini_free(&ini);
+
+    char *text = fossil_media_read_file(path, NULL);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_TRUE(strcmp(text, "[a]\nk=22\n") == 0);
+    free(text);
+    remove(path);
+
+    ASSUME_ITS_TRUE(fossil_media_ini_save_file("no_such_dir/x.ini", &ini) != 0);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -304,6 +584,15 @@ FOSSIL_TEST_GROUP(c_ini_tests) {
     FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_special_characters);
     FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_section_and_key_whitespace);
     FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_key_without_value);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_load_buffer_unterminated);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_multiline_exact);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_load_large_file);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_typed_getters);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_indexed_lookups);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_save_preserves_source);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_save_keeps_crlf);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_borrowed_source);
+    FOSSIL_TEST_ADD(c_ini_fixture, c_test_ini_save_replaces_atomically);
 
     FOSSIL_TEST_REGISTER(c_ini_fixture);
 } // end of tests
@@ -274,6 +274,26 @@ FOSSIL_TEST_CASE(cpp_ini_key_without_value) {
     ASSUME_ITS_TRUE(ini.get("empty", "justkey").empty());
 }
 
+FOSSIL_TEST_CASE(cpp_ini_set_then_move) {
+    Ini ini("[a]\nk=v\n");
+    ASSUME_ITS_TRUE(ini.set("a", "k", "changed"));
+    ASSUME_ITS_TRUE(ini.set("b", "n", "1"));
+    Ini moved(std::move(ini));
+    ASSUME_ITS_TRUE(moved.get("a", "k") == "changed");
+    ASSUME_ITS_TRUE(moved.get("b", "n") == "1");
+    ASSUME_ITS_TRUE(ini.get("a", "k").empty());
+}
+
+FOSSIL_TEST_CASE(cpp_ini_typed_getters) {
+    Ini ini("[svc]\nport = 8080\nratio = 0.5\ndebug = on\nttl = 2m\nbuf = 4Ki\n");
+    ASSUME_ITS_TRUE(ini.get_int("svc", "port") == 8080);
+    ASSUME_ITS_TRUE(ini.get_double("svc", "ratio") == 0.5);
+    ASSUME_ITS_TRUE(ini.get_bool("svc", "debug"));
+    ASSUME_ITS_TRUE(ini.get_duration("svc", "ttl") == 120000);
+    ASSUME_ITS_TRUE(ini.get_size("svc", "buf") == 4096);
+    ASSUME_ITS_TRUE(ini.get_int("svc", "debug", -1) == -1);
+}
+
 FOSSIL_TEST_GROUP(cpp_ini_tests) {
     FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_default_ctor);
     FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_load_string_ctor);
@@ -297,6 +317,8 @@ FOSSIL_TEST_GROUP(cpp_ini_tests) {
     FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_special_characters);
     FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_section_and_key_whitespace);
     FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_key_without_value);
+    FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_set_then_move);
+    FOSSIL_TEST_ADD(cpp_ini_fixture, cpp_ini_typed_getters);
 
     FOSSIL_TEST_REGISTER(cpp_ini_fixture);
 } // end of tests
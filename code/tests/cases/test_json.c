@@ -276,6 +276,26 @@ FOSSIL_TEST_CASE(c_test_json_get_path) {
     fossil_media_json_free(val);
 }
 
+FOSSIL_TEST_CASE(c_test_json_parse_unicode_escapes) {
+    fossil_media_json_error_t err = {0};
+    fossil_media_json_value_t *val = fossil_media_json_parse("\"\\u00e9\\ud83d\\ude00\\u20ac\"", &err);
+    ASSUME_NOT_CNULL(val);
+    ASSUME_ITS_TRUE(strcmp(val->u.string, "\xc3\xa9\xf0\x9f\x98\x80\xe2\x82\xac") == 0);
+    fossil_media_json_free(val);
+    /* a lone surrogate becomes U+FFFD */
+    val = fossil_media_json_parse("\"\\ud83dx\"", &err);
+    ASSUME_NOT_CNULL(val);
+    ASSUME_ITS_TRUE(strcmp(val->u.string, "\xef\xbf\xbdx") == 0);
+    fossil_media_json_free(val);
+}
+
+FOSSIL_TEST_CASE(c_test_json_parse_invalid_utf8) {
+    fossil_media_json_error_t err = {0};
+    fossil_media_json_value_t *val = fossil_media_json_parse("[\"ok\", \"bad \xc3\x28\"]", &err);
+    ASSUME_ITS_TRUE(val == NULL);
+    ASSUME_ITS_TRUE(err.code != 0 && err.position == 12);
+}
+
 FOSSIL_TEST_CASE(c_test_json_parse_empty_array) {
     fossil_media_json_error_t err = {0};
     const char *json = "[]";
@@ -497,6 +517,8 @@ FOSSIL_TEST_GROUP(c_json_tests) {
     FOSSIL_TEST_ADD(c_json_fixture, c_test_json_parse_deeply_nested);
     FOSSIL_TEST_ADD(c_json_fixture, c_test_json_parse_mixed_types_array);
     FOSSIL_TEST_ADD(c_json_fixture, c_test_json_parse_object_with_array_values);
+    FOSSIL_TEST_ADD(c_json_fixture, c_test_json_parse_unicode_escapes);
+    FOSSIL_TEST_ADD(c_json_fixture, c_test_json_parse_invalid_utf8);
 
     FOSSIL_TEST_REGISTER(c_json_fixture);
 } // end of tests
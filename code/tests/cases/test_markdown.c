@@ -235,6 +235,345 @@ FOSSIL_TEST_CASE(c_test_md_parse_long_input) {
     free(md_output);
 }
 
+FOSSIL_TEST_CASE(c_test_md_serialize_exact) {
+    const char *md_input = "# Title\n- one\n> quote\n```c\nint x;\n```\nplain\n```\n```\n";
+    fossil_media_md_node_t *root = fossil_media_md_parse(md_input);
+    ASSUME_NOT_CNULL(root);
+    char *md_output = fossil_media_md_serialize(root);
+    ASSUME_NOT_CNULL(md_output);
+    ASSUME_ITS_TRUE(strcmp(md_output, "# Title\n- one\n> quote\n```c\nint x;\n```\nplain\n```\n\n```\n") == 0);
+    free(md_output);
+
+    fossil_media_md_free(root);
+
+    /* large code blocks used to skip the capacity check */
+    char *big = (char*)malloc(100009);
+    memcpy(big, "```\n", 4);
+    memset(big + 4, 'x', 100000);
+    memcpy(big + 100004, "\n```", 5);
+    big[100008] = '\0';
+    root = fossil_media_md_parse(big);
+    free(big);
+    ASSUME_NOT_CNULL(root);
+    md_output = fossil_media_md_serialize(root);
+    ASSUME_NOT_CNULL(md_output);
+    ASSUME_ITS_TRUE(strlen(md_output) == 100009);
+    free(md_output);
+    fossil_media_md_free(root);
+}
+
+FOSSIL_TEST_CASE(c_test_md_render_html) {
+    const char *md_input = "## A & B\n- one\n- <two>\n> q1\n> q2\n```c\nif (a < b) {}\n```\ntext \"here\"\n";
+    fossil_media_md_node_t *root = fossil_media_md_parse(md_input);
+    ASSUME_NOT_CNULL(root);
+    char *html = fossil_media_md_render_html_string(root);
+    ASSUME_NOT_CNULL(html);
+    ASSUME_ITS_TRUE(strcmp(html,
+        "<h2>A &amp; B</h2>\n"
+        "<ul>\n<li>one</li>\n<li>&lt;two&gt;</li>\n</ul>\n"
+        "<blockquote>\n<p>q1</p>\n<p>q2</p>\n</blockquote>\n"
+        "<pre><code class=\"language-c\">if (a &lt; b) {}\n</code></pre>\n"
+        "<p>text &quot;here&quot;</p>\n") == 0);
+
+    fossil_media_buffer_t out = {0};
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_render_html(root, fossil_media_sink_buffer, &out));
+    ASSUME_ITS_TRUE(out.len == strlen(html) && memcmp(out.data, html, out.len) == 0);
+    fossil_media_buffer_free(&out);
+    free(html);
+    fossil_media_md_free(root);
+}
+
+/* Inline children of a block as a compact string, e.g. "T(a)B(T(b))" */
+static void md_dump_inline(const fossil_media_md_node_t *n, fossil_media_buffer_t *out) {
+    for (size_t i = 0; i < n->child_count; ++i) {
+        const fossil_media_md_node_t *c = n->children[i];
+        const char *tag = c->type == FOSSIL_MEDIA_MD_TEXT ? "T" : c->type == FOSSIL_MEDIA_MD_BOLD ? "B" :
+                          c->type == FOSSIL_MEDIA_MD_ITALIC ? "I" : c->type == FOSSIL_MEDIA_MD_CODE ? "C" : "L";
+        fossil_media_sink_buffer(out, tag, 1);
+        fossil_media_sink_buffer(out, "(", 1);
+        if (c->type == FOSSIL_MEDIA_MD_LINK) {
+            fossil_media_sink_buffer(out, c->extra, strlen(c->extra));
+            fossil_media_sink_buffer(out, "|", 1);
+        }
+        if (c->child_count) md_dump_inline(c, out);
+        else if (c->content) fossil_media_sink_buffer(out, c->content, strlen(c->content));
+        fossil_media_sink_buffer(out, ")", 1);
+    }
+    fossil_media_sink_buffer(out, "", 0);
+}
+
+static int md_inline_is(const char *line, const char *expected) {
+    fossil_media_md_node_t *root = fossil_media_md_parse(line);
+    if (!root || root->child_count != 1) {
+        fossil_media_md_free(root);
+        return 0;
+    }
+    fossil_media_buffer_t out = {0};
+    md_dump_inline(root->children[0], &out);
+    int ok = strcmp(out.data ? out.data : "", expected) == 0;
+    fossil_media_buffer_free(&out);
+    fossil_media_md_free(root);
+    return ok;
+}
+
+FOSSIL_TEST_CASE(c_test_md_inline_emphasis) {
+    ASSUME_ITS_TRUE(md_inline_is("plain text", ""));
+    ASSUME_ITS_TRUE(md_inline_is("snake_case_name", ""));
+    ASSUME_ITS_TRUE(md_inline_is("a **b** c", "T(a )B(T(b))T( c)"));
+    ASSUME_ITS_TRUE(md_inline_is("*it* and _it_", "I(T(it))T( and )I(T(it))"));
+    ASSUME_ITS_TRUE(md_inline_is("***both***", "I(B(T(both)))"));
+    ASSUME_ITS_TRUE(md_inline_is("**a *b* c**", "B(T(a )I(T(b))T( c))"));
+    ASSUME_ITS_TRUE(md_inline_is("2 * 3 * 4", ""));
+    ASSUME_ITS_TRUE(md_inline_is("**open", ""));
+    ASSUME_ITS_TRUE(md_inline_is("\\*not\\*", "T(*not*)"));
+    ASSUME_ITS_TRUE(md_inline_is("- item *x*", "I(T(x))") == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_md_inline_code_and_links) {
+    ASSUME_ITS_TRUE(md_inline_is("use `a*b*c` here", "T(use )C(a*b*c)T( here)"));
+    ASSUME_ITS_TRUE(md_inline_is("`` a`b ``", "C(a`b)"));
+    ASSUME_ITS_TRUE(md_inline_is("`open", ""));
+    ASSUME_ITS_TRUE(md_inline_is("see [the *docs*](http://x.io/a_(b)) now",
+                                 "T(see )L(http://x.io/a_(b)|T(the )I(T(docs)))T( now)"));
+    ASSUME_ITS_TRUE(md_inline_is("[a [b](u) c](v)", "T([a )L(u|T(b))T( c](v))"));
+    ASSUME_ITS_TRUE(md_inline_is("[not a link] x", ""));
+
+    /* headings, items and quotes get inline children; content keeps the source */
+    fossil_media_md_node_t *root = fossil_media_md_parse("## A *b*\n- `c`\n> [d](e)\n");
+    ASSUME_NOT_CNULL(root);
+    ASSUME_ITS_EQUAL_SIZE(3, root->child_count);
+    ASSUME_ITS_TRUE(strcmp(root->children[0]->content, "A *b*") == 0);
+    ASSUME_ITS_EQUAL_SIZE(2, root->children[0]->child_count);
+    ASSUME_ITS_TRUE(root->children[1]->children[0]->type == FOSSIL_MEDIA_MD_CODE);
+    ASSUME_ITS_TRUE(root->children[2]->children[0]->type == FOSSIL_MEDIA_MD_LINK);
+    ASSUME_ITS_TRUE(root->children[2]->children[0]->parent == root->children[2]);
+
+    char *html = fossil_media_md_render_html_string(root);
+    ASSUME_NOT_CNULL(html);
+    ASSUME_ITS_TRUE(strcmp(html, "<h2>A <em>b</em></h2>\n<ul>\n<li><code>c</code></li>\n</ul>\n"
+                                 "<blockquote>\n<p><a href=\"e\">d</a></p>\n</blockquote>\n") == 0);
+    free(html);
+    char *md = fossil_media_md_serialize(root);
+    ASSUME_ITS_TRUE(strcmp(md, "## A *b*\n- `c`\n> [d](e)\n") == 0);
+    free(md);
+    fossil_media_md_free(root);
+}
+
+FOSSIL_TEST_CASE(c_test_md_inline_linear) {
+    /* unmatched openers and backticks must not make parsing quadratic */
+    size_t n = 200000;
+    char *text = (char*)malloc(n + 1);
+    for (size_t i = 0; i < n; ++i) text[i] = "*_`["[i % 4];
+    text[n] = '\0';
+    fossil_media_md_node_t *root = fossil_media_md_parse(text);
+    free(text);
+    ASSUME_NOT_CNULL(root);
+    ASSUME_ITS_EQUAL_SIZE(1, root->child_count);
+    fossil_media_md_free(root);
+
+    /* nor may link destinations that never close */
+    static const char *const runs[] = { "[](", "[*a](", "[](a " };
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); ++r) {
+        size_t unit = strlen(runs[r]);
+        text = (char*)malloc(n + 1);
+        for (size_t i = 0; i < n; ++i) text[i] = runs[r][i % unit];
+        text[n] = '\0';
+        root = fossil_media_md_parse(text);
+        free(text);
+        ASSUME_NOT_CNULL(root);
+        ASSUME_ITS_EQUAL_SIZE(1, root->child_count);
+        fossil_media_md_free(root);
+    }
+
+    /* deep but legal nesting still links */
+    root = fossil_media_md_parse("[a](x(((y))))");
+    ASSUME_NOT_CNULL(root);
+    ASSUME_ITS_EQUAL_I32(FOSSIL_MEDIA_MD_LINK, root->children[0]->children[0]->type);
+    ASSUME_ITS_EQUAL_CSTR("x(((y)))", root->children[0]->children[0]->extra);
+    fossil_media_md_free(root);
+}
+
+/* An edited tree must match a fresh parse of its source */
+static int md_matches_fresh_parse(const fossil_media_md_node_t *root) {
+    fossil_media_md_node_t *fresh = fossil_media_md_parse(fossil_media_md_source(root, NULL));
+    if (!fresh) return 0;
+    char *a = fossil_media_md_render_html_string(root);
+    char *b = fossil_media_md_render_html_string(fresh);
+    char *c = fossil_media_md_serialize(root);
+    char *d = fossil_media_md_serialize(fresh);
+    int ok = a && b && c && d && strcmp(a, b) == 0 && strcmp(c, d) == 0 &&
+             root->child_count == fresh->child_count;
+    for (size_t i = 0; ok && i < root->child_count; ++i) {
+        ok = root->children[i]->parent == root && root->children[i]->type == fresh->children[i]->type;
+    }
+    free(a);
+    free(b);
+    free(c);
+    free(d);
+    fossil_media_md_free(fresh);
+    return ok;
+}
+
+FOSSIL_TEST_CASE(c_test_md_edit_reuses_nodes) {
+    const char *text = "# Title\n\nfirst line\n- item\n> quote\n\nlast *line*\n";
+    fossil_media_md_node_t *root = fossil_media_md_parse(text);
+    ASSUME_NOT_CNULL(root);
+    ASSUME_ITS_EQUAL_SIZE(5, root->child_count);
+    fossil_media_md_node_t *title = root->children[0];
+    fossil_media_md_node_t *last = root->children[4];
+
+    /* edit inside "first line" only replaces that block */
+    fossil_media_md_change_t change;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 15, 4, "**LINE**", 8, &change));
+    ASSUME_ITS_TRUE(change.removed >= 1 && change.inserted == change.removed);
+    ASSUME_ITS_TRUE(change.first <= 1 && change.first + change.removed >= 2 && change.first + change.removed <= 3);
+    ASSUME_ITS_TRUE(root->children[0] == title);
+    ASSUME_ITS_TRUE(root->children[4] == last);
+    ASSUME_ITS_TRUE(strcmp(root->children[1]->content, "first **LINE**") == 0);
+    ASSUME_ITS_TRUE(root->children[1]->children[1]->type == FOSSIL_MEDIA_MD_BOLD);
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+
+    /* inserting a new block, then removing a block */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 8, 0, "## Sub\n", 7, &change));
+    ASSUME_ITS_EQUAL_SIZE(6, root->child_count);
+    ASSUME_ITS_TRUE(root->children[0] == title && root->children[5] == last);
+    ASSUME_ITS_EQUAL_I32(2, root->children[1]->level);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 8, NULL, 0, &change));
+    ASSUME_ITS_EQUAL_SIZE(0, change.first);
+    ASSUME_ITS_EQUAL_SIZE(5, root->child_count);
+    ASSUME_ITS_TRUE(root->children[4] == last);
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+
+    /* an opening fence swallows the following lines until it is closed */
+    size_t len;
+    const char *src = fossil_media_md_source(root, &len);
+    size_t at = (size_t)(strstr(src, "- item") - src);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, at, 0, "```\n", 4, &change));
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, len + 4, 0, "```\nafter\n", 10, &change));
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, at, 4, "", 0, &change));
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+
+    /* bad ranges leave the document untouched */
+    src = fossil_media_md_source(root, &len);
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_md_edit(root, len + 1, 0, "x", 1, &change));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_md_edit(root, len - 1, 2, "x", 1, &change));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_md_edit(root, 0, 0, "a\0b", 3, &change));
+    ASSUME_ITS_EQUAL_SIZE(len, strlen(fossil_media_md_source(root, NULL)));
+    fossil_media_md_free(root);
+
+    fossil_media_md_node_t manual = {0};
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_md_edit(&manual, 0, 0, "x", 1, NULL));
+    ASSUME_ITS_TRUE(fossil_media_md_source(&manual, NULL) == NULL);
+}
+
+FOSSIL_TEST_CASE(c_test_md_edit_empty_document) {
+    fossil_media_md_node_t *root = fossil_media_md_parse("");
+    ASSUME_NOT_CNULL(root);
+    ASSUME_ITS_EQUAL_SIZE(0, root->child_count);
+    fossil_media_md_change_t change;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 0, "", 0, &change));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 0, "\n", 1, &change));
+    ASSUME_ITS_EQUAL_SIZE(0, root->child_count);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 1, "# Hi\n", 5, &change));
+    ASSUME_ITS_EQUAL_SIZE(1, root->child_count);
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+    /* and back to empty */
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 5, NULL, 0, &change));
+    ASSUME_ITS_EQUAL_SIZE(0, root->child_count);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(root, 0, 0, "text", 4, &change));
+    ASSUME_ITS_TRUE(md_matches_fresh_parse(root));
+    fossil_media_md_free(root);
+}
+
+FOSSIL_TEST_CASE(c_test_md_edit_random) {
+    static const char *pieces[] = {
+        "\n", "\n\n", "# ", "- ", "> ", "```", "```c\n", "*", "**", "_", "`", "[a](b)", "text", " ", "x\n"
+    };
+    fossil_media_md_node_t *root = fossil_media_md_parse("# Start\n\nsome *text*\n```\ncode\n```\n- a\n- b\n");
+    ASSUME_NOT_CNULL(root);
+    unsigned seed = 12345;
+    int ok = 1;
+    for (int i = 0; i < 600 && ok; ++i) {
+        size_t len;
+        fossil_media_md_source(root, &len);
+        seed = seed * 1103515245u + 12345u;
+        size_t offset = (seed >> 8) % (len + 1);
+        seed = seed * 1103515245u + 12345u;
+        size_t deleted = len > offset && (seed >> 9) % 3 == 0 ? (seed >> 12) % (len - offset < 6 ? len - offset + 1 : 6) : 0;
+        const char *ins = pieces[(seed >> 16) % (sizeof(pieces) / sizeof(pieces[0]))];
+        if (len > 4000) {
+            offset = 0;
+            deleted = len / 2;
+        }
+        fossil_media_md_change_t change;
+        ok = fossil_media_md_edit(root, offset, deleted, ins, strlen(ins), &change) == 0 &&
+             change.first + change.inserted <= root->child_count &&
+             md_matches_fresh_parse(root);
+    }
+    ASSUME_ITS_TRUE(ok);
+    fossil_media_md_free(root);
+}
+
+/* Large document with fences holding blank lines, so cuts must skip them */
+static char *md_make_corpus(size_t sections, int unclosed) {
+    fossil_media_buffer_t out = {0};
+    char line[160];
+    for (size_t i = 0; i < sections; ++i) {
+        int n = snprintf(line, sizeof(line),
+                         "## Section %zu\n\nSome *text* with `code` and [a link](u%zu).\n- item **%zu**\n> quote\n\n",
+                         i, i, i);
+        fossil_media_sink_buffer(&out, line, (size_t)n);
+        if (i % 7 == 0) {
+            const char *fence = "```c\nint x;\n\n\nint y; /* blank lines inside */\n```\n\n";
+            fossil_media_sink_buffer(&out, fence, strlen(fence));
+        }
+    }
+    if (unclosed) fossil_media_sink_buffer(&out, "```\nnever closed\n\n# lost\n", 25);
+    return out.data;
+}
+
+FOSSIL_TEST_CASE(c_test_md_parse_parallel) {
+    for (int unclosed = 0; unclosed < 2; ++unclosed) {
+        char *text = md_make_corpus(3000, unclosed);
+        ASSUME_NOT_CNULL(text);
+        ASSUME_ITS_TRUE(strlen(text) > 4 * 16 * 1024);
+        fossil_media_md_node_t *serial = fossil_media_md_parse(text);
+        fossil_media_md_node_t *parallel = fossil_media_md_parse_parallel(text, 4);
+        ASSUME_NOT_CNULL(serial);
+        ASSUME_NOT_CNULL(parallel);
+        ASSUME_ITS_EQUAL_SIZE(serial->child_count, parallel->child_count);
+        int same = 1;
+        for (size_t i = 0; i < serial->child_count && same; ++i) {
+            same = serial->children[i]->type == parallel->children[i]->type &&
+                   strcmp(serial->children[i]->content, parallel->children[i]->content) == 0 &&
+                   parallel->children[i]->parent == parallel;
+        }
+        ASSUME_ITS_TRUE(same);
+        char *a = fossil_media_md_render_html_string(serial);
+        char *b = fossil_media_md_render_html_string(parallel);
+        ASSUME_ITS_TRUE(a && b && strcmp(a, b) == 0);
+        free(a);
+        free(b);
+
+        /* the parallel tree carries spans for edits */
+        ASSUME_ITS_EQUAL_I32(0, fossil_media_md_edit(parallel, strlen(text) / 2, 0, "\n# inserted\n", 12, NULL));
+        ASSUME_ITS_TRUE(md_matches_fresh_parse(parallel));
+
+        fossil_media_md_free(serial);
+        fossil_media_md_free(parallel);
+        free(text);
+    }
+
+    /* small inputs and one thread fall back to the serial parser */
+    fossil_media_md_node_t *small = fossil_media_md_parse_parallel("# a\n\nb\n", 0);
+    ASSUME_NOT_CNULL(small);
+    ASSUME_ITS_EQUAL_SIZE(2, small->child_count);
+    fossil_media_md_free(small);
+    ASSUME_ITS_TRUE(fossil_media_md_parse_parallel(NULL, 0) == NULL);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -251,6 +590,15 @@ FOSSIL_TEST_GROUP(c_markdown_tests) {
     FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_parse_code_block_no_language);
     FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_parse_unclosed_code_block);
     FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_parse_long_input);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_serialize_exact);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_render_html);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_inline_emphasis);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_inline_code_and_links);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_inline_linear);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_edit_reuses_nodes);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_edit_random);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_edit_empty_document);
+    FOSSIL_TEST_ADD(c_markdown_fixture, c_test_md_parse_parallel);
 
     FOSSIL_TEST_REGISTER(c_markdown_fixture);
 } // end of tests
@@ -197,6 +197,53 @@ FOSSIL_TEST_CASE(cpp_test_md_parse_long_input) {
     fossil::media::Markdown::free(root);
 }
 
+FOSSIL_TEST_CASE(cpp_test_md_render_html) {
+    fossil_media_md_node_t* root = fossil::media::Markdown::parse("# Hi\n- a\n- b\n");
+    std::string html = fossil::media::Markdown::render_html(root);
+    ASSUME_ITS_TRUE(html == "<h1>Hi</h1>\n<ul>\n<li>a</li>\n<li>b</li>\n</ul>\n");
+    fossil::media::Markdown::free(root);
+}
+
+FOSSIL_TEST_CASE(cpp_test_md_render_inline) {
+    fossil_media_md_node_t* root = fossil::media::Markdown::parse("Some **bold** and `code`, [x](y).\n");
+    std::string html = fossil::media::Markdown::render_html(root);
+    ASSUME_ITS_TRUE(html == "<p>Some <strong>bold</strong> and <code>code</code>, <a href=\"y\">x</a>.</p>\n");
+    ASSUME_ITS_TRUE(fossil::media::Markdown::serialize(root) == "Some **bold** and `code`, [x](y).\n");
+    fossil::media::Markdown::free(root);
+}
+
+FOSSIL_TEST_CASE(cpp_test_md_edit) {
+    fossil_media_md_node_t* root = fossil::media::Markdown::parse("# Hi\n\nold\n- a\n");
+    fossil_media_md_node_t* item = root->children[2];
+    fossil_media_md_change_t change = fossil::media::Markdown::edit(root, 6, 3, "new *text*");
+    ASSUME_ITS_EQUAL_SIZE(1, change.first);
+    ASSUME_ITS_EQUAL_SIZE(1, change.removed);
+    ASSUME_ITS_EQUAL_SIZE(1, change.inserted);
+    ASSUME_ITS_TRUE(root->children[2] == item);
+    ASSUME_ITS_TRUE(fossil::media::Markdown::serialize(root) == "# Hi\nnew *text*\n- a\n");
+    bool thrown = false;
+    try {
+        fossil::media::Markdown::edit(root, 100, 0, "x");
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSUME_ITS_TRUE(thrown);
+    fossil::media::Markdown::free(root);
+}
+
+FOSSIL_TEST_CASE(cpp_test_md_parse_parallel) {
+    std::string text;
+    for (int i = 0; i < 4000; ++i) {
+        text += "# Heading " + std::to_string(i) + "\n\nbody *" + std::to_string(i) + "*\n\n";
+    }
+    fossil_media_md_node_t* serial = fossil::media::Markdown::parse(text);
+    fossil_media_md_node_t* parallel = fossil::media::Markdown::parse_parallel(text, 3);
+    ASSUME_ITS_EQUAL_SIZE(serial->child_count, parallel->child_count);
+    ASSUME_ITS_TRUE(fossil::media::Markdown::render_html(serial) == fossil::media::Markdown::render_html(parallel));
+    fossil::media::Markdown::free(serial);
+    fossil::media::Markdown::free(parallel);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -213,6 +260,10 @@ FOSSIL_TEST_GROUP(cpp_markdown_tests) {
     FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_parse_code_block_no_language);
     FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_parse_unclosed_code_block);
     FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_parse_long_input);
+    FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_render_html);
+    FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_render_inline);
+    FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_edit);
+    FOSSIL_TEST_ADD(cpp_markdown_fixture, cpp_test_md_parse_parallel);
 
     FOSSIL_TEST_REGISTER(cpp_markdown_fixture);
 } // end of tests
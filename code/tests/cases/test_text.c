@@ -86,6 +86,122 @@ FOSSIL_TEST_CASE(c_test_text_toupper_basic) {
     ASSUME_ITS_TRUE(strcmp(upper, "HELLO WORLD!") == 0);
 }
 
+FOSSIL_TEST_CASE(c_test_text_case_long_ascii) {
+    char buf[80], want[80];
+    for (size_t i = 0; i < 79; ++i) {
+        buf[i] = i % 3 == 0 ? (char)('A' + i % 26) : i % 3 == 1 ? (char)('a' + i % 26) : "@[`{\xc3\x89 9"[i % 7];
+        want[i] = (buf[i] >= 'A' && buf[i] <= 'Z') ? (char)(buf[i] + 32) : buf[i];
+    }
+    buf[79] = want[79] = '\0';
+    fossil_media_text_tolower(buf);
+    ASSUME_ITS_TRUE(strcmp(buf, want) == 0);
+    for (size_t i = 0; i < 79; ++i) {
+        if (want[i] >= 'a' && want[i] <= 'z') want[i] = (char)(want[i] - 32);
+    }
+    fossil_media_text_toupper(buf);
+    ASSUME_ITS_TRUE(strcmp(buf, want) == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_memcasecmp) {
+    const char *a = "The quick brown fox jumps over the lazy dog, 0123456789 [@`{]";
+    const char *b = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG, 0123456789 [@`{]";
+    size_t n = strlen(a);
+    ASSUME_ITS_TRUE(fossil_media_memcasecmp(a, b, n) == 0);
+    /* '@' and '`' differ only in bit 0x20 but are not letters */
+    ASSUME_ITS_TRUE(fossil_media_memcasecmp("x@", "X`", 2) < 0);
+    for (size_t i = 0; i < n; ++i) {
+        char c[80];
+        memcpy(c, b, n);
+        c[i] = '~';
+        ASSUME_ITS_TRUE(fossil_media_memcasecmp(a, c, n) < 0);
+        ASSUME_ITS_TRUE(fossil_media_memcasecmp(c, a, n) > 0);
+    }
+    ASSUME_ITS_TRUE(fossil_media_strncasecmp("Hello", "hELLO world", 5) == 0);
+    ASSUME_ITS_TRUE(fossil_media_strncasecmp("Hello", "hELLO world", 6) < 0);
+    ASSUME_ITS_TRUE(fossil_media_strncasecmp("abc", "ABD", 100) < 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_trim_n) {
+    const char *s = " \t\r\n   padded text with inner  spaces \n\n\t                      ";
+    size_t n = 0;
+    const char *t = fossil_media_trim_n(s, strlen(s), &n);
+    ASSUME_ITS_TRUE(n == strlen("padded text with inner  spaces"));
+    ASSUME_ITS_TRUE(strncmp(t, "padded text with inner  spaces", n) == 0);
+    t = fossil_media_trim_n("                                   ", 35, &n);
+    ASSUME_ITS_TRUE(n == 0);
+    char buf[] = "                    x                    ";
+    ASSUME_ITS_TRUE(strcmp(fossil_media_text_trim(buf), "x") == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_casefold) {
+    char out[64];
+    const char *in = "\xc3\x89T\xc3\x89 \xe1\xba\x9e \xce\xa3\xcf\x82 \xe2\x84\xaa \xe1\x8f\xb8";
+    const char *want = "\xc3\xa9t\xc3\xa9 \xc3\x9f \xcf\x83\xcf\x83 k \xe1\x8f\xb0";
+    size_t n = fossil_media_text_casefold(in, strlen(in), out, sizeof(out));
+    ASSUME_ITS_TRUE(n == strlen(want));
+    ASSUME_ITS_TRUE(strcmp(out, want) == 0);
+    /* the Kelvin sign shrinks from three bytes to one; malformed bytes pass */
+    ASSUME_ITS_TRUE(fossil_media_text_casefold("\xe2\x84\xaa\xff", 4, NULL, 0) == 2);
+    n = fossil_media_text_casefold("ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26, out, 8);
+    ASSUME_ITS_TRUE(n == 26);
+    ASSUME_ITS_TRUE(strcmp(out, "abcdefg") == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_casecmp) {
+    const char *a = "Grüße aus KÖLN, \xce\xa3\xce\xb5\xce\xbb\xce\xae\xce\xbd\xce\xb7 and a long ASCII tail of words";
+    const char *b = "GRÜSSE";
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp("Grüße", strlen("Grüße"), "GRÜßE", strlen("GRÜßE")) == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp(a, strlen(a), b, strlen(b)) != 0);
+    const char *c = "grüsse aus köln, \xcf\x83\xce\xb5\xce\xbb\xce\xae\xce\xbd\xce\xb7 AND A LONG ascii TAIL OF WORDS";
+    const char *d = "GRÜSSE AUS KÖLN, \xce\xa3\xce\x95\xce\x9b\xce\x89\xce\x9d\xce\x97 and a long ASCII tail of words";
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp(c, strlen(c), d, strlen(d)) == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp("\xe2\x84\xaa", 3, "k", 1) == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp("abc", 3, "ABCD", 4) < 0);
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp("abd", 3, "ABC", 3) > 0);
+    ASSUME_ITS_TRUE(fossil_media_text_casecmp("", 0, "", 0) == 0);
+}
+
+static int text_sign(int v) {
+    return (v > 0) - (v < 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_casecmp_malformed_antisymmetric) {
+    /* a lead byte whose sequence is cut short against a complete character */
+    ASSUME_ITS_TRUE(text_sign(fossil_media_text_casecmp("\xc3[", 2, "\xc3\xa9[", 3)) ==
+                    -text_sign(fossil_media_text_casecmp("\xc3\xa9[", 3, "\xc3[", 2)));
+    ASSUME_ITS_TRUE(text_sign(fossil_media_text_casecmp("\xc3", 1, "\xc3\xa9", 2)) ==
+                    -text_sign(fossil_media_text_casecmp("\xc3\xa9", 2, "\xc3", 1)));
+    static const char *pool[] = { "a", "A", "[", "\xc3", "\xa9", "\x89", "\xe2", "\x82", "\xac", "\xc3\xa9", "\xc3\x89" };
+    char a[24], b[24];
+    unsigned seed = 99;
+    for (int round = 0; round < 20000; ++round) {
+        size_t alen = 0, blen = 0;
+        seed = seed * 1103515245u + 12345u;
+        size_t na = (seed >> 16) % 6, nb = (seed >> 20) % 6;
+        for (size_t k = 0; k < na; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            const char *piece = pool[(seed >> 16) % 11];
+            memcpy(a + alen, piece, strlen(piece));
+            alen += strlen(piece);
+        }
+        /* b often shares a prefix with a so the fast path stops mid-character */
+        if (round % 2) {
+            blen = alen ? (seed >> 8) % (alen + 1) : 0;
+            memcpy(b, a, blen);
+        }
+        for (size_t k = 0; k < nb; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            const char *piece = pool[(seed >> 16) % 11];
+            memcpy(b + blen, piece, strlen(piece));
+            blen += strlen(piece);
+        }
+        int ab = text_sign(fossil_media_text_casecmp(a, alen, b, blen));
+        int ba = text_sign(fossil_media_text_casecmp(b, blen, a, alen));
+        ASSUME_ITS_TRUE(ab == -ba);
+        ASSUME_ITS_TRUE(fossil_media_text_casecmp(a, alen, a, alen) == 0);
+    }
+}
+
 FOSSIL_TEST_CASE(c_test_text_replace_basic) {
     char buf[64] = "one fish two fish";
     size_t replaced = fossil_media_text_replace(buf, "fish", "cat", sizeof(buf));
@@ -106,6 +222,143 @@ FOSSIL_TEST_CASE(c_test_text_replace_buffer_too_small) {
     ASSUME_ITS_TRUE(replaced == 0);
 }
 
+FOSSIL_TEST_CASE(c_test_text_replace_grows_in_place) {
+    char buf[64] = "a-b-c-d";
+    ASSUME_ITS_TRUE(fossil_media_text_replace(buf, "-", "<->", sizeof(buf)) == 3);
+    ASSUME_ITS_TRUE(strcmp(buf, "a<->b<->c<->d") == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_replace(buf, "<->", "", sizeof(buf)) == 3);
+    ASSUME_ITS_TRUE(strcmp(buf, "abcd") == 0);
+
+    /* all or nothing: a result one byte too long leaves the text alone */
+    char tight[8] = "xx";
+    ASSUME_ITS_TRUE(fossil_media_text_replace(tight, "x", "abcd", sizeof(tight)) == 0);
+    ASSUME_ITS_TRUE(strcmp(tight, "xx") == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_replace(tight, "x", "abc", sizeof(tight)) == 2);
+    ASSUME_ITS_TRUE(strcmp(tight, "abcabc") == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_replace_all_size_query) {
+    size_t count = 0;
+    size_t need = fossil_media_text_replace_all("aaa", "a", "bb", NULL, 0, &count);
+    ASSUME_ITS_TRUE(need == 6);
+    ASSUME_ITS_TRUE(count == 3);
+
+    char out[16];
+    ASSUME_ITS_TRUE(fossil_media_text_replace_all("aaa", "a", "bb", out, sizeof(out), NULL) == 6);
+    ASSUME_ITS_TRUE(strcmp(out, "bbbbbb") == 0);
+
+    /* truncated like snprintf */
+    char small[4];
+    ASSUME_ITS_TRUE(fossil_media_text_replace_all("aaa", "a", "bb", small, sizeof(small), NULL) == 6);
+    ASSUME_ITS_TRUE(strcmp(small, "bbb") == 0);
+
+    /* occurrences do not overlap; empty needle copies */
+    ASSUME_ITS_TRUE(fossil_media_text_replace_all("aaaa", "aa", "b", out, sizeof(out), &count) == 2);
+    ASSUME_ITS_TRUE(strcmp(out, "bb") == 0 && count == 2);
+    ASSUME_ITS_TRUE(fossil_media_text_replace_all("abc", "", "x", out, sizeof(out), &count) == 3);
+    ASSUME_ITS_TRUE(strcmp(out, "abc") == 0 && count == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_replace_all("abc", "b", NULL, out, sizeof(out), NULL) == 2);
+    ASSUME_ITS_TRUE(strcmp(out, "ac") == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_replacer_basic) {
+    const char *pats[] = { "{{name}}", "{{n}}", "&", "<", "<script" };
+    const char *reps[] = { "World", "1", "&amp;", "&lt;", "[removed]" };
+    fossil_media_text_replacer_t *r = fossil_media_text_replacer_new(pats, reps, 5);
+    ASSUME_NOT_CNULL(r);
+
+    char out[128];
+    size_t count = 0;
+    const char *in = "Hello {{name}} & {{n}} <b> <script>{{x}}";
+    size_t need = fossil_media_text_replacer_apply(r, in, NULL, 0, NULL);
+    ASSUME_ITS_TRUE(fossil_media_text_replacer_apply(r, in, out, sizeof(out), &count) == need);
+    ASSUME_ITS_TRUE(strcmp(out, "Hello World &amp; 1 &lt;b> [removed]>{{x}}") == 0);
+    ASSUME_ITS_TRUE(count == 5);
+    ASSUME_ITS_TRUE(need == strlen(out));
+
+    ASSUME_ITS_TRUE(fossil_media_text_replacer_apply(r, "no tokens", out, sizeof(out), &count) == 9);
+    ASSUME_ITS_TRUE(strcmp(out, "no tokens") == 0 && count == 0);
+    fossil_media_text_replacer_free(r);
+
+    /* leftmost beats a shorter pattern ending earlier */
+    const char *p2[] = { "abcd", "bc" };
+    const char *r2[] = { "1", "2" };
+    r = fossil_media_text_replacer_new(p2, r2, 2);
+    ASSUME_NOT_CNULL(r);
+    fossil_media_text_replacer_apply(r, "abcd abce", out, sizeof(out), NULL);
+    ASSUME_ITS_TRUE(strcmp(out, "1 a2e") == 0);
+    fossil_media_text_replacer_free(r);
+
+    const char *bad[] = { "ok", "" };
+    ASSUME_ITS_TRUE(fossil_media_text_replacer_new(bad, r2, 2) == NULL);
+    ASSUME_ITS_TRUE(fossil_media_text_replacer_new(NULL, r2, 1) == NULL);
+}
+
+/* Leftmost-longest reference: try every pattern at every position */
+static size_t naive_replace(const char *const *pats, const char *const *reps, size_t n, const char *s, char *out) {
+    size_t len = 0;
+    while (*s) {
+        size_t best = n, best_len = 0;
+        for (size_t i = 0; i < n; ++i) {
+            size_t l = strlen(pats[i]);
+            if (l > best_len && strncmp(s, pats[i], l) == 0) {
+                best = i;
+                best_len = l;
+            }
+        }
+        if (best < n) {
+            strcpy(out + len, reps[best]);
+            len += strlen(reps[best]);
+            s += best_len;
+        } else {
+            out[len++] = *s++;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+FOSSIL_TEST_CASE(c_test_text_replacer_random) {
+    unsigned seed = 7;
+    int ok = 1;
+    for (int round = 0; round < 200 && ok; ++round) {
+        char pat_buf[8][6];
+        const char *pats[8];
+        const char *reps[8] = { "", "X", "YY", "ZZZ", "0", "11", "222", "3333" };
+        size_t n = 1 + round % 8;
+        for (size_t i = 0; i < n; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            size_t l = 1 + (seed >> 16) % 5;
+            for (size_t k = 0; k < l; ++k) {
+                seed = seed * 1103515245u + 12345u;
+                pat_buf[i][k] = "abc"[(seed >> 16) % 3];
+            }
+            pat_buf[i][l] = '\0';
+            pats[i] = pat_buf[i];
+        }
+        /* the first of duplicate patterns wins in both */
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < i; ++j) {
+                if (strcmp(pats[i], pats[j]) == 0) pats[i] = pats[j], reps[i] = reps[j];
+            }
+        }
+        char text[65];
+        for (size_t k = 0; k < 64; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            text[k] = "abcd"[(seed >> 16) % 4];
+        }
+        text[64] = '\0';
+
+        char expect[512], got[512];
+        size_t want = naive_replace(pats, reps, n, text, expect);
+        fossil_media_text_replacer_t *r = fossil_media_text_replacer_new(pats, reps, n);
+        ok = r && fossil_media_text_replacer_apply(r, text, got, sizeof(got), NULL) == want &&
+             strcmp(expect, got) == 0;
+        fossil_media_text_replacer_free(r);
+    }
+    ASSUME_ITS_TRUE(ok);
+}
+
 FOSSIL_TEST_CASE(c_test_text_find_basic) {
     const char *haystack = "abcdefg";
     char *found = fossil_media_text_find(haystack, "cde");
@@ -119,6 +372,142 @@ FOSSIL_TEST_CASE(c_test_text_find_not_found) {
     ASSUME_ITS_TRUE(found == NULL);
 }
 
+static const char *naive_find(const char *h, size_t len, const char *n, size_t m) {
+    for (size_t i = 0; i + m <= len; ++i) {
+        if (memcmp(h + i, n, m) == 0) return h + i;
+    }
+    return NULL;
+}
+
+FOSSIL_TEST_CASE(c_test_text_find_n_matches_naive) {
+    static char hay[2048];
+    unsigned seed = 99;
+    int ok = 1;
+    for (int round = 0; round < 400 && ok; ++round) {
+        /* small alphabets make filter false positives and periodic needles common */
+        const char *alpha = round % 3 == 0 ? "ab" : round % 3 == 1 ? "abc" : "a\0b";
+        size_t k = round % 3 == 1 ? 3 : 2;
+        seed = seed * 1103515245u + 12345u;
+        size_t len = (seed >> 16) % sizeof(hay);
+        for (size_t i = 0; i < len; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            hay[i] = alpha[(seed >> 16) % k];
+        }
+        char needle[40];
+        seed = seed * 1103515245u + 12345u;
+        size_t m = 1 + (seed >> 16) % sizeof(needle);
+        for (size_t i = 0; i < m; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            needle[i] = alpha[(seed >> 16) % k];
+        }
+        /* plant the needle sometimes */
+        if (round % 2 && m <= len) memcpy(hay + len - m, needle, m);
+        ok = fossil_media_text_find_n(hay, len, needle, m) == naive_find(hay, len, needle, m);
+    }
+    ASSUME_ITS_TRUE(ok);
+
+    /* adversarial for the byte filter: every position passes it */
+    size_t big = 1 << 16;
+    char *a = (char*)malloc(big);
+    memset(a, 'a', big);
+    ASSUME_ITS_TRUE(fossil_media_text_find_n(a, big, "aaaaaaaabaaaaaaaa", 17) == NULL);
+    memcpy(a + big - 17, "aaaaaaaabaaaaaaaa", 17);
+    ASSUME_ITS_TRUE(fossil_media_text_find_n(a, big, "aaaaaaaabaaaaaaaa", 17) == a + big - 17);
+    free(a);
+
+    ASSUME_ITS_TRUE(fossil_media_text_find_n("abc", 3, "", 0) != NULL);
+    ASSUME_ITS_TRUE(fossil_media_text_find_n("abc", 3, "abcd", 4) == NULL);
+    ASSUME_ITS_TRUE(fossil_media_text_find_n("x\0yz", 4, "yz", 2) != NULL);
+}
+
+typedef struct {
+    size_t offsets[64];
+    size_t needles[64];
+    size_t count;
+} match_log_t;
+
+static int log_match(void *user, size_t offset, size_t length, size_t needle) {
+    match_log_t *log = (match_log_t*)user;
+    (void)length;
+    if (log->count < 64) {
+        log->offsets[log->count] = offset;
+        log->needles[log->count] = needle;
+    }
+    log->count++;
+    return 0;
+}
+
+static int stop_at_first(void *user, size_t offset, size_t length, size_t needle) {
+    (void)user;
+    (void)offset;
+    (void)length;
+    (void)needle;
+    return 1;
+}
+
+FOSSIL_TEST_CASE(c_test_text_searcher_basic) {
+    const char *needles[] = { "he", "she", "his", "hers" };
+    fossil_media_text_searcher_t *s = fossil_media_text_searcher_new(needles, NULL, 4);
+    ASSUME_NOT_CNULL(s);
+    match_log_t log = {0};
+    ASSUME_ITS_TRUE(fossil_media_text_searcher_find(s, "ushers", 6, log_match, &log) == 3);
+    /* "she" and "he" both end at 4, longer first; then "hers" */
+    ASSUME_ITS_TRUE(log.offsets[0] == 1 && log.needles[0] == 1);
+    ASSUME_ITS_TRUE(log.offsets[1] == 2 && log.needles[1] == 0);
+    ASSUME_ITS_TRUE(log.offsets[2] == 2 && log.needles[2] == 3);
+    ASSUME_ITS_TRUE(fossil_media_text_searcher_find(s, "ushers", 6, stop_at_first, NULL) == 1);
+    ASSUME_ITS_TRUE(fossil_media_text_searcher_find(s, "nothing", 7, NULL, NULL) == 0);
+    fossil_media_text_searcher_free(s);
+
+    /* binary needles */
+    const char *bin[] = { "\0\1", "\1" };
+    size_t lens[] = { 2, 1 };
+    s = fossil_media_text_searcher_new(bin, lens, 2);
+    ASSUME_NOT_CNULL(s);
+    ASSUME_ITS_TRUE(fossil_media_text_searcher_find(s, "\0\1\0\1", 4, NULL, NULL) == 4);
+    fossil_media_text_searcher_free(s);
+    ASSUME_ITS_TRUE(fossil_media_text_searcher_new(bin, NULL, 2) == NULL);
+}
+
+FOSSIL_TEST_CASE(c_test_text_searcher_matches_naive) {
+    unsigned seed = 3;
+    int ok = 1;
+    for (int round = 0; round < 100 && ok; ++round) {
+        char pat_buf[24][5];
+        const char *pats[24];
+        size_t n = 1 + round % 24;
+        for (size_t i = 0; i < n; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            size_t l = 1 + (seed >> 16) % 4;
+            for (size_t k = 0; k < l; ++k) {
+                seed = seed * 1103515245u + 12345u;
+                pat_buf[i][k] = "abcxyz"[(seed >> 16) % (round % 2 ? 3 : 6)];
+            }
+            pat_buf[i][l] = '\0';
+            pats[i] = pat_buf[i];
+        }
+        char text[200];
+        for (size_t k = 0; k < sizeof(text); ++k) {
+            seed = seed * 1103515245u + 12345u;
+            text[k] = "abcxyz."[(seed >> 16) % 7];
+        }
+        /* count distinct needles at every position */
+        size_t expect = 0;
+        for (size_t pos = 0; pos < sizeof(text); ++pos) {
+            for (size_t i = 0; i < n; ++i) {
+                int dup = 0;
+                for (size_t j = 0; j < i; ++j) dup |= strcmp(pats[i], pats[j]) == 0;
+                size_t l = strlen(pats[i]);
+                if (!dup && pos + l <= sizeof(text) && memcmp(text + pos, pats[i], l) == 0) expect++;
+            }
+        }
+        fossil_media_text_searcher_t *s = fossil_media_text_searcher_new(pats, NULL, n);
+        ok = s && fossil_media_text_searcher_find(s, text, sizeof(text), NULL, NULL) == expect;
+        fossil_media_text_searcher_free(s);
+    }
+    ASSUME_ITS_TRUE(ok);
+}
+
 FOSSIL_TEST_CASE(c_test_text_split_basic) {
     char buf[] = "a,b,c";
     char *tokens[3];
@@ -146,6 +535,52 @@ FOSSIL_TEST_CASE(c_test_text_split_empty_string) {
     ASSUME_ITS_TRUE(strcmp(tokens[0], "") == 0);
 }
 
+FOSSIL_TEST_CASE(c_test_text_split_iter_sequence) {
+    const char *text = "alpha::beta::::gamma::";
+    const char *want[] = { "alpha", "beta", "", "gamma", "" };
+    fossil_media_text_split_iter_t it;
+    const char *token;
+    size_t len, count = 0;
+    ASSUME_ITS_TRUE(fossil_media_text_split_init(&it, text, strlen(text), "::", 2) == 0);
+    while (fossil_media_text_split_next(&it, &token, &len)) {
+        ASSUME_ITS_TRUE(count < 5);
+        ASSUME_ITS_TRUE(len == strlen(want[count]) && memcmp(token, want[count], len) == 0);
+        ++count;
+    }
+    ASSUME_ITS_TRUE(count == 5);
+    ASSUME_ITS_TRUE(fossil_media_text_split_next(&it, &token, &len) == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_split_init(&it, text, strlen(text), "", 0) == -1);
+    /* empty text still yields one empty token */
+    ASSUME_ITS_TRUE(fossil_media_text_split_init(&it, "", 0, ",", 1) == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_split_next(&it, &token, &len) == 1 && len == 0);
+    ASSUME_ITS_TRUE(fossil_media_text_split_next(&it, &token, &len) == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_text_split_iter_any) {
+    char text[200];
+    size_t n = 0, words = 0;
+    /* long enough to cross several 16-byte blocks, with a NUL inside a token */
+    for (size_t i = 0; i < 30; ++i) {
+        memcpy(text + n, "wo\0rd", 5);
+        n += 5;
+        text[n++] = " \t\n"[i % 3];
+    }
+    fossil_media_text_split_iter_t it;
+    const char *token;
+    size_t len;
+    ASSUME_ITS_TRUE(fossil_media_text_split_any_init(&it, text, n, " \t\n") == 0);
+    while (fossil_media_text_split_next(&it, &token, &len)) {
+        if (words < 30) {
+            ASSUME_ITS_TRUE(len == 5 && token == text + words * 6);
+        } else {
+            ASSUME_ITS_TRUE(len == 0 && token == text + n);
+        }
+        ++words;
+    }
+    ASSUME_ITS_TRUE(words == 31);
+    ASSUME_ITS_TRUE(fossil_media_text_split_any_init(&it, text, n, "") == -1);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -155,14 +590,29 @@ FOSSIL_TEST_GROUP(c_text_tests) {
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_trim_no_spaces);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_tolower_basic);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_toupper_basic);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_case_long_ascii);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_memcasecmp);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_trim_n);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_casefold);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_casecmp);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_casecmp_malformed_antisymmetric);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replace_basic);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replace_no_match);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replace_buffer_too_small);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replace_grows_in_place);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replace_all_size_query);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replacer_basic);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_replacer_random);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_find_basic);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_find_not_found);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_find_n_matches_naive);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_searcher_basic);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_searcher_matches_naive);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_split_basic);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_split_limit_tokens);
     FOSSIL_TEST_ADD(c_text_fixture, c_test_text_split_empty_string);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_split_iter_sequence);
+    FOSSIL_TEST_ADD(c_text_fixture, c_test_text_split_iter_any);
 
     FOSSIL_TEST_REGISTER(c_text_fixture);
 } // end of tests
@@ -52,6 +52,7 @@ FOSSIL_TEARDOWN(cpp_text_fixture) {
 // * * * * * * * * * * * * * * * * * * * * * * * *
 
 using fossil::media::Text;
+using fossil::media::TextSplit;
 
 FOSSIL_TEST_CASE(cpp_test_text_trim_no_spaces) {
     std::string input = "abc";
@@ -92,6 +93,43 @@ FOSSIL_TEST_CASE(cpp_test_text_replace_buffer_too_small) {
     ASSUME_ITS_TRUE(replaced == "longerstring def longerstring");
 }
 
+FOSSIL_TEST_CASE(cpp_test_text_replacer) {
+    fossil::media::TextReplacer r({ {"$user", "ada"}, {"$home", "/home/ada"}, {"$", "\\$"} });
+    ASSUME_ITS_TRUE(r.apply("cd $home # $user pays $5") == "cd /home/ada # ada pays \\$5");
+    ASSUME_ITS_TRUE(r.apply("") == "");
+    bool thrown = false;
+    try {
+        std::vector<std::pair<std::string, std::string>> pairs = { {"", "x"} };
+        fossil::media::TextReplacer bad(pairs);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    ASSUME_ITS_TRUE(thrown);
+}
+
+FOSSIL_TEST_CASE(cpp_test_text_casefold) {
+    ASSUME_ITS_TRUE(Text::casefold("\xe2\x84\xaa\xc3\x89LVIN") == "k\xc3\xa9lvin");
+    std::string longer(40, '\xc8');
+    longer[39] = '\xba';
+    for (size_t i = 0; i < 38; i += 2) longer[i + 1] = '\xba';
+    /* U+023A folds to U+2C65, growing from two bytes to three */
+    ASSUME_ITS_TRUE(Text::casefold(longer).size() == 60);
+    ASSUME_ITS_TRUE(Text::casecmp("\xce\xa3\xce\xbf\xcf\x86\xce\xaf\xce\xb1", "\xcf\x83\xce\xbf\xcf\x86\xce\xaf\xce\xb1") == 0);
+    ASSUME_ITS_TRUE(Text::casecmp("Apple", "banana") < 0);
+}
+
+FOSSIL_TEST_CASE(cpp_test_text_searcher) {
+    fossil::media::TextSearcher searcher({ "error", "warn", std::string("\0x", 2) });
+    std::string text = std::string("warn: error") + std::string("\0x", 2) + "error";
+    std::vector<fossil::media::TextSearcher::Match> matches = searcher.find_all(text);
+    ASSUME_ITS_EQUAL_SIZE(4, matches.size());
+    ASSUME_ITS_TRUE(matches[0].offset == 0 && matches[0].needle == 1);
+    ASSUME_ITS_TRUE(matches[1].offset == 6 && matches[1].needle == 0);
+    ASSUME_ITS_TRUE(matches[2].offset == 11 && matches[2].length == 2 && matches[2].needle == 2);
+    ASSUME_ITS_TRUE(matches[3].offset == 13);
+    ASSUME_ITS_TRUE(fossil::media::Text::find(text, std::string("x", 1)) == 12);
+}
+
 FOSSIL_TEST_CASE(cpp_test_text_find_basic) {
     std::string haystack = "abcdefg";
     size_t pos = Text::find(haystack, "cde");
@@ -132,6 +170,30 @@ FOSSIL_TEST_CASE(cpp_test_text_split_empty_string) {
     ASSUME_ITS_TRUE(tokens[0] == "");
 }
 
+FOSSIL_TEST_CASE(cpp_test_text_split_view) {
+    std::string line = "key = value = more";
+    std::vector<std::string_view> parts;
+    for (std::string_view part : TextSplit(line, " = ")) parts.push_back(part);
+    ASSUME_ITS_TRUE(parts.size() == 3);
+    ASSUME_ITS_TRUE(parts[0] == "key" && parts[1] == "value" && parts[2] == "more");
+    ASSUME_ITS_TRUE(parts[1].data() == line.data() + 6);
+
+    size_t count = 0;
+    for (std::string_view word : TextSplit::any("a b\tc\n", " \t\n")) {
+        ASSUME_ITS_TRUE(word.size() == (count < 3 ? 1u : 0u));
+        ++count;
+    }
+    ASSUME_ITS_TRUE(count == 4);
+
+    bool threw = false;
+    try {
+        TextSplit bad(line, "");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSUME_ITS_TRUE(threw);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -142,11 +204,15 @@ FOSSIL_TEST_GROUP(cpp_text_tests) {
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_replace_basic);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_replace_no_match);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_replace_buffer_too_small);
+    FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_replacer);
+    FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_casefold);
+    FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_searcher);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_find_basic);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_find_not_found);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_split_basic);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_split_limit_tokens);
     FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_split_empty_string);
+    FOSSIL_TEST_ADD(cpp_text_fixture, cpp_test_text_split_view);
 
     FOSSIL_TEST_REGISTER(cpp_text_fixture);
 } // end of tests
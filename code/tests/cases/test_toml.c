@@ -0,0 +1,532 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+#include <math.h>
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(c_toml_fixture);
+
+FOSSIL_SETUP(c_toml_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(c_toml_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(c_test_toml_parse_tables) {
+    const char *toml_data =
+        "title = \"Example\" # comment\n"
+        "\n"
+        "[server]\n"
+        "host = \"localhost\"\n"
+        "port = 8080\n"
+        "\n"
+        "[server.http]\n"
+        "enabled = true\n";
+    fossil_media_toml_t toml;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(toml_data, &toml));
+    ASSUME_ITS_EQUAL_SIZE(toml.table_count, 3);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "title"), "Example") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, "server", "host"), "localhost") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, "server", "port"), "8080") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, "server.http", "enabled"), "true") == 0);
+    ASSUME_ITS_CNULL(fossil_media_toml_get(&toml, "server", "missing"));
+    ASSUME_ITS_CNULL(fossil_media_toml_get(&toml, "nope", "host"));
+    fossil_media_toml_free(&toml);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_typed_values) {
+    const char *toml_data =
+        "int = -1_000\n"
+        "hex = 0xff\n"
+        "oct = 0o17\n"
+        "bin = 0b101\n"
+        "float = 6.25e-1\n"
+        "inf = -inf\n"
+        "yes = true\n"
+        "no = false\n"
+        "when = 1979-05-27T07:32:00.5-07:00\n"
+        "day = 1979-05-27\n"
+        "at = 07:32:00\n";
+    fossil_media_toml_t toml;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(toml_data, &toml));
+
+    int64_t i = 0;
+    double d = 0;
+    int b = -1;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_get_int(&toml, NULL, "int", &i));
+    ASSUME_ITS_TRUE(i == -1000);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_int(&toml, NULL, "hex", &i) == 0 && i == 255);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_int(&toml, NULL, "oct", &i) == 0 && i == 15);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_int(&toml, NULL, "bin", &i) == 0 && i == 5);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_double(&toml, NULL, "float", &d) == 0 && d == 0.625);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_double(&toml, NULL, "int", &d) == 0 && d == -1000.0);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_double(&toml, NULL, "inf", &d) == 0 && d < -1e308);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_bool(&toml, NULL, "yes", &b) == 0 && b == 1);
+    ASSUME_ITS_TRUE(fossil_media_toml_get_bool(&toml, NULL, "no", &b) == 0 && b == 0);
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_toml_get_int(&toml, NULL, "float", &i));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "int"), "-1_000") == 0);
+
+    const fossil_media_toml_value_t *v = fossil_media_toml_get_value(&toml, NULL, "when");
+    ASSUME_ITS_TRUE(v != NULL && v->type == FOSSIL_MEDIA_TOML_DATETIME);
+    ASSUME_ITS_TRUE(v->as.datetime.year == 1979 && v->as.datetime.month == 5 && v->as.datetime.day == 27);
+    ASSUME_ITS_TRUE(v->as.datetime.hour == 7 && v->as.datetime.minute == 32);
+    ASSUME_ITS_TRUE(v->as.datetime.nanosecond == 500000000);
+    ASSUME_ITS_TRUE(v->as.datetime.has_offset && v->as.datetime.offset_minutes == -420);
+    v = fossil_media_toml_get_value(&toml, NULL, "day");
+    ASSUME_ITS_TRUE(v->as.datetime.has_date && !v->as.datetime.has_time);
+    v = fossil_media_toml_get_value(&toml, NULL, "at");
+    ASSUME_ITS_TRUE(!v->as.datetime.has_date && v->as.datetime.has_time);
+    fossil_media_toml_free(&toml);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_strings) {
+    const char *toml_data =
+        "basic = \"tab\\there \\u00e9 # not a comment\"\n"
+        "literal = 'C:\\path'\n"
+        "multi = \"\"\"\n"
+        "one \\\n"
+        "   two\"\"\"\n"
+        "raw = '''\n"
+        "line1\n"
+        "line2'''\n"
+        "\"quoted key\" = 1\n";
+    fossil_media_toml_t toml;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(toml_data, &toml));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "basic"), "tab\there \xc3\xa9 # not a comment") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "literal"), "C:\\path") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "multi"), "one two") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "raw"), "line1\nline2") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_toml_get(&toml, NULL, "quoted key"), "1") == 0);
+    fossil_media_toml_free(&toml);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_arrays_and_inline_tables) {
+    const char *toml_data =
+        "ports = [ 8001, 8002,\n"
+        "  8003, # trailing comma\n"
+        "]\n"
+        "nested = [[1, 2], [\"a\"]]\n"
+        "point = { x = 1, y.z = \"deep\" }\n"
+        "\n"
+        "[[products]]\n"
+        "name = \"Hammer\"\n"
+        "[[products]]\n"
+        "name = \"Nail\"\n";
+    fossil_media_toml_t toml;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(toml_data, &toml));
+
+    const fossil_media_toml_value_t *v = fossil_media_toml_get_value(&toml, NULL, "ports");
+    ASSUME_ITS_TRUE(v != NULL && v->type == FOSSIL_MEDIA_TOML_ARRAY);
+    ASSUME_ITS_EQUAL_SIZE(v->as.array.count, 3);
+    ASSUME_ITS_TRUE(v->as.array.items[2].as.integer == 8003);
+
+    v = fossil_media_toml_get_value(&toml, NULL, "nested");
+    ASSUME_ITS_TRUE(v->as.array.count == 2 && v->as.array.items[0].as.array.count == 2);
+    ASSUME_ITS_TRUE(strcmp(v->as.array.items[1].as.array.items[0].as.string.data, "a") == 0);
+
+    v = fossil_media_toml_get_value(&toml, NULL, "point");
+    ASSUME_ITS_TRUE(v != NULL && v->type == FOSSIL_MEDIA_TOML_TABLE);
+    ASSUME_ITS_EQUAL_SIZE(v->as.table.count, 2);
+    ASSUME_ITS_TRUE(strcmp(v->as.table.entries[1].key, "y.z") == 0);
+    ASSUME_ITS_TRUE(strcmp(v->as.table.entries[1].value, "deep") == 0);
+
+    ASSUME_ITS_EQUAL_SIZE(toml.table_count, 3);
+    ASSUME_ITS_TRUE(toml.tables[2].array_element);
+    ASSUME_ITS_TRUE(strcmp(toml.tables[2].entries[0].value, "Nail") == 0);
+    fossil_media_toml_free(&toml);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_invalid_input) {
+    const char *bad[] = {
+        "key = \"unterminated\n",
+        "key = \n",
+        "key = 0123\n",
+        "key = 1__0\n",
+        "key = [1, 2\n",
+        "key = 1 extra\n",
+        "[table\n",
+        "= value\n",
+        "date = 2023-02-30\n",
+        "big = 9223372036854775808\n",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        fossil_media_toml_t toml;
+        ASSUME_ITS_TRUE(fossil_media_toml_parse(bad[i], &toml) != 0);
+        ASSUME_ITS_TRUE(toml.tables == NULL && toml.table_count == 0);
+    }
+
+    fossil_media_toml_t toml;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse("min = -9223372036854775808\n", &toml));
+    int64_t i = 0;
+    ASSUME_ITS_TRUE(fossil_media_toml_get_int(&toml, NULL, "min", &i) == 0 && i == INT64_MIN);
+    fossil_media_toml_free(&toml);
+}
+
+typedef struct {
+    const char *input;
+    int64_t sums[64];
+} toml_parallel_ctx_t;
+
+static void toml_parse_task(void *ctx, size_t index, size_t worker) {
+    toml_parallel_ctx_t *c = (toml_parallel_ctx_t*)ctx;
+    fossil_media_toml_t toml;
+    int64_t a = 0, b = 0;
+    (void)worker;
+    if (fossil_media_toml_parse(c->input, &toml) != 0 ||
+        fossil_media_toml_get_int(&toml, "t", "a", &a) != 0 ||
+        fossil_media_toml_get_int(&toml, "t", "b", &b) != 0) {
+        c->sums[index] = -1;
+    } else {
+        c->sums[index] = a + b;
+    }
+    fossil_media_toml_free(&toml);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_parallel_parse) {
+    toml_parallel_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.input = "# shared\n[t]\na = 40\nb = 2\nname = \"x\"\n";
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_parallel_run(64, 4, toml_parse_task, &ctx));
+    int ok = 1;
+    for (size_t i = 0; i < 64; ++i) {
+        if (ctx.sums[i] != 42) ok = 0;
+    }
+    ASSUME_ITS_TRUE(ok);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_CASE(c_test_toml_find_dotted) {
+    const char *input =
+        "title = \"doc\"\n"
+        "[server.http]\nport = 8080\nlimits = { body = 1024, headers = { max = 64 } }\n"
+        "[[fruit]]\nname = \"apple\"\n[fruit.physical]\ncolor = \"red\"\n"
+        "[[fruit]]\nname = \"banana\"\n"
+        "[[fruit.variety]]\nname = \"plantain\"\n"
+        "[misc]\npoints = [ { x = 1 }, { x = 2 } ]\n";
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(input, &doc));
+
+    const fossil_media_toml_entry_t *e = fossil_media_toml_find(&doc, "server.http.port");
+    ASSUME_NOT_CNULL(e);
+    ASSUME_ITS_TRUE(e->typed.as.integer == 8080);
+    ASSUME_ITS_EQUAL_CSTR("doc", fossil_media_toml_find(&doc, "title")->value);
+    ASSUME_ITS_EQUAL_CSTR("1024", fossil_media_toml_find(&doc, "server.http.limits.body")->value);
+    ASSUME_ITS_EQUAL_CSTR("64", fossil_media_toml_find(&doc, "server.http.limits.headers.max")->value);
+    ASSUME_ITS_EQUAL_CSTR("apple", fossil_media_toml_find(&doc, "fruit[0].name")->value);
+    ASSUME_ITS_EQUAL_CSTR("red", fossil_media_toml_find(&doc, "fruit[0].physical.color")->value);
+    ASSUME_ITS_EQUAL_CSTR("banana", fossil_media_toml_find(&doc, "fruit[1].name")->value);
+    ASSUME_ITS_EQUAL_CSTR("plantain", fossil_media_toml_find(&doc, "fruit[1].variety[0].name")->value);
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_toml_find(&doc, "misc.points[1].x")->value);
+    ASSUME_ITS_CNULL(fossil_media_toml_find(&doc, "server.http"));
+    ASSUME_ITS_CNULL(fossil_media_toml_find(&doc, "fruit.name"));
+
+    /* table/key lookups keep their meaning */
+    ASSUME_ITS_EQUAL_CSTR("8080", fossil_media_toml_get(&doc, "server.http", "port"));
+    ASSUME_ITS_EQUAL_CSTR("apple", fossil_media_toml_get(&doc, "fruit", "name"));
+    ASSUME_ITS_EQUAL_CSTR("red", fossil_media_toml_get(&doc, "fruit.physical", "color"));
+    ASSUME_ITS_CNULL(fossil_media_toml_get(&doc, "server", "http"));
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_find_key) {
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse("a.b = 1\n[a]\nc = 2\n", &doc));
+    fossil_media_toml_key_t *key = fossil_media_toml_key_compile("a.c");
+    ASSUME_NOT_CNULL(key);
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_toml_find_key(&doc, key)->value);
+    fossil_media_toml_key_free(key);
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_toml_find(&doc, "a.b")->value);
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_toml_get(&doc, NULL, "a.b"));
+    ASSUME_ITS_CNULL(fossil_media_toml_get(&doc, "a", "b"));
+    fossil_media_toml_free(&doc);
+}
+
+static int toml_collect_names(void *user, const char *name, size_t len, const fossil_media_toml_entry_t *entry) {
+    (void)entry;
+    fossil_media_buffer_t *out = (fossil_media_buffer_t*)user;
+    fossil_media_sink_buffer(out, name, len);
+    return fossil_media_sink_buffer(out, ";", 1);
+}
+
+static int toml_stop_after_one(void *user, const char *name, size_t len, const fossil_media_toml_entry_t *entry) {
+    (void)name; (void)len; (void)entry;
+    ++*(int*)user;
+    return 1;
+}
+
+FOSSIL_TEST_CASE(c_test_toml_foreach) {
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse("a = { b = 1 }\n[[t]]\nx = 1\n[[t]]\nx = 2\n", &doc));
+    fossil_media_buffer_t names = {0};
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_foreach(&doc, toml_collect_names, &names));
+    fossil_media_sink_buffer(&names, "", 1);
+    ASSUME_ITS_TRUE(strcmp(names.data, "a;a.b;t[0].x;t[1].x;") == 0);
+    fossil_media_buffer_free(&names);
+
+    int seen = 0;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_foreach(&doc, toml_stop_after_one, &seen));
+    ASSUME_ITS_EQUAL_I32(1, seen);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_many_tables) {
+    fossil_media_buffer_t buf = {0};
+    char line[64];
+    for (int i = 0; i < 2000; ++i) {
+        int n = snprintf(line, sizeof(line), "[t%d]\nv = %d\n", i, i);
+        fossil_media_sink_buffer(&buf, line, (size_t)n);
+    }
+    fossil_media_sink_buffer(&buf, "", 1);
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(buf.data, &doc));
+    fossil_media_buffer_free(&buf);
+    ASSUME_ITS_TRUE(doc.table_count == 2001);
+
+    int ok = 1;
+    for (int i = 0; i < 2000; ++i) {
+        int64_t v = -1;
+        snprintf(line, sizeof(line), "t%d", i);
+        if (fossil_media_toml_get_int(&doc, line, "v", &v) != 0 || v != i) ok = 0;
+        snprintf(line, sizeof(line), "t%d.v", i);
+        const fossil_media_toml_entry_t *e = fossil_media_toml_find(&doc, line);
+        if (!e || e->typed.as.integer != i) ok = 0;
+    }
+    ASSUME_ITS_TRUE(ok);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_write_output) {
+    const char *input =
+        "# comment\n"
+        "title = 'say \"hi\"'\n"
+        "site.\"home page\" = true\n"
+        "[server]\n"
+        "ports = [ 80, 443 ]\n"
+        "ratio = 2.0\n"
+        "when = 1979-05-27T07:32:00.500-07:00\n"
+        "inline = { a = 1, \"b c\" = \"x\\ty\" }\n"
+        "[[item]]\n"
+        "id = 0x10\n";
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(input, &doc));
+    char *text = fossil_media_toml_write_string(&doc);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_EQUAL_CSTR(
+        "title = \"say \\\"hi\\\"\"\n"
+        "site.\"home page\" = true\n"
+        "\n[server]\n"
+        "ports = [80, 443]\n"
+        "ratio = 2.0\n"
+        "when = 1979-05-27T07:32:00.5-07:00\n"
+        "inline = { a = 1, \"b c\" = \"x\\ty\" }\n"
+        "\n[[item]]\n"
+        "id = 16\n", text);
+    free(text);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_write_round_trip) {
+    const char *input =
+        "a = \"line\\nnext \\u0001 \\u00e9\"\n"
+        "f = [ 0.1, -1e300, inf, -inf ]\n"
+        "d = 1979-05-27\n"
+        "t = 07:32:00\n"
+        "[[fruit]]\nname = \"apple\"\n[fruit.physical]\ncolor = \"red\"\n"
+        "[[fruit]]\nname = \"banana\"\n";
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(input, &doc));
+    char *text = fossil_media_toml_write_string(&doc);
+    fossil_media_toml_free(&doc);
+    ASSUME_NOT_CNULL(text);
+
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(text, &doc));
+    const fossil_media_toml_entry_t *a = fossil_media_toml_find(&doc, "a");
+    ASSUME_NOT_CNULL(a);
+    ASSUME_ITS_TRUE(strcmp(a->typed.as.string.data, "line\nnext \x01 \xC3\xA9") == 0);
+    const fossil_media_toml_value_t *f = &fossil_media_toml_find(&doc, "f")->typed;
+    ASSUME_ITS_TRUE(f->as.array.count == 4);
+    ASSUME_ITS_TRUE(f->as.array.items[0].as.floating == 0.1);
+    ASSUME_ITS_TRUE(f->as.array.items[1].as.floating == -1e300);
+    ASSUME_ITS_TRUE(isinf(f->as.array.items[3].as.floating) && f->as.array.items[3].as.floating < 0);
+    ASSUME_ITS_EQUAL_CSTR("1979-05-27", fossil_media_toml_find(&doc, "d")->value);
+    ASSUME_ITS_EQUAL_CSTR("07:32:00", fossil_media_toml_find(&doc, "t")->value);
+    ASSUME_ITS_EQUAL_CSTR("red", fossil_media_toml_find(&doc, "fruit[0].physical.color")->value);
+    ASSUME_ITS_EQUAL_CSTR("banana", fossil_media_toml_find(&doc, "fruit[1].name")->value);
+
+    /* writing again gives the same text */
+    char *again = fossil_media_toml_write_string(&doc);
+    ASSUME_NOT_CNULL(again);
+    ASSUME_ITS_TRUE(strcmp(text, again) == 0);
+    free(again);
+    free(text);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_quoted_key_parts) {
+    const char *input =
+        "site.\"google.com\" = true\n"
+        "'site'.'a\"b' = 2\n"
+        "[\"a.b\"]\n"
+        "x = 1\n"
+        "[a.b]\n"
+        "x = 3\n";
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(input, &doc));
+
+    /* a dot inside quotes stays part of the key */
+    ASSUME_ITS_EQUAL_CSTR("true", fossil_media_toml_find(&doc, "site.\"google.com\"")->value);
+    ASSUME_ITS_CNULL(fossil_media_toml_find(&doc, "site.google.com"));
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_toml_find(&doc, "site.\"a\\\"b\"")->value);
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_toml_find(&doc, "\"a.b\".x")->value);
+    ASSUME_ITS_EQUAL_CSTR("3", fossil_media_toml_find(&doc, "a.b.x")->value);
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_toml_get(&doc, "\"a.b\"", "x"));
+
+    char *text = fossil_media_toml_write_string(&doc);
+    fossil_media_toml_free(&doc);
+    ASSUME_NOT_CNULL(text);
+    ASSUME_ITS_EQUAL_CSTR(
+        "site.\"google.com\" = true\n"
+        "site.\"a\\\"b\" = 2\n"
+        "\n[\"a.b\"]\nx = 1\n"
+        "\n[a.b]\nx = 3\n", text);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse(text, &doc));
+    ASSUME_ITS_EQUAL_CSTR("1", fossil_media_toml_find(&doc, "\"a.b\".x")->value);
+    free(text);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_redefinitions_rejected) {
+    const char *bad[] = {
+        "a = 1\na = 2\n",
+        "\"a\" = 1\na = 2\n",
+        "[t]\n[t]\n",
+        "[t]\nx = 1\n[u]\n[t]\ny = 2\n",
+        "[[t]]\n[t]\n",
+        "[t]\n[[t]]\n",
+        "a.b = 1\n[a]\nb = 2\n",
+        "p = { x = 1, x = 2 }\n",
+        /* a value redefined as a table, in either order */
+        "a = 1\na.b = 2\n",
+        "[a]\nb = 1\n[a.b]\nc = 2\n",
+        "[a.b]\nc = 2\n[a]\nb = 1\n",
+        "a = 1\n[a]\n",
+        "a = 1\n[[a]]\n",
+        "a = { x = 1 }\n[a]\n",
+        "a = [1]\n[[a]]\n"
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        fossil_media_toml_t doc;
+        ASSUME_ITS_TRUE(fossil_media_toml_parse(bad[i], &doc) != 0);
+    }
+
+    /* sub-tables and array elements are not redefinitions */
+    fossil_media_toml_t doc;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse("[a]\n[a.b]\n[[c]]\n[c.d]\n[[c]]\n[c.d]\n", &doc));
+    fossil_media_toml_free(&doc);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_parse("a.b = 1\na.c = 2\nt = [{ x = 1 }, { x = 2 }]\n"
+                                                    "p = { q = { r = 1 } }\n[s]\nu.v = 1\n", &doc));
+    ASSUME_ITS_EQUAL_CSTR("2", fossil_media_toml_find(&doc, "t[1].x")->value);
+    fossil_media_toml_free(&doc);
+}
+
+FOSSIL_TEST_CASE(c_test_toml_write_hand_built) {
+    fossil_media_toml_entry_t root_entries[1];
+    fossil_media_toml_entry_t net_entries[2];
+    fossil_media_toml_table_t tables[2];
+    memset(root_entries, 0, sizeof(root_entries));
+    memset(net_entries, 0, sizeof(net_entries));
+    memset(tables, 0, sizeof(tables));
+    char name[] = "net";
+    char k1[] = "host", v1[] = "example.org";
+    char k2[] = "port";
+    char k3[] = "my key", v3[] = "a\"b";
+    net_entries[0].key = k1;
+    net_entries[0].value = v1;
+    net_entries[1].key = k2;
+    net_entries[1].typed.type = FOSSIL_MEDIA_TOML_INTEGER;
+    net_entries[1].typed.as.integer = 8080;
+    root_entries[0].key = k3;
+    root_entries[0].value = v3;
+    /* root placed last on purpose */
+    tables[0].name = name;
+    tables[0].entries = net_entries;
+    tables[0].entry_count = 2;
+    tables[1].entries = root_entries;
+    tables[1].entry_count = 1;
+    fossil_media_toml_t doc = { tables, 2, NULL };
+
+    FILE *fp = tmpfile();
+    ASSUME_NOT_CNULL(fp);
+    int fd = fileno(fp);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_toml_write(&doc, fossil_media_sink_fd, &fd));
+    char out[256];
+    rewind(fp);
+    size_t n = fread(out, 1, sizeof(out) - 1, fp);
+    out[n] = '\0';
+    fclose(fp);
+    ASSUME_ITS_EQUAL_CSTR("\"my key\" = \"a\\\"b\"\n\n[net]\nhost = \"example.org\"\nport = 8080\n", out);
+    ASSUME_ITS_EQUAL_CSTR("example.org", fossil_media_toml_find(&doc, "net.host")->value);
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_toml_write(NULL, fossil_media_sink_fd, &fd));
+}
+
+FOSSIL_TEST_GROUP(c_toml_tests) {
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_parse_tables);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_typed_values);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_strings);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_arrays_and_inline_tables);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_invalid_input);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_parallel_parse);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_find_dotted);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_find_key);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_foreach);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_many_tables);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_write_output);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_write_round_trip);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_quoted_key_parts);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_redefinitions_rejected);
+    FOSSIL_TEST_ADD(c_toml_fixture, c_test_toml_write_hand_built);
+
+    FOSSIL_TEST_REGISTER(c_toml_fixture);
+} // end of tests
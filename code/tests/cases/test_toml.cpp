@@ -0,0 +1,115 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(cpp_toml_fixture);
+
+FOSSIL_SETUP(cpp_toml_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(cpp_toml_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_CASE(cpp_test_toml_get) {
+    using fossil::media::Toml;
+    Toml toml("name = \"demo\"\n[limits]\nmax = 64\nratio = 0.5\nstrict = true\n");
+
+    ASSUME_ITS_TRUE(toml.get("", "name") == "demo");
+    ASSUME_ITS_TRUE(toml.get("limits", "max") == "64");
+    ASSUME_ITS_TRUE(toml.get_int("limits", "max") == 64);
+    ASSUME_ITS_TRUE(toml.get_double("limits", "ratio") == 0.5);
+    ASSUME_ITS_TRUE(toml.get_bool("limits", "strict"));
+    ASSUME_ITS_TRUE(toml.get_int("limits", "missing", -1) == -1);
+}
+
+FOSSIL_TEST_CASE(cpp_test_toml_invalid) {
+    using fossil::media::Toml;
+    bool thrown = false;
+    try {
+        Toml toml("key = [1, 2\n");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    ASSUME_ITS_TRUE(thrown);
+}
+
+FOSSIL_TEST_CASE(cpp_test_toml_move) {
+    using fossil::media::Toml;
+    Toml a("x = 1\n");
+    Toml b(std::move(a));
+    ASSUME_ITS_TRUE(b.get_int("", "x") == 1);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_CASE(cpp_test_toml_find) {
+    using fossil::media::Toml;
+    using fossil::media::TomlKey;
+    Toml doc("[server.http]\nport = 8080\n[[item]]\nid = 7\n");
+    ASSUME_ITS_TRUE(doc.find("server.http.port") == "8080");
+    ASSUME_ITS_TRUE(doc.find("missing").empty());
+    TomlKey key("item[0].id");
+    ASSUME_ITS_TRUE(doc.find(key) == "7");
+    Toml moved(std::move(doc));
+    ASSUME_ITS_TRUE(moved.find(key) == "7");
+}
+
+FOSSIL_TEST_CASE(cpp_test_toml_dump) {
+    using fossil::media::Toml;
+    Toml doc("[b]\nx = 'y'\n[a]\nz = 1\n");
+    ASSUME_ITS_TRUE(doc.dump() == "[b]\nx = \"y\"\n\n[a]\nz = 1\n");
+    Toml again(doc.dump());
+    ASSUME_ITS_TRUE(again.get_int("a", "z") == 1);
+}
+
+FOSSIL_TEST_GROUP(cpp_toml_tests) {
+    FOSSIL_TEST_ADD(cpp_toml_fixture, cpp_test_toml_get);
+    FOSSIL_TEST_ADD(cpp_toml_fixture, cpp_test_toml_invalid);
+    FOSSIL_TEST_ADD(cpp_toml_fixture, cpp_test_toml_move);
+    FOSSIL_TEST_ADD(cpp_toml_fixture, cpp_test_toml_find);
+    FOSSIL_TEST_ADD(cpp_toml_fixture, cpp_test_toml_dump);
+
+    FOSSIL_TEST_REGISTER(cpp_toml_fixture);
+} // end of tests
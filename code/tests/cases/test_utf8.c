@@ -0,0 +1,181 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(c_utf8_fixture);
+
+FOSSIL_SETUP(c_utf8_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(c_utf8_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+/* Byte-at-a-time reference validator */
+static size_t utf8_reference(const unsigned char *s, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        unsigned char c = s[i];
+        size_t n = c < 0x80 ? 1 : (c >= 0xC2 && c <= 0xDF) ? 2 : (c >= 0xE0 && c <= 0xEF) ? 3 : (c >= 0xF0 && c <= 0xF4) ? 4 : 0;
+        if (n == 0 || i + n > len) return i;
+        for (size_t k = 1; k < n; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80) return i;
+        }
+        if (c == 0xE0 && s[i + 1] < 0xA0) return i;
+        if (c == 0xED && s[i + 1] > 0x9F) return i;
+        if (c == 0xF0 && s[i + 1] < 0x90) return i;
+        if (c == 0xF4 && s[i + 1] > 0x8F) return i;
+        i += n;
+    }
+    return len;
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_validate_basic) {
+    size_t pos = 0;
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("", 0, NULL) == 0);
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("plain ascii", 11, NULL) == 0);
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80", 14, NULL) == 0);
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("ab\xc0\xaf", 4, &pos) == -1 && pos == 2);     /* overlong */
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("\xed\xa0\x80", 3, &pos) == -1 && pos == 0);   /* surrogate */
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("\xf4\x90\x80\x80", 4, &pos) == -1);           /* > U+10FFFF */
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("abc\xe2\x82", 5, &pos) == -1 && pos == 3);    /* truncated */
+    ASSUME_ITS_TRUE(fossil_media_utf8_validate("\x80", 1, &pos) == -1 && pos == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_validate_matches_reference) {
+    static const char *pieces[] = { "a", "Z ", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf",
+                                    "\xef\xbf\xbd", "\xf4\x8f\xbf\xbf", "0123456789abcdef" };
+    static const unsigned char noise[] = { 0x80, 0xBF, 0xC0, 0xC1, 0xC2, 0xE0, 0xED, 0xF0, 0xF4, 0xF5, 0xFF, 0xA0, 0x90 };
+    unsigned char buf[300];
+    unsigned seed = 12345;
+    for (int round = 0; round < 3000; ++round) {
+        size_t len = 0;
+        seed = seed * 1103515245u + 12345u;
+        size_t target = (seed >> 16) % 200;
+        while (len < target) {
+            seed = seed * 1103515245u + 12345u;
+            const char *p = pieces[(seed >> 16) % 9];
+            size_t n = strlen(p);
+            memcpy(buf + len, p, n);
+            len += n;
+        }
+        /* corrupt a few rounds in one or two places */
+        for (int k = 0; k < round % 3 && len; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            buf[(seed >> 8) % len] = noise[(seed >> 16) % sizeof(noise)];
+        }
+        /* and cut some off mid-sequence */
+        if (round % 5 == 0 && len) len -= (seed >> 4) % 3 < len ? (seed >> 4) % 3 : 0;
+        size_t want = utf8_reference(buf, len), pos = len;
+        int rc = fossil_media_utf8_validate((const char*)buf, len, &pos);
+        ASSUME_ITS_TRUE(rc == (want == len ? 0 : -1));
+        ASSUME_ITS_TRUE(want == len || pos == want);
+    }
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_count) {
+    char buf[512];
+    size_t len = 0;
+    for (int i = 0; i < 50; ++i) {
+        memcpy(buf + len, "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", 10);
+        len += 10;
+    }
+    ASSUME_ITS_TRUE(fossil_media_utf8_count(buf, len) == 200);
+    ASSUME_ITS_TRUE(fossil_media_utf8_count(buf, 3) == 2);
+    ASSUME_ITS_TRUE(fossil_media_utf8_count("", 0) == 0);
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_transcode_utf16) {
+    const char *text = "Hello, world! A long ASCII run \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 end";
+    size_t len = strlen(text), n = 0, back = 0;
+    uint16_t units[64];
+    char round[96];
+    ASSUME_ITS_TRUE(fossil_media_utf8_to_utf16(text, len, NULL, 0, &n) == 0);
+    ASSUME_ITS_TRUE(n == 31 + 1 + 1 + 2 + 4);
+    ASSUME_ITS_TRUE(fossil_media_utf8_to_utf16(text, len, units, 10, &n) == -1 && n == 39);
+    ASSUME_ITS_TRUE(fossil_media_utf8_to_utf16(text, len, units, 64, &n) == 0);
+    ASSUME_ITS_TRUE(units[0] == 'H' && units[31] == 0xE9 && units[32] == 0x20AC);
+    ASSUME_ITS_TRUE(units[33] == 0xD83D && units[34] == 0xDE00);
+    ASSUME_ITS_TRUE(fossil_media_utf16_to_utf8(units, n, round, sizeof(round), &back) == 0);
+    ASSUME_ITS_TRUE(back == len && memcmp(round, text, len) == 0);
+    /* an unpaired surrogate has no UTF-8 form */
+    units[34] = 'x';
+    ASSUME_ITS_TRUE(fossil_media_utf16_to_utf8(units, n, round, sizeof(round), &back) == -1);
+    ASSUME_ITS_TRUE(fossil_media_utf8_to_utf16("\xff", 1, units, 64, &n) == -1);
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_transcode_utf32) {
+    const char *text = "0123456789abcdefXYZ\xc3\xa9\xf0\x9f\x98\x80";
+    size_t len = strlen(text), n = 0, back = 0;
+    uint32_t cps[32];
+    char round[64];
+    ASSUME_ITS_TRUE(fossil_media_utf8_to_utf32(text, len, cps, 32, &n) == 0);
+    ASSUME_ITS_TRUE(n == 21 && cps[15] == 'f' && cps[19] == 0xE9 && cps[20] == 0x1F600);
+    ASSUME_ITS_TRUE(fossil_media_utf32_to_utf8(cps, n, round, sizeof(round), &back) == 0);
+    ASSUME_ITS_TRUE(back == len && memcmp(round, text, len) == 0);
+    cps[0] = 0xD800;
+    ASSUME_ITS_TRUE(fossil_media_utf32_to_utf8(cps, n, NULL, 0, &back) == -1);
+}
+
+FOSSIL_TEST_CASE(c_test_utf8_decode_encode) {
+    uint32_t cp = 0;
+    char out[4];
+    ASSUME_ITS_TRUE(fossil_media_utf8_decode("\xe2\x82\xac", 3, &cp) == 3 && cp == 0x20AC);
+    ASSUME_ITS_TRUE(fossil_media_utf8_decode("\xe2\x82", 2, &cp) == 0);
+    ASSUME_ITS_TRUE(fossil_media_utf8_encode(0x1F600, out) == 4 && memcmp(out, "\xf0\x9f\x98\x80", 4) == 0);
+    ASSUME_ITS_TRUE(fossil_media_utf8_encode(0xDC00, out) == 3 && memcmp(out, "\xef\xbf\xbd", 3) == 0);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_GROUP(c_utf8_tests) {
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_validate_basic);
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_validate_matches_reference);
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_count);
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_transcode_utf16);
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_transcode_utf32);
+    FOSSIL_TEST_ADD(c_utf8_fixture, c_test_utf8_decode_encode);
+
+    FOSSIL_TEST_REGISTER(c_utf8_fixture);
+} // end of tests
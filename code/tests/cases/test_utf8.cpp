@@ -0,0 +1,94 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Project: Fossil Logic
+ *
+ * This file is part of the Fossil Logic project, which aims to develop
+ * high-performance, cross-platform applications and libraries. The code
+ * contained herein is licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License. You may obtain
+ * a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ * Author: Michael Gene Brockus (Dreamer)
+ * Date: 04/05/2014
+ *
+ * Copyright (C) 2014-2025 Fossil Logic. All rights reserved.
+ * -----------------------------------------------------------------------------
+ */
+#include <fossil/pizza/framework.h>
+#include "fossil/media/framework.h"
+
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Utilities
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// Setup steps for things like test fixtures and
+// mock objects are set here.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+FOSSIL_TEST_SUITE(cpp_utf8_fixture);
+
+FOSSIL_SETUP(cpp_utf8_fixture) {
+    // Setup the test fixture
+}
+
+FOSSIL_TEARDOWN(cpp_utf8_fixture) {
+    // Teardown the test fixture
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Cases
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// The test cases below are provided as samples, inspired
+// by the Meson build system's approach of using test cases
+// as samples for library usage.
+// * * * * * * * * * * * * * * * * * * * * * * * *
+
+using fossil::media::Utf8;
+
+FOSSIL_TEST_CASE(cpp_test_utf8_roundtrip) {
+    std::string text = "na\xc3\xafve \xe2\x82\xac \xf0\x9f\x98\x80";
+    ASSUME_ITS_TRUE(Utf8::valid(text));
+    ASSUME_ITS_TRUE(!Utf8::valid("\xc3"));
+    ASSUME_ITS_TRUE(Utf8::count(text) == 9);
+    std::u16string wide = Utf8::to_utf16(text);
+    ASSUME_ITS_TRUE(wide == u"naïve € \U0001F600");
+    ASSUME_ITS_TRUE(Utf8::from_utf16(wide) == text);
+    std::u32string cps = Utf8::to_utf32(text);
+    ASSUME_ITS_TRUE(cps.size() == 9 && cps.back() == U'\U0001F600');
+    ASSUME_ITS_TRUE(Utf8::from_utf32(cps) == text);
+}
+
+FOSSIL_TEST_CASE(cpp_test_utf8_invalid_throws) {
+    bool threw = false;
+    try {
+        Utf8::to_utf16("bad \xff byte");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSUME_ITS_TRUE(threw);
+    threw = false;
+    try {
+        Utf8::from_utf16(std::u16string(1, u'\xD800'));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSUME_ITS_TRUE(threw);
+}
+
+// * * * * * * * * * * * * * * * * * * * * * * * *
+// * Fossil Logic Test Pool
+// * * * * * * * * * * * * * * * * * * * * * * * *
+FOSSIL_TEST_GROUP(cpp_utf8_tests) {
+    FOSSIL_TEST_ADD(cpp_utf8_fixture, cpp_test_utf8_roundtrip);
+    FOSSIL_TEST_ADD(cpp_utf8_fixture, cpp_test_utf8_invalid_throws);
+
+    FOSSIL_TEST_REGISTER(cpp_utf8_fixture);
+} // end of tests
@@ -205,6 +205,446 @@ FOSSIL_TEST_CASE(c_test_yaml_get_nested_value) {
     fossil_media_yaml_free(head);
 }
 
+FOSSIL_TEST_CASE(c_test_yaml_parse_sequences) {
+    const char *yaml =
+        "items:\n"
+        "  - apple\n"
+        "  - banana\n"
+        "list:\n"
+        "- one\n"
+        "- two\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    ASSUME_ITS_TRUE(strcmp(head->key, "items") == 0);
+    ASSUME_ITS_TRUE(head->type == FOSSIL_MEDIA_YAML_TYPE_SEQUENCE);
+    ASSUME_ITS_TRUE(head->child != NULL && head->child->key == NULL);
+    ASSUME_ITS_TRUE(strcmp(head->child->value, "apple") == 0);
+    ASSUME_ITS_TRUE(strcmp(head->child->next->value, "banana") == 0);
+    ASSUME_ITS_TRUE(head->next != NULL && head->next->type == FOSSIL_MEDIA_YAML_TYPE_SEQUENCE);
+    ASSUME_ITS_TRUE(strcmp(head->next->child->next->value, "two") == 0);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_sequence_of_mappings) {
+    const char *yaml =
+        "containers:\n"
+        "  - name: web\n"
+        "    image: nginx\n"
+        "  - name: db\n"
+        "    image: postgres\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    fossil_media_yaml_node_t *first = head->child;
+    ASSUME_ITS_TRUE(first != NULL && first->type == FOSSIL_MEDIA_YAML_TYPE_MAPPING);
+    ASSUME_ITS_TRUE(strcmp(first->child->key, "name") == 0);
+    ASSUME_ITS_TRUE(strcmp(first->child->next->value, "nginx") == 0);
+    ASSUME_ITS_TRUE(strcmp(first->next->child->next->value, "postgres") == 0);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_flow_collections) {
+    const char *yaml =
+        "ports: [80, 443]\n"
+        "env: {mode: prod, 'debug': false}\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    ASSUME_ITS_TRUE(head->type == FOSSIL_MEDIA_YAML_TYPE_SEQUENCE);
+    ASSUME_ITS_TRUE(strcmp(head->child->value, "80") == 0);
+    ASSUME_ITS_TRUE(head->child->type == FOSSIL_MEDIA_YAML_TYPE_INT);
+    ASSUME_ITS_TRUE(strcmp(head->child->next->value, "443") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "mode"), "prod") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "debug"), "false") == 0);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_block_scalars) {
+    const char *yaml =
+        "literal: |\n"
+        "  line one\n"
+        "  line two\n"
+        "folded: >-\n"
+        "  folded\n"
+        "  text\n"
+        "after: x\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "literal"), "line one\nline two\n") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "folded"), "folded text") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "after"), "x") == 0);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_quoted_and_comments) {
+    const char *yaml =
+        "# leading comment\n"
+        "a: \"tab\\there \\u00e9\" # trailing\n"
+        "b: 'it''s'\n"
+        "c: plain value # comment\n"
+        "d: \"has # hash\"\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "a"), "tab\there \xc3\xa9") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "b"), "it's") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "c"), "plain value") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get(head, "d"), "has # hash") == 0);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_core_schema_types) {
+    const char *yaml =
+        "i: -42\n"
+        "f: 3.5e2\n"
+        "b: true\n"
+        "n: ~\n"
+        "s: \"123\"\n"
+        "t: !!str 7\n"
+        "v: 1.2.3\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    fossil_media_yaml_node_t *n = head;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_INT); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_FLOAT); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_BOOL); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_NULL); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_STRING); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_STRING);
+    ASSUME_ITS_TRUE(strcmp(n->value, "7") == 0); n = n->next;
+    ASSUME_ITS_TRUE(n->type == FOSSIL_MEDIA_YAML_TYPE_STRING);
+    fossil_media_yaml_free(head);
+}
+
+typedef struct {
+    char trace[256];
+    size_t len;
+} yaml_trace_t;
+
+static int yaml_trace_event(const fossil_media_yaml_event_t *ev, void *user) {
+    static const char codes[] = "DdMmSs=";
+    yaml_trace_t *t = (yaml_trace_t*)user;
+    if (t->len + 1 < sizeof(t->trace)) t->trace[t->len++] = codes[ev->type];
+    if (ev->type == FOSSIL_MEDIA_YAML_EVENT_SCALAR && t->len + ev->length + 1 < sizeof(t->trace)) {
+        memcpy(t->trace + t->len, ev->value, ev->length);
+        t->len += ev->length;
+    }
+    t->trace[t->len] = '\0';
+    return 0;
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_events) {
+    const char *yaml =
+        "%YAML 1.2\n"
+        "---\n"
+        "k: [a, {b: c}]\n"
+        "...\n"
+        "---\n"
+        "- x\n";
+    yaml_trace_t t;
+    memset(&t, 0, sizeof(t));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_parse_events(yaml, strlen(yaml), yaml_trace_event, &t));
+    ASSUME_ITS_TRUE(strcmp(t.trace, "DM=kS=aM=b=cmsmdDS=xsd") == 0);
+
+    /* unterminated flow collection */
+    const char *bad = "k: [a, b\n";
+    memset(&t, 0, sizeof(t));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_parse_events(bad, strlen(bad), yaml_trace_event, &t));
+    ASSUME_ITS_TRUE(fossil_media_yaml_parse(bad) == NULL);
+}
+
+typedef struct {
+    fossil_media_yaml_style_t style[4];
+    fossil_media_yaml_type_t type[4];
+    size_t count;
+} yaml_scalar_log_t;
+
+static int yaml_log_scalar(const fossil_media_yaml_event_t *ev, void *user) {
+    yaml_scalar_log_t *seen = (yaml_scalar_log_t*)user;
+    if (ev->type == FOSSIL_MEDIA_YAML_EVENT_SCALAR && seen->count < 4) {
+        seen->style[seen->count] = ev->style;
+        seen->type[seen->count++] = ev->scalar_type;
+    }
+    return 0;
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_event_key_styles) {
+    /* plain keys keep their style and resolve as strings */
+    const char *yaml = "123: 4\n'x': !!str 5\n";
+    yaml_scalar_log_t seen;
+    memset(&seen, 0, sizeof(seen));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_parse_events(yaml, strlen(yaml), yaml_log_scalar, &seen));
+    ASSUME_ITS_EQUAL_SIZE(4, seen.count);
+    ASSUME_ITS_TRUE(seen.style[0] == FOSSIL_MEDIA_YAML_STYLE_PLAIN);
+    ASSUME_ITS_TRUE(seen.type[0] == FOSSIL_MEDIA_YAML_TYPE_STRING);
+    ASSUME_ITS_TRUE(seen.style[1] == FOSSIL_MEDIA_YAML_STYLE_PLAIN);
+    ASSUME_ITS_TRUE(seen.type[1] == FOSSIL_MEDIA_YAML_TYPE_INT);
+    ASSUME_ITS_TRUE(seen.style[2] == FOSSIL_MEDIA_YAML_STYLE_SINGLE_QUOTED);
+    ASSUME_ITS_TRUE(seen.style[3] == FOSSIL_MEDIA_YAML_STYLE_PLAIN);
+    ASSUME_ITS_TRUE(seen.type[3] == FOSSIL_MEDIA_YAML_TYPE_STRING);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_complex_keys_rejected) {
+    const char *cases[] = {
+        "? a\n: b\n",
+        "m:\n  k: v\n  ? [a, b]\n  : c\n",
+        "{? a : b}\n",
+        "- ?\n"
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        yaml_trace_t t;
+        memset(&t, 0, sizeof(t));
+        ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_parse_events(cases[i], strlen(cases[i]), yaml_trace_event, &t));
+        ASSUME_ITS_TRUE(fossil_media_yaml_parse(cases[i]) == NULL);
+    }
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_get_path) {
+    const char *yaml =
+        "metadata:\n"
+        "  name: app\n"
+        "spec:\n"
+        "  name: inner\n"
+        "  template:\n"
+        "    containers:\n"
+        "      - name: web\n"
+        "        image: nginx\n"
+        "      - name: db\n"
+        "        image: postgres\n"
+        "  \"dotted.key\": yes\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(head, "spec.name"), "inner") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(head, "metadata.name"), "app") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(head, "spec.template.containers[0].image"), "nginx") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(head, "spec.template.containers[1].name"), "db") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(head, "spec[\"dotted.key\"]"), "yes") == 0);
+    ASSUME_ITS_TRUE(fossil_media_yaml_get_path(head, "spec.template.containers[2]") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_get_path(head, "spec.missing") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_get_path(head, "name") == NULL);
+
+    const fossil_media_yaml_node_t *node = fossil_media_yaml_find(head, "spec.template.containers");
+    ASSUME_ITS_TRUE(node != NULL && node->type == FOSSIL_MEDIA_YAML_TYPE_SEQUENCE);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_path_compile) {
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("a..b") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("a.") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("a[x]") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("a[0") == NULL);
+    ASSUME_ITS_TRUE(fossil_media_yaml_path_compile("a[0]b") == NULL);
+
+    const char *yaml = "- k: [a, b]\n- k: [c, d]\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    fossil_media_yaml_path_t *path = fossil_media_yaml_path_compile("[1].k[0]");
+    ASSUME_ITS_TRUE(path != NULL);
+    for (int i = 0; i < 3; ++i) {
+        const fossil_media_yaml_node_t *node = fossil_media_yaml_path_find(head, path);
+        ASSUME_ITS_TRUE(node != NULL && strcmp(node->value, "c") == 0);
+    }
+    fossil_media_yaml_path_free(path);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_path_hand_built_tree) {
+    fossil_media_yaml_node_t child = { "port", "8080", 2, NULL, NULL, FOSSIL_MEDIA_YAML_TYPE_INT, NULL };
+    fossil_media_yaml_node_t root = { "server", "", 0, NULL, &child, FOSSIL_MEDIA_YAML_TYPE_MAPPING, NULL };
+    ASSUME_ITS_TRUE(fossil_media_yaml_index(&root) == -1);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(&root, "server.port"), "8080") == 0);
+    ASSUME_ITS_TRUE(fossil_media_yaml_get_path(&root, "port") == NULL);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_stream_buffer) {
+    const char *yaml =
+        "# preamble comment\n"
+        "%YAML 1.2\n"
+        "---\n"
+        "name: first\n"
+        "text: |\n"
+        "  --- not a marker\n"
+        "...\n"
+        "---\n"
+        "name: second\n"
+        "--- plain scalar\n"
+        "---\n"
+        "- name: third\n";
+    fossil_media_yaml_stream_t *stream = fossil_media_yaml_stream_open_buffer(yaml, strlen(yaml));
+    ASSUME_ITS_TRUE(stream != NULL);
+    fossil_media_yaml_node_t *doc = NULL;
+
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(doc, "name"), "first") == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(doc, "text"), "--- not a marker\n") == 0);
+    fossil_media_yaml_free(doc); /* no-op for stream documents */
+
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(doc, "name"), "second") == 0);
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_TRUE(doc == NULL);
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(doc, "[0].name"), "third") == 0);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_stream_next(stream, &doc));
+    fossil_media_yaml_stream_close(stream);
+
+    const char *bad = "---\na: 1\n---\nb: [1, 2\n";
+    stream = fossil_media_yaml_stream_open_buffer(bad, strlen(bad));
+    ASSUME_ITS_EQUAL_I32(1, fossil_media_yaml_stream_next(stream, &doc));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_stream_next(stream, &doc));
+    fossil_media_yaml_stream_close(stream);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_stream_fd) {
+    FILE *file = tmpfile();
+    ASSUME_ITS_TRUE(file != NULL);
+    for (int i = 0; i < 3000; ++i) {
+        fprintf(file, "---\nid: %d\nlabels:\n  app: web-%d\n", i, i);
+    }
+    fflush(file);
+    rewind(file);
+
+    fossil_media_yaml_stream_t *stream = fossil_media_yaml_stream_open_fd(fileno(file));
+    ASSUME_ITS_TRUE(stream != NULL);
+    fossil_media_yaml_node_t *doc = NULL;
+    int count = 0, ok = 1;
+    char expected[32];
+    while (fossil_media_yaml_stream_next(stream, &doc) == 1) {
+        snprintf(expected, sizeof(expected), "web-%d", count);
+        const char *app = fossil_media_yaml_get_path(doc, "labels.app");
+        if (!app || strcmp(app, expected) != 0) ok = 0;
+        count++;
+    }
+    ASSUME_ITS_EQUAL_I32(3000, count);
+    ASSUME_ITS_TRUE(ok);
+    fossil_media_yaml_stream_close(stream);
+    fclose(file);
+
+    ASSUME_ITS_TRUE(fossil_media_yaml_stream_open_fd(-1) == NULL);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_parse_all_matches_stream) {
+    char *yaml = (char*)malloc(200 * 64);
+    size_t len = 0;
+    len += (size_t)sprintf(yaml + len, "first: doc\n");
+    for (int i = 0; i < 200; ++i) {
+        len += (size_t)sprintf(yaml + len, i % 50 == 0 ? "...\n# gap\n" : "---\nitem: %d\nlist: [a, b]\n", i);
+    }
+
+    fossil_media_yaml_node_t **docs = NULL;
+    size_t count = 0;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_parse_all(yaml, len, 4, &docs, &count));
+
+    fossil_media_yaml_stream_t *stream = fossil_media_yaml_stream_open_buffer(yaml, len);
+    fossil_media_yaml_node_t *doc = NULL;
+    size_t serial = 0;
+    int same = 1;
+    while (fossil_media_yaml_stream_next(stream, &doc) == 1) {
+        const char *a = fossil_media_yaml_get_path(doc, "item");
+        const char *b = serial < count ? fossil_media_yaml_get_path(docs[serial], "item") : "";
+        if ((a == NULL) != (b == NULL) || (a && strcmp(a, b) != 0)) same = 0;
+        serial++;
+    }
+    fossil_media_yaml_stream_close(stream);
+    ASSUME_ITS_EQUAL_SIZE(serial, count);
+    ASSUME_ITS_EQUAL_SIZE((size_t)197, count);
+    ASSUME_ITS_TRUE(same);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(docs[0], "first"), "doc") == 0);
+    fossil_media_yaml_free_all(docs, count);
+
+    const char *bad = "---\na: 1\n---\nb: \"open\n";
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_parse_all(bad, strlen(bad), 2, &docs, &count));
+    ASSUME_ITS_TRUE(docs == NULL);
+    free(yaml);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_emit_tree) {
+    const char *yaml =
+        "name: app\n"
+        "port: 8080\n"
+        "version: '1.0'\n"
+        "empty:\n"
+        "note: \"a: b\"\n"
+        "script: \"echo 1\\necho 2\\n\"\n"
+        "containers:\n"
+        "- name: web\n"
+        "  ports: [80]\n"
+        "- []\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    ASSUME_ITS_TRUE(head != NULL);
+    char *out = fossil_media_yaml_emit_string(head, NULL);
+    ASSUME_ITS_TRUE(out != NULL);
+    ASSUME_ITS_TRUE(strcmp(out,
+        "name: app\n"
+        "port: 8080\n"
+        "version: '1.0'\n"
+        "empty:\n"
+        "note: 'a: b'\n"
+        "script: |\n"
+        "  echo 1\n"
+        "  echo 2\n"
+        "containers:\n"
+        "  - name: web\n"
+        "    ports:\n"
+        "      - 80\n"
+        "  - []\n") == 0);
+
+    /* the output reads back to the same tree */
+    fossil_media_yaml_node_t *again = fossil_media_yaml_parse(out);
+    char *out2 = fossil_media_yaml_emit_string(again, NULL);
+    ASSUME_ITS_TRUE(out2 != NULL && strcmp(out, out2) == 0);
+    ASSUME_ITS_TRUE(strcmp(fossil_media_yaml_get_path(again, "script"), "echo 1\necho 2\n") == 0);
+    free(out2);
+    fossil_media_yaml_free(again);
+    free(out);
+    fossil_media_yaml_free(head);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_emit_options) {
+    const char *yaml = "a:\n  b: text\n  c: 3\n";
+    fossil_media_yaml_node_t *head = fossil_media_yaml_parse(yaml);
+    fossil_media_yaml_emit_options_t options = { 4, FOSSIL_MEDIA_YAML_QUOTE_DOUBLE, 1 };
+    char *out = fossil_media_yaml_emit_string(head, &options);
+    ASSUME_ITS_TRUE(out != NULL);
+    ASSUME_ITS_TRUE(strcmp(out, "---\na:\n    b: \"text\"\n    c: 3\n") == 0);
+    free(out);
+    fossil_media_yaml_free(head);
+
+    /* hand-built trees: strings by default, legacy value plus children */
+    fossil_media_yaml_node_t child = { "port", "8080", 2, NULL, NULL, FOSSIL_MEDIA_YAML_TYPE_STRING, NULL };
+    fossil_media_yaml_node_t root = { "server", "main", 0, NULL, &child, FOSSIL_MEDIA_YAML_TYPE_STRING, NULL };
+    out = fossil_media_yaml_emit_string(&root, NULL);
+    ASSUME_ITS_TRUE(out != NULL);
+    ASSUME_ITS_TRUE(strcmp(out, "server: main\n  port: '8080'\n") == 0);
+    free(out);
+}
+
+FOSSIL_TEST_CASE(c_test_yaml_emit_events) {
+    const char *yaml = "---\nk: [1, {x: y}]\n--- scalar\n";
+    fossil_media_buffer_t buf = { NULL, 0, 0 };
+    fossil_media_yaml_emitter_t *emitter = fossil_media_yaml_emitter_new(NULL, fossil_media_sink_buffer, &buf);
+    ASSUME_ITS_TRUE(emitter != NULL);
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_parse_events(yaml, strlen(yaml), fossil_media_yaml_emitter_event, emitter));
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_emitter_finish(emitter));
+    fossil_media_yaml_emitter_free(emitter);
+    ASSUME_ITS_TRUE(buf.data != NULL && strcmp(buf.data, "k: [1, {x: y}]\n--- scalar\n") == 0);
+    fossil_media_buffer_free(&buf);
+
+    /* out-of-place events are rejected */
+    emitter = fossil_media_yaml_emitter_new(NULL, fossil_media_sink_buffer, &buf);
+    fossil_media_yaml_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = FOSSIL_MEDIA_YAML_EVENT_SEQUENCE_END;
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_emitter_event(&ev, emitter));
+    fossil_media_yaml_emitter_free(emitter);
+
+    emitter = fossil_media_yaml_emitter_new(NULL, fossil_media_sink_buffer, &buf);
+    ev.type = FOSSIL_MEDIA_YAML_EVENT_MAPPING_START;
+    ASSUME_ITS_EQUAL_I32(0, fossil_media_yaml_emitter_event(&ev, emitter));
+    ASSUME_ITS_EQUAL_I32(-1, fossil_media_yaml_emitter_finish(emitter));
+    fossil_media_yaml_emitter_free(emitter);
+    fossil_media_buffer_free(&buf);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -222,6 +662,24 @@ FOSSIL_TEST_GROUP(c_yaml_tests) {
     FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_duplicate_keys);
     FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_long_key_and_value);
     FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_get_nested_value);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_sequences);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_sequence_of_mappings);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_flow_collections);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_block_scalars);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_quoted_and_comments);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_core_schema_types);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_events);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_event_key_styles);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_complex_keys_rejected);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_get_path);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_path_compile);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_path_hand_built_tree);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_stream_buffer);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_stream_fd);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_parse_all_matches_stream);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_emit_tree);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_emit_options);
+    FOSSIL_TEST_ADD(c_yaml_fixture, c_test_yaml_emit_events);
 
     FOSSIL_TEST_REGISTER(c_yaml_fixture);
 } // end of tests
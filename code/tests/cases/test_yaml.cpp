@@ -220,6 +220,69 @@ FOSSIL_TEST_CASE(cpp_test_yaml_get_nested_value) {
     ASSUME_ITS_TRUE(strcmp(doc.get("deep"), "deeper") == 0);
 }
 
+FOSSIL_TEST_CASE(cpp_test_yaml_parse_structured) {
+    using fossil::media::Yaml;
+    const char *yaml =
+        "spec:\n"
+        "  containers:\n"
+        "    - name: web\n"
+        "      image: \"nginx:1.25\"\n"
+        "  ports: [80, 443]\n"
+        "  script: |\n"
+        "    echo hi\n";
+    Yaml doc(yaml);
+
+    ASSUME_ITS_TRUE(strcmp(doc.get("image"), "nginx:1.25") == 0);
+    ASSUME_ITS_TRUE(strcmp(doc.get("script"), "echo hi\n") == 0);
+    ASSUME_ITS_TRUE(doc.get("ports") != nullptr);
+}
+
+FOSSIL_TEST_CASE(cpp_test_yaml_get_path) {
+    using fossil::media::Yaml;
+    using fossil::media::YamlPath;
+    const char *yaml =
+        "spec:\n"
+        "  containers:\n"
+        "    - name: web\n"
+        "      image: nginx\n";
+    Yaml doc(yaml);
+    YamlPath image("spec.containers[0].image");
+
+    ASSUME_ITS_TRUE(strcmp(doc.get_path("spec.containers[0].name"), "web") == 0);
+    ASSUME_ITS_TRUE(strcmp(doc.get_path(image), "nginx") == 0);
+    ASSUME_ITS_TRUE(doc.get_path("spec.image") == nullptr);
+
+    bool thrown = false;
+    try {
+        YamlPath bad("spec..x");
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    ASSUME_ITS_TRUE(thrown);
+}
+
+FOSSIL_TEST_CASE(cpp_test_yaml_stream) {
+    using fossil::media::YamlStream;
+    const std::string yaml = "---\nname: a\n---\nname: b\n";
+    YamlStream stream(yaml.data(), yaml.size());
+    const fossil_media_yaml_node_t *doc = nullptr;
+    std::string names;
+    while (stream.next(doc)) {
+        names += fossil_media_yaml_get_path(doc, "name");
+    }
+    ASSUME_ITS_TRUE(names == "ab");
+}
+
+FOSSIL_TEST_CASE(cpp_test_yaml_emit) {
+    using fossil::media::Yaml;
+    Yaml doc("list:\n  - 1\n  - two\n");
+    const std::string out = doc.emit();
+    ASSUME_ITS_TRUE(out == "list:\n  - 1\n  - two\n");
+
+    Yaml again(out.c_str());
+    ASSUME_ITS_TRUE(strcmp(again.get_path("list[1]"), "two") == 0);
+}
+
 // * * * * * * * * * * * * * * * * * * * * * * * *
 // * Fossil Logic Test Pool
 // * * * * * * * * * * * * * * * * * * * * * * * *
@@ -239,6 +302,10 @@ FOSSIL_TEST_GROUP(cpp_yaml_tests) {
     FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_parse_long_key_and_value);
     FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_parse_tabs_and_spaces_indent);
     FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_get_nested_value);
+    FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_parse_structured);
+    FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_get_path);
+    FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_stream);
+    FOSSIL_TEST_ADD(cpp_yaml_fixture, cpp_test_yaml_emit);
 
     FOSSIL_TEST_REGISTER(cpp_yaml_fixture);
 } // end of tests